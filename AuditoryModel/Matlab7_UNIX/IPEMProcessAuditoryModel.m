@@ -18,7 +18,12 @@ function outResult = IPEMProcessAuditoryModel (varargin)
 %   IPEMProcessAuditoryModel(inInputFileName,inInputFilePath,...
 %                            inOutputFileName,inOutputFilePath,...
 %                            inSampleFrequency,inNumOfChannels,...
-%                            inFirstFreq,inFreqDist)
+%                            inFirstFreq,inFreqDist,...
+%                            inCacheDirectory,inCacheSize,...
+%                            inPyramidFile,inPyramidLevels,...
+%                            inChannelScale,inChannelPositions,...
+%                            inStart,inDuration,inPreRoll,...
+%                            inNormalization,inLevel)
 %
 % Description:
 %   Matlab interface function towards the auditory model developed by the
@@ -28,7 +33,9 @@ function outResult = IPEMProcessAuditoryModel (varargin)
 %   nerve image corresponding to this sound file.
 %
 % Input arguments:
-%   inInputFileName = name of the file to process (only .wav files)
+%   inInputFileName = name of the file to process (.wav, .aiff/.aifc, .au/.snd
+%                     or .flac; the format is recognized from the file itself,
+%                     and files with several channels are mixed down to mono)
 %   inInputFilePath = directory path to the input file
 %                     if empty or not specified, '' is used by default
 %   inOutputFileName = name for the output file
@@ -43,6 +50,47 @@ function outResult = IPEMProcessAuditoryModel (varargin)
 %                 if empty or not specified, 2.0 is used by default
 %   inFreqDist = distance between center frequencies of two adjecent auditory channels (in cbu)
 %                if empty or not specified, 0.5 is used by default
+%   inCacheDirectory = directory of a cache of nerve images: if the same sound
+%                      was already processed with the same parameters, the
+%                      stored image is copied instead of running the model
+%                      if empty or not specified, no cache is used
+%   inCacheSize = maximum size of the cache (in MB), the least recently used
+%                 images are removed first
+%                 if empty or not specified, 1024 is used by default
+%   inPyramidFile = also write the nerve image at ever coarser time scales
+%                   (each level 4 times coarser, with the minimum, maximum and
+%                   mean per channel) to this file (including its path), for
+%                   fast overviews of long images: see IPEMLoadANIPyramid
+%                   if empty or not specified, no pyramid is written
+%   inPyramidLevels = number of levels of the pyramid (at most 12)
+%                     if empty or not specified, 6 is used by default
+%   inChannelScale = scale of inFirstFreq, inFreqDist and inChannelPositions:
+%                    'cbu' (critical band units of the model), 'erb' (ERB-rate
+%                    units), 'bark' or 'hz'; the filters are always one
+%                    critical band wide
+%                    if empty or not specified, 'cbu' is used by default
+%   inChannelPositions = positions of the channels on inChannelScale, in
+%                        increasing order (e.g. a few formant regions): only
+%                        these channels are computed, and inNumOfChannels,
+%                        inFirstFreq and inFreqDist are not used
+%                        if empty or not specified, the channels are equally
+%                        spaced
+%   inStart = only analyse the sound from this time (in s) on: the file is
+%             read from there, so the cost depends on inDuration only
+%             if empty or not specified, 0 is used by default
+%   inDuration = length of the part to analyse (in s)
+%                if empty or not specified, the sound is analysed up to its end
+%   inPreRoll = sound analysed before inStart to let the model settle, whose
+%               frames are not written (in s)
+%               if empty or not specified, 0.5 is used by default
+%   inNormalization = 'none', 'peak' (raise the sound to a peak of 0.75) or
+%                     'rms' (scale it to an RMS level of inLevel dB, like
+%                     IPEMAdaptLevel); the level is measured on the part that
+%                     is analysed and, with inCacheDirectory, kept in the
+%                     cache so that the file is not scanned again
+%                     if empty or not specified, 'none' is used by default
+%   inLevel = RMS level (in dB) for inNormalization 'rms'
+%             if empty or not specified, -20 is used by default
 %
 % Output:
 %   outResult = if zero, processing was ok
@@ -73,13 +121,18 @@ function outResult = IPEMProcessAuditoryModel (varargin)
 
 % Handle input arguments
 [inInputFileName, inInputFilePath, inOutputFileName,inOutputFilePath,...
-        inSampleFrequency,inNumOfChannels, inFirstFreq, inFreqDist] = ...
-    IPEMHandleInputArguments(varargin,2,{'input.wav','','nerve_image.ani','',22050,40,2.0,0.5});
+        inSampleFrequency,inNumOfChannels, inFirstFreq, inFreqDist,...
+        inCacheDirectory,inCacheSize,inPyramidFile,inPyramidLevels,...
+        inChannelScale,inChannelPositions,inStart,inDuration,inPreRoll,...
+        inNormalization,inLevel] = ...
+    IPEMHandleInputArguments(varargin,2,{'input.wav','','nerve_image.ani','',22050,40,2.0,0.5,'',1024,'',6,'cbu',[],0,-1,-1,'none',-20});
 
 % Check types
 if (~ischar(inInputFileName) | ~ischar(inInputFilePath) | ~ischar(inOutputFileName) ...
     | ~ischar(inOutputFilePath) | ~isnumeric(inSampleFrequency) | ~isnumeric(inNumOfChannels) ...
-    | ~isnumeric(inFirstFreq) | ~isnumeric(inFreqDist))
+    | ~isnumeric(inFirstFreq) | ~isnumeric(inFreqDist) ...
+    | ~ischar(inChannelScale) | ~isnumeric(inChannelPositions) ...
+    | ~ischar(inNormalization) | ~isnumeric(inLevel))
     disp('Some arguments are not of the correct type...');
     outResult = -1;
     return;
@@ -99,7 +152,9 @@ end
 outResult = IPEMProcessAuditoryModelSafe (...
     inNumOfChannels,inFirstFreq,inFreqDist,...
     inInputFileName,inInputFilePath,inOutputFileName,inOutputFilePath,...
-    inSampleFrequency,-1);
+    inSampleFrequency,-1,inCacheDirectory,inCacheSize,...
+    inPyramidFile,inPyramidLevels,inChannelScale,double(inChannelPositions),...
+    inStart,inDuration,inPreRoll,inNormalization,inLevel);
 
 %
 % Commented out by Stefan Tomic
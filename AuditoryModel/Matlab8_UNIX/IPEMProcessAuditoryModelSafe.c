@@ -10,57 +10,101 @@ IPEMProcessModel_external.cpp by Koen Tanghe
 
 *************************************************************************/
 #include "mex.h"
+#include "ipemam.h"
 
 
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
 
   /* Declare C variables for the Matlab arguments and set to defaults */
-  long theNumOfChannels = -1;
-  double theFirstFreq = -1.0;
-  double theFreqDist = -1.0;
+  ipemam_params theParams;
+  ipemam_file_options theOptions;
+  ipemam_plan* thePlan;
+  double theValue;
   char* theInputFileName = NULL;
   char* theInputFilePath = NULL;
   char* theOutputFileName = NULL;
   char* theOutputFilePath = NULL;
-  double theSampleFrequency = -1.0;
-  long theSoundFileFormat = -1;
+  char* theCacheDirectory = NULL;
+  char* thePyramidFileName = NULL;
+  char* theChannelScaleName = NULL;
+  char* theNormalizationName = NULL;
 
   double *output;
 
-  theNumOfChannels =  mxGetScalar(prhs[0]);
-  theFirstFreq = mxGetScalar(prhs[1]);
-  theFreqDist = mxGetScalar(prhs[2]);
+  /* -1 (or an empty argument) gives the default */
+  ipemam_params_init(&theParams);
+  ipemam_file_options_init(&theOptions);
+  if ((theValue = mxGetScalar(prhs[0])) != -1) theParams.nchan = (int32_t) theValue;
+  if ((theValue = mxGetScalar(prhs[1])) != -1) theParams.first_freq = theValue;
+  if ((theValue = mxGetScalar(prhs[2])) != -1) theParams.freq_dist = theValue;
   theInputFileName = mxArrayToString(prhs[3]);
   theInputFilePath = mxArrayToString(prhs[4]);
   theOutputFileName = mxArrayToString(prhs[5]);
   theOutputFilePath = mxArrayToString(prhs[6]);
-  theSampleFrequency = mxGetScalar(prhs[7]);
-  theSoundFileFormat = (long)mxGetScalar(prhs[8]);
+  if ((theValue = mxGetScalar(prhs[7])) != -1) theParams.fs = theValue;
+  /* prhs[8], the sound file format, is found from the header of the file */
+  /* optional: ANI cache directory and its maximum size (MB) */
+  if (nrhs > 9) theCacheDirectory = mxArrayToString(prhs[9]);
+  if (nrhs > 10) theOptions.cache_size = mxGetScalar(prhs[10]);
+  /* optional: pyramid file (including its path) and its number of levels */
+  if (nrhs > 11) thePyramidFileName = mxArrayToString(prhs[11]);
+  if (nrhs > 12) theOptions.pyramid_levels = (int32_t)mxGetScalar(prhs[12]);
+  /* optional: scale of the channels ('cbu', 'erb', 'bark' or 'hz') and
+     their positions on that scale */
+  if ((nrhs > 13) && !mxIsEmpty(prhs[13]))
+  {
+    theChannelScaleName = mxArrayToString(prhs[13]);
+    theParams.scale = ipemam_scale(theChannelScaleName);
+    mxFree(theChannelScaleName);
+    if (theParams.scale == -1)
+      mexErrMsgTxt("IPEMProcessAuditoryModelSafe: unknown channel scale");
+  }
+  if ((nrhs > 14) && !mxIsEmpty(prhs[14]))
+  {
+    theParams.positions = mxGetPr(prhs[14]);
+    theParams.npositions = (int32_t)mxGetNumberOfElements(prhs[14]);
+  }
+  /* optional: part of the sound to analyse (s) and the pre-roll before it */
+  if ((nrhs > 15) && !mxIsEmpty(prhs[15])) theOptions.start = mxGetScalar(prhs[15]);
+  if ((nrhs > 16) && !mxIsEmpty(prhs[16])) theOptions.duration = mxGetScalar(prhs[16]);
+  if ((nrhs > 17) && !mxIsEmpty(prhs[17])) theOptions.preroll = mxGetScalar(prhs[17]);
+  /* optional: normalization of the sound ('none', 'peak' or 'rms') and the
+     RMS level (dB) for 'rms' */
+  if ((nrhs > 18) && !mxIsEmpty(prhs[18]))
+  {
+    theNormalizationName = mxArrayToString(prhs[18]);
+    theOptions.normalization = ipemam_normalization(theNormalizationName);
+    mxFree(theNormalizationName);
+    if (theOptions.normalization == -1)
+      mexErrMsgTxt("IPEMProcessAuditoryModelSafe: unknown normalization");
+  }
+  if ((nrhs > 19) && !mxIsEmpty(prhs[19])) theOptions.level = mxGetScalar(prhs[19]);
+  theOptions.cache_dir = theCacheDirectory;
+  theOptions.pyramid_file = thePyramidFileName;
 
 
-  IPEMAuditoryModel_Setup( theNumOfChannels,
-			   theFirstFreq,
-			   theFreqDist,
-			   theInputFileName,
-			   theInputFilePath,
-			   theOutputFileName,
-			   theOutputFilePath,
-			   theSampleFrequency,
-			   theSoundFileFormat);
-
-
-  
   plhs[0] = mxCreateDoubleMatrix(1,1,mxREAL);
   output = mxGetPr(plhs[0]);
   /* Start processing */
-  *output = (double) IPEMAuditoryModel_Process();
+  thePlan = ipemam_plan_create(&theParams);
+  if (thePlan == NULL) *output = -1;
+  else
+  {
+    *output = (double) ipemam_analyse_file(thePlan,theInputFileName,theInputFilePath,
+					    theOutputFileName,theOutputFilePath,&theOptions);
+    ipemam_plan_destroy(thePlan);
+  }
   
   /* Free memory for strings */
   mxFree(theInputFileName);
   mxFree(theInputFilePath);
   mxFree(theOutputFileName);
   mxFree(theOutputFilePath);
+  if (theCacheDirectory != NULL) mxFree(theCacheDirectory);
+  if (thePyramidFileName != NULL) mxFree(thePyramidFileName);
+  if (*output == ipemam_error_param)
+    mexErrMsgTxt("IPEMProcessAuditoryModelSafe: a file name or path is too long");
   
   
 }
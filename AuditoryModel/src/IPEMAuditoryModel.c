@@ -32,6 +32,7 @@
 // Includes
 // --------
 #include "IPEMAuditoryModel.h"
+#include <command.h>	/* only for per_thread */
 #include <string.h>
 
 
@@ -40,15 +41,49 @@
 // The ONE and ONLY interface point towards the "audiprog" algorithm.
 // We are NOT using an inclusion of the audiprog.h header file here, because
 // this would introduce all the global variables of the C-modules in this module
-// (which is something we don't want to do)
-long AudiProg (long inNumOfChannels, double inFirstFreq, double inFreqDist,
-			const char* inInputFileName, const char* inInputFilePath,
-			const char* inOutputFileName, const char* inOutputFilePath,
-			double inSampleFrequency, long inSoundFileFormat);
+// (which is something we don't want to do): audiparams.h only declares the
+// entry point and its parameters
+#include <audiparams.h>
 
 
 
 void IPEMAuditoryModel_SetDefaults();
+static long CopyName(char* outName, const char* inName);
+
+
+/* these variables become globals now, since we are using C instead of C++
+   and we want to use them across more than one function
+   (one set per thread, like the state of the model itself) */
+per_thread long	mNumOfChannels;
+per_thread double	mFirstFreq;
+per_thread double	mFreqDist;
+per_thread char	mInputFileName[IPEMAuditoryModel_MaxNameLength+1];
+per_thread char	mInputFilePath[IPEMAuditoryModel_MaxNameLength+1];
+per_thread char	mOutputFileName[IPEMAuditoryModel_MaxNameLength+1];
+per_thread char	mOutputFilePath[IPEMAuditoryModel_MaxNameLength+1];
+per_thread double	mSampleFrequency;
+per_thread long	mSoundFileFormat;
+per_thread long	mOutputFormat;
+per_thread const double*	mInputSignal;
+per_thread long	mInputSignalLength;
+per_thread FILE*	mOutputStream;
+per_thread char	mCacheDirectory[IPEMAuditoryModel_MaxNameLength+1];
+per_thread double	mCacheSize;
+per_thread char	mPitchFileName[IPEMAuditoryModel_MaxNameLength+1];
+per_thread const ani_sink*	mOutputSink;
+per_thread char	mPyramidFileName[IPEMAuditoryModel_MaxNameLength+1];
+per_thread long	mPyramidLevels;
+per_thread const log_sink*	mLogSink;
+per_thread long	mChannelScale;
+per_thread const double*	mChannelPositions;
+per_thread long	mNumOfPositions;
+per_thread double	mStart;
+per_thread double	mDuration;
+per_thread double	mPreRoll;
+per_thread long	mNormalization;
+per_thread double	mLevel;
+per_thread long	mKernel;
+per_thread const decoder_source*	mInputSource;
 
 
 // Constants
@@ -60,6 +95,8 @@ const char*	cDefInputFileName = "input.wav";
 const char*	cDefOutputFileName = "e8n00bin";
 const double	cDefSampleFrequency = 20050;
 const long	cDefSoundFileFormat = sffWav;
+const long	cDefOutputFormat = aofText;
+const double	cDefLevel = -20;
 
 // -----------------------------------------------------------------------------
 //	IPEMAuditoryModel
@@ -68,7 +105,7 @@ const long	cDefSoundFileFormat = sffWav;
 //  - if -1 is specified (for a numeric value)
 //  - if NULL is specified (for a string)
 // Was the constructor of the original cpp file (S.T.)
-IPEMAuditoryModel_Setup(long inNumOfChannels,
+long IPEMAuditoryModel_Setup(long inNumOfChannels,
 									double inFirstFreq,
 									double inFreqDist,
 									const char* inInputFileName,
@@ -78,6 +115,8 @@ IPEMAuditoryModel_Setup(long inNumOfChannels,
 									double inSampleFrequency,
 									long inSoundFileFormat)
 {
+	long theResult = 1;
+
 	// Start with default values
 	IPEMAuditoryModel_SetDefaults();
 
@@ -85,12 +124,225 @@ IPEMAuditoryModel_Setup(long inNumOfChannels,
 	if (inNumOfChannels != -1)	mNumOfChannels = inNumOfChannels;
 	if (inFirstFreq != -1.0)	mFirstFreq = inFirstFreq;
   	if (inFreqDist != -1.0)		mFreqDist = inFreqDist;
-	if ((inInputFileName != NULL) && (strlen(inInputFileName) != 0))	strcpy(mInputFileName,inInputFileName);
-	if ((inInputFilePath != NULL)	&& (strlen(inInputFilePath) != 0))	strcpy(mInputFilePath,inInputFilePath);
-	if ((inOutputFileName != NULL) && (strlen(inOutputFileName) != 0))	strcpy(mOutputFileName,inOutputFileName);
-	if ((inOutputFilePath != NULL) && (strlen(inOutputFilePath) != 0))	strcpy(mOutputFilePath,inOutputFilePath);
+	if ((inInputFileName != NULL) && (strlen(inInputFileName) != 0))	theResult &= CopyName(mInputFileName,inInputFileName);
+	if ((inInputFilePath != NULL)	&& (strlen(inInputFilePath) != 0))	theResult &= CopyName(mInputFilePath,inInputFilePath);
+	if ((inOutputFileName != NULL) && (strlen(inOutputFileName) != 0))	theResult &= CopyName(mOutputFileName,inOutputFileName);
+	if ((inOutputFilePath != NULL) && (strlen(inOutputFilePath) != 0))	theResult &= CopyName(mOutputFilePath,inOutputFilePath);
 	if (inSampleFrequency != -1.0)	mSampleFrequency = inSampleFrequency;
 	if (inSoundFileFormat != -1) mSoundFileFormat = inSoundFileFormat;
+	return theResult;
+}
+
+
+// -----------------------------------------------------------------------------
+//	CopyName
+// -----------------------------------------------------------------------------
+// Copies a name into one of the buffers above (of IPEMAuditoryModel_MaxNameLength
+// characters and the terminating zero); a longer name leaves it empty
+
+static long CopyName(char* outName, const char* inName)
+{
+	if (strlen(inName) > IPEMAuditoryModel_MaxNameLength)
+	{
+		outName[0] = '\0';
+		return 0;
+	}
+	strcpy(outName,inName);
+	return 1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetOutputFormat
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetOutputFormat(long inOutputFormat)
+{
+	if (inOutputFormat == -1) mOutputFormat = cDefOutputFormat;
+	else mOutputFormat = inOutputFormat;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetInputSignal
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetInputSignal(const double* inSignal, long inLength)
+{
+	mInputSignal = inSignal;
+	mInputSignalLength = inLength;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetInputSource
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetInputSource(const decoder_source* inSource)
+{
+	mInputSource = inSource;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetOutputStream
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetOutputStream(FILE* inStream)
+{
+	mOutputStream = inStream;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetOutputSink
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetOutputSink(const ani_sink* inSink)
+{
+	mOutputSink = inSink;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetCache
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_SetCache(const char* inDirectory, double inMaxSize)
+{
+	mCacheSize = inMaxSize;
+	if (inDirectory == NULL) mCacheDirectory[0] = '\0';
+	else return CopyName(mCacheDirectory,inDirectory);
+	return 1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetPitchFile
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_SetPitchFile(const char* inFileName)
+{
+	if (inFileName == NULL) mPitchFileName[0] = '\0';
+	else return CopyName(mPitchFileName,inFileName);
+	return 1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetPyramidFile
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_SetPyramidFile(const char* inFileName, long inNumOfLevels)
+{
+	mPyramidLevels = inNumOfLevels;
+	if (inFileName == NULL) mPyramidFileName[0] = '\0';
+	else return CopyName(mPyramidFileName,inFileName);
+	return 1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetLogSink
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetLogSink(const log_sink* inSink)
+{
+	mLogSink = inSink;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetChannels
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetChannels(long inScale, const double* inPositions, long inNumOfPositions)
+{
+	mChannelScale = inScale;
+	mChannelPositions = inPositions;
+	mNumOfPositions = (inPositions == NULL) ? 0 : inNumOfPositions;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetRange
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetRange(double inStart, double inDuration, double inPreRoll)
+{
+	mStart = inStart;
+	mDuration = inDuration;
+	mPreRoll = inPreRoll;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetNormalization
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetNormalization(long inMode, double inLevel)
+{
+	mNormalization = inMode;
+	mLevel = inLevel;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SetKernel
+// -----------------------------------------------------------------------------
+
+void IPEMAuditoryModel_SetKernel(long inKernel)
+{
+	mKernel = inKernel;
+}
+
+
+// -----------------------------------------------------------------------------
+//	ChannelScale
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_ChannelScale(const char* inName)
+{
+	if (strcmp(inName,"cbu") == 0) return csCBU;
+	else if (strcmp(inName,"erb") == 0) return csERB;
+	else if (strcmp(inName,"bark") == 0) return csBark;
+	else if (strcmp(inName,"hz") == 0) return csHz;
+	else return -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	Normalization
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_Normalization(const char* inName)
+{
+	if (strcmp(inName,"none") == 0) return nmNone;
+	else if (strcmp(inName,"peak") == 0) return nmPeak;
+	else if (strcmp(inName,"rms") == 0) return nmRMS;
+	else return -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	Kernel
+// -----------------------------------------------------------------------------
+
+long IPEMAuditoryModel_Kernel(const char* inName)
+{
+	if (strcmp(inName,"double") == 0) return akDouble;
+	else if (strcmp(inName,"fixed") == 0) return akFixed;
+	else return -1;
+}
+
+
+// -----------------------------------------------------------------------------
+//	SampleFrequency
+// -----------------------------------------------------------------------------
+
+double IPEMAuditoryModel_SampleFrequency()
+{
+	return mSampleFrequency;
 }
 
 
@@ -100,12 +352,42 @@ IPEMAuditoryModel_Setup(long inNumOfChannels,
 
 long IPEMAuditoryModel_Process()
 {
+	audiprog_params theParams;
+
+	theParams.nchan = mNumOfChannels;
+	theParams.first_freq = mFirstFreq;
+	theParams.freq_dist = mFreqDist;
+	theParams.input_file = mInputFileName;
+	theParams.input_path = mInputFilePath;
+	theParams.output_file = mOutputFileName;
+	theParams.output_path = mOutputFilePath;
+	theParams.sample_freq = mSampleFrequency;
+	theParams.sound_format = 2; /* any sound file, see sffWav */
+	theParams.output_format = (mOutputFormat == aofBinary) ? 1 : 0;
+	theParams.signal = mInputSignal;
+	theParams.signal_length = mInputSignalLength;
+	theParams.source = mInputSource;
+	theParams.output_stream = mOutputStream;
+	theParams.output_sink = mOutputSink;
+	theParams.cache_dir = mCacheDirectory;
+	theParams.cache_size = mCacheSize;
+	theParams.pitch_file = mPitchFileName;
+	theParams.pyramid_file = mPyramidFileName;
+	theParams.pyramid_levels = mPyramidLevels;
+	theParams.log_sink = mLogSink;
+	theParams.chan_scale = mChannelScale;
+	theParams.chan_positions = mChannelPositions;
+	theParams.npositions = mNumOfPositions;
+	theParams.start = mStart;
+	theParams.duration = mDuration;
+	theParams.preroll = mPreRoll;
+	theParams.normalization = mNormalization;
+	theParams.level = mLevel;
+	theParams.kernel = mKernel;
+
   // Call the original AudiProg-module
   // (this starts the computation, if everyting is allright)*/
-  	return AudiProg(mNumOfChannels, mFirstFreq, mFreqDist,
-			mInputFileName, mInputFilePath,
-			mOutputFileName, mOutputFilePath,
-			mSampleFrequency, (mSoundFileFormat == sffWav) ? 2 : 3 /* ? */);
+	return AudiProg(&theParams);
 
 
  
@@ -126,4 +408,25 @@ void IPEMAuditoryModel_SetDefaults()
 	mOutputFilePath[0] = '\0';
 	mSampleFrequency = cDefSampleFrequency;
 	mSoundFileFormat = cDefSoundFileFormat;
+	mOutputFormat = cDefOutputFormat;
+	mInputSignal = NULL;
+	mInputSignalLength = 0;
+	mOutputStream = NULL;
+	mCacheDirectory[0] = '\0';
+	mCacheSize = -1;
+	mPitchFileName[0] = '\0';
+	mOutputSink = NULL;
+	mPyramidFileName[0] = '\0';
+	mPyramidLevels = -1;
+	mLogSink = NULL;
+	mChannelScale = csCBU;
+	mChannelPositions = NULL;
+	mNumOfPositions = 0;
+	mStart = -1;
+	mDuration = -1;
+	mPreRoll = -1;
+	mNormalization = nmNone;
+	mLevel = cDefLevel;
+	mKernel = akDouble;
+	mInputSource = NULL;
 }
@@ -44,21 +44,189 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <aniio.h>
+#include <logging.h>
+#include <decoder.h>
 
+#if defined(__cplusplus)
+extern "C" {
+#endif
 
-/*these variables become globals now, since we are using C instead of C++
-  and we want to use them across more than one function */	
-enum {sffWav = 0, SffSnd };
+/* Sound file formats: wav (PCM or float), snd (Sun/NeXT .au/.snd), aiff
+   (AIFF/AIFC) and flac. The decoder is chosen from the header of the input
+   file (see library/decoder.h), so any of these reads all of them; files
+   with more than one channel are mixed down to mono. */
+enum {sffWav = 0, sffSnd, sffAiff, sffFlac };
 
-long	mNumOfChannels;
-double	mFirstFreq;
-double	mFreqDist;
-char	mInputFileName[256];
-char	mInputFilePath[256];
-char	mOutputFileName[256];
-char	mOutputFilePath[256];
-double	mSampleFrequency;
-long	mSoundFileFormat;
+/* Output formats of the auditory nerve image:
+   aofText writes one line of text per frame, aofBinary writes a binary ANI
+   file that can be mapped in memory by the reader in library/aniio.h */
+enum {aofText = 0, aofBinary };
+
+/* Scales on which the channels are placed: csCBU is the critical band scale
+   of the model itself, csERB the ERB-rate scale of Glasberg and Moore, csBark
+   the Bark scale (Traunmueller's formula) and csHz a linear scale in Hz */
+enum {csCBU = 0, csERB, csBark, csHz };
+
+/* Normalizations of the input: nmNone uses the samples as they are, nmPeak
+   raises them to a peak of 0.75 (a louder signal is left as it is) and nmRMS
+   scales them to a given RMS level in dB, as IPEMAdaptLevel does */
+enum {nmNone = 0, nmPeak, nmRMS };
+
+/* Arithmetic of the model: akDouble is the model in double precision, akFixed
+   runs the OMEF, the decimation, the filterbank and the haircell models in
+   32 bit fixed point (see audiprog/qformat.h), which gives the same result on
+   every host. akFixed is for reproducible results, not for speed: it runs
+   about 3 to 4 times slower than akDouble. Its deviation and throughput
+   against akDouble are reported by bench/fixbench */
+enum {akDouble = 0, akFixed };
+
+/* Longest name or path (in characters) that the model takes: Setup and the
+   setters below refuse longer ones */
+#define IPEMAuditoryModel_MaxNameLength 255
+
+/* A default value for any of the arguments can be requested:
+    - if -1 is specified (for a numeric value)
+    - if NULL is specified (for a string)
+   Returns 0 if a name or path is longer than IPEMAuditoryModel_MaxNameLength
+   (it is then left empty, so that Process fails), 1 otherwise */
+long IPEMAuditoryModel_Setup(long inNumOfChannels,
+							double inFirstFreq,
+							double inFreqDist,
+							const char* inInputFileName,
+							const char* inInputFilePath,
+							const char* inOutputFileName,
+							const char* inOutputFilePath,
+							double inSampleFrequency,
+							long inSoundFileFormat);
+
+/* Selects aofText or aofBinary (call after IPEMAuditoryModel_Setup, which
+   resets the output format to aofText) */
+void IPEMAuditoryModel_SetOutputFormat(long inOutputFormat);
+
+/* Analyse inSignal[0..inLength-1] (samples in -1..+1, at the sample
+   frequency given to IPEMAuditoryModel_Setup) instead of the input file.
+   The signal is not copied and must stay valid during Process.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetInputSignal(const double* inSignal, long inLength);
+
+/* Analyse the samples that inSource (see library/decoder.h) delivers instead
+   of the input file, e.g. a signal that arrives a block at a time. A source is
+   read once: it cannot be normalized (the mode is ignored) nor cached. The
+   source is not copied and must stay valid during Process.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetInputSource(const decoder_source* inSource);
+
+/* Write the envelopes to an open stream instead of to the output file.
+   In that case none of the other files (outfile.dat, FilterFrequencies.txt,
+   filter responses) are written. The stream is flushed, not closed.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetOutputStream(FILE* inStream);
+
+/* Hand the frames of the auditory nerve image to inSink (see library/aniio.h)
+   instead of writing them to the output file, e.g. to fill a buffer in memory.
+   As with an output stream, none of the other files are written. The sink is
+   not copied and must stay valid during Process.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetOutputSink(const ani_sink* inSink);
+
+/* Consult the ANI cache in inDirectory (which must exist) before running the
+   model, and store new results in it. The cache is shared safely between
+   processes and holds at most inMaxSize MB (-1 for the default, 1024);
+   the least recently used results are removed first. An empty or NULL
+   directory disables the cache (the default). Not used with an output
+   stream or sink. Returns 0 (and disables the cache) if inDirectory is longer
+   than IPEMAuditoryModel_MaxNameLength, 1 otherwise.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+long IPEMAuditoryModel_SetCache(const char* inDirectory, double inMaxSize);
+
+/* Also compute a pitch track, written to inFileName (including its path) as
+   one line "T0 evidence vuv" per frame of 10 ms: the period T0 (ms, 0 if
+   unvoiced), the voicing evidence and the voiced/unvoiced decision (1/0).
+   Line m describes the signal at m*10 ms. An empty or NULL name (the
+   default) disables the pitch stage; it does not change the ANI. Returns 0
+   (and disables the pitch stage) if the name is too long, 1 otherwise.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+long IPEMAuditoryModel_SetPitchFile(const char* inFileName);
+
+/* Also write a pyramid of the auditory nerve image to inFileName (including
+   its path): inNumOfLevels levels (-1 for the default, 6; at most 12), each
+   4 times coarser than the previous one, with the minimum, maximum and mean
+   of every channel per bin (see library/aniio.h). A viewer reads only the
+   level that matches its zoom, so an overview of a long ANI costs as much
+   as one of a short one. Written in the same pass as the ANI itself, also
+   when it goes to a stream or a sink. An empty or NULL name (the default)
+   disables the pyramid. Returns 0 (and disables the pyramid) if the name is
+   too long, 1 otherwise.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+long IPEMAuditoryModel_SetPyramidFile(const char* inFileName, long inNumOfLevels);
+
+/* Send the messages of the model to inSink (see library/logging.h) instead of
+   the default, which only writes warnings and errors to stderr. The sink gets
+   the messages up to its level: log_info adds one record per analysis with the
+   fields file, nchan, fs, duration, elapsed and throughput; log_debug adds the
+   parameters of the modules. As the sink is kept per thread, analyses running
+   at the same time can each log to their own destination. The sink is not
+   copied and must stay valid during Process.
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetLogSink(const log_sink* inSink);
+
+/* Place the channels on inScale (one of csCBU, ...) instead of in critical
+   band units: the first frequency and the distance given to
+   IPEMAuditoryModel_Setup are then on that scale. If inPositions is not NULL,
+   the channels are at inPositions[0..inNumOfPositions-1] (on inScale, in
+   increasing order) instead of equally spaced, and inNumOfPositions replaces
+   the number of channels, so only the requested channels are computed.
+   Whatever the scale, each filter is one critical band of the model wide.
+   The positions are not copied and must stay valid during Process.
+   (call after IPEMAuditoryModel_Setup, which resets it to csCBU, NULL) */
+void IPEMAuditoryModel_SetChannels(long inScale, const double* inPositions, long inNumOfPositions);
+
+/* Only analyse inDuration seconds of the signal from inStart (in s) on. The
+   reading starts inPreRoll seconds earlier (-1 for the default, 0.5 s) to let
+   the model settle; the frames of the pre-roll are not written, so the output
+   holds the frames of the range only (in a binary ANI, start_time in the header
+   tells where they start). Sound files are positioned directly (FLAC files are
+   decoded up to the pre-roll), so the cost depends on the range, not on the
+   length of the file. -1 for inStart and inDuration analyses all (the default).
+   (call after IPEMAuditoryModel_Setup, which resets it) */
+void IPEMAuditoryModel_SetRange(double inStart, double inDuration, double inPreRoll);
+
+/* Normalize the input (analysed range, without the pre-roll) with inMode (one
+   of nmNone, ...); for nmRMS, inLevel is the RMS level in dB (e.g. -20, where 0
+   dB is an RMS of 1). The level is measured in one pass over the signal before
+   the analysis, which is the pass that hashes the signal if the ANI cache is
+   used. With a cache directory, the level of a sound file is also kept there,
+   so that a next analysis of the same file finds it without reading it.
+   (call after IPEMAuditoryModel_Setup, which resets it to nmNone, -20) */
+void IPEMAuditoryModel_SetNormalization(long inMode, double inLevel);
+
+/* Run the model with inKernel (akDouble or akFixed). Samples beyond +-16 (after
+   the normalization) are clipped by akFixed.
+   (call after IPEMAuditoryModel_Setup, which resets it to akDouble) */
+void IPEMAuditoryModel_SetKernel(long inKernel);
+
+/* The scale called inName ("cbu", "erb", "bark" or "hz"), -1 if unknown */
+long IPEMAuditoryModel_ChannelScale(const char* inName);
+
+/* The normalization called inName ("none", "peak" or "rms"), -1 if unknown */
+long IPEMAuditoryModel_Normalization(const char* inName);
+
+/* The kernel called inName ("double" or "fixed"), -1 if unknown */
+long IPEMAuditoryModel_Kernel(const char* inName);
+
+/* The sample frequency (Hz) set up on this thread: the model takes the samples
+   of a sound file to be at this rate, so ranges (in s) are counted at it too */
+double IPEMAuditoryModel_SampleFrequency();
+
+/* All settings are kept per thread: different threads can set up and run
+   the model at the same time */
+long IPEMAuditoryModel_Process();
+
+#if defined(__cplusplus)
+}
+#endif
 
 
 
@@ -0,0 +1,379 @@
+// --------------------------------------------------------------------------------
+//  IPEMAuditoryModelBatch.cpp
+// --------------------------------------------------------------------------------
+//  Analysis of a batch of sound files (see IPEMAuditoryModelBatch.h).
+//
+//  The cost of a task is the duration of the signal it analyses (with the pre-roll
+//  for a segment): the model takes about the same time per second of signal for
+//  any sound. The last task to finish a segment of a file appends all the
+//  segments of that file that can be appended in order, outside the lock, so that
+//  the other threads go on with their next task meanwhile.
+// --------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+// Includes
+#include "IPEMAuditoryModelBatch.h"
+#include "aniio.h"
+#include "decoder.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef CRITICAL_SECTION Mutex;
+static void InitMutex (Mutex* inMutex) { InitializeCriticalSection(inMutex); }
+static void Lock (Mutex* inMutex) { EnterCriticalSection(inMutex); }
+static void Unlock (Mutex* inMutex) { LeaveCriticalSection(inMutex); }
+static void FreeMutex (Mutex* inMutex) { DeleteCriticalSection(inMutex); }
+#else
+#include <pthread.h>
+typedef pthread_mutex_t Mutex;
+static void InitMutex (Mutex* inMutex) { pthread_mutex_init(inMutex,NULL); }
+static void Lock (Mutex* inMutex) { pthread_mutex_lock(inMutex); }
+static void Unlock (Mutex* inMutex) { pthread_mutex_unlock(inMutex); }
+static void FreeMutex (Mutex* inMutex) { pthread_mutex_destroy(inMutex); }
+#endif
+
+// Constants
+// ---------
+const double	cSplitFactor = 1.5;			// files up to this many segments stay whole
+const double	cMinSegmentLength = 10;		// (s) the pre-roll is a small part of it
+const long		cTasksPerWorker = 8;		// at least, if the segments can be short enough
+const double	cDefPreRoll = 0.5;			// (s) default of IPEMAuditoryModel_SetRange
+const long		cCopyBufferSize = 65536;
+
+// Types
+// -----
+struct BatchFile
+{
+	const char*	mInput;
+	const char*	mOutput;
+	long		mFirstTask;
+	long long	mLength;			// (samples), -1 if not known
+	double		mRate;				// (Hz) the model takes the samples to be at
+	double		mDuration;			// (s)
+	long		mNumOfSegments;		// 1: analysed whole
+	long		mNextSegment;		// first segment not yet appended
+	bool		mAppending;			// a thread is appending segments
+	bool		mFailed;
+	bool		mBinary;			// (of the segments)
+	FILE*		mFile;				// output of a split file, while appending
+	long long	mNumOfFrames;		// appended so far (binary)
+};
+
+struct BatchTask
+{
+	long		mFile;
+	long		mSegment;
+	double		mStart;				// (s)
+	double		mDuration;			// (s), -1: up to the end
+	double		mCost;
+	FILE*		mOutput;			// temporary file of a segment
+	bool		mDone;
+	bool		mFailed;
+};
+
+struct Batch
+{
+	BatchFile*	mFiles;
+	BatchTask*	mTasks;
+	double		mPreRoll;
+	IPEMAuditoryModelBatchSetup	mSetup;
+	void*		mContext;
+	const log_sink*	mLogSink;
+	double		mBusy;				// (s) summed over the tasks
+	Mutex		mLock;
+};
+
+// -----------------------------------------------------------------------------
+//	SignalLength
+// -----------------------------------------------------------------------------
+// Returns the number of samples (per channel) of a sound file, -1 if the header
+// does not tell or the file cannot be read; outSize is the size of the file
+static long long SignalLength (const char* inFileName, long& outSize)
+{
+	FILE* theFile = fopen(inFileName,"rb");
+	outSize = 0;
+	if (theFile == NULL) return -1;
+	decoder theDecoder;
+	long long theLength = -1;
+	if (decoder_open(&theDecoder,theFile))
+	{
+		theLength = theDecoder.frames;
+		decoder_close(&theDecoder);
+	}
+	if (fseek(theFile,0,SEEK_END) == 0) outSize = ftell(theFile);
+	fclose(theFile);
+	return theLength;
+}
+
+// -----------------------------------------------------------------------------
+//	CopyRest
+// -----------------------------------------------------------------------------
+// Copies inSource from its current position up to the end to outDestination
+static bool CopyRest (FILE* inSource, FILE* outDestination)
+{
+	char theBuffer[cCopyBufferSize];
+	size_t theCount;
+	while ((theCount = fread(theBuffer,1,sizeof(theBuffer),inSource)) > 0)
+		if (fwrite(theBuffer,1,theCount,outDestination) != theCount) return false;
+	return !ferror(inSource);
+}
+
+// -----------------------------------------------------------------------------
+//	AppendSegment
+// -----------------------------------------------------------------------------
+// Appends the ANI of a segment to the output of its file. A binary ANI takes the
+// header of the first segment (its frames start at time 0), and the number of
+// frames is set once the last segment is in. A text ANI is just the lines.
+static bool AppendSegment (BatchFile& ioFile, BatchTask& inTask)
+{
+	ani_header theHeader;
+	bool theResult = true;
+
+	rewind(inTask.mOutput);
+	size_t theSize = fread(&theHeader,1,sizeof(theHeader),inTask.mOutput);
+	bool theBinary = (theSize == sizeof(theHeader))
+		&& (memcmp(theHeader.magic,ani_magic,sizeof(theHeader.magic)) == 0);
+	rewind(inTask.mOutput);
+	if (inTask.mSegment == 0)
+	{
+		ioFile.mBinary = theBinary;
+		ioFile.mNumOfFrames = 0;
+		ioFile.mFile = fopen(ioFile.mOutput,"wb");
+		if (ioFile.mFile == NULL) return false;
+	}
+	else if (theBinary != ioFile.mBinary) theResult = false;
+	else if (theBinary && (fseek(inTask.mOutput,theHeader.header_size,SEEK_SET) != 0))
+		theResult = false;
+	if (theResult) theResult = CopyRest(inTask.mOutput,ioFile.mFile);
+	if (theBinary) ioFile.mNumOfFrames += theHeader.nframes;
+
+	if (inTask.mSegment == ioFile.mNumOfSegments - 1)
+	{
+		if (theResult && ioFile.mBinary)
+			theResult = (fseek(ioFile.mFile,offsetof(ani_header,nframes),SEEK_SET) == 0)
+				&& (fwrite(&ioFile.mNumOfFrames,sizeof(ioFile.mNumOfFrames),1,ioFile.mFile) == 1);
+		if (fclose(ioFile.mFile) != 0) theResult = false;
+		ioFile.mFile = NULL;
+	}
+	return theResult;
+}
+
+// -----------------------------------------------------------------------------
+//	SegmentDone
+// -----------------------------------------------------------------------------
+// Records that a segment is done and, unless another thread is at it, appends
+// the segments of its file that are next in order
+static void SegmentDone (Batch& ioBatch, BatchTask& ioTask)
+{
+	BatchFile& theFile = ioBatch.mFiles[ioTask.mFile];
+
+	Lock(&ioBatch.mLock);
+	ioTask.mDone = true;
+	if (ioTask.mFailed) theFile.mFailed = true;
+	if (theFile.mAppending)
+	{
+		Unlock(&ioBatch.mLock);
+		return;
+	}
+	theFile.mAppending = true;
+	while ((theFile.mNextSegment < theFile.mNumOfSegments)
+		&& ioBatch.mTasks[theFile.mFirstTask + theFile.mNextSegment].mDone)
+	{
+		BatchTask& theTask = ioBatch.mTasks[theFile.mFirstTask + theFile.mNextSegment];
+		bool theFailed = theFile.mFailed;
+		Unlock(&ioBatch.mLock);
+
+		if (!theFailed) theFailed = !AppendSegment(theFile,theTask);
+		if (theTask.mOutput != NULL) fclose(theTask.mOutput);	// and removes it
+		theTask.mOutput = NULL;
+
+		Lock(&ioBatch.mLock);
+		if (theFailed) theFile.mFailed = true;
+		theFile.mNextSegment++;
+	}
+	theFile.mAppending = false;
+	Unlock(&ioBatch.mLock);
+}
+
+// -----------------------------------------------------------------------------
+//	RunTask
+// -----------------------------------------------------------------------------
+static void RunTask (void* inBatch, long inIndex)
+{
+	Batch& theBatch = *(Batch*)inBatch;
+	BatchTask& theTask = theBatch.mTasks[inIndex];
+	BatchFile& theFile = theBatch.mFiles[theTask.mFile];
+	double theStart = log_clock();
+
+	theBatch.mSetup(theBatch.mContext,theFile.mInput,theFile.mOutput);
+	IPEMAuditoryModel_SetLogSink(theBatch.mLogSink);
+	if (theFile.mNumOfSegments > 1)
+	{
+		theTask.mOutput = tmpfile();
+		IPEMAuditoryModel_SetRange(theTask.mStart,theTask.mDuration,theBatch.mPreRoll);
+		IPEMAuditoryModel_SetOutputStream(theTask.mOutput);
+	}
+	if ((theFile.mNumOfSegments > 1) && (theTask.mOutput == NULL))
+		theTask.mFailed = true;
+	else
+		theTask.mFailed = (IPEMAuditoryModel_Process() != 0);
+
+	if (theFile.mNumOfSegments > 1) SegmentDone(theBatch,theTask);
+	Lock(&theBatch.mLock);
+	if ((theFile.mNumOfSegments == 1) && theTask.mFailed) theFile.mFailed = true;
+	theBatch.mBusy += log_clock() - theStart;
+	Unlock(&theBatch.mLock);
+}
+
+// -----------------------------------------------------------------------------
+//	IPEMAuditoryModelBatch_Run
+// -----------------------------------------------------------------------------
+long IPEMAuditoryModelBatch_Run (long inNumOfFiles,
+						const char* const* inInputFileNames,
+						const char* const* inOutputFileNames,
+						long inNumOfWorkers, double inSegmentLength, double inPreRoll,
+						IPEMAuditoryModelBatchSetup inSetup, void* inContext,
+						const log_sink* inLogSink)
+{
+	Batch theBatch;
+	long theNumOfTasks = 0;
+	long theNumOfSplit = 0;
+	long theNumOfFailed = 0;
+	long f, s;
+
+	if (inNumOfFiles <= 0) return 0;
+	if (inSegmentLength < 0) inSegmentLength = cBatchDefSegmentLength;
+	if (inNumOfWorkers <= 0) inNumOfWorkers = parallel_threads();
+	theBatch.mPreRoll = inPreRoll;
+	theBatch.mSetup = inSetup;
+	theBatch.mContext = inContext;
+	theBatch.mLogSink = inLogSink;
+	theBatch.mBusy = 0;
+	log_set_sink(inLogSink);
+
+	// Measure the files. The model takes the samples to be at the sample
+	// frequency it is set up with (not that of the file), so the duration in
+	// seconds is counted at that rate.
+	theBatch.mFiles = (BatchFile*)calloc(inNumOfFiles,sizeof(BatchFile));
+	if (theBatch.mFiles == NULL)
+	{
+		log_message(log_error,"out of memory");
+		log_set_sink(NULL);
+		return inNumOfFiles;
+	}
+	double theTotal = 0;
+	for (f = 0; f < inNumOfFiles; f++)
+	{
+		BatchFile& theFile = theBatch.mFiles[f];
+		long theSize;
+		theFile.mInput = inInputFileNames[f];
+		theFile.mOutput = inOutputFileNames[f];
+		inSetup(inContext,theFile.mInput,theFile.mOutput);
+		theFile.mRate = IPEMAuditoryModel_SampleFrequency();
+		theFile.mLength = SignalLength(theFile.mInput,theSize);
+		if (theFile.mLength >= 0) theFile.mDuration = theFile.mLength/theFile.mRate;
+		else theFile.mDuration = theSize/(2*theFile.mRate);	// as if 16 bit mono
+		theTotal += theFile.mDuration;
+	}
+
+	// Split the long files, in shorter segments if there would not be enough
+	// tasks for the threads to finish together
+	if (inSegmentLength > theTotal/(cTasksPerWorker*inNumOfWorkers))
+		inSegmentLength = theTotal/(cTasksPerWorker*inNumOfWorkers);
+	if ((inSegmentLength > 0) && (inSegmentLength < cMinSegmentLength))
+		inSegmentLength = cMinSegmentLength;
+	for (f = 0; f < inNumOfFiles; f++)
+	{
+		BatchFile& theFile = theBatch.mFiles[f];
+		theFile.mFirstTask = theNumOfTasks;
+		theFile.mNumOfSegments = 1;
+		if ((inSegmentLength > 0) && (theFile.mLength > 0)
+			&& (theFile.mDuration > cSplitFactor*inSegmentLength))
+		{
+			theFile.mNumOfSegments = (long)floor(theFile.mDuration/inSegmentLength + 0.5);
+			theNumOfSplit++;
+		}
+		theNumOfTasks += theFile.mNumOfSegments;
+	}
+
+	// One task per segment; the boundaries are whole samples, so that the
+	// segments of a file add up to exactly its frames
+	theBatch.mTasks = (BatchTask*)calloc(theNumOfTasks,sizeof(BatchTask));
+	double* theCosts = (double*)malloc(theNumOfTasks*sizeof(double));
+	if ((theBatch.mTasks == NULL) || (theCosts == NULL))
+	{
+		log_message(log_error,"out of memory");
+		free(theBatch.mFiles); free(theBatch.mTasks); free(theCosts);
+		log_set_sink(NULL);
+		return inNumOfFiles;
+	}
+	double thePreRoll = (inPreRoll >= 0) ? inPreRoll : cDefPreRoll;
+	for (f = 0; f < inNumOfFiles; f++)
+	{
+		BatchFile& theFile = theBatch.mFiles[f];
+		for (s = 0; s < theFile.mNumOfSegments; s++)
+		{
+			BatchTask& theTask = theBatch.mTasks[theFile.mFirstTask + s];
+			long long theFirst = theFile.mLength*s/theFile.mNumOfSegments;
+			long long theNext = theFile.mLength*(s + 1)/theFile.mNumOfSegments;
+			theTask.mFile = f;
+			theTask.mSegment = s;
+			theTask.mStart = (s > 0) ? theFirst/theFile.mRate : -1;
+			theTask.mDuration = (s < theFile.mNumOfSegments - 1) ? (theNext - theFirst)/theFile.mRate : -1;
+			theTask.mCost = (theFile.mNumOfSegments == 1) ? theFile.mDuration
+				: (theNext - theFirst)/theFile.mRate + ((s > 0) ? thePreRoll : 0);
+			if (theTask.mCost <= 0) theTask.mCost = 1;	// unreadable: fails quickly
+			theCosts[theFile.mFirstTask + s] = theTask.mCost;
+		}
+	}
+
+	// Run
+	InitMutex(&theBatch.mLock);
+	double theStart = log_clock();
+	parallel_steal(theNumOfTasks,theCosts,inNumOfWorkers,RunTask,&theBatch);
+	double theTime = log_clock() - theStart;
+	FreeMutex(&theBatch.mLock);
+
+	log_set_sink(inLogSink);
+	for (f = 0; f < inNumOfFiles; f++)
+		if (theBatch.mFiles[f].mFailed)
+		{
+			if (theBatch.mFiles[f].mFile != NULL) fclose(theBatch.mFiles[f].mFile);
+			log_message(log_error,"%s could not be analysed",theBatch.mFiles[f].mInput);
+			remove(theBatch.mFiles[f].mOutput);
+			theNumOfFailed++;
+		}
+	if (inNumOfWorkers > theNumOfTasks) inNumOfWorkers = theNumOfTasks;
+	log_message(log_info,"batch: %ld files (%ld split) in %ld tasks on %ld threads, %.1f s, %.1f %% busy",
+				inNumOfFiles,theNumOfSplit,theNumOfTasks,inNumOfWorkers,theTime,
+				(theTime > 0) ? 100*theBatch.mBusy/(inNumOfWorkers*theTime) : 100.0);
+	log_set_sink(NULL);
+
+	free(theBatch.mFiles); free(theBatch.mTasks);
+	free(theCosts);
+	return theNumOfFailed;
+}
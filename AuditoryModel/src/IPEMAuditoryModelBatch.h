@@ -0,0 +1,76 @@
+// --------------------------------------------------------------------------------
+//  IPEMAuditoryModelBatch.h
+// --------------------------------------------------------------------------------
+//  Analysis of a batch of sound files on several threads.
+//
+//  Files of up to 1.5 segment lengths are analysed whole (one task each); longer
+//  files are split into segments of about one segment length, each analysed as a
+//  range with a pre-roll (see IPEMAuditoryModel_SetRange). The segments are made
+//  shorter (down to 10 s) when the batch would otherwise have fewer than 8 tasks
+//  per thread. The tasks are run with
+//  work stealing (parallel_steal, see analysis/parallel.h), so that a few long
+//  recordings among many short ones do not keep one thread busy while the others
+//  are idle. The ANI of a segment goes to a temporary file; the segments of a file
+//  are appended to its output, in order, as soon as all the ones before are done.
+//
+//  The frames of a split file are the frames of the whole file, except that the
+//  model has only settled for the pre-roll at the start of each segment, and that
+//  the decay after the end of the signal may be a few frames longer or shorter.
+// --------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "IPEMAuditoryModel.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define cBatchDefSegmentLength	60.0	// (s)
+
+/* Sets up the model for one task, on the thread that will run it: calls
+   IPEMAuditoryModel_Setup with inInputFileName and inOutputFileName and then
+   any of the other setters. The batch then selects the range, the output (for a
+   segment) and the log sink of the task. The settings must not depend on the
+   whole file (a normalization, a range, a pitch or pyramid file), unless the
+   files are analysed whole (inSegmentLength <= 0). */
+typedef void (*IPEMAuditoryModelBatchSetup)(void* inContext,
+						const char* inInputFileName, const char* inOutputFileName);
+
+/* Analyses the sound files inInputFileNames[0..inNumOfFiles-1] to the ANI files
+   inOutputFileNames[..] on inNumOfWorkers threads (<= 0: one per processor).
+   Files longer than inSegmentLength seconds (-1: cBatchDefSegmentLength, 0: none)
+   are split, with a pre-roll of inPreRoll seconds (-1: the default of
+   IPEMAuditoryModel_SetRange). The messages of the batch (a summary with the
+   fraction of the time the threads were busy) and of the tasks go to inLogSink.
+   Returns the number of files that could not be analysed; their output files are
+   removed. */
+long IPEMAuditoryModelBatch_Run(long inNumOfFiles,
+						const char* const* inInputFileNames,
+						const char* const* inOutputFileNames,
+						long inNumOfWorkers, double inSegmentLength, double inPreRoll,
+						IPEMAuditoryModelBatchSetup inSetup, void* inContext,
+						const log_sink* inLogSink);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -14,13 +14,44 @@
 //			-nc		number of channels
 //			-f1		frequency of first channel
 //			-fd		frequency distance between adjecent channels
+//			-sc		scale of the channels (cbu, erb, bark or hz)
+//			-cl		list of channel positions on that scale (e.g. 3,4.5,7)
 //			-if		input file name
 //			-id		input file path
 //			-of		output file name
 //			-od		output file path
 //			-ss		signal's sampling frequency
-//			-ff		sound file format (either 0 for wav, or 1 for snd)
+//			-ff		sound file format (wav, snd, aiff or flac; informative only,
+//					the format is recognized from the file's header)
+//			-ot		output file type (either txt or bin)
+//			-ts		start of the part of the signal to analyse (s)
+//			-td		duration of that part (s)
+//			-tp		pre-roll analysed (and dropped) before it (s)
+//			-nm		normalization of the input (none, peak or rms)
+//			-nl		RMS level for -nm rms (dB)
+//			-kn		kernel of the model (double or fixed)
+//			-pf		pitch track file (T0, evidence, vuv per frame)
+//			-zf		pyramid file (ANI at ever coarser time scales, for zooming)
+//			-zl		number of levels of the pyramid
+//			-lv		level of the messages written to stdout (0 = errors,
+//					1 = warnings, 2 = one line per analysis, 3 = details)
+//			-cd		directory of the ANI cache
+//			-cs		maximum size of the ANI cache (MB)
 //			-i		start interactive session (see above)
+//	- server:
+//		"IPEMAuditoryModelConsole -server <socket> [-nw <workers>]" serves
+//		requests on a UNIX domain socket (see IPEMAuditoryModelServer.h).
+//	- batch:
+//		"IPEMAuditoryModelConsole -batch <list> [-nw <workers>] [-sg <seconds>]
+//		[options]" analyses the sound files named in the list file, one per line
+//		(optionally followed by a tab and the name of the output file; by default
+//		that of the sound file with extension .ani), on several threads, long
+//		files in segments of -sg seconds (see IPEMAuditoryModelBatch.h). The model
+//		options apply to every file; -ts, -td, -pf and -zf are refused, -tp is the
+//		pre-roll of the segments, and with -nm the files are analysed whole.
+//	With "-nn <nodes>", the server or batch threads are pinned to the processors
+//	of that many NUMA nodes, spread over the nodes, each with its thread local
+//	model state on its own node (Linux; see parallel.h).
 // -----------------------------------------------------------------------------
 
 /*------------------------------------------------------------------------------
@@ -44,9 +75,40 @@
 
 // Includes
 #include "IPEMAuditoryModel.h" //name extension changed from .hpp to .h by S.T. for compatibility with the C version for linux
+#include "IPEMAuditoryModelServer.h"
+#include "IPEMAuditoryModelBatch.h"
+#include "parallel.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// -----------------------------------------------------------------------------
+//	ReadLine
+// -----------------------------------------------------------------------------
+// Reads one line from standard input (without the trailing newline)
+static void ReadLine (char* outBuffer, int inSize)
+{
+	if (fgets(outBuffer,inSize,stdin) == NULL) outBuffer[0] = '\0';
+	outBuffer[strcspn(outBuffer,"\r\n")] = '\0';
+}
+
+// -----------------------------------------------------------------------------
+//	CopyArgument
+// -----------------------------------------------------------------------------
+// Copies a name from the command line into one of the buffers of main (of
+// IPEMAuditoryModel_MaxNameLength characters and the terminating zero)
+static bool CopyArgument (char* outBuffer, const char* inArgument)
+{
+	if (strlen(inArgument) > IPEMAuditoryModel_MaxNameLength)
+	{
+		printf("ERROR: name longer than %d characters: %s\n",
+						IPEMAuditoryModel_MaxNameLength,inArgument);
+		return false;
+	}
+	strcpy(outBuffer,inArgument);
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 //	DoInteractiveSession
 // -----------------------------------------------------------------------------
@@ -56,43 +118,54 @@ bool DoInteractiveSession (long& outNumOfChannels,
 							double& outFirstFreq, double& outFreqDist,
 							char* outInputFileName, char* outInputFilePath,
 							char* outOutputFileName, char* outOutputFilePath,
-							double& outSampleFrequency, long& outSoundFileFormat)
+							double& outSampleFrequency, long& outSoundFileFormat,
+							long& outOutputFormat)
 {
 	// Note: this is a working 'quick-and-dirty' version.
 	// When the time is right or the needs are high, this could be improved...
 	char theBuffer[256];
 	printf("\n");
 	printf("Number of channels: ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) outNumOfChannels = atol(theBuffer);
 	printf("Frequency of first channel (cbu): ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) outFirstFreq = atof(theBuffer);
 	printf("Frequency distance between adjecent channels (cbu): ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) outFreqDist = atof(theBuffer);
 	printf("Name of input file: ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) strcpy(outInputFileName,theBuffer);
 	printf("Path to input file: ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) strcpy(outInputFilePath,theBuffer);
 	printf("Name of output file: ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) strcpy(outOutputFileName,theBuffer);
 	printf("Path to output file: ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) strcpy(outOutputFileName,theBuffer);
 	printf("Signal's sample frequency (Hz): ");
-	gets(theBuffer);
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0) outSampleFrequency = atof(theBuffer);
-	printf("Signal's file format (0 = wav, 1 = snd): ");
-	gets(theBuffer);
+	printf("Signal's file format (0 = wav, 1 = snd, 2 = aiff, 3 = flac): ");
+	ReadLine(theBuffer,sizeof(theBuffer));
+	if (strlen(theBuffer) != 0)
+	{
+		long theValue = atol(theBuffer);
+		if (theValue == 1)		outSoundFileFormat = sffSnd;
+		else if (theValue == 2)	outSoundFileFormat = sffAiff;
+		else if (theValue == 3)	outSoundFileFormat = sffFlac;
+		else					outSoundFileFormat = sffWav;
+	}
+	printf("Output file type (0 = txt, 1 = bin): ");
+	ReadLine(theBuffer,sizeof(theBuffer));
 	if (strlen(theBuffer) != 0)
 	{
 		long theValue = atol(theBuffer);
-		if (theValue == 1)	outSoundFileFormat = IPEMAuditoryModel::sffSnd;
-		else				outSoundFileFormat = IPEMAuditoryModel::sffWav;
+		if (theValue == 1)	outOutputFormat = aofBinary;
+		else				outOutputFormat = aofText;
 	}
 
 	return true;
@@ -113,12 +186,34 @@ void ShowCorrectUsage (const char* inApplicationName)
 	printf(" -nc integer    number of channels (max. 40)\n");
 	printf(" -f1 double     first channel frequency (cbu)\n");
 	printf(" -fd double     distance between channel frequencies (cbu)\n");
+	printf(" -sc string     scale of -f1, -fd and -cl (cbu (default), erb, bark or hz)\n");
+	printf(" -cl string     comma separated channel positions, instead of -nc, -f1 and -fd\n");
 	printf(" -if string     name of the input file\n");
 	printf(" -id string     path to the input file\n");
 	printf(" -of string     name of the output file\n");
 	printf(" -od string     path to the output file\n");
 	printf(" -fs double     signal's sample frequency (Hz)\n");
-	printf(" -ff string     signal's file format (either wav or snd)\n");
+	printf(" -ff string     signal's file format (wav, snd, au, aiff or flac)\n");
+	printf(" -ot string     output file type (either txt or bin)\n");
+	printf(" -ts double     only analyse the signal from this time (s) on\n");
+	printf(" -td double     ... during this time (s) (default: up to the end)\n");
+	printf(" -tp double     pre-roll to let the model settle (s) (default: 0.5)\n");
+	printf(" -nm string     normalize the input: none (default), peak (0.75) or rms\n");
+	printf(" -nl double     RMS level of -nm rms (dB) (default: -20)\n");
+	printf(" -kn string     arithmetic of the model: double (default) or fixed (32 bit,\n");
+	printf("                reproducible on every host, about 4x slower)\n");
+	printf(" -pf string     also write a pitch track (T0, evidence, vuv) to this file\n");
+	printf(" -zf string     also write a pyramid of the ANI (4x coarser per level) to this file\n");
+	printf(" -zl integer    number of levels of the pyramid (default: 6, max. 12)\n");
+	printf(" -lv integer    messages: 0 errors, 1 warnings, 2 summary (default), 3 details\n");
+	printf(" -cd string     directory of the ANI cache (default: no cache)\n");
+	printf(" -cs double     maximum size of the ANI cache (MB)\n");
+	printf(" -server string serve requests on this UNIX domain socket\n");
+	printf(" -batch string  analyse the sound files listed in this file, one per line\n");
+	printf(" -sg double     length of the segments of long files in a batch (s) (default: 60)\n");
+	printf(" -nw integer    number of server or batch threads (default: one per processor)\n");
+	printf(" -nn integer    pin the server or batch threads to the processors of this many\n");
+	printf("                NUMA nodes (Linux) (default: 0, not pinned)\n");
 	printf("If you do not specify a certain option, the default is used.\n");
 	printf("Use '%s -i' to start an interactive session.\n",inApplicationName);
 	printf("(Version of 19991108)");
@@ -133,7 +228,20 @@ bool DoCommandLineParsing (int inNumOfArguments, char* inArguments[],
 							double& outFirstFreq, double& outFreqDist,
 							char* outInputFileName, char* outInputFilePath,
 							char* outOutputFileName, char* outOutputFilePath,
-							double& outSampleFrequency, long& outSoundFileFormat)
+							double& outSampleFrequency, long& outSoundFileFormat,
+							long& outOutputFormat,
+							char* outPitchFileName,
+							char* outPyramidFileName, long& outPyramidLevels,
+							long& outLogLevel,
+							long& outChannelScale,
+							double* outChannelPositions, long& outNumOfPositions,
+							double& outStart, double& outDuration, double& outPreRoll,
+							long& outNormalization, double& outLevel,
+							long& outKernel,
+							char* outCacheDirectory, double& outCacheSize,
+							char* outSocketPath, long& outNumOfWorkers,
+							char* outBatchFileName, double& outSegmentLength,
+							long& outNumOfNodes)
 {
 	bool theResult = true;
 
@@ -159,21 +267,40 @@ bool DoCommandLineParsing (int inNumOfArguments, char* inArguments[],
 			{
 				outFreqDist = atof(inArguments[theIndex++]);
 			}
+			else if (strcmp(theArgument,"-sc") == 0)
+			{
+				outChannelScale = IPEMAuditoryModel_ChannelScale(inArguments[theIndex++]);
+				if (outChannelScale == -1) theResult = false;
+			}
+			else if (strcmp(theArgument,"-cl") == 0)
+			{
+				char* thePosition = inArguments[theIndex++];
+				char* theEnd;
+				outNumOfPositions = 0;
+				while (theResult && (outNumOfPositions < 256))
+				{
+					outChannelPositions[outNumOfPositions++] = strtod(thePosition,&theEnd);
+					if (theEnd == thePosition) theResult = false;
+					else if (*theEnd == ',') thePosition = theEnd + 1;
+					else if (*theEnd == '\0') break;
+					else theResult = false;
+				}
+			}
 			else if (strcmp(theArgument,"-if") == 0)
 			{
-				strcpy(outInputFileName,inArguments[theIndex++]);
+				if (!CopyArgument(outInputFileName,inArguments[theIndex++])) theResult = false;
 			}
 			else if (strcmp(theArgument,"-id") == 0)
 			{
-				strcpy(outInputFilePath,inArguments[theIndex++]);
+				if (!CopyArgument(outInputFilePath,inArguments[theIndex++])) theResult = false;
 			}
 			else if (strcmp(theArgument,"-of") == 0)
 			{
-				strcpy(outOutputFileName,inArguments[theIndex++]);
+				if (!CopyArgument(outOutputFileName,inArguments[theIndex++])) theResult = false;
 			}
 			else if (strcmp(theArgument,"-od") == 0)
 			{
-				strcpy(outOutputFilePath,inArguments[theIndex++]);
+				if (!CopyArgument(outOutputFilePath,inArguments[theIndex++])) theResult = false;
 			}
 			else if (strcmp(theArgument,"-fs") == 0)
 			{	
@@ -181,8 +308,89 @@ bool DoCommandLineParsing (int inNumOfArguments, char* inArguments[],
 			}
 			else if (strcmp(theArgument,"-ff") == 0)
 			{
-				if (strcmp(inArguments[theIndex],"wav") == 0) outSoundFileFormat = IPEMAuditoryModel::sffWav;
-				else if (strcmp(inArguments[theIndex],"snd") == 0) outSoundFileFormat = IPEMAuditoryModel::sffSnd;
+				if (strcmp(inArguments[theIndex],"wav") == 0) outSoundFileFormat = sffWav;
+				else if (strcmp(inArguments[theIndex],"snd") == 0) outSoundFileFormat = sffSnd;
+				else if (strcmp(inArguments[theIndex],"au") == 0) outSoundFileFormat = sffSnd;
+				else if (strcmp(inArguments[theIndex],"aiff") == 0) outSoundFileFormat = sffAiff;
+				else if (strcmp(inArguments[theIndex],"flac") == 0) outSoundFileFormat = sffFlac;
+				else
+					theResult = false;
+				theIndex++;
+			}
+			else if (strcmp(theArgument,"-ts") == 0)
+			{
+				outStart = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-td") == 0)
+			{
+				outDuration = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-tp") == 0)
+			{
+				outPreRoll = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-nm") == 0)
+			{
+				outNormalization = IPEMAuditoryModel_Normalization(inArguments[theIndex++]);
+				if (outNormalization == -1) theResult = false;
+			}
+			else if (strcmp(theArgument,"-nl") == 0)
+			{
+				outLevel = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-kn") == 0)
+			{
+				outKernel = IPEMAuditoryModel_Kernel(inArguments[theIndex++]);
+				if (outKernel == -1) theResult = false;
+			}
+			else if (strcmp(theArgument,"-pf") == 0)
+			{
+				if (!CopyArgument(outPitchFileName,inArguments[theIndex++])) theResult = false;
+			}
+			else if (strcmp(theArgument,"-zf") == 0)
+			{
+				if (!CopyArgument(outPyramidFileName,inArguments[theIndex++])) theResult = false;
+			}
+			else if (strcmp(theArgument,"-zl") == 0)
+			{
+				outPyramidLevels = atol(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-lv") == 0)
+			{
+				outLogLevel = atol(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-cd") == 0)
+			{
+				if (!CopyArgument(outCacheDirectory,inArguments[theIndex++])) theResult = false;
+			}
+			else if (strcmp(theArgument,"-cs") == 0)
+			{
+				outCacheSize = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-server") == 0)
+			{
+				if (!CopyArgument(outSocketPath,inArguments[theIndex++])) theResult = false;
+			}
+			else if (strcmp(theArgument,"-nw") == 0)
+			{
+				outNumOfWorkers = atol(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-nn") == 0)
+			{
+				outNumOfNodes = atol(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-batch") == 0)
+			{
+				if (!CopyArgument(outBatchFileName,inArguments[theIndex++])) theResult = false;
+			}
+			else if (strcmp(theArgument,"-sg") == 0)
+			{
+				outSegmentLength = atof(inArguments[theIndex++]);
+			}
+			else if (strcmp(theArgument,"-ot") == 0)
+			{
+				if (strcmp(inArguments[theIndex],"txt") == 0) outOutputFormat = aofText;
+				else if (strcmp(inArguments[theIndex],"bin") == 0) outOutputFormat = aofBinary;
 				else
 					theResult = false;
 				theIndex++;
@@ -195,6 +403,93 @@ bool DoCommandLineParsing (int inNumOfArguments, char* inArguments[],
 	return theResult;
 }
 
+// -----------------------------------------------------------------------------
+//	ReadBatchList
+// -----------------------------------------------------------------------------
+// Reads the list of a batch (see the -batch option above); empty lines and lines
+// starting with '#' are skipped. Returns the number of files, -1 if the list
+// cannot be read.
+static long ReadBatchList (const char* inFileName, char**& outInputs, char**& outOutputs)
+{
+	FILE* theFile = fopen(inFileName,"r");
+	if (theFile == NULL) return -1;
+	long theNumOfFiles = 0;
+	long theCapacity = 0;
+	char theLine[2*256];
+	while (fgets(theLine,sizeof(theLine),theFile) != NULL)
+	{
+		theLine[strcspn(theLine,"\r\n")] = '\0';
+		if ((theLine[0] == '\0') || (theLine[0] == '#')) continue;
+		char* theOutput = strchr(theLine,'\t');
+		if (theOutput != NULL) *theOutput++ = '\0';
+		if ((strlen(theLine) > 250) || ((theOutput != NULL) && (strlen(theOutput) > 250)))
+		{
+			printf("ERROR: file name too long in %s\n",inFileName);
+			continue;
+		}
+		if (theNumOfFiles == theCapacity)
+		{
+			theCapacity = (theCapacity == 0) ? 64 : 2*theCapacity;
+			outInputs = (char**)realloc(outInputs,theCapacity*sizeof(char*));
+			outOutputs = (char**)realloc(outOutputs,theCapacity*sizeof(char*));
+			if ((outInputs == NULL) || (outOutputs == NULL)) { fclose(theFile); return -1; }
+		}
+		outInputs[theNumOfFiles] = (char*)malloc(256);
+		outOutputs[theNumOfFiles] = (char*)malloc(256);
+		strcpy(outInputs[theNumOfFiles],theLine);
+		if (theOutput != NULL) strcpy(outOutputs[theNumOfFiles],theOutput);
+		else
+		{
+			// the name of the sound file, with extension .ani
+			strcpy(outOutputs[theNumOfFiles],theLine);
+			char* theDot = strrchr(outOutputs[theNumOfFiles],'.');
+			if ((theDot == NULL) || (strchr(theDot,'/') != NULL))
+				theDot = outOutputs[theNumOfFiles] + strlen(outOutputs[theNumOfFiles]);
+			strcpy(theDot,".ani");
+		}
+		theNumOfFiles++;
+	}
+	fclose(theFile);
+	return theNumOfFiles;
+}
+
+// -----------------------------------------------------------------------------
+//	BatchSettings
+// -----------------------------------------------------------------------------
+// The model options of the command line, applied to each task of a batch
+struct BatchSettings
+{
+	long			mNumOfChannels;
+	double			mFirstFrequency;
+	double			mFrequencyDistance;
+	double			mSampleFrequency;
+	long			mOutputFormat;
+	long			mChannelScale;
+	const double*	mChannelPositions;
+	long			mNumOfPositions;
+	long			mNormalization;
+	double			mLevel;
+	long			mKernel;
+	const char*		mCacheDirectory;
+	double			mCacheSize;
+};
+
+static void SetupBatchTask (void* inSettings, const char* inInputFileName,
+							const char* inOutputFileName)
+{
+	BatchSettings& theSettings = *(BatchSettings*)inSettings;
+	IPEMAuditoryModel_Setup(theSettings.mNumOfChannels,
+						theSettings.mFirstFrequency, theSettings.mFrequencyDistance,
+						inInputFileName, NULL, inOutputFileName, NULL,
+						theSettings.mSampleFrequency, -1);
+	IPEMAuditoryModel_SetOutputFormat(theSettings.mOutputFormat);
+	IPEMAuditoryModel_SetCache(theSettings.mCacheDirectory,theSettings.mCacheSize);
+	IPEMAuditoryModel_SetChannels(theSettings.mChannelScale,
+						theSettings.mChannelPositions, theSettings.mNumOfPositions);
+	IPEMAuditoryModel_SetNormalization(theSettings.mNormalization,theSettings.mLevel);
+	IPEMAuditoryModel_SetKernel(theSettings.mKernel);
+}
+
 // -----------------------------------------------------------------------------
 //	main
 // -----------------------------------------------------------------------------
@@ -204,12 +499,33 @@ int main (int inNumOfArguments, char* inArguments[])
 	long theNumOfChannels = -1;
 	double theFirstFrequency = -1.0;
 	double theFrequencyDistance = -1.0;
-	char theInputFileName[256]; theInputFileName[0] = '\0';
-	char theInputFilePath[256]; theInputFilePath[0] = '\0';
-	char theOutputFileName[256]; theOutputFileName[0] = '\0';
-	char theOutputFilePath[256]; theOutputFilePath[0] = '\0';
+	char theInputFileName[IPEMAuditoryModel_MaxNameLength+1]; theInputFileName[0] = '\0';
+	char theInputFilePath[IPEMAuditoryModel_MaxNameLength+1]; theInputFilePath[0] = '\0';
+	char theOutputFileName[IPEMAuditoryModel_MaxNameLength+1]; theOutputFileName[0] = '\0';
+	char theOutputFilePath[IPEMAuditoryModel_MaxNameLength+1]; theOutputFilePath[0] = '\0';
 	double theSampleFrequency = -1.0;
 	long theSoundFileFormat = -1;
+	long theOutputFormat = -1;
+	char thePitchFileName[IPEMAuditoryModel_MaxNameLength+1]; thePitchFileName[0] = '\0';
+	char thePyramidFileName[IPEMAuditoryModel_MaxNameLength+1]; thePyramidFileName[0] = '\0';
+	long thePyramidLevels = -1;
+	long theLogLevel = log_info;
+	long theChannelScale = csCBU;
+	double theChannelPositions[256];
+	long theNumOfPositions = 0;
+	double theStart = -1.0;
+	double theDuration = -1.0;
+	double thePreRoll = -1.0;
+	long theNormalization = nmNone;
+	double theLevel = -20.0;
+	long theKernel = akDouble;
+	char theCacheDirectory[IPEMAuditoryModel_MaxNameLength+1]; theCacheDirectory[0] = '\0';
+	double theCacheSize = -1.0;
+	char theSocketPath[IPEMAuditoryModel_MaxNameLength+1]; theSocketPath[0] = '\0';
+	long theNumOfWorkers = -1;
+	char theBatchFileName[IPEMAuditoryModel_MaxNameLength+1]; theBatchFileName[0] = '\0';
+	double theSegmentLength = -1.0;
+	long theNumOfNodes = 0;
 
 	// Capture arguments (either interactive or from command line)
 	bool theParametersAreOK = false;
@@ -218,31 +534,101 @@ int main (int inNumOfArguments, char* inArguments[])
 						theFirstFrequency, theFrequencyDistance,
 						theInputFileName, theInputFilePath,
 						theOutputFileName, theOutputFilePath,
-						theSampleFrequency, theSoundFileFormat);
+						theSampleFrequency, theSoundFileFormat,
+						theOutputFormat);
 	else
 		theParametersAreOK = DoCommandLineParsing(inNumOfArguments,inArguments,
 						theNumOfChannels,
 						theFirstFrequency, theFrequencyDistance,
 						theInputFileName, theInputFilePath,
 						theOutputFileName, theOutputFilePath,
-						theSampleFrequency, theSoundFileFormat);
+						theSampleFrequency, theSoundFileFormat,
+						theOutputFormat,
+						thePitchFileName,
+						thePyramidFileName, thePyramidLevels,
+						theLogLevel,
+						theChannelScale,
+						theChannelPositions, theNumOfPositions,
+						theStart, theDuration, thePreRoll,
+						theNormalization, theLevel,
+						theKernel,
+						theCacheDirectory, theCacheSize,
+						theSocketPath, theNumOfWorkers,
+						theBatchFileName, theSegmentLength,
+						theNumOfNodes);
 
 	// If something went wrong, quit now
 	if (!theParametersAreOK) return -1;
 
+	// Placement of the server or batch threads
+	if (theNumOfNodes > 0) parallel_set_nodes(theNumOfNodes);
+
+	// Server mode: the model parameters come with each request
+	if (strlen(theSocketPath) != 0)
+	{
+		// A server runs until it is killed: its lines must not wait in a buffer
+		setvbuf(stdout,NULL,_IOLBF,0);
+		log_sink theLogSink = {stdout, log_to_stream, (int)theLogLevel};
+		return IPEMAuditoryModelServer_Run(theSocketPath,theNumOfWorkers,&theLogSink);
+	}
+
+	// Batch mode: the model options apply to every file of the list
+	if (strlen(theBatchFileName) != 0)
+	{
+		// One pitch or pyramid file cannot hold the results of many sound
+		// files, and a range does not apply to all of them
+		if ((strlen(thePitchFileName) != 0) || (strlen(thePyramidFileName) != 0)
+			|| (theStart != -1.0) || (theDuration != -1.0))
+		{
+			printf("ERROR: -pf, -zf, -ts and -td cannot be used with -batch\n");
+			return -1;
+		}
+		char** theInputs = NULL;
+		char** theOutputs = NULL;
+		long theNumOfFiles = ReadBatchList(theBatchFileName,theInputs,theOutputs);
+		if (theNumOfFiles < 0)
+		{
+			printf("ERROR: cannot read the list %s\n",theBatchFileName);
+			return -1;
+		}
+		BatchSettings theSettings = {theNumOfChannels, theFirstFrequency, theFrequencyDistance,
+						theSampleFrequency, theOutputFormat,
+						theChannelScale, (theNumOfPositions > 0) ? theChannelPositions : NULL,
+						theNumOfPositions, theNormalization, theLevel, theKernel,
+						theCacheDirectory, theCacheSize};
+		log_sink theLogSink = {stdout, log_to_stream, (int)theLogLevel};
+		// Normalization is computed over the analysed range: only whole files
+		long theNumOfFailed = IPEMAuditoryModelBatch_Run(theNumOfFiles,theInputs,theOutputs,
+						theNumOfWorkers, (theNormalization == nmNone) ? theSegmentLength : 0,
+						thePreRoll, SetupBatchTask, &theSettings, &theLogSink);
+		for (long i = 0; i < theNumOfFiles; i++) { free(theInputs[i]); free(theOutputs[i]); }
+		free(theInputs); free(theOutputs);
+		return (theNumOfFailed == 0) ? 0 : -1;
+	}
+
 
 
 
-	// Create a model from our data
-	IPEMAuditoryModel theModel(theNumOfChannels,
+	// Setup the model from our data
+	IPEMAuditoryModel_Setup(theNumOfChannels,
 						theFirstFrequency, theFrequencyDistance,
 						theInputFileName, theInputFilePath,
 						theOutputFileName, theOutputFilePath,
 						theSampleFrequency, theSoundFileFormat);
+	IPEMAuditoryModel_SetOutputFormat(theOutputFormat);
+	IPEMAuditoryModel_SetCache(theCacheDirectory,theCacheSize);
+	IPEMAuditoryModel_SetPitchFile(thePitchFileName);
+	IPEMAuditoryModel_SetPyramidFile(thePyramidFileName,thePyramidLevels);
+	IPEMAuditoryModel_SetChannels(theChannelScale,
+						(theNumOfPositions > 0) ? theChannelPositions : NULL, theNumOfPositions);
+	IPEMAuditoryModel_SetRange(theStart,theDuration,thePreRoll);
+	IPEMAuditoryModel_SetNormalization(theNormalization,theLevel);
+	IPEMAuditoryModel_SetKernel(theKernel);
+	log_sink theLogSink = {stdout, log_to_stream, (int)theLogLevel};
+	IPEMAuditoryModel_SetLogSink(&theLogSink);
 
 	// Start the computations and return the result
-	// (model object is automatically destroyed upon leaving this function)
-	return theModel.Process();
+	return IPEMAuditoryModel_Process();
 }
 
 
@@ -0,0 +1,337 @@
+// --------------------------------------------------------------------------------
+//  IPEMAuditoryModelServer.cpp
+// --------------------------------------------------------------------------------
+//  Auditory model server (see IPEMAuditoryModelServer.h for the protocol).
+//
+//  The main thread accepts connections and hands them to a fixed pool of worker
+//  threads through a bounded queue. When all workers are busy and the queue is
+//  full, the main thread stops accepting, so new clients wait in the listen
+//  backlog. A worker writes the ANI straight to its socket: if a client reads
+//  slowly, the worker blocks on the socket instead of buffering frames, and a
+//  client that stops reading altogether is dropped after cSendTimeout.
+// --------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+// Includes
+#include "IPEMAuditoryModelServer.h"
+#include "IPEMAuditoryModel.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Constants
+// ---------
+const long	cQueuePerWorker = 2;	// pending connections per worker
+const long	cReceiveTimeout = 30;	// (s) to receive a complete request
+const long	cSendTimeout = 60;		// (s) that a client may stop reading
+const long	cStreamBufferSize = 65536;
+
+// Connection queue
+// ----------------
+static int*				sQueue = NULL;
+static long				sQueueSize = 0;
+static long				sQueueHead = 0;
+static long				sQueueCount = 0;
+static pthread_mutex_t	sQueueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	sQueueNotEmpty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	sQueueNotFull = PTHREAD_COND_INITIALIZER;
+
+// Diagnostics of the server and of the model
+// -------------------------------------------
+static const log_sink*	sLogSink = NULL;
+
+// -----------------------------------------------------------------------------
+//	PushConnection
+// -----------------------------------------------------------------------------
+// Blocks while the queue is full
+static void PushConnection (int inSocket)
+{
+	pthread_mutex_lock(&sQueueMutex);
+	while (sQueueCount == sQueueSize) pthread_cond_wait(&sQueueNotFull,&sQueueMutex);
+	sQueue[(sQueueHead + sQueueCount) % sQueueSize] = inSocket;
+	sQueueCount++;
+	pthread_cond_signal(&sQueueNotEmpty);
+	pthread_mutex_unlock(&sQueueMutex);
+}
+
+// -----------------------------------------------------------------------------
+//	PopConnection
+// -----------------------------------------------------------------------------
+// Blocks while the queue is empty
+static int PopConnection ()
+{
+	int theSocket;
+
+	pthread_mutex_lock(&sQueueMutex);
+	while (sQueueCount == 0) pthread_cond_wait(&sQueueNotEmpty,&sQueueMutex);
+	theSocket = sQueue[sQueueHead];
+	sQueueHead = (sQueueHead + 1) % sQueueSize;
+	sQueueCount--;
+	pthread_cond_signal(&sQueueNotFull);
+	pthread_mutex_unlock(&sQueueMutex);
+	return theSocket;
+}
+
+// -----------------------------------------------------------------------------
+//	ReceiveAll / SendStatus
+// -----------------------------------------------------------------------------
+static bool ReceiveAll (int inSocket, void* outBuffer, size_t inSize)
+{
+	char* theBuffer = (char*)outBuffer;
+	while (inSize > 0)
+	{
+		ssize_t theCount = recv(inSocket,theBuffer,inSize,0);
+		if ((theCount < 0) && (errno == EINTR)) continue;
+		if (theCount <= 0) return false;
+		theBuffer += theCount;
+		inSize -= theCount;
+	}
+	return true;
+}
+
+static bool SendStatus (int inSocket, int inStatus)
+{
+	return send(inSocket,&inStatus,sizeof(inStatus),0) == (ssize_t)sizeof(inStatus);
+}
+
+// -----------------------------------------------------------------------------
+//	Worker
+// -----------------------------------------------------------------------------
+// Per worker buffers, reused (and grown when needed) from request to request
+struct Worker
+{
+	float*	mSamples;
+	double*	mSignal;
+	long	mCapacity;
+};
+
+// -----------------------------------------------------------------------------
+//	ReadRequest
+// -----------------------------------------------------------------------------
+// Receives and checks a request; returns its status, and for srkFile the
+// path in outPath or for srkSignal the number of samples in ioWorker.mSignal
+static int ReadRequest (int inSocket, Worker& ioWorker,
+						IPEMAuditoryModelRequest& outRequest,
+						char* outPath, long& outNumOfSamples)
+{
+	if (!ReceiveAll(inSocket,&outRequest,sizeof(outRequest))) return srsBadRequest;
+	if (memcmp(outRequest.Magic,cServerMagic,sizeof(outRequest.Magic)) != 0) return srsBadRequest;
+	if ((outRequest.NumOfChannels != -1)
+		&& ((outRequest.NumOfChannels < 1) || (outRequest.NumOfChannels > 40))) return srsBadRequest;
+	if ((outRequest.SampleFrequency != -1.0) && (outRequest.SampleFrequency <= 0)) return srsBadRequest;
+	if (outRequest.Length < 0) return srsBadRequest;
+
+	if (outRequest.Kind == srkFile)
+	{
+		if ((outRequest.Length == 0) || (outRequest.Length > cServerMaxPath)) return srsBadRequest;
+		if (!ReceiveAll(inSocket,outPath,(size_t)outRequest.Length)) return srsBadRequest;
+		outPath[outRequest.Length] = '\0';
+		FILE* theFile = fopen(outPath,"rb");
+		if (theFile == NULL) return srsNoInput;
+		fclose(theFile);
+		outNumOfSamples = 0;
+	}
+	else if (outRequest.Kind == srkSignal)
+	{
+		if ((outRequest.Length % sizeof(float)) != 0) return srsBadRequest;
+		long theNumOfSamples = (long)(outRequest.Length/sizeof(float));
+		if (theNumOfSamples > cServerMaxSignal) return srsBadRequest;
+		if (theNumOfSamples > ioWorker.mCapacity)
+		{
+			free(ioWorker.mSamples); free(ioWorker.mSignal);
+			ioWorker.mSamples = (float*)malloc(theNumOfSamples*sizeof(float));
+			ioWorker.mSignal = (double*)malloc(theNumOfSamples*sizeof(double));
+			ioWorker.mCapacity = theNumOfSamples;
+			if ((ioWorker.mSamples == NULL) || (ioWorker.mSignal == NULL))
+			{
+				ioWorker.mCapacity = 0;
+				return srsFailed;
+			}
+		}
+		if (!ReceiveAll(inSocket,ioWorker.mSamples,theNumOfSamples*sizeof(float))) return srsBadRequest;
+		for (long i = 0; i < theNumOfSamples; i++) ioWorker.mSignal[i] = ioWorker.mSamples[i];
+		outNumOfSamples = theNumOfSamples;
+	}
+	else return srsBadRequest;
+
+	return srsOK;
+}
+
+// -----------------------------------------------------------------------------
+//	HandleConnection
+// -----------------------------------------------------------------------------
+// Serves one request and closes the connection
+static void HandleConnection (int inSocket, Worker& ioWorker)
+{
+	IPEMAuditoryModelRequest theRequest;
+	char thePath[cServerMaxPath+1];
+	long theNumOfSamples = 0;
+
+	struct timeval theTimeout;
+	theTimeout.tv_sec = cReceiveTimeout; theTimeout.tv_usec = 0;
+	setsockopt(inSocket,SOL_SOCKET,SO_RCVTIMEO,&theTimeout,sizeof(theTimeout));
+	theTimeout.tv_sec = cSendTimeout;
+	setsockopt(inSocket,SOL_SOCKET,SO_SNDTIMEO,&theTimeout,sizeof(theTimeout));
+
+	int theStatus = ReadRequest(inSocket,ioWorker,theRequest,thePath,theNumOfSamples);
+	if (!SendStatus(inSocket,theStatus) || (theStatus != srsOK))
+	{
+		close(inSocket);
+		return;
+	}
+
+	FILE* theStream = fdopen(inSocket,"wb");
+	if (theStream == NULL)
+	{
+		close(inSocket);
+		return;
+	}
+	setvbuf(theStream,NULL,_IOFBF,cStreamBufferSize);
+
+	IPEMAuditoryModel_Setup(theRequest.NumOfChannels,
+						theRequest.FirstFreq, theRequest.FreqDist,
+						(theRequest.Kind == srkFile) ? thePath : NULL, NULL,
+						NULL, NULL,
+						theRequest.SampleFrequency, sffWav);
+	IPEMAuditoryModel_SetOutputFormat(aofBinary);
+	if (theRequest.Kind == srkSignal)
+		IPEMAuditoryModel_SetInputSignal(ioWorker.mSignal,theNumOfSamples);
+	IPEMAuditoryModel_SetOutputStream(theStream);
+	IPEMAuditoryModel_SetLogSink(sLogSink);
+	if (IPEMAuditoryModel_Process() != 0)
+	{
+		log_set_sink(sLogSink);		// the model restores the default when it is done
+		log_message(log_error,"server: request failed");
+	}
+
+	fclose(theStream);	// also closes the socket
+}
+
+// -----------------------------------------------------------------------------
+//	WorkerThread
+// -----------------------------------------------------------------------------
+// Started by parallel_spawn, so that it runs on the processor (and its
+// buffers, which it allocates and fills itself, on the memory node) that
+// was chosen with parallel_set_nodes.
+static void WorkerThread (void*, long)
+{
+	Worker theWorker;
+	theWorker.mSamples = NULL;
+	theWorker.mSignal = NULL;
+	theWorker.mCapacity = 0;
+
+	while (true) HandleConnection(PopConnection(),theWorker);
+}
+
+// -----------------------------------------------------------------------------
+//	IPEMAuditoryModelServer_Run
+// -----------------------------------------------------------------------------
+int IPEMAuditoryModelServer_Run (const char* inSocketPath, long inNumOfWorkers,
+								  const log_sink* inLogSink)
+{
+	struct sockaddr_un theAddress;
+
+	sLogSink = inLogSink;
+	log_set_sink(inLogSink);
+	if (inNumOfWorkers <= 0) inNumOfWorkers = parallel_threads();
+	if (strlen(inSocketPath) >= sizeof(theAddress.sun_path))
+	{
+		log_message(log_error,"server: socket path too long");
+		return -1;
+	}
+
+	// Writing to a client that went away must fail, not kill the server
+	signal(SIGPIPE,SIG_IGN);
+
+	int theListener = socket(AF_UNIX,SOCK_STREAM,0);
+	if (theListener < 0)
+	{
+		log_message(log_error,"server: socket: %s",strerror(errno));
+		return -1;
+	}
+	memset(&theAddress,0,sizeof(theAddress));
+	theAddress.sun_family = AF_UNIX;
+	strcpy(theAddress.sun_path,inSocketPath);
+	unlink(inSocketPath);	// left behind by a previous server
+	if ((bind(theListener,(struct sockaddr*)&theAddress,sizeof(theAddress)) != 0)
+		|| (listen(theListener,inNumOfWorkers*cQueuePerWorker) != 0))
+	{
+		log_message(log_error,"server: bind: %s",strerror(errno));
+		close(theListener);
+		return -1;
+	}
+
+	sQueueSize = inNumOfWorkers*cQueuePerWorker;
+	sQueue = (int*)malloc(sQueueSize*sizeof(int));
+	if (sQueue == NULL)
+	{
+		log_message(log_error,"server: out of memory");
+		close(theListener);
+		return -1;
+	}
+	for (long i = 0; i < inNumOfWorkers; i++)
+	{
+		if (!parallel_spawn(i,WorkerThread,NULL))
+		{
+			log_message(log_error,"server: cannot start worker %ld",i);
+			return -1;
+		}
+	}
+	log_message(log_info,"server: listening on %s with %ld workers",inSocketPath,inNumOfWorkers);
+
+	while (true)
+	{
+		int theSocket = accept(theListener,NULL,NULL);
+		if (theSocket < 0)
+		{
+			if ((errno == EINTR) || (errno == ECONNABORTED)) continue;
+			log_message(log_error,"server: accept: %s",strerror(errno));
+			break;
+		}
+		PushConnection(theSocket);
+	}
+	close(theListener);
+	return -1;
+}
+
+#else
+
+int IPEMAuditoryModelServer_Run (const char* inSocketPath, long inNumOfWorkers,
+								  const log_sink* inLogSink)
+{
+	log_set_sink(inLogSink);
+	log_message(log_error,"server: not available on this platform");
+	log_set_sink(NULL);
+	return -1;
+}
+
+#endif /* !defined(_WIN32) */
@@ -0,0 +1,82 @@
+// --------------------------------------------------------------------------------
+//  IPEMAuditoryModelServer.h
+// --------------------------------------------------------------------------------
+//  Long-running auditory model server on a local (UNIX domain) socket.
+//
+//  A client connects, sends one request and reads the reply:
+//
+//  request  = IPEMAuditoryModelRequest followed by Length bytes of payload:
+//               srkFile   : path of a wav file (no trailing '\0')
+//               srkSignal : Length/4 samples as 32 bit floats in -1..+1
+//  reply    = 32 bit status (srsOK or one of the errors below), and if the
+//             status is srsOK, the auditory nerve image as a binary ANI stream
+//             (see library/aniio.h, frame count -1) until the server closes
+//             the connection
+//
+//  All numbers are in the byte order of the server's host. A value of -1 for
+//  a model parameter requests its default (see IPEMAuditoryModel_Setup).
+//
+//  The server keeps one auditory model per worker thread, so that the filter
+//  coefficients computed for one request are reused by the next request with
+//  the same parameters.
+// --------------------------------------------------------------------------------
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "logging.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define cServerMagic	"IAMR"
+#define cServerMaxPath	255					// longest path of a srkFile request
+#define cServerMaxSignal	(64L*1024*1024)	// most samples of a srkSignal request
+
+/* Request kinds */
+enum {srkFile = 0, srkSignal };
+
+/* Reply status */
+enum {srsOK = 0, srsBadRequest, srsNoInput, srsFailed };
+
+typedef struct
+{
+	char		Magic[4];			// cServerMagic
+	int			Kind;				// srkFile or srkSignal
+	int			NumOfChannels;
+	int			Reserved;
+	double		FirstFreq;			// (cbu)
+	double		FreqDist;			// (cbu)
+	double		SampleFrequency;	// (Hz)
+	long long	Length;				// bytes of payload following the request
+} IPEMAuditoryModelRequest;
+
+/* Runs the server until it is killed; returns only if the socket could not
+   be set up. inNumOfWorkers <= 0 uses one worker per processor. The
+   messages of the server and of the model go to inLogSink (which must
+   stay valid), those of the default sink if it is NULL. */
+int IPEMAuditoryModelServer_Run(const char* inSocketPath, long inNumOfWorkers,
+								const log_sink* inLogSink);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,205 @@
+/* anisink.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    AUDITORY NERVE IMAGE OF A SIGNAL IN MEMORY
+
+    What IPEMCalcANI.m does with the frames of the model, for the
+    gateways that run it on a signal in memory (IPEMCalcANIMex,
+    IPEMCalcANIBatchMex and IPEMRoughnessOfSoundPairsMex). The signal
+    is padded with nzeros samples of silence on each side; it is
+    handed to a context of libipemam (ipemam.h) a block at a time,
+    and the frames that come back are kept in a ring, without the
+    frames of the silences (round(nzeros/fs*frame_rate) at either
+    end), and downsampled as resample(x,1,factor): a lowpass filter
+    of 10 zero crossings on each side, windowed with a Kaiser window
+    (beta 5). The columns are collected in b->ani, or handed to a
+    writer one at a time, so that a gateway can put them straight
+    into the storage of its output. Only malloc is used, so that it
+    can run on any thread.
+
+ ************** list of routines and their function ******************
+
+    anisink_capacity(fs,frame_rate,length,factor)
+      The number of columns of a padded signal of length samples at
+      fs Hz, rounded up: the model runs a little beyond the end of the
+      signal, so that it is seldom exceeded (but it may be).
+    anisink_open(b,c,fs,length,nzeros,factor,writer)
+      Set up b for the frames of context c, for a padded signal of
+      length samples at fs Hz, with the columns going to writer (NULL:
+      to b->ani). Returns 1 on success.
+    anisink_run(b,c,xn,length)
+      Run the model of c on xn[0..length-1] (the padded signal) and
+      flush it: b->ncols columns of b->nchan values at
+      b->frame_rate/b->factor Hz were written (in b->ani without a
+      writer). Returns 1 on success.
+    anisink_close(b)
+      Release the buffers of b (also b->ani, unless it was taken and
+      set to NULL).
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <anisink.h>
+
+#define half_zeros  10     /* zero crossings on each side of the filter */
+#define kaiser_beta 5.0
+#define cnt_block   8192   /* samples given to the model at a time      */
+#define cnt_read    64     /* frames read from the model at a time      */
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+/* modified Bessel function of order 0 (for the Kaiser window) */
+static double bessel_i0(double x)
+{double sum=1,term=1;
+ int    k;
+
+ for (k=1;k<50;k++)
+ {term*=(x/(2*k))*(x/(2*k));
+  sum+=term;
+  if (term<1e-12*sum) break;
+ }
+ return sum;
+}
+
+/* lowpass filter of resample(x,1,factor) */
+static void design_filter(anisink_buffer *b)
+{long   j,c=b->half;
+ double x,sum=0;
+
+ for (j=-c;j<=c;j++)
+ {x=(double)j/b->factor;
+  b->filter[j+c]=(j==0) ? 1 : sin(M_PI*x)/(M_PI*x);
+  if (c>0)
+     b->filter[j+c]*=bessel_i0(kaiser_beta*sqrt(1-((double)j/c)*((double)j/c)))
+                     /bessel_i0(kaiser_beta);
+  sum+=b->filter[j+c];
+ }
+ for (j=0;j<=2*c;j++) b->filter[j]/=sum;
+}
+
+long anisink_capacity(double fs,double frame_rate,long length,long factor)
+{
+ return (long)ceil((length/fs+0.25)*frame_rate/factor)+1;
+}
+
+int anisink_open(anisink_buffer *b,const ipemam_context *c,double fs,
+                 long length,long nzeros,long factor,
+                 const anisink_writer *writer)
+{
+ memset(b,0,sizeof(anisink_buffer));
+ b->nchan=ipemam_channels(c); b->frame_rate=ipemam_frame_rate(c);
+ b->factor=factor;
+ b->trim=(long)floor(nzeros*b->frame_rate/fs+0.5);
+ b->skip=b->trim;
+ b->half=(factor>1) ? half_zeros*factor : 0;
+ b->filter=(double*)malloc((2*b->half+1)*sizeof(double));
+ if (b->filter!=NULL) design_filter(b);
+ b->nring=b->trim+2*b->half+2;
+ b->ring=(double*)malloc(b->nring*b->nchan*sizeof(double));
+ b->frames=(double*)malloc(cnt_read*b->nchan*sizeof(double));
+ b->writer=writer;
+ if (writer!=NULL) b->column=(double*)malloc(b->nchan*sizeof(double));
+ else
+ {/* grown if needed */
+  b->capacity=anisink_capacity(fs,b->frame_rate,length,factor);
+  b->ani=(double*)malloc(b->capacity*b->nchan*sizeof(double));
+ }
+ b->failed=(b->filter==NULL) || (b->ring==NULL) || (b->frames==NULL)
+           || ((writer!=NULL) ? (b->column==NULL) : (b->ani==NULL));
+ return !b->failed;
+}
+
+/* Compute column ncols from the kept frames; frames at or beyond end
+   (and before the first one) are silent */
+static void write_column(anisink_buffer *b,long end)
+{long    k=b->ncols,c=b->half,j,i,p;
+ double *frame,*column,*tmp;
+
+ if (b->writer!=NULL) column=b->column;
+ else
+ {if (k==b->capacity)
+  {tmp=(double*)realloc(b->ani,2*b->capacity*b->nchan*sizeof(double));
+   if (tmp==NULL) {b->failed=1; return;}
+   b->ani=tmp; b->capacity*=2;
+  }
+  column=b->ani+k*b->nchan;
+ }
+ for (p=0;p<b->nchan;p++)
+ {column[p]=0;
+  for (j=-c;j<=c;j++)
+  {i=k*b->factor+j;
+   if ((i<0) || (i>=end)) continue;
+   frame=b->ring+(i%b->nring)*b->nchan;
+   column[p]+=b->filter[j+c]*frame[p];
+  }
+ }
+ if ((b->writer!=NULL) && !b->writer->column(b->writer->context,k,column))
+ {b->failed=1; return;}
+ b->ncols++;
+}
+
+static void put_frame(anisink_buffer *b,const double *values)
+{
+ if (b->skip>0) {b->skip--; return;}
+ memcpy(b->ring+(b->nin%b->nring)*b->nchan,values,b->nchan*sizeof(double));
+ b->nin++;
+ /* a frame is known not to be one of the trailing ones once trim
+    frames have followed it */
+ while (!b->failed && (b->ncols*b->factor+b->half<b->nin-b->trim))
+    write_column(b,b->nin);
+}
+
+static int read_frames(anisink_buffer *b,ipemam_context *c,int64_t available)
+/* the frames of c (available: result of ipemam_process or _flush) */
+{int64_t n,k;
+
+ if (available<0) b->failed=1;
+ while (!b->failed && ((n=ipemam_read(c,b->frames,cnt_read))>0))
+    for (k=0;k<n;k++) put_frame(b,b->frames+k*b->nchan);
+ return !b->failed;
+}
+
+int anisink_run(anisink_buffer *b,ipemam_context *c,const double *xn,
+                long length)
+{long i,end;
+
+ for (i=0;(i<length) && !b->failed;i+=cnt_block)
+    read_frames(b,c,ipemam_process(c,xn+i,(length-i<cnt_block) ? length-i
+                                                                : cnt_block));
+ if (!b->failed) read_frames(b,c,ipemam_flush(c));
+ /* the last columns, with the trailing frames left out */
+ end=b->nin-b->trim;
+ while (!b->failed && (b->ncols*b->factor<end)) write_column(b,end);
+ return !b->failed;
+}
+
+void anisink_close(anisink_buffer *b)
+{
+ free(b->filter); free(b->ring); free(b->frames); free(b->ani);
+ free(b->column);
+ b->filter=b->ring=b->frames=b->ani=b->column=NULL;
+}
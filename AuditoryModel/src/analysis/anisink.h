@@ -0,0 +1,73 @@
+/* anisink.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( ANISINK_H )
+#define ANISINK_H
+
+#include <ipemam.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* receiver of the columns, instead of anisink_buffer.ani: column(context,k,
+   values) stores column k (nchan values, k = 0, 1, ...); returns 0 if it
+   cannot, which fails the analysis */
+typedef struct{
+               void  *context;
+               int  (*column)(void *context,long k,const double *values);
+              } anisink_writer;
+
+/* auditory nerve image of one padded signal, downsampled in memory */
+typedef struct{
+               long    nchan;
+               double  frame_rate;  /* of the model (Hz)                 */
+               long    factor;      /* downsampling factor               */
+               long    skip;        /* leading frames still to be dropped */
+               long    trim;        /* frames dropped at either end      */
+               double *filter;      /* 2*half+1 taps                     */
+               long    half;
+               double *ring;        /* the last nring frames kept        */
+               long    nring;
+               long    nin;         /* frames kept so far                */
+               double *frames;      /* cnt_read frames read at a time    */
+               double *ani;         /* nchan x ncols, column major       */
+               long    ncols;
+               long    capacity;    /* columns allocated in ani          */
+               const anisink_writer *writer; /* or NULL: ani is used     */
+               double *column;      /* column given to the writer        */
+               int     failed;
+              } anisink_buffer;
+
+extern long anisink_capacity(double fs,double frame_rate,long length,
+                             long factor);
+extern int  anisink_open(anisink_buffer *b,const ipemam_context *c,double fs,
+                         long length,long nzeros,long factor,
+                         const anisink_writer *writer);
+extern int  anisink_run(anisink_buffer *b,ipemam_context *c,const double *xn,
+                        long length);
+extern void anisink_close(anisink_buffer *b);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( ANISINK_H ) */
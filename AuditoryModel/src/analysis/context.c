@@ -0,0 +1,175 @@
+/* context.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TONAL CONTEXT: LEAKY INTEGRATION AND CONTEXTUALITY INDEX
+
+    Native version of IPEMLeakyIntegration and IPEMContextualityIndex.
+    A periodicity pitch image is integrated column by column into a
+    chord image (short half decay time) and a tone center image (long
+    half decay time), both in the same pass:
+
+        out(:,j) = coef*out(:,j-1) + in(:,j),  coef = 2^(-1/(fs*half))
+
+    The sums needed for the correlation coefficients are gathered
+    while the columns are produced, so that a correlation costs one
+    extra dot product at most.
+
+ ************** list of routines and their function ******************
+
+    context_coef(fs,half_decay)
+      Coefficient of a leaky integrator (0 if half_decay is 0).
+    context_open(s,nrows,fs,half_decay_chords,half_decay_tones)
+      Set up a streaming engine (zero state). Returns 1 on success.
+    context_column(s,in,chord,tone,sums)
+      Consume one column in[0..nrows-1] (NULL for a silent column),
+      copy the new chord and tone center columns to chord and tone
+      (either may be NULL) and their sums to sums (may be NULL).
+      Returns the correlation between both columns.
+    context_close(s)
+      Release the engine.
+    context_correlation(n,x,xx,y,yy,xy)
+      Correlation coefficient of two vectors of length n from their
+      sums, sums of squares and sum of products (NaN if either is
+      constant, as corrcoef).
+    context_index(in,nrows,ncols,nextra,fs,half_decay_chords,
+                  half_decay_tones,snapshot,chords,tones,c1,c2,c3)
+      IPEMContextualityIndex on in (nrows x ncols, column major),
+      extended with nextra silent columns. The outputs are allocated
+      by the caller: chords and tones have nrows x (ncols+nextra)
+      elements, c1, c2 and c3 ncols+nextra. snapshot is the (0 based)
+      column of the chord image the others are compared with.
+      Returns 1 on success.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <context.h>
+
+double context_coef(double fs,double half_decay)
+{
+ if (half_decay==0) return 0;
+ return pow(2.0,-1/(fs*half_decay));
+}
+
+int context_open(context_state *s,long nrows,double fs,
+                 double half_decay_chords,double half_decay_tones)
+{
+ s->nrows=nrows; s->ncols=0;
+ s->chord_coef=context_coef(fs,half_decay_chords);
+ s->tone_coef=context_coef(fs,half_decay_tones);
+ s->chord=(double*)calloc(2*nrows+1,sizeof(double));
+ s->tone=s->chord+nrows;
+ return s->chord!=NULL;
+}
+
+void context_close(context_state *s)
+{
+ free(s->chord); s->chord=NULL; s->tone=NULL;
+}
+
+static double not_a_number()
+{double zero=0;
+
+ return zero/zero;
+}
+
+double context_correlation(long n,double x,double xx,double y,double yy,
+                           double xy)
+{double vx,vy;
+
+ vx=n*xx-x*x; vy=n*yy-y*y;
+ /* rounding may leave a tiny negative variance for a constant vector */
+ if ((vx<=0) || (vy<=0)) return not_a_number();
+ return (n*xy-x*y)/sqrt(vx*vy);
+}
+
+double context_column(context_state *s,const double *in,double *chord,
+                      double *tone,context_sums *sums)
+{context_sums u;
+ double c,t,x;
+ long   p;
+
+ memset(&u,0,sizeof(u));
+ for (p=0;p<s->nrows;p++)
+ {x=(in!=NULL) ? in[p] : 0;
+  c=s->chord_coef*s->chord[p]+x; s->chord[p]=c;
+  t=s->tone_coef*s->tone[p]+x;   s->tone[p]=t;
+  u.c+=c; u.cc+=c*c; u.t+=t; u.tt+=t*t; u.ct+=c*t;
+ }
+ if (chord!=NULL) memcpy(chord,s->chord,s->nrows*sizeof(double));
+ if (tone!=NULL) memcpy(tone,s->tone,s->nrows*sizeof(double));
+ if (sums!=NULL) *sums=u;
+ s->ncols++;
+ return context_correlation(s->nrows,u.c,u.cc,u.t,u.tt,u.ct);
+}
+
+static void inspect(long nrows,const double *chord,const double *tone,
+                    const double *snap,const context_sums *u,
+                    const context_sums *v,double *c1,double *c2)
+/*********************************************************************
+   Compare one column (sums u) with the snapshot column (sums v).
+ *********************************************************************/
+{double d1=0,d2=0;
+ long   p;
+
+ for (p=0;p<nrows;p++) {d1+=chord[p]*snap[p]; d2+=tone[p]*snap[p];}
+ *c1=context_correlation(nrows,u->c,u->cc,v->c,v->cc,d1);
+ *c2=context_correlation(nrows,u->t,u->tt,v->c,v->cc,d2);
+}
+
+int context_index(const double *in,long nrows,long ncols,long nextra,
+                  double fs,double half_decay_chords,double half_decay_tones,
+                  long snapshot,double *chords,double *tones,
+                  double *c1,double *c2,double *c3)
+{context_state s;
+ context_sums *sums;
+ const double *snap;
+ long          n=ncols+nextra,i,j;
+
+ if ((snapshot<0) || (snapshot>=n)) return 0;
+ /* the sums of the columns up to the snapshot are kept until it is known,
+    after it the sums of the current column go to sums[snapshot+1] */
+ sums=(context_sums*)malloc((snapshot+2)*sizeof(context_sums));
+ if (sums==NULL) return 0;
+ if (!context_open(&s,nrows,fs,half_decay_chords,half_decay_tones))
+ {free(sums); return 0;}
+
+ snap=chords+snapshot*nrows;
+ for (j=0;j<n;j++)
+ {i=(j<=snapshot) ? j : snapshot+1;
+  c3[j]=context_column(&s,(j<ncols) ? in+j*nrows : NULL,
+                       chords+j*nrows,tones+j*nrows,&sums[i]);
+  if (j==snapshot)
+     for (i=0;i<=j;i++)
+        inspect(nrows,chords+i*nrows,tones+i*nrows,snap,
+                &sums[i],&sums[snapshot],&c1[i],&c2[i]);
+  else if (j>snapshot)
+     inspect(nrows,chords+j*nrows,tones+j*nrows,snap,
+             &sums[snapshot+1],&sums[snapshot],&c1[j],&c2[j]);
+ }
+ context_close(&s);
+ free(sums);
+ return 1;
+}
@@ -0,0 +1,66 @@
+/* context.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( CONTEXT_H )
+#define CONTEXT_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* sums over the rows of one column of the chord and tone center images */
+typedef struct{
+               double c,cc;    /* chords: sum, sum of squares        */
+               double t,tt;    /* tone centers: sum, sum of squares  */
+               double ct;      /* sum of products                    */
+              } context_sums;
+
+typedef struct{
+               long    nrows;
+               double  chord_coef;  /* leaky integrator coefficients   */
+               double  tone_coef;
+               double *chord;       /* last column of the chord image  */
+               double *tone;        /* last column of the tone centers */
+               long    ncols;       /* columns consumed so far         */
+              } context_state;
+
+extern double context_coef(double fs,double half_decay);
+
+extern int  context_open(context_state *s,long nrows,double fs,
+                         double half_decay_chords,double half_decay_tones);
+extern double context_column(context_state *s,const double *in,
+                             double *chord,double *tone,context_sums *sums);
+extern void context_close(context_state *s);
+
+extern double context_correlation(long n,double x,double xx,
+                                  double y,double yy,double xy);
+
+extern int context_index(const double *in,long nrows,long ncols,long nextra,
+                         double fs,double half_decay_chords,
+                         double half_decay_tones,long snapshot,
+                         double *chords,double *tones,
+                         double *c1,double *c2,double *c3);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( CONTEXT_H ) */
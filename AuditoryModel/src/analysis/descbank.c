@@ -0,0 +1,259 @@
+/* descbank.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    DESCRIPTOR BANK: SPECTRAL DESCRIPTORS OF A SIGNAL OR AN ANI
+
+    Native version of IPEMCalcCentroid, IPEMCalcCentroidWidth,
+    IPEMGetRolloff, IPEMCalcZeroCrossingRate, IPEMGetCrestFactor and
+    IPEMCalcFlux, computing the descriptors asked for in the bitmask
+    in one pass over the frames. Every frame gives weights w over the
+    distances d:
+
+      signal  frames of an STFT plan (stft.c): w are the magnitudes of
+              bins 0..nfft/2 (stft_frame), d their frequencies. Every
+              frame is transformed once, whatever the descriptors.
+      ANI     frames of width columns every step columns (only those
+              that fit entirely, as in IPEMCalcCentroid): w is the mean
+              of the columns of the frame, d the centre frequencies of
+              the channels.
+
+    and from them, with W = sum(w):
+
+      centroid  c = sum(d.*w)/W                  (0 if W is 0)
+      width     sum(abs(d-c).*w)/W
+      rolloff   d(r), r the first index with sum(w(1:r)) >= rolloff*W
+      zcr       sign changes per second in the samples of the frame,
+                samples with abs(x) < tolerance counting as 0 (signal
+                only)
+      crest     max(abs(x))/rms(x) of the samples of the frame (signal)
+                or of w (ANI), 1 if the rms is 0
+      flux      norm(w(k)-w(k-1)), 0 for the first frame
+
+    For an ANI, centroid and width are those of IPEMCalcCentroid and
+    IPEMCalcCentroidWidth, which sum the columns of a frame. The frames
+    are spread over the threads in runs of consecutive frames; a run
+    computes the weights of the frame before it again for the flux,
+    so that the runs do not depend on each other.
+
+ ************** list of routines and their function ******************
+
+    descbank_rows(mask)
+      Number of descriptors (rows of the output) in mask.
+    descbank_signal(p,x,length,d,out)
+      Descriptors d->mask of the stft_frames(p,length) frames of
+      x[0..length-1]: out receives descbank_rows values per frame
+      (rows x frames, column major). Returns the number of frames,
+      -1 if it failed.
+    descbank_ani_frames(ncols,width,step)
+      Number of frames of an ANI of ncols columns.
+    descbank_ani(ani,nchan,ncols,freqs,width,step,d,out)
+      The same for the frames of an ANI (nchan x ncols, column major)
+      whose channels have centre frequencies freqs (NULL: 1..nchan).
+      descbank_zcr is not available (returns -1).
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include <parallel.h>
+#include <descbank.h>
+
+#define frames_per_task  32    /* consecutive frames per parallel task */
+
+typedef struct{
+               const descbank_params *d;
+               int           rows;
+               long          nframes;
+               long          n;         /* weights per frame            */
+               double       *dist;      /* their distances              */
+               double       *out;
+               int           failed;
+               /* signal */
+               const stft_plan *p;
+               const double *x;
+               long          length;
+               /* ANI */
+               const double *ani;
+               long          width,step;
+              } desc_job;
+
+int descbank_rows(int mask)
+{int i,rows=0;
+
+ for (i=descbank_centroid;i<=descbank_flux;i*=2) if (mask&i) rows++;
+ return rows;
+}
+
+long descbank_ani_frames(long ncols,long width,long step)
+{
+ if (width<1 || step<1 || ncols<width) return 0;
+ return (ncols-width)/step+1;
+}
+
+/* number of samples of signal frame f */
+static long frame_avail(const desc_job *job,long f)
+{long start=f*job->p->hop;
+
+ return (job->length-start<job->p->width) ? job->length-start : job->p->width;
+}
+
+static void frame_weights(const desc_job *job,long f,double *w,float *mags,
+                          double *work)
+{long i,j;
+ const double *col;
+
+ if (job->p!=NULL)
+ {stft_frame(job->p,job->x+f*job->p->hop,frame_avail(job,f),mags,work);
+  for (i=0;i<job->n;i++) w[i]=mags[i];
+  return;
+ }
+ for (i=0;i<job->n;i++) w[i]=0;
+ for (j=0;j<job->width;j++)
+ {col=job->ani+(f*job->step+j)*job->n;
+  for (i=0;i<job->n;i++) w[i]+=col[i];
+ }
+ for (i=0;i<job->n;i++) w[i]/=job->width;
+}
+
+/* zero crossings per second of a signal frame (IPEMCountZeroCrossings) */
+static double frame_zcr(const desc_job *job,long f)
+{const double *x=job->x+f*job->p->hop;
+ long   i,avail=frame_avail(job,f),count=0;
+ int    sign,last=0;
+
+ for (i=0;i<avail;i++)
+ {if (fabs(x[i])<job->d->tolerance || x[i]==0) continue;
+  sign=(x[i]>0) ? 1 : -1;
+  if (last!=0 && sign!=last) count++;
+  last=sign;
+ }
+ return count*job->p->fs/job->p->width;
+}
+
+static double crest(const double *x,long avail,long n)
+{long   i;
+ double peak=0,sum=0;
+
+ for (i=0;i<avail;i++)
+ {if (fabs(x[i])>peak) peak=fabs(x[i]);
+  sum+=x[i]*x[i];
+ }
+ return (sum>0) ? peak/sqrt(sum/n) : 1;
+}
+
+/* the descriptors of frame f, with weights w (prev: those of frame
+   f-1, NULL for the first frame) */
+static void describe(const desc_job *job,long f,const double *w,
+                     const double *prev,double *out)
+{int    mask=job->d->mask;
+ long   i,n=job->n;
+ double total=0,moment=0,c,v;
+
+ for (i=0;i<n;i++) {total+=w[i]; moment+=job->dist[i]*w[i];}
+ c=(total!=0) ? moment/total : 0;
+ if (mask&descbank_centroid) *out++=c;
+ if (mask&descbank_width)
+ {for (v=0,i=0;i<n;i++) v+=fabs(job->dist[i]-c)*w[i];
+  *out++=(total!=0) ? v/total : 0;
+ }
+ if (mask&descbank_rolloff)
+ {for (v=0,i=0;i<n-1;i++) {v+=w[i]; if (v>=job->d->rolloff*total) break;}
+  *out++=job->dist[i];
+ }
+ if (mask&descbank_zcr) *out++=frame_zcr(job,f);
+ if (mask&descbank_crest)
+    *out++=(job->p!=NULL) ? crest(job->x+f*job->p->hop,frame_avail(job,f),job->p->width)
+                          : crest(w,n,n);
+ if (mask&descbank_flux)
+ {v=0;
+  if (prev!=NULL) for (i=0;i<n;i++) v+=(w[i]-prev[i])*(w[i]-prev[i]);
+  *out++=sqrt(v);
+ }
+}
+
+/* frames_per_task frames (runs on a thread) */
+static void desc_task(void *context,long index)
+{desc_job *job=(desc_job*)context;
+ long    f,first,last;
+ double *w,*prev,*tmp,*work=NULL;
+ float  *mags=NULL;
+
+ w=(double*)malloc(2*job->n*sizeof(double));
+ if (job->p!=NULL)
+ {work=(double*)malloc(stft_frame_work(job->p)*sizeof(double));
+  mags=(float*)malloc(job->n*sizeof(float));
+ }
+ if (w==NULL || (job->p!=NULL && (work==NULL || mags==NULL)))
+ {job->failed=1; free(w); free(work); free(mags); return;}
+ prev=w+job->n;
+ first=index*frames_per_task;
+ last=(first+frames_per_task<job->nframes) ? first+frames_per_task : job->nframes;
+ if ((job->d->mask&descbank_flux) && first>0)
+    frame_weights(job,first-1,prev,mags,work);
+ for (f=first;f<last;f++)
+ {frame_weights(job,f,w,mags,work);
+  describe(job,f,w,(f>0) ? prev : NULL,job->out+f*job->rows);
+  tmp=prev; prev=w; w=tmp;
+ }
+ free((w<prev) ? w : prev); free(work); free(mags);
+}
+
+static long run(desc_job *job)
+{
+ if (job->nframes>0 && job->rows>0)
+    parallel_for((job->nframes+frames_per_task-1)/frames_per_task,
+                 job->d->nthreads,desc_task,job);
+ free(job->dist);
+ return job->failed ? -1 : job->nframes;
+}
+
+long descbank_signal(const stft_plan *p,const double *x,long length,
+                     const descbank_params *d,double *out)
+{desc_job job;
+ long     i;
+
+ job.d=d; job.rows=descbank_rows(d->mask); job.out=out; job.failed=0;
+ job.nframes=stft_frames(p,length); job.n=p->nbins;
+ job.p=p; job.x=x; job.length=length; job.ani=NULL;
+ job.dist=(double*)malloc(job.n*sizeof(double));
+ if (job.dist==NULL) return -1;
+ for (i=0;i<job.n;i++) job.dist[i]=i*p->fs/p->nfft;
+ return run(&job);
+}
+
+long descbank_ani(const double *ani,long nchan,long ncols,
+                  const double *freqs,long width,long step,
+                  const descbank_params *d,double *out)
+{desc_job job;
+ long     i;
+
+ if ((d->mask&descbank_zcr) || nchan<1) return -1;
+ job.d=d; job.rows=descbank_rows(d->mask); job.out=out; job.failed=0;
+ job.nframes=descbank_ani_frames(ncols,width,step); job.n=nchan;
+ job.p=NULL; job.x=NULL; job.length=0;
+ job.ani=ani; job.width=width; job.step=step;
+ job.dist=(double*)malloc(job.n*sizeof(double));
+ if (job.dist==NULL) return -1;
+ for (i=0;i<job.n;i++) job.dist[i]=(freqs!=NULL) ? freqs[i] : i+1;
+ return run(&job);
+}
@@ -0,0 +1,60 @@
+/* descbank.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( DESCBANK_H )
+#define DESCBANK_H
+
+#include <stft.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* descriptors, combined in a bitmask; the rows of the output follow
+   the order of the bits */
+#define descbank_centroid  1  /* spectral centroid (IPEMCalcCentroid)     */
+#define descbank_width     2  /* centroid width (IPEMCalcCentroidWidth)    */
+#define descbank_rolloff   4  /* rolloff frequency (IPEMGetRolloff)        */
+#define descbank_zcr       8  /* zero-crossing rate (signal only)          */
+#define descbank_crest    16  /* crest factor (IPEMGetCrestFactor)         */
+#define descbank_flux     32  /* spectral flux (IPEMCalcFlux)              */
+#define descbank_all      63
+
+typedef struct{
+               int     mask;
+               double  rolloff;    /* fraction of the total weight   */
+               double  tolerance;  /* ZCR: values below it are 0     */
+               long    nthreads;   /* <= 0: parallel_threads()       */
+              } descbank_params;
+
+extern int  descbank_rows(int mask);
+extern long descbank_signal(const stft_plan *p,const double *x,long length,
+                            const descbank_params *d,double *out);
+extern long descbank_ani_frames(long ncols,long width,long step);
+extern long descbank_ani(const double *ani,long nchan,long ncols,
+                         const double *freqs,long width,long step,
+                         const descbank_params *d,double *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( DESCBANK_H ) */
@@ -0,0 +1,200 @@
+/* featbank.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    FEATURE BANK: RUNNING RMS, FLUX AND ENVELOPES OF AN ANI
+
+    Native version of IPEMCalcRMS, IPEMCalcFlux and IPEMEnvelopeFollower
+    for a multichannel signal (typically an auditory nerve image),
+    consumed frame by frame or in blocks of frames as they come out of
+    the model. The features asked for in the bitmask are computed in
+    one pass over each frame:
+
+      rms     every step frames, over the last width frames:
+                rms(p) = sqrt(sum(x(p,i:i+width-1).^2)/width)
+              (windows start at frame 0, step, 2*step, ... as in
+              IPEMCalcRMS)
+      flux    flux(j) = norm(x(:,j)-x(:,j-1)), flux(0) = 0
+      envelope  per channel, with a = |x(p,j)|:
+                e = a + (a>e ? attack : release)*(e-a)
+              attack/release = 2^(-1/(fs*time)), 0 for a time of 0
+
+    For the RMS, the squares are summed per chunk of step frames;
+    a window is made up of the last width/step whole chunks and the
+    part of the chunk that is being filled when it completes. The
+    whole chunks are kept as a running sum: a chunk is added when it
+    is complete and the one that leaves the window subtracted, so a
+    window costs the same whatever width/step. Every time the ring of
+    width/step+1 chunks wraps, the running sum is added up again from
+    the chunks, so that no rounding errors build up over long streams
+    (and the RMS of a window that is silent since then is exactly 0).
+
+ ************** list of routines and their function ******************
+
+    featbank_rms_frames(n,width,step)
+      Number of RMS frames for a signal of n frames.
+    featbank_open(s,nchan,mask,fs,width,step,attack,release)
+      Set up a streaming bank for nchan channels at fs Hz, computing
+      the features in mask. width and step (frames) are only used
+      for featbank_rms, attack and release (half-value times in s)
+      only for featbank_envelope. Returns 1 on success.
+    featbank_frame(s,in,rms,flux,env)
+      Consume one frame in[0..nchan-1]. The envelope is written to
+      env[0..nchan-1] and the flux to *flux; if a window completes,
+      its RMS values are written to rms[0..nchan-1] and 1 is
+      returned, else 0. Pointers of unused features may be NULL.
+    featbank_block(s,in,ncols,rms,flux,env)
+      Consume ncols frames (nchan x ncols, column major). flux and
+      env receive one value (column) per frame, rms one column per
+      completed window. Returns the number of RMS columns written.
+    featbank_close(s)
+      Release the bank.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include <featbank.h>
+
+static double half_value_coef(double fs,double time)
+{
+ if (time==0) return 0;
+ return pow(2.0,-1/(fs*time));
+}
+
+long featbank_rms_frames(long n,long width,long step)
+{
+ if ((width<1) || (step<1) || (n<width)) return 0;
+ return (n-width)/step+1;
+}
+
+int featbank_open(featbank_state *s,long nchan,int mask,double fs,
+                  long width,long step,double attack,double release)
+{long n;
+
+ s->nchan=nchan; s->mask=mask; s->nframes=0;
+ s->width=(width<1) ? 1 : width;
+ s->step=(step<1) ? 1 : step;
+ s->nchunks=(mask&featbank_rms) ? s->width/s->step+1 : 0;
+ s->attack=half_value_coef(fs,attack);
+ s->release=half_value_coef(fs,release);
+ n=(mask&featbank_rms) ? (s->nchunks+1)*nchan : 0;
+ if (mask&featbank_flux) n+=nchan;
+ if (mask&featbank_envelope) n+=nchan;
+ s->chunks=(double*)calloc(n+1,sizeof(double));
+ if (s->chunks==NULL) return 0;
+ s->sums=s->chunks+s->nchunks*nchan;
+ s->prev=s->sums+((mask&featbank_rms) ? nchan : 0);
+ s->env=s->prev+((mask&featbank_flux) ? nchan : 0);
+ return 1;
+}
+
+void featbank_close(featbank_state *s)
+{
+ free(s->chunks);
+ s->chunks=s->sums=s->prev=s->env=NULL;
+}
+
+static void chunk_done(featbank_state *s,long chunk)
+/*********************************************************************
+   Chunk is complete: update the running sum of the last q=width/step
+   whole chunks, chunk-q+1..chunk. Chunk chunk-q, which leaves it,
+   is still in the ring (in the slot of chunk+1).
+ *********************************************************************/
+{long    p,c,q=s->width/s->step;
+ double *u,*v;
+
+ if (q==0) return;
+ if (chunk%s->nchunks==0)
+ {for (p=0;p<s->nchan;p++) s->sums[p]=0;
+  for (c=(chunk-q+1<0) ? 0 : chunk-q+1;c<=chunk;c++)
+  {u=s->chunks+(c%s->nchunks)*s->nchan;
+   for (p=0;p<s->nchan;p++) s->sums[p]+=u[p];
+  }
+  return;
+ }
+ u=s->chunks+(chunk%s->nchunks)*s->nchan;
+ v=s->chunks+((chunk+1)%s->nchunks)*s->nchan;
+ for (p=0;p<s->nchan;p++)
+ {s->sums[p]+=u[p];
+  if (chunk-q>=0) s->sums[p]-=v[p];
+ }
+}
+
+int featbank_frame(featbank_state *s,const double *in,double *rms,
+                   double *flux,double *env)
+{long    p,chunk,used,q,r,first;
+ double *u=NULL,x,a,e,d,f=0,w;
+ int     mask=s->mask;
+
+ chunk=s->nframes/s->step; used=s->nframes%s->step;
+ if (mask&featbank_rms)
+ {u=s->chunks+(chunk%s->nchunks)*s->nchan;
+  if (used==0) for (p=0;p<s->nchan;p++) u[p]=0;
+ }
+ /* one pass over the channels for all features */
+ for (p=0;p<s->nchan;p++)
+ {x=in[p];
+  if (mask&featbank_rms) u[p]+=x*x;
+  if (mask&featbank_flux)
+  {d=x-s->prev[p]; f+=d*d; s->prev[p]=x;
+  }
+  if (mask&featbank_envelope)
+  {a=fabs(x); e=s->env[p];
+   e=a+((a>e) ? s->attack : s->release)*(e-a);
+   s->env[p]=e;
+  }
+ }
+ if ((mask&featbank_flux) && (flux!=NULL))
+    *flux=(s->nframes==0) ? 0 : sqrt(f);
+ if ((mask&featbank_envelope) && (env!=NULL))
+    for (p=0;p<s->nchan;p++) env[p]=s->env[p];
+ s->nframes++;
+
+ /* the window starting at chunk first ends after r frames of chunk
+    first+q, or with chunk first+q-1 if r is 0: it is the running sum
+    of the last q whole chunks, plus the r frames of chunk if r>0 */
+ if (!(mask&featbank_rms)) return 0;
+ q=s->width/s->step; r=s->width%s->step; used++;
+ if (used==s->step) chunk_done(s,chunk);
+ if ((r>0) && (used==r)) first=chunk-q;
+ else if ((r==0) && (used==s->step)) first=chunk-q+1;
+ else return 0;
+ if (first<0) return 0;
+ if (rms!=NULL)
+    for (p=0;p<s->nchan;p++)
+    {w=s->sums[p]+((r>0) ? u[p] : 0);
+     rms[p]=(w>0) ? sqrt(w/s->width) : 0;
+    }
+ return 1;
+}
+
+long featbank_block(featbank_state *s,const double *in,long ncols,
+                    double *rms,double *flux,double *env)
+{long j,n=0;
+
+ for (j=0;j<ncols;j++)
+    if (featbank_frame(s,in+j*s->nchan,(rms!=NULL) ? rms+n*s->nchan : NULL,
+                       (flux!=NULL) ? flux+j : NULL,
+                       (env!=NULL) ? env+j*s->nchan : NULL)) n++;
+ return n;
+}
@@ -0,0 +1,63 @@
+/* featbank.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( FEATBANK_H )
+#define FEATBANK_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* features, combined in a bitmask */
+#define featbank_rms       1  /* running RMS per channel (IPEMCalcRMS)          */
+#define featbank_flux      2  /* flux across channels (IPEMCalcFlux)            */
+#define featbank_envelope  4  /* envelope per channel (IPEMEnvelopeFollower)    */
+
+typedef struct{
+               long    nchan;
+               int     mask;
+               long    width;      /* RMS: frames per window          */
+               long    step;       /* RMS: frames between windows     */
+               double  attack;     /* envelope: coefficients          */
+               double  release;
+               long    nchunks;    /* RMS: chunks of step frames kept */
+               double *chunks;     /* sums of squares per chunk       */
+               double *sums;       /* RMS: running sum of the chunks  */
+               double *prev;       /* previous frame (flux)           */
+               double *env;        /* envelope state                  */
+               long    nframes;    /* frames consumed so far          */
+              } featbank_state;
+
+extern long featbank_rms_frames(long n,long width,long step);
+
+extern int  featbank_open(featbank_state *s,long nchan,int mask,double fs,
+                          long width,long step,double attack,double release);
+extern int  featbank_frame(featbank_state *s,const double *in,double *rms,
+                           double *flux,double *env);
+extern long featbank_block(featbank_state *s,const double *in,long ncols,
+                           double *rms,double *flux,double *env);
+extern void featbank_close(featbank_state *s);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( FEATBANK_H ) */
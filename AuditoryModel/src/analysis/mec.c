@@ -0,0 +1,110 @@
+/* mec.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    MINIMAL ENERGY CHANGE (MEC) PERIODICITY ANALYSIS
+
+    Native version of IPEMMECAnalysis. For every channel, evaluation
+    moment t (every step samples) and candidate period P the
+    difference value is |x(t)-x(t-P)|, where the signal is preceded
+    by max_period zeros. The values of one period are then leaky
+    integrated over the evaluation moments:
+
+        v(P,k) = coef*v(P,k-1) + |x(k*step)-x(k*step-P)|
+
+    Both are done in the same loop, one column (all periods of one
+    moment) at a time, so that the previous column is still in the
+    cache. The channels are independent and run on parallel threads.
+
+ ************** list of routines and their function ******************
+
+    mec_frames(n,step)
+      Number of evaluation moments for a signal of n samples.
+    mec_analysis(signal,nchan,n,min_period,max_period,step,coef,
+                 values,nthreads)
+      Analyse signal (nchan x n, column major, as in Matlab). The
+      periods and step are in samples, coef is the coefficient of the
+      leaky integration (0 for none, see context_coef). values[c]
+      receives the (max_period-min_period+1) x mec_frames(n,step)
+      values of channel c (column major, allocated by the caller).
+      nthreads <= 0 uses all processors. Returns 1 on success.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mec.h>
+#include <parallel.h>
+
+typedef struct{
+               const double *signal;
+               long          nchan,n;
+               long          min_period,max_period,step;
+               double        coef;
+               double      **values;
+               int           failed;
+              } mec_job;
+
+long mec_frames(long n,long step)
+{
+ return (n<=0) ? 0 : (n-1)/step+1;
+}
+
+static void mec_channel(void *context,long c)
+{mec_job *job=(mec_job*)context;
+ long     np=job->max_period-job->min_period+1,k,t,j;
+ double  *x,*col,*prev,xt,v,coef=job->coef;
+ const double *past;
+
+ /* the channel as a contiguous row, preceded by max_period zeros */
+ x=(double*)calloc(job->max_period+job->n,sizeof(double));
+ if (x==NULL) {job->failed=1; return;}
+ for (t=0;t<job->n;t++) x[job->max_period+t]=job->signal[t*job->nchan+c];
+
+ for (k=0,t=0;t<job->n;k++,t+=job->step)
+ {xt=x[job->max_period+t];
+  past=x+job->max_period+t-job->min_period;  /* past[-j] = x(t-P) */
+  col=job->values[c]+k*np; prev=col-np;
+  if ((k==0) || (coef==0))
+     for (j=0;j<np;j++) col[j]=fabs(xt-past[-j]);
+  else
+     for (j=0;j<np;j++)
+     {v=fabs(xt-past[-j]);
+      col[j]=prev[j]*coef+v;
+     }
+ }
+ free(x);
+}
+
+int mec_analysis(const double *signal,long nchan,long n,long min_period,
+                 long max_period,long step,double coef,double **values,
+                 long nthreads)
+{mec_job job;
+
+ if ((min_period<0) || (max_period<min_period) || (step<1)) return 0;
+ job.signal=signal; job.nchan=nchan; job.n=n;
+ job.min_period=min_period; job.max_period=max_period; job.step=step;
+ job.coef=coef; job.values=values; job.failed=0;
+ parallel_for(nchan,nthreads,mec_channel,&job);
+ return !job.failed;
+}
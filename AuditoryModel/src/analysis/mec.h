@@ -0,0 +1,38 @@
+/* mec.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( MEC_H )
+#define MEC_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+extern long mec_frames(long n,long step);
+extern int  mec_analysis(const double *signal,long nchan,long n,
+                         long min_period,long max_period,long step,
+                         double coef,double **values,long nthreads);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( MEC_H ) */
@@ -0,0 +1,249 @@
+/* mecsynth.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    MEC PATTERN EXTRACTION AND RESYNTHESIS
+
+    Native version of IPEMMECExtractPatterns and IPEMMECSynthesis.
+
+    The pattern of a channel at analysis moment k (every step samples)
+    is the period of length samples that ends just before sample
+    k*step (the signal being preceded by zeros), optionally rescaled
+    between 0 and 1, and rotated over k*step samples to account for
+    the phase (IPEMRotateMatrix):
+
+        out(j) = seg((j-k*step) mod length),  seg(i) = x(k*step-length+i)
+
+    It is extracted only for the moments asked for, instead of a
+    max_period x moments matrix per channel.
+
+    The resynthesis modulates band passed noise in every channel with
+    the repeated pattern of that channel, linearly interpolated from
+    the sample frequency of the pattern to that of the output (ratio
+    is their quotient), and optionally with its contrast enhanced:
+
+        m = ((m/norm)^3)*norm,  norm = max(abs(pattern))
+
+    The noise of a channel is one period of noise with a flat spectrum
+    in its band and random phases (inverse FFT, as in
+    IPEMGenerateBandPassedNoise with a given FFT width), at the level
+    asked for (dB as in IPEMAdaptLevel), computed once and repeated.
+    Output sample t then only depends on t: any block of the output
+    can be computed on its own, and blocks run on parallel threads.
+
+ ************** list of routines and their function ******************
+
+    mecsynth_extract(x,stride,n,step,k,length,rescale,out)
+      Pattern of length samples at moment k (0 based) of the channel
+      x[0], x[stride], ... x[(n-1)*stride], into out[0..length-1].
+    mecsynth_noise_open(z,nchan,bands,fs,period,level,seed)
+      Compute a period of period samples of noise at fs Hz for nchan
+      channels, the band of channel c being bands[c]..bands[nchan+c]
+      (Hz, a column major nchan x 2 matrix as in Matlab), at level dB.
+      seed (any value) selects the random phases. Returns 1 on
+      success.
+    mecsynth_noise_close(z)
+      Release the noise.
+    mecsynth_render(z,patterns,ratio,contrast,first,count,sound,
+                    channels,stride)
+      Output samples first..first+count-1: the sum of the channels
+      into sound[0..count-1] and channel c of sample i into
+      channels[i*stride+c] (either may be NULL).
+    mecsynth_render_all(z,patterns,ratio,contrast,count,sound,
+                        channels,nthreads)
+      Samples 0..count-1, in blocks on nthreads threads (<= 0: all
+      processors); channels is nchan x count.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include <parallel.h>
+#include <stft.h>
+#include <mecsynth.h>
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define block_size  4096    /* output samples per parallel task */
+#define chunk_size  256     /* samples modulated at a time      */
+
+/* Patterns */
+
+void mecsynth_extract(const double *x,long stride,long n,long step,
+                      long k,long length,int rescale,double *out)
+{long   i,j,start=k*step-length,shift;
+ double v,min=0,max=0;
+
+ if (length<1) return;
+ shift=(k*step)%length;
+ for (i=0;i<length;i++)
+ {v=(start+i>=0 && start+i<n) ? x[(start+i)*stride] : 0;
+  if (i==0 || v<min) min=v;
+  if (i==0 || v>max) max=v;
+  j=(i+shift)%length;
+  out[j]=v;
+ }
+ if (rescale)
+    for (j=0;j<length;j++) out[j]=(max!=min) ? (out[j]-min)/(max-min) : 0;
+}
+
+/* Noise */
+
+/* uniform in [0,1) (xorshift64*) */
+static double uniform(unsigned long long *state)
+{
+ *state^=*state>>12; *state^=*state<<25; *state^=*state>>27;
+ return ((*state*2685821657736338717ULL)>>11)*(1.0/9007199254740992.0);
+}
+
+int mecsynth_noise_open(mecsynth_noise *z,long nchan,const double *bands,
+                        double fs,long period,double level,unsigned long seed)
+{unsigned long long state=seed*6364136223846793005ULL+1442695040888963407ULL;
+ stft_fft f;
+ long     c,k,lo,hi,nbins=period/2+1;
+ double  *re,*im,*work,*x,phase,rms;
+
+ z->nchan=nchan; z->period=period;
+ z->noise=NULL;
+ if (nchan<1 || period<1 || fs<=0 || !stft_fft_open(&f,period)) return 0;
+ z->noise=(double*)malloc(nchan*period*sizeof(double));
+ re=(double*)malloc(2*nbins*sizeof(double)); im=re+nbins;
+ work=(double*)malloc(stft_fft_work(&f)*sizeof(double));
+ if (z->noise==NULL || re==NULL || work==NULL)
+ {free(re); free(work); stft_fft_close(&f); mecsynth_noise_close(z); return 0;}
+ for (c=0;c<nchan;c++)
+ {lo=(long)floor(fmin(bands[c],bands[nchan+c])/fs*period+0.5);
+  hi=(long)floor(fmax(bands[c],bands[nchan+c])/fs*period+0.5);
+  if (lo<0) lo=0;
+  if (hi>nbins-1) hi=nbins-1;
+  for (k=0;k<nbins;k++)
+  {re[k]=im[k]=0;
+   phase=2*M_PI*uniform(&state);
+   if (k<lo || k>hi) continue;
+   if (k==0 || 2*k==period) re[k]=(phase<M_PI) ? 1 : -1;
+   else {re[k]=cos(phase); im[k]=sin(phase);}
+  }
+  x=z->noise+c*period;
+  stft_fft_inverse(&f,re,im,x,work);
+  for (rms=0,k=0;k<period;k++) rms+=x[k]*x[k];
+  rms=sqrt(rms/period);
+  if (rms>0) for (k=0;k<period;k++) x[k]*=pow(10,level/20)/rms;
+ }
+ free(re); free(work);
+ stft_fft_close(&f);
+ return 1;
+}
+
+void mecsynth_noise_close(mecsynth_noise *z)
+{
+ free(z->noise); z->noise=NULL;
+}
+
+/* Resynthesis */
+
+void mecsynth_render(const mecsynth_noise *z,
+                     const mecsynth_pattern *patterns,
+                     double ratio,int contrast,long first,long count,
+                     double *sound,double *channels,long stride)
+{const mecsynth_pattern *p;
+ const double *v,*noise;
+ long   i,j,k,n,s,r,c,i0,i1,q,length;
+ double u,frac,d,scale;
+ double m[chunk_size];
+
+ if (sound!=NULL) for (i=0;i<count;i++) sound[i]=0;
+ u=first*ratio;
+ for (c=0;c<z->nchan;c++)
+ {p=patterns+c; v=p->values; length=p->length;
+  noise=z->noise+c*z->period;
+  if (length<1)
+  {if (channels!=NULL) for (i=0;i<count;i++) channels[i*stride+c]=0;
+   continue;
+  }
+  scale=(contrast && p->norm>0) ? 1/(p->norm*p->norm) : 0;
+
+  /* the position in the pattern and in the noise move on by ratio and
+     1 per sample; the modulation is linear between two pattern samples,
+     so it is computed a segment at a time, then applied to the noise a
+     run (up to the end of the noise period) at a time */
+  i0=(long)floor(u); frac=u-i0; i0%=length;
+  q=first%z->period;
+  for (i=0;i<count;i+=n)
+  {n=(count-i<chunk_size) ? count-i : chunk_size;
+   for (k=0;k<n;k+=s)
+   {i1=(i0+1<length) ? i0+1 : 0;
+    d=v[i1]-v[i0];
+    s=(long)ceil((1-frac)/ratio);
+    if (s<1) s=1;
+    if (s>n-k) s=n-k;
+    for (j=0;j<s;j++) m[k+j]=v[i0]+d*(frac+j*ratio);
+    frac+=s*ratio;
+    if (frac>=1)
+    {i0=(i0+(long)floor(frac))%length; frac-=floor(frac);
+    }
+   }
+   if (scale>0) for (k=0;k<n;k++) m[k]=m[k]*m[k]*m[k]*scale;
+   for (k=0;k<n;k+=r)
+   {r=(z->period-q<n-k) ? z->period-q : n-k;
+    for (j=0;j<r;j++) m[k+j]*=noise[q+j];
+    q+=r; if (q==z->period) q=0;
+   }
+   if (sound!=NULL) for (k=0;k<n;k++) sound[i+k]+=m[k];
+   if (channels!=NULL) for (k=0;k<n;k++) channels[(i+k)*stride+c]=m[k];
+  }
+ }
+}
+
+typedef struct{
+               const mecsynth_noise   *z;
+               const mecsynth_pattern *patterns;
+               double  ratio;
+               int     contrast;
+               long    count;
+               double *sound,*channels;
+              } render_job;
+
+/* block index of the output (runs on a thread) */
+static void render_task(void *context,long index)
+{render_job *job=(render_job*)context;
+ long first=index*block_size,count=job->count-first;
+
+ if (count>block_size) count=block_size;
+ mecsynth_render(job->z,job->patterns,job->ratio,job->contrast,first,count,
+                 (job->sound!=NULL) ? job->sound+first : NULL,
+                 (job->channels!=NULL) ? job->channels+first*job->z->nchan : NULL,
+                 job->z->nchan);
+}
+
+void mecsynth_render_all(const mecsynth_noise *z,
+                         const mecsynth_pattern *patterns,
+                         double ratio,int contrast,long count,
+                         double *sound,double *channels,long nthreads)
+{render_job job;
+
+ job.z=z; job.patterns=patterns; job.ratio=ratio; job.contrast=contrast;
+ job.count=count; job.sound=sound; job.channels=channels;
+ if (count>0)
+    parallel_for((count+block_size-1)/block_size,nthreads,render_task,&job);
+}
@@ -0,0 +1,66 @@
+/* mecsynth.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( MECSYNTH_H )
+#define MECSYNTH_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* one period of band passed noise per channel, computed once */
+typedef struct{
+               long    nchan;
+               long    period;     /* samples per period            */
+               double *noise;      /* nchan x period, row by row    */
+              } mecsynth_noise;
+
+/* the pattern that modulates a channel */
+typedef struct{
+               const double *values;
+               long          length;
+               double        norm;     /* max(abs(values)), for the  */
+                                       /* contrast enhancement       */
+              } mecsynth_pattern;
+
+extern void mecsynth_extract(const double *x,long stride,long n,long step,
+                             long k,long length,int rescale,double *out);
+
+extern int  mecsynth_noise_open(mecsynth_noise *z,long nchan,
+                                const double *bands,double fs,long period,
+                                double level,unsigned long seed);
+extern void mecsynth_noise_close(mecsynth_noise *z);
+
+extern void mecsynth_render(const mecsynth_noise *z,
+                            const mecsynth_pattern *patterns,
+                            double ratio,int contrast,long first,long count,
+                            double *sound,double *channels,long stride);
+extern void mecsynth_render_all(const mecsynth_noise *z,
+                                const mecsynth_pattern *patterns,
+                                double ratio,int contrast,long count,
+                                double *sound,double *channels,
+                                long nthreads);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( MECSYNTH_H ) */
@@ -0,0 +1,511 @@
+/* onset.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    STREAMING ONSET DETECTION
+
+    Native version of IPEMCalcOnsetsFromANI, fed with the frames of an
+    auditory nerve image as they come out of the model. The chain of
+    the Matlab version is followed step by step, but each step only
+    keeps the frames it still needs:
+
+      1. running RMS per channel over 29 ms, every 5.8 ms (featbank)
+      2. second order Butterworth low-pass at 15 Hz (as filter), of
+         which the output is advanced by the delay of the peak of its
+         impulse response (the first frames are dropped)
+      3. peak picking per channel (IPEMOnsetPeakDetection1Channel,
+         method Peak4): clipping below 0.06, 0.5 s median filter
+         (medfilt1, zero padded), all peaks (IPEMFindAllPeaks,
+         'center'), removal of peaks whose nearest minimum to the left
+         is above 90% of the peak, of peaks masked by an earlier one
+         (IPEMCreateMask, 0.2 s half decay), of peaks with a bigger
+         one within 35 ms and of peaks below 1.2 times the median;
+         the importance of a peak is 2*(peak-median)/median, clipped
+         to 1
+      4. upsampling by 16 (resample: windowed sinc, 10 zero crossings,
+         Kaiser window with beta 5)
+      5. integrate-and-fire neural net (IPEMOnsetPattern)
+      6. onset pattern filter (IPEMOnsetPatternFilter): an onset is
+         reported where at least 9/40 of the channels fire within
+         30 ms, at least 40 ms after the previous one
+
+    The peak picking decides about a peak as soon as the median and
+    the neighbourhood of the peak are known. A peak is only found at
+    the end of its plateau, so a pending plateau is given up once it
+    lasts longer than half the median filter: the output of step 3 is
+    then final a fixed number of frames (lag) after its input, about
+    0.28 s of RMS frames. With the 10 frames of the upsampling filter
+    and the 30 ms of the pattern filter, an onset is reported about
+    0.37 s (plus the length of an RMS window) after it was heard.
+    Exactly flat plateaus of that length do not occur in the filtered
+    RMS of an ANI, so the result is that of IPEMCalcOnsetsFromANI.
+
+ ************** list of routines and their function ******************
+
+    onset_open(s,nchan,fs,report,context)
+      Set up a detector for an ANI of nchan channels at fs Hz. Every
+      onset is passed to report(context,index,strength), with index
+      the sample of the onset in the onset signal of
+      IPEMCalcOnsetsFromANI (sample frequency s->onset_fs) and
+      strength the fraction of channels that fired. Returns 1 on
+      success.
+    onset_frame(s,in)
+      Consume one frame in[0..nchan-1] of the ANI.
+    onset_block(s,in,ncols)
+      Consume ncols frames (nchan x ncols, column major).
+    onset_finish(s)
+      End of the ANI: report the remaining onsets and return the
+      length of the onset signal (samples).
+    onset_close(s)
+      Release the detector.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <onset.h>
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+/* IPEMCalcOnsetsFromANI */
+#define rms_width       0.029   /* s */
+#define rms_interval    0.0058  /* s */
+#define cutoff          15.0    /* Hz */
+#define max_impulse     4096    /* samples of the impulse response searched */
+/* IPEMOnsetPeakDetection1Channel */
+#define clip_limit      0.06
+#define clip_to         0.05
+#define neighbourhood   0.07    /* s */
+#define median_width    0.5     /* s */
+#define valley_factor   0.9
+#define mask_period     0.2     /* s */
+#define median_factor   1.2
+/* resample(x,16,1) */
+#define up_factor       16
+#define up_zeros        10
+#define kaiser_beta     5.0
+/* IPEMOnsetPattern */
+#define dissipation     0.4
+#define n_adjacent      6
+#define n_feedback      20
+#define ext_weight      2.0
+#define int_weight      0.5
+#define threshold       7.0
+#define refractory      0.04    /* s */
+/* IPEMOnsetPatternFilter */
+#define pattern_width   0.03    /* s */
+#define min_fraction    (9.0/40)
+#define min_distance    0.04    /* s */
+
+#define up_columns      (2*up_zeros+1)
+#define up_half         (up_zeros*up_factor)
+
+static long round_positive(double x)
+{
+ return (long)floor(x+0.5);
+}
+
+static long min_long(long a,long b) {return (a<b) ? a : b;}
+static long max_long(long a,long b) {return (a>b) ? a : b;}
+
+/* Low-pass filter */
+
+static void butter2(double wn,double *b,double *a)
+/*********************************************************************
+   butter(2,wn): bilinear transform with prewarping
+ *********************************************************************/
+{double k=tan(M_PI*wn/2),n;
+
+ n=1/(1+sqrt(2.0)*k+k*k);
+ b[0]=k*k*n; b[1]=2*b[0]; b[2]=b[0];
+ a[0]=1; a[1]=2*(k*k-1)*n; a[2]=(1-sqrt(2.0)*k+k*k)*n;
+}
+
+static long impulse_peak(const double *b,const double *a)
+{double x,y,z1=0,z2=0,max=0;
+ long   n,res=0;
+
+ for (n=0;n<max_impulse;n++)
+ {x=(n==0) ? 1 : 0;
+  y=b[0]*x+z1; z1=b[1]*x+z2-a[1]*y; z2=b[2]*x-a[2]*y;
+  if ((n==0) || (y>max)) {max=y; res=n;}
+ }
+ return res;
+}
+
+/* Upsampling filter */
+
+static double bessel_i0(double x)
+{double sum=1,term=1;
+ int    k;
+
+ for (k=1;k<50;k++)
+ {term*=(x/(2*k))*(x/(2*k));
+  sum+=term;
+  if (term<1e-12*sum) break;
+ }
+ return sum;
+}
+
+static void design_filter(double *h)
+{long   j;
+ double x,sum=0;
+
+ for (j=-up_half;j<=up_half;j++)
+ {x=(double)j/up_factor;
+  h[j+up_half]=(j==0) ? 1 : sin(M_PI*x)/(M_PI*x);
+  h[j+up_half]*=bessel_i0(kaiser_beta*sqrt(1-((double)j/up_half)*((double)j/up_half)))
+                /bessel_i0(kaiser_beta);
+  sum+=h[j+up_half];
+ }
+ for (j=0;j<=2*up_half;j++) h[j]*=up_factor/sum;
+}
+
+/* Setup */
+
+int onset_open(onset_state *s,long nchan,double fs,onset_report report,
+               void *context)
+{long   width,step,n,p;
+ int    ok;
+ onset_channel *ch;
+
+ memset(s,0,sizeof(onset_state));
+ s->nchan=nchan; s->report=report; s->context=context;
+ width=round_positive(rms_width/(1/fs));
+ step=round_positive(rms_interval/(1/fs));
+ if ((nchan<1) || (width<1) || (step<1)) return 0;
+ s->rms_fs=fs/step;
+ if (2*cutoff>=s->rms_fs) return 0;
+ butter2(cutoff/(s->rms_fs/2),s->b,s->a);
+ s->delay=impulse_peak(s->b,s->a);
+
+ n=max_long(round_positive(median_width*s->rms_fs),1);
+ s->lo=n/2; s->hi=n-1-s->lo;
+ s->half=round_positive(neighbourhood*s->rms_fs)/2;
+ s->cap=s->hi;
+ s->lag=max_long(s->hi,s->half+s->cap);
+ s->ring=max_long(n,s->lag+s->half)+2;
+ s->mask_coef=-log(0.5)/(mask_period*s->rms_fs);
+
+ s->onset_fs=s->rms_fs*up_factor;
+ s->dt=1/s->onset_fs;
+ s->width=max_long(round_positive(pattern_width*s->onset_fs),1);
+ s->distance=max_long(round_positive(min_distance*s->onset_fs),1);
+
+ ok=featbank_open(&s->bank,nchan,featbank_rms,fs,width,step,0,0);
+ s->rms=(double*)calloc(nchan,sizeof(double));
+ s->z=(double*)calloc(2*nchan,sizeof(double));
+ s->chan=(onset_channel*)calloc(nchan,sizeof(onset_channel));
+ s->filter=(double*)calloc(2*up_half+1,sizeof(double));
+ s->columns=(double*)calloc(up_columns*nchan,sizeof(double));
+ s->nonzero=(char*)calloc(up_columns,sizeof(char));
+ s->up=(double*)calloc(nchan,sizeof(double));
+ s->accu=(double*)calloc(nchan,sizeof(double));
+ s->refract=(double*)calloc(nchan,sizeof(double));
+ s->fired=(char*)calloc(2*nchan,sizeof(char));
+ s->counts=(long*)calloc(s->width+2,sizeof(long));
+ if (!ok || (s->rms==NULL) || (s->z==NULL) || (s->chan==NULL)
+     || (s->filter==NULL) || (s->columns==NULL) || (s->nonzero==NULL)
+     || (s->up==NULL) || (s->accu==NULL) || (s->refract==NULL)
+     || (s->fired==NULL) || (s->counts==NULL))
+ {onset_close(s); return 0;
+ }
+ s->fired_prev=s->fired+nchan;
+ design_filter(s->filter);
+
+ for (p=0;p<nchan;p++)
+ {ch=s->chan+p;
+  ch->c=(double*)calloc(4*s->ring+n+1,sizeof(double));
+  ch->peaks=(onset_peak*)calloc(s->ring,sizeof(onset_peak));
+  if ((ch->c==NULL) || (ch->peaks==NULL)) {onset_close(s); return 0;}
+  ch->valley=ch->c+s->ring;
+  ch->median=ch->valley+s->ring;
+  ch->importance=ch->median+s->ring;
+  ch->window=ch->importance+s->ring;
+  ch->nwindow=s->lo;   /* the zeros before the signal */
+  ch->start=-1; ch->mask_index=-1;
+ }
+ return 1;
+}
+
+void onset_close(onset_state *s)
+{long p;
+
+ if (s->chan!=NULL)
+    for (p=0;p<s->nchan;p++) {free(s->chan[p].c); free(s->chan[p].peaks);}
+ featbank_close(&s->bank);
+ free(s->rms); free(s->z); free(s->chan); free(s->filter);
+ free(s->columns); free(s->nonzero); free(s->up); free(s->accu);
+ free(s->refract); free(s->fired); free(s->counts);
+ s->chan=NULL;
+}
+
+/* Step 6: onset pattern filter */
+
+static void inspect(onset_state *s,int end)
+{long   i,k,last,total,len=s->width+2;
+ double fraction;
+
+ for (;;)
+ {i=s->next;
+  if (end) {if (i>=s->nsamples-1) break;}
+  else if (i+max_long(s->width-1,1)>=s->nsamples) break;
+  if (s->counts[i%len]==0) {s->next++; continue;}
+  last=min_long(i+s->width-1,s->nsamples-1);
+  for (total=0,k=i;k<=last;k++) total+=s->counts[k%len];
+  fraction=(double)total/s->nchan;
+  if (fraction>=min_fraction)
+  {if (s->report!=NULL) s->report(s->context,i,fraction);
+   s->next+=s->distance;
+  }
+  else s->next++;
+ }
+}
+
+/* Step 5: integrate-and-fire neural net */
+
+static void fire(onset_state *s,const double *u)
+{long   n=s->nchan,i,k,fb,count=0;
+ double in;
+ char  *tmp;
+
+ for (i=0;i<n;i++)
+ {in=0;
+  for (k=max_long(0,i-n_adjacent/2);k<=min_long(n-1,i+n_adjacent/2);k++)
+     in+=u[k]*ext_weight;
+  for (fb=0,k=max_long(0,i-n_feedback/2);k<=min_long(n-1,i+n_feedback/2);k++)
+     if ((k!=i) && s->fired_prev[k]) fb++;
+  in+=fb*int_weight;
+  if (s->refract[i]>0) {s->refract[i]-=s->dt; in=0;}
+  s->accu[i]=(1-dissipation)*s->accu[i]+in;
+  s->fired[i]=(s->accu[i]>threshold);
+  if (s->fired[i]) {s->accu[i]=0; s->refract[i]=refractory; count++;}
+ }
+ tmp=s->fired_prev; s->fired_prev=s->fired; s->fired=tmp;
+
+ s->counts[s->nsamples%(s->width+2)]=count;
+ s->nsamples++;
+ inspect(s,0);
+}
+
+/* Step 4: upsampling */
+
+static void upsample(onset_state *s,long m)
+/*********************************************************************
+   Output samples up_factor*m ... up_factor*(m+1)-1 of
+   resample(x,16,1), from the columns m-up_zeros ... m+up_zeros that
+   have been received.
+ *********************************************************************/
+{long          n,r,j,p;
+ const double *col;
+ double        h;
+
+ for (r=0;r<up_factor;r++)
+ {for (p=0;p<s->nchan;p++) s->up[p]=0;
+  for (n=max_long(0,m-up_zeros);n<=min_long(m+up_zeros,s->ncolumns-1);n++)
+  {j=up_factor*(m-n)+r+up_half;
+   if ((j>2*up_half) || !s->nonzero[n%up_columns]) continue;
+   col=s->columns+(n%up_columns)*s->nchan; h=s->filter[j];
+   for (p=0;p<s->nchan;p++) s->up[p]+=col[p]*h;
+  }
+  fire(s,s->up);
+ }
+}
+
+static void emit_column(onset_state *s,long j)
+{double *col=s->columns+(s->ncolumns%up_columns)*s->nchan;
+ char    nonzero=0;
+ long    p;
+
+ for (p=0;p<s->nchan;p++)
+ {col[p]=s->chan[p].importance[j%s->ring];
+  s->chan[p].importance[j%s->ring]=0;
+  if (col[p]!=0) nonzero=1;
+ }
+ s->nonzero[s->ncolumns%up_columns]=nonzero;
+ s->ncolumns++;
+ if (s->ncolumns>up_zeros) upsample(s,s->ncolumns-1-up_zeros);
+}
+
+/* Step 3: peak picking */
+
+static void window_insert(onset_channel *ch,double v)
+{long lo=0,hi=ch->nwindow,mid;
+
+ while (lo<hi) {mid=(lo+hi)/2; if (ch->window[mid]<v) lo=mid+1; else hi=mid;}
+ memmove(ch->window+lo+1,ch->window+lo,(ch->nwindow-lo)*sizeof(double));
+ ch->window[lo]=v; ch->nwindow++;
+}
+
+static void window_remove(onset_channel *ch,double v)
+{long lo=0,hi=ch->nwindow-1,mid;
+
+ while (lo<hi) {mid=(lo+hi)/2; if (ch->window[mid]<v) lo=mid+1; else hi=mid;}
+ ch->nwindow--;
+ memmove(ch->window+lo,ch->window+lo+1,(ch->nwindow-lo)*sizeof(double));
+}
+
+static void slide(onset_state *s,onset_channel *ch,long k,double v)
+/*********************************************************************
+   Frame k of the clipped signal (v, 0 beyond the end) enters the
+   median filter, which then covers frames k-lo-hi ... k.
+ *********************************************************************/
+{long j=k-(s->lo+s->hi+1),n;
+
+ window_insert(ch,v);
+ if (k>s->hi) window_remove(ch,(j<0) ? 0 : ch->c[j%s->ring]);
+ if (k>=s->hi)
+ {n=ch->nwindow;
+  ch->median[(k-s->hi)%s->ring]=(n%2==1) ? ch->window[n/2]
+                                         : (ch->window[n/2-1]+ch->window[n/2])/2;
+ }
+}
+
+static void new_peak(onset_state *s,onset_channel *ch,long q)
+{double      level=ch->c[q%s->ring];
+ int         masked=0;
+ onset_peak *peak;
+
+ if (ch->valley[q%s->ring]>valley_factor*level) return;
+ /* the masks of all earlier peaks decay at the same rate: only the
+    dominant one is kept (a mask starts one frame after its peak) */
+ if (ch->mask_index>=0)
+ {masked=(ch->mask*exp(-(q-ch->mask_index-1)*s->mask_coef)>level);
+  if (level>=ch->mask*exp(-(q-ch->mask_index)*s->mask_coef)) ch->mask_index=-1;
+ }
+ if (ch->mask_index<0) {ch->mask=level; ch->mask_index=q;}
+ if (masked) return;
+ /* decided peaks left of the neighbourhoods still to come are no longer needed */
+ while ((ch->npeaks>0) && ch->peaks[ch->first].decided
+        && (ch->peaks[ch->first].index<q-s->half))
+ {ch->first=(ch->first+1)%s->ring; ch->npeaks--;
+ }
+ peak=ch->peaks+(ch->first+ch->npeaks)%s->ring;
+ peak->index=q; peak->value=level; peak->decided=0;
+ ch->npeaks++;
+}
+
+static void decide(onset_state *s,onset_channel *ch,onset_peak *q)
+/*********************************************************************
+   As in Peak4, the peaks left of q have already been replaced by
+   their importance (or 0) when q is compared with its neighbourhood.
+ *********************************************************************/
+{double      max=q->value,med,res=0;
+ onset_peak *r;
+ long        i;
+
+ for (i=0;i<ch->npeaks;i++)
+ {r=ch->peaks+(ch->first+i)%s->ring;
+  if (r->index<q->index-s->half) continue;
+  if (r->index>q->index+s->half) break;
+  if (r->value>max) max=r->value;
+ }
+ med=ch->median[q->index%s->ring];
+ if (!(q->value<max) && !(q->value<median_factor*med))
+    res=(q->value-med)/med;
+ q->value=res; q->decided=1;
+ ch->importance[q->index%s->ring]=(res>0) ? ((2*res<1) ? 2*res : 1) : 0;
+}
+
+static void decide_ready(onset_state *s,onset_channel *ch,long t,int end)
+/*********************************************************************
+   Decide the peaks of which the median and the neighbourhood are
+   known after frame t (all of them at the end).
+ *********************************************************************/
+{long        bound,i;
+ onset_peak *q;
+
+ /* no peak to come lies before bound */
+ bound=(ch->start>=0) ? ch->start+1 : t+1;
+ for (i=0;i<ch->npeaks;i++)
+ {q=ch->peaks+(ch->first+i)%s->ring;
+  if (q->decided) continue;
+  if (!end && ((q->index+s->hi>t) || (q->index+s->half>=bound))) break;
+  decide(s,ch,q);
+ }
+}
+
+static void pick(onset_state *s,const double *x)
+{long           t=s->npicked,p,r=s->ring;
+ double         c,d;
+ onset_channel *ch;
+
+ for (p=0;p<s->nchan;p++)
+ {ch=s->chan+p;
+  c=(x[p]<clip_limit) ? clip_to : x[p];
+  ch->c[t%r]=c;
+  /* value of the nearest minimum to the left (IPEMFindNearestMinima) */
+  ch->valley[t%r]=((t>0) && !(ch->c[(t-1)%r]>c)) ? ch->valley[(t-1)%r] : c;
+  slide(s,ch,t,c);
+  /* IPEMFindAllPeaks, 'center' */
+  if (t>0)
+  {d=c-ch->c[(t-1)%r];
+   if (d>0) ch->start=t-1;
+   else if ((d<0) && (ch->start>=0)) {new_peak(s,ch,(t+ch->start)/2); ch->start=-1;}
+   if ((ch->start>=0) && (t-ch->start>s->cap)) ch->start=-1;
+  }
+  decide_ready(s,ch,t,0);
+ }
+ s->npicked++;
+ if (t>=s->lag) emit_column(s,t-s->lag);
+}
+
+/* Steps 1 and 2 */
+
+void onset_frame(onset_state *s,const double *in)
+{long   p;
+ double x,y,*z;
+
+ if (!featbank_frame(&s->bank,in,s->rms,NULL,NULL)) return;
+ /* direct form II transposed, as filter */
+ for (p=0;p<s->nchan;p++)
+ {x=s->rms[p]; z=s->z+2*p;
+  y=s->b[0]*x+z[0];
+  z[0]=s->b[1]*x+z[1]-s->a[1]*y;
+  z[1]=s->b[2]*x-s->a[2]*y;
+  s->rms[p]=y;
+ }
+ if (s->delay>0) {s->delay--; return;}
+ pick(s,s->rms);
+}
+
+void onset_block(onset_state *s,const double *in,long ncols)
+{long j;
+
+ for (j=0;j<ncols;j++) onset_frame(s,in+j*s->nchan);
+}
+
+long onset_finish(onset_state *s)
+{long n=s->npicked,k,p,j;
+
+ for (p=0;p<s->nchan;p++)
+ {for (k=n;k<n+s->hi;k++) slide(s,s->chan+p,k,0);
+  decide_ready(s,s->chan+p,n-1,1);
+ }
+ for (j=max_long(0,n-s->lag);j<n;j++) emit_column(s,j);
+ for (j=max_long(0,s->ncolumns-up_zeros);j<s->ncolumns;j++) upsample(s,j);
+ inspect(s,1);
+ return s->nsamples;
+}
@@ -0,0 +1,108 @@
+/* onset.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( ONSET_H )
+#define ONSET_H
+
+#include <featbank.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* called for every onset: index of the onset in the onset signal (sample
+   frequency onset_fs), strength between 0 and 1 */
+typedef void (*onset_report)(void *context,long index,double strength);
+
+typedef struct{
+               long   index;
+               double value;      /* level, or importance once decided */
+               int    decided;
+              } onset_peak;
+
+/* peak picking in one channel */
+typedef struct{
+               double     *c;          /* clipped signal (ring)            */
+               double     *valley;     /* nearest minimum to the left      */
+               double     *median;     /* median filtered signal (ring)    */
+               double     *importance; /* importances of the peaks (ring)  */
+               double     *window;     /* sorted values under the median   */
+               long        nwindow;
+               long        start;      /* start of a rise (-1 if none)     */
+               double      mask;       /* dominant mask, cast by the peak  */
+               long        mask_index; /* at mask_index (-1 if none)       */
+               onset_peak *peaks;      /* unmasked peaks (ring)            */
+               long        first;
+               long        npeaks;
+              } onset_channel;
+
+typedef struct{
+               long            nchan;
+               /* RMS and its low-pass filter */
+               featbank_state  bank;
+               double          rms_fs;
+               double         *rms;
+               double          b[3],a[3];
+               double         *z;          /* filter state, 2 per channel   */
+               long            delay;      /* filtered frames still to drop */
+               /* peak picking */
+               long            lo,hi;      /* reach of the median filter    */
+               long            half;       /* half width of a neighbourhood */
+               long            cap;        /* longest plateau of a peak     */
+               long            lag;        /* frames until a column is final */
+               long            ring;       /* length of the rings           */
+               double          mask_coef;
+               onset_channel  *chan;
+               long            npicked;    /* frames consumed               */
+               long            ncolumns;   /* final columns passed on       */
+               /* upsampling */
+               double         *filter;
+               double         *columns;    /* last 2*zeros+1 columns        */
+               char           *nonzero;
+               double         *up;
+               /* integrate-and-fire net */
+               double         *accu;
+               double         *refract;
+               char           *fired,*fired_prev;
+               double          dt;
+               /* onset pattern filter */
+               long           *counts;
+               long            width;
+               long            distance;
+               long            nsamples;   /* samples of the onset signal   */
+               long            next;       /* next sample to inspect        */
+               double          onset_fs;
+               onset_report    report;
+               void           *context;
+              } onset_state;
+
+extern int  onset_open(onset_state *s,long nchan,double fs,
+                       onset_report report,void *context);
+extern void onset_frame(onset_state *s,const double *in);
+extern void onset_block(onset_state *s,const double *in,long ncols);
+extern long onset_finish(onset_state *s);
+extern void onset_close(onset_state *s);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( ONSET_H ) */
@@ -0,0 +1,525 @@
+/* parallel.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    RUN INDEPENDENT TASKS ON SEVERAL THREADS
+
+    The native analysis kernels process channels (or other units of
+    work) that do not depend on each other. The tasks are handed out
+    one at a time, so that threads that finish early take over the
+    remaining work. Tasks must not call back into Matlab or Octave.
+
+ ************** list of routines and their function ******************
+
+    parallel_processors()
+      Number of processors that are online (at least 1).
+    parallel_for(count,nthreads,task,context)
+      Call task(context,i) for i=0..count-1 on at most nthreads
+      threads (the calling thread is one of them); nthreads <= 0
+      uses parallel_threads(). Returns when all tasks are done;
+      returns 0 if no thread could be started (the tasks have then
+      all been run by the calling thread).
+    parallel_steal(count,cost,nthreads,task,context)
+      As parallel_for, for tasks of very different sizes: cost[i] is
+      an estimate of the work of task i (in any unit; NULL if they are
+      all alike). The tasks are dealt, the most expensive first, to
+      one deque per thread, each time to the deque with the least
+      work. A thread runs its own deque from the front (expensive
+      tasks first) and, once it is empty, steals from the back of the
+      deque with the most work left, so that the threads run out of
+      work at about the same time whatever the spread of the costs.
+    parallel_spawn(t,task,context)
+      Start a detached thread that runs task(context,t), placed as
+      thread t (see below). Returns 0 if it could not be started.
+    parallel_nodes()
+      Number of NUMA nodes with processors (at least 1).
+    parallel_set_nodes(nnodes)
+      Place the threads of the routines above on the processors of
+      the first nnodes NUMA nodes (0, the default: let the system
+      place them): thread t is pinned to the t-th processor of a list
+      that takes one processor of each node in turn, and its stack,
+      which holds the thread local state of the model (the filter
+      and decimation coefficients, its blocks and buffers), is
+      placed on the node of that processor. What a thread allocates
+      and first touches itself then stays on its node as well. The
+      calling thread of parallel_for and parallel_steal is thread 0
+      while it takes part. Only on Linux; elsewhere a no-op.
+    parallel_threads()
+      Number of threads used by default (nthreads <= 0): one per
+      placed processor, or one per processor.
+
+ *********************************************************************/
+
+#if defined(__linux__)
+#define _GNU_SOURCE          /* for the affinity of threads */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <parallel.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef CRITICAL_SECTION mutex;
+typedef struct{HANDLE id;} thread;
+typedef DWORD (WINAPI   *thread_routine)(LPVOID);
+#define mutex_init(m)    InitializeCriticalSection(m)
+#define mutex_lock(m)    EnterCriticalSection(m)
+#define mutex_unlock(m)  LeaveCriticalSection(m)
+#define mutex_free(m)    DeleteCriticalSection(m)
+#define routine(name)    static DWORD WINAPI name(LPVOID arg)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t  mutex;
+typedef struct{
+               pthread_t      id;
+               void          *stack;      /* if placed, else NULL        */
+               size_t         size;
+              } thread;
+typedef void *(*thread_routine)(void*);
+#define mutex_init(m)    pthread_mutex_init(m,NULL)
+#define mutex_lock(m)    pthread_mutex_lock(m)
+#define mutex_unlock(m)  pthread_mutex_unlock(m)
+#define mutex_free(m)    pthread_mutex_destroy(m)
+#define routine(name)    static void *name(void *arg)
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define placement        1
+#define max_nodes        64         /* bits of the mask given to mbind  */
+#define max_cpus         1024
+#define mpol_preferred   1          /* MPOL_PREFERRED of linux/mempolicy.h */
+#define node_dir         "/sys/devices/system/node/node%d/cpulist"
+
+static long place_count=0;          /* placed processors, 0: no placement */
+static int  place_cpu[max_cpus];    /* processor of thread t%place_count  */
+static int  place_node[max_cpus];   /* and its node                       */
+#endif
+
+typedef struct{
+               parallel_task  task;
+               void          *context;
+               long           count;
+               long           next;       /* first task not handed out */
+               mutex          lock;
+              } work;
+
+typedef struct{
+               long          *items;      /* task numbers, dearest first */
+               long           head,tail;  /* items[head..tail-1] are left */
+               double         left;       /* cost of the tasks left      */
+               mutex          lock;
+              } deque;
+
+typedef struct{
+               parallel_task  task;
+               void          *context;
+               const double  *cost;
+               long           nthreads;
+               deque         *deques;
+              } pool;
+
+typedef struct{
+               pool          *p;
+               long           id;         /* the thread's own deque      */
+              } member;
+
+typedef struct{
+               double         cost;
+               long           index;
+              } ranked;
+
+typedef struct{
+               parallel_task  task;
+               void          *context;
+               long           index;
+              } spawned;
+
+long parallel_processors()
+{long n;
+
+#if defined(_WIN32)
+ SYSTEM_INFO info;
+
+ GetSystemInfo(&info); n=(long)info.dwNumberOfProcessors;
+#else
+ n=sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+ return (n<1) ? 1 : n;
+}
+
+#if defined(placement)
+static long read_cpulist(int node,int *cpus)
+/* the processors of a node, from its cpulist ("0-3,8-11"); returns
+   their number, 0 if the node does not exist or has none */
+{FILE *f;
+ char  name[64],list[4096],*s;
+ long  n=0,first,last;
+
+ sprintf(name,node_dir,node);
+ if ((f=fopen(name,"r"))==NULL) return 0;
+ if (fgets(list,sizeof(list),f)==NULL) list[0]='\0';
+ fclose(f);
+ for (s=list;(*s>='0') && (*s<='9');)
+ {first=last=strtol(s,&s,10);
+  if (*s=='-') last=strtol(s+1,&s,10);
+  for (;(first<=last) && (n<max_cpus);first++) cpus[n++]=(int)first;
+  if (*s==',') s++;
+ }
+ return n;
+}
+
+static void place_attr(pthread_attr_t *attr,thread *th,long t)
+/* pin thread t to its processor and give it a stack on its node */
+{cpu_set_t     set;
+ unsigned long mask;
+ size_t        size,page=(size_t)sysconf(_SC_PAGESIZE);
+ void         *stack;
+ int           node=place_node[t%place_count];
+
+ CPU_ZERO(&set); CPU_SET(place_cpu[t%place_count],&set);
+ pthread_attr_setaffinity_np(attr,sizeof(set),&set);
+ if ((node<0) || (node>=max_nodes)) return;
+ pthread_attr_getstacksize(attr,&size);
+ size=(size+page-1)/page*page;
+ stack=mmap(NULL,size+page,PROT_READ|PROT_WRITE,
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK,-1,0);
+ if (stack==MAP_FAILED) return;
+ /* nothing is touched yet: the pages, the thread local state at the
+    top included, come from the node when they are first written */
+ mask=1UL<<node;
+ syscall(SYS_mbind,stack,size+page,mpol_preferred,&mask,max_nodes+1,0);
+ mprotect(stack,page,PROT_NONE);                 /* guard page */
+ if (pthread_attr_setstack(attr,(char*)stack+page,size)!=0)
+ {munmap(stack,size+page); return;}
+ th->stack=stack; th->size=size+page;
+}
+#endif
+
+static int create_thread(thread *th,long t,thread_routine r,void *arg)
+/* start r on arg as thread t (placed if so asked); returns 0 if not */
+{
+#if defined(_WIN32)
+ th->id=CreateThread(NULL,0,r,arg,0,NULL);
+ return th->id!=NULL;
+#else
+ pthread_attr_t attr;
+ int            res;
+
+ th->stack=NULL; th->size=0;
+ if (pthread_attr_init(&attr)!=0) return 0;
+#if defined(placement)
+ if (place_count>0) place_attr(&attr,th,t);
+#endif
+ res=(pthread_create(&th->id,&attr,r,arg)==0);
+ pthread_attr_destroy(&attr);
+ if ((!res) && (th->stack!=NULL)) munmap(th->stack,th->size);
+ return res;
+#endif
+}
+
+static long start_threads(thread *threads,long count,thread_routine r,
+                          void *args,size_t size)
+/* start count threads running r, the i-th on args+i*size as thread
+   i+1 (the caller is thread 0); returns the number of threads started
+   (they are the first ones) */
+{long t;
+
+ for (t=0;t<count;t++)
+  if (!create_thread(&threads[t],t+1,r,(char*)args+t*size)) break;
+ return t;
+}
+
+static void join_threads(thread *threads,long count)
+{long t;
+
+ for (t=0;t<count;t++)
+ {
+#if defined(_WIN32)
+  WaitForSingleObject(threads[t].id,INFINITE); CloseHandle(threads[t].id);
+#else
+  pthread_join(threads[t].id,NULL);
+  if (threads[t].stack!=NULL) munmap(threads[t].stack,threads[t].size);
+#endif
+ }
+}
+
+#if defined(placement)
+static int pin_caller(cpu_set_t *saved)
+/* make the calling thread thread 0 while it takes part; returns 1 if
+   its affinity is to be restored from saved */
+{cpu_set_t set;
+
+ if (place_count==0) return 0;
+ if (pthread_getaffinity_np(pthread_self(),sizeof(*saved),saved)!=0) return 0;
+ CPU_ZERO(&set); CPU_SET(place_cpu[0],&set);
+ return pthread_setaffinity_np(pthread_self(),sizeof(set),&set)==0;
+}
+
+#define pinned(saved)    cpu_set_t saved; int saved##_pinned
+#define pin(saved)       saved##_pinned=pin_caller(&saved)
+#define unpin(saved)     if (saved##_pinned) \
+                           pthread_setaffinity_np(pthread_self(),sizeof(saved),&saved)
+#else
+#define pinned(saved)    int saved
+#define pin(saved)       saved=0
+#define unpin(saved)     (void)saved
+#endif
+
+long parallel_nodes()
+{
+#if defined(placement)
+ static int cpus[max_cpus];
+ long       n=0;
+ int        node;
+
+ for (node=0;node<max_nodes;node++) if (read_cpulist(node,cpus)>0) n++;
+ return (n<1) ? 1 : n;
+#else
+ return 1;
+#endif
+}
+
+void parallel_set_nodes(long nnodes)
+{
+#if defined(placement)
+ static int cpus[max_cpus],cpu[max_cpus],node_of[max_cpus];
+ cpu_set_t  allowed;
+ long       n=0,k,c,i,nodes=0,round,taken;
+ int        node,ids[max_nodes];
+
+ place_count=0;
+ if (nnodes<=0) return;
+ if (sched_getaffinity(0,sizeof(allowed),&allowed)!=0) CPU_ZERO(&allowed);
+ /* the allowed processors of the first nnodes nodes, node by node */
+ for (node=0;(node<max_nodes) && (nodes<nnodes);node++)
+ {k=read_cpulist(node,cpus);
+  for (c=0,i=n;c<k;c++)
+   if (CPU_ISSET(cpus[c],&allowed)) {cpu[n]=cpus[c]; node_of[n++]=node;}
+  if (n>i) ids[nodes++]=node;
+ }
+ if (n==0)
+ {/* no NUMA information: one node of all allowed processors */
+  for (c=0;(c<CPU_SETSIZE) && (n<max_cpus);c++)
+   if (CPU_ISSET(c,&allowed)) {cpu[n]=c; node_of[n++]=-1;}
+  nodes=1; ids[0]=-1;
+ }
+ /* deal them out one node at a time, so that the first threads are
+    spread over the nodes */
+ for (round=0;place_count<n;round++)
+  for (k=0;k<nodes;k++)
+   for (i=0,taken=0;i<n;i++)
+    if ((node_of[i]==ids[k]) && (taken++==round))
+    {place_cpu[place_count]=cpu[i]; place_node[place_count++]=node_of[i];
+     break;
+    }
+#else
+ (void)nnodes;
+#endif
+}
+
+long parallel_threads()
+{
+#if defined(placement)
+ if (place_count>0) return place_count;
+#endif
+ return parallel_processors();
+}
+
+routine(spawn_start)
+{spawned s=*(spawned*)arg;
+
+ free(arg);
+ s.task(s.context,s.index);
+ return 0;
+}
+
+int parallel_spawn(long t,parallel_task task,void *context)
+{spawned *s=malloc(sizeof(spawned));
+ thread   th;
+
+ if (s==NULL) return 0;
+ s->task=task; s->context=context; s->index=t;
+ if (!create_thread(&th,t,spawn_start,s)) {free(s); return 0;}
+#if defined(_WIN32)
+ CloseHandle(th.id);
+#else
+ pthread_detach(th.id);   /* a placed stack lives as long as the process */
+#endif
+ return 1;
+}
+
+static long next_task(work *w)
+{long i;
+
+ mutex_lock(&w->lock);
+ i=w->next++;
+ mutex_unlock(&w->lock);
+ return i;
+}
+
+routine(worker)
+{work *w=(work*)arg;
+ long  i;
+
+ while ((i=next_task(w))<w->count) w->task(w->context,i);
+ return 0;
+}
+
+int parallel_for(long count,long nthreads,parallel_task task,void *context)
+{work    w;
+ long    started=0;
+ int     res=1;
+ thread *threads;
+ pinned(saved);
+
+ if (nthreads<=0) nthreads=parallel_threads();
+ if (nthreads>count) nthreads=count;
+ w.task=task; w.context=context; w.count=count; w.next=0;
+ mutex_init(&w.lock);
+
+ /* the calling thread is worker 0 */
+ threads=NULL;
+ if (nthreads>1) threads=malloc((nthreads-1)*sizeof(*threads));
+ if (threads!=NULL) started=start_threads(threads,nthreads-1,worker,&w,0);
+ if ((nthreads>1) && (started==0)) res=0;
+ pin(saved);
+ worker(&w);
+ unpin(saved);
+ join_threads(threads,started);
+ free(threads);
+ mutex_free(&w.lock);
+ return res;
+}
+
+static long take_task(pool *p,long id)
+/* the next task for thread id, -1 if all have been handed out */
+{deque *d=&p->deques[id];
+ long   i=-1,t,victim;
+ double most=0;
+
+ mutex_lock(&d->lock);
+ if (d->head<d->tail)
+ {i=d->items[d->head++];
+  d->left-=(p->cost!=NULL) ? p->cost[i] : 1;
+ }
+ mutex_unlock(&d->lock);
+ while (i<0)
+ {victim=-1;
+  for (t=0;t<p->nthreads;t++)
+  {d=&p->deques[t];
+   mutex_lock(&d->lock);
+   if ((d->head<d->tail) && ((victim<0) || (d->left>most)))
+   {victim=t; most=d->left;}
+   mutex_unlock(&d->lock);
+  }
+  if (victim<0) return -1;
+  /* the victim may have taken its last task since, then look again */
+  d=&p->deques[victim];
+  mutex_lock(&d->lock);
+  if (d->head<d->tail)
+  {i=d->items[--d->tail];
+   d->left-=(p->cost!=NULL) ? p->cost[i] : 1;
+  }
+  mutex_unlock(&d->lock);
+ }
+ return i;
+}
+
+routine(stealer)
+{member *m=(member*)arg;
+ long    i;
+
+ while ((i=take_task(m->p,m->id))>=0) m->p->task(m->p->context,i);
+ return 0;
+}
+
+static int dearer(const void *a,const void *b)
+{const ranked *x=(const ranked*)a,*y=(const ranked*)b;
+
+ if (x->cost!=y->cost) return (x->cost>y->cost) ? -1 : 1;
+ return (x->index<y->index) ? -1 : (x->index>y->index);
+}
+
+int parallel_steal(long count,const double *cost,long nthreads,
+                   parallel_task task,void *context)
+{pool     p;
+ ranked  *order;
+ long    *owner,*items,i,t,best,started=0;
+ member  *members;
+ deque   *d;
+ thread  *threads=NULL;
+ int      res=1;
+ pinned(saved);
+
+ if (count<=0) return 1;
+ if (nthreads<=0) nthreads=parallel_threads();
+ if (nthreads>count) nthreads=count;
+ order=malloc(count*sizeof(ranked));
+ owner=malloc(count*sizeof(long));
+ items=malloc(count*sizeof(long));
+ p.deques=malloc(nthreads*sizeof(deque));
+ members=malloc(nthreads*sizeof(member));
+ if ((order==NULL) || (owner==NULL) || (items==NULL) || (p.deques==NULL)
+     || (members==NULL))
+ {free(order); free(owner); free(items); free(p.deques); free(members);
+  return parallel_for(count,nthreads,task,context);
+ }
+ p.task=task; p.context=context; p.cost=cost; p.nthreads=nthreads;
+
+ /* deal the tasks, the dearest first, each to the least loaded deque */
+ for (i=0;i<count;i++)
+ {order[i].cost=(cost!=NULL) ? cost[i] : 1; order[i].index=i;}
+ qsort(order,count,sizeof(ranked),dearer);
+ for (t=0;t<nthreads;t++) {p.deques[t].left=0; p.deques[t].tail=0;}
+ for (i=0;i<count;i++)
+ {best=0;
+  for (t=1;t<nthreads;t++) if (p.deques[t].left<p.deques[best].left) best=t;
+  owner[i]=best; p.deques[best].left+=order[i].cost; p.deques[best].tail++;
+ }
+ for (t=0,i=0;t<nthreads;i+=p.deques[t].tail,t++)
+ {p.deques[t].items=items+i; p.deques[t].head=0;
+  mutex_init(&p.deques[t].lock);
+  members[t].p=&p; members[t].id=t;
+ }
+ for (i=0;i<count;i++)
+ {d=&p.deques[owner[i]]; d->items[d->head++]=order[i].index;}
+ for (t=0;t<nthreads;t++) p.deques[t].head=0;
+
+ /* the calling thread is member 0 */
+ if (nthreads>1) threads=malloc((nthreads-1)*sizeof(*threads));
+ if (threads!=NULL)
+    started=start_threads(threads,nthreads-1,stealer,members+1,sizeof(member));
+ if ((nthreads>1) && (started==0)) res=0;
+ pin(saved);
+ stealer(members);
+ unpin(saved);
+ join_threads(threads,started);
+ free(threads);
+ for (t=0;t<nthreads;t++) mutex_free(&p.deques[t].lock);
+ free(order); free(owner); free(items); free(p.deques); free(members);
+ return res;
+}
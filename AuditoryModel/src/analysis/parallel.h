@@ -0,0 +1,45 @@
+/* parallel.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( PARALLEL_H )
+#define PARALLEL_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef void (*parallel_task)(void *context,long index);
+
+extern long parallel_processors();
+extern int  parallel_for(long count,long nthreads,parallel_task task,
+                         void *context);
+extern int  parallel_steal(long count,const double *cost,long nthreads,
+                           parallel_task task,void *context);
+extern int  parallel_spawn(long t,parallel_task task,void *context);
+extern long parallel_nodes();
+extern void parallel_set_nodes(long nnodes);
+extern long parallel_threads();
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( PARALLEL_H ) */
@@ -0,0 +1,258 @@
+/* roughness.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    ROUGHNESS OF AN AUDITORY NERVE IMAGE
+
+    Native version of IPEMRoughnessFFT. Frames of width samples are
+    taken every step samples from each channel of the ANI, weighted
+    with a Hamming window and transformed with an FFT of nfft points
+    (zero padded); with A the magnitudes, DC = A(0) and the bins
+    begin..begin+nbins-1 covering 5..300 Hz:
+
+      bychan(p) = sqrt(sum(W(p,k)/DC(p)*A(p,k).^1.6)/nfft/width)
+      byfreq(k) = sqrt(sum(W(p,k)/DC(p)*A(p,k).^1.6)/nfft/width)
+                  (the sums are over k resp. p)
+      rough     = sum(bychan)/nchan
+
+    The weights W (the synchronization filters of the channels times
+    the channel weighting of IPEMRoughnessFFT), the window and the
+    FFT tables only depend on the size and the sample frequency of
+    the ANI. They are computed once in a plan that can then be shared
+    by any number of threads computing roughness at the same time.
+    The channel weighting runs linearly from 1 to 0.45 over the
+    channels (IPEMRoughnessFFT only handles 40 channels).
+
+    Two channels are transformed at once, as the real and imaginary
+    part of one complex FFT.
+
+ ************** list of routines and their function ******************
+
+    roughness_plan_open(p,nchan,fs,width,step)
+      Set up a plan for an ANI of nchan channels at fs Hz, with
+      frames of width s every step s (IPEMRoughnessFFT: 0.2 and
+      0.02). Returns 1 on success.
+    roughness_frames(p,ncols)
+      Number of roughness frames for an ANI of ncols samples.
+    roughness_rate(p)
+      Sample frequency of the roughness (Hz).
+    roughness_compute(p,ani,ncols,rough,bychan,byfreq)
+      Compute the roughness of ani (nchan x ncols, column major):
+      rough receives one value per frame, bychan nchan values and
+      byfreq nbins values per frame (column major); bychan and byfreq
+      may be NULL. Returns 1 on success.
+    roughness_plan_close(p)
+      Release the plan.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include <roughness.h>
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+/* round half away from zero (as Matlab's round) */
+static double round_matlab(double x)
+{
+ return (x<0) ? -floor(-x+0.5) : floor(x+0.5);
+}
+
+/* synchronization filter of channel win (1-based) over bins 1..end */
+static void filter_weights(double *w,long win,long begin,long end)
+{double sigmoid,max_hz,bw_hz,peak=0,lo,hi,v;
+ long   max_at,bw,k,argmax=1,offset;
+ double *filter;
+
+ sigmoid=pow(win/40.0,2)/(0.04+pow(win/40.0,2.8))-win*0.007;
+ max_hz=20+52*sigmoid;
+ max_at=(long)round_matlab(end*(max_hz/300));
+ sigmoid=pow(win/40.0,2)/(0.04+pow(win/40.0,2.45))-win*0.007;
+ bw_hz=10+300*sigmoid;
+ bw=(long)round_matlab(end*(bw_hz/310));
+ if (bw<1) bw=1;
+
+ filter=(double*)malloc(bw*sizeof(double));
+ for (k=1;k<=bw;k++)
+ {v=exp(-8.0*k/bw)*(1-cos(2*M_PI*k/(10.0*bw)));
+  filter[k-1]=(v>0) ? v : 0;
+  if (filter[k-1]>peak) {peak=filter[k-1]; argmax=k;}
+ }
+ for (k=0;k<bw;k++) filter[k]/=peak;
+
+ /* [zeros(1,max_at-argmax) filter zeros(...)](begin:end) */
+ offset=(max_at-argmax>0) ? max_at-argmax : 0;
+ for (k=begin;k<=end;k++)
+    w[k-begin]=(k>offset && k<=offset+bw) ? filter[k-offset-1] : 0;
+ free(filter);
+
+ lo=hi=w[0];
+ for (k=1;k<=end-begin;k++)
+ {if (w[k]<lo) lo=w[k];
+  if (w[k]>hi) hi=w[k];
+ }
+ for (k=0;k<=end-begin;k++) w[k]=w[k]*1/(hi-lo)-lo;
+}
+
+int roughness_plan_open(roughness_plan *p,long nchan,double fs,double width,
+                        double step)
+{long   k,n,i,r,begin=0,end=0;
+ double f,cw;
+
+ p->window=p->weights=p->cosines=p->sines=NULL; p->reverse=NULL;
+ p->nchan=nchan; p->fs=fs;
+ p->width=(long)round_matlab(width*fs);
+ p->step=(long)round_matlab(step*fs);
+ if (nchan<1 || p->width<1 || p->step<1) return 0;
+ for (p->log2n=0,p->nfft=1;p->nfft<p->width;p->log2n++) p->nfft*=2;
+
+ /* bins 0..nfft/2 at k/nfft*fs Hz */
+ for (k=0;k<=p->nfft/2;k++)
+ {f=(double)k/p->nfft*fs;
+  if (f<=roughness_low) begin=k;
+  if (f<=roughness_high) end=k;
+ }
+ p->begin=begin; p->nbins=end-begin+1;
+
+ p->window=(double*)malloc(p->width*sizeof(double));
+ p->weights=(double*)malloc(nchan*p->nbins*sizeof(double));
+ p->cosines=(double*)malloc((p->nfft/2+1)*sizeof(double));
+ p->sines=(double*)malloc((p->nfft/2+1)*sizeof(double));
+ p->reverse=(long*)malloc(p->nfft*sizeof(long));
+ if (!p->window || !p->weights || !p->cosines || !p->sines || !p->reverse)
+ {roughness_plan_close(p); return 0;}
+
+ for (i=0;i<p->width;i++)
+    p->window[i]=(p->width==1) ? 1 : 0.54-0.46*cos(2*M_PI*i/(p->width-1));
+ for (i=1;i<=nchan;i++)
+ {filter_weights(p->weights+(i-1)*p->nbins,i,begin+1,end+1);
+  cw=(nchan==1) ? 1 : 1+(0.45-1)*(i-1)/(nchan-1);
+  for (k=0;k<p->nbins;k++) p->weights[(i-1)*p->nbins+k]*=cw;
+ }
+
+ n=p->nfft;
+ for (k=0;k<n/2;k++)
+ {p->cosines[k]=cos(2*M_PI*k/n); p->sines[k]=-sin(2*M_PI*k/n);}
+ for (i=0;i<n;i++)
+ {for (r=0,k=0;k<p->log2n;k++) r|=((i>>k)&1)<<(p->log2n-1-k);
+  p->reverse[i]=r;
+ }
+ return 1;
+}
+
+long roughness_frames(const roughness_plan *p,long ncols)
+{
+ return (ncols<p->width) ? 0 : (ncols-p->width)/p->step+1;
+}
+
+double roughness_rate(const roughness_plan *p)
+{
+ return p->fs/p->step;
+}
+
+/* in place radix 2 FFT of re+j*im (input in bit reversed order) */
+static void fft(const roughness_plan *p,double *re,double *im)
+{long   size,half,stride,i,j,k;
+ double c,s,tr,ti;
+
+ for (size=2;size<=p->nfft;size*=2)
+ {half=size/2; stride=p->nfft/size;
+  for (i=0;i<p->nfft;i+=size)
+     for (j=0,k=0;j<half;j++,k+=stride)
+     {c=p->cosines[k]; s=p->sines[k];
+      tr=c*re[i+j+half]-s*im[i+j+half];
+      ti=c*im[i+j+half]+s*re[i+j+half];
+      re[i+j+half]=re[i+j]-tr; im[i+j+half]=im[i+j]-ti;
+      re[i+j]+=tr; im[i+j]+=ti;
+     }
+ }
+}
+
+int roughness_compute(const roughness_plan *p,const double *ani,long ncols,
+                      double *rough,double *bychan,double *byfreq)
+{long    nframes=roughness_frames(p,ncols),n=p->nfft,nb=p->nbins;
+ long    fr,ch,i,k,m,start,pair;
+ double *re,*im,*mags,*dc,*freqs,sum,total,t,ar,ai,br,bi;
+ const double *x;
+
+ re=(double*)malloc(2*n*sizeof(double)); im=re+n;
+ mags=(double*)malloc((p->nchan*nb+2*p->nchan+nb)*sizeof(double));
+ if (!re || !mags) {free(re); free(mags); return 0;}
+ dc=mags+p->nchan*nb; freqs=dc+p->nchan;
+
+ for (fr=0;fr<nframes;fr++)
+ {start=fr*p->step;
+
+  /* magnitudes at DC and in the band, two channels per FFT */
+  for (ch=0;ch<p->nchan;ch+=2)
+  {pair=(ch+1<p->nchan);
+   for (i=0;i<n;i++) re[i]=im[i]=0;
+   x=ani+start*p->nchan+ch;
+   for (i=0;i<p->width;i++)
+   {re[p->reverse[i]]=p->window[i]*x[i*p->nchan];
+    if (pair) im[p->reverse[i]]=p->window[i]*x[i*p->nchan+1];
+   }
+   fft(p,re,im);
+   for (k=-1;k<nb;k++)
+   {i=(k<0) ? 0 : p->begin+k; m=(n-i)%n;
+    ar=(re[i]+re[m])/2; ai=(im[i]-im[m])/2;
+    br=(im[i]+im[m])/2; bi=(re[m]-re[i])/2;
+    if (k<0)
+    {dc[ch]=sqrt(ar*ar+ai*ai);
+     if (pair) dc[ch+1]=sqrt(br*br+bi*bi);
+    }
+    else
+    {mags[ch*nb+k]=sqrt(ar*ar+ai*ai);
+     if (pair) mags[(ch+1)*nb+k]=sqrt(br*br+bi*bi);
+    }
+   }
+  }
+
+  total=0;
+  for (k=0;k<nb;k++) freqs[k]=0;
+  for (ch=0;ch<p->nchan;ch++)
+  {sum=0;
+   for (k=0;k<nb;k++)
+   {t=p->weights[ch*nb+k]/dc[ch]*pow(mags[ch*nb+k],roughness_alfa);
+    sum+=t; freqs[k]+=t;
+   }
+   sum=sqrt(sum/n/p->width);
+   if (bychan) bychan[fr*p->nchan+ch]=sum;
+   total+=sum;
+  }
+  rough[fr]=total/p->nchan;
+  if (byfreq)
+     for (k=0;k<nb;k++) byfreq[fr*nb+k]=sqrt(freqs[k]/n/p->width);
+ }
+
+ free(re); free(mags);
+ return 1;
+}
+
+void roughness_plan_close(roughness_plan *p)
+{
+ free(p->window); free(p->weights); free(p->cosines); free(p->sines);
+ free(p->reverse);
+ p->window=p->weights=p->cosines=p->sines=NULL; p->reverse=NULL;
+}
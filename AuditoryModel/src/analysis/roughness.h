@@ -0,0 +1,63 @@
+/* roughness.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( ROUGHNESS_H )
+#define ROUGHNESS_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define roughness_low    5.0    /* band of the synchronization (Hz) */
+#define roughness_high   300.0
+#define roughness_alfa   1.6    /* exponent of the magnitudes        */
+
+/* everything that only depends on the size and rate of the ANI */
+typedef struct{
+               long    nchan;
+               double  fs;         /* sample frequency of the ANI     */
+               long    width;      /* frame width (samples)           */
+               long    step;       /* frame step (samples)            */
+               long    nfft;
+               int     log2n;
+               long    begin;      /* first bin of the band (0-based) */
+               long    nbins;      /* bins in the band                */
+               double *window;     /* Hamming window, width values    */
+               double *weights;    /* nchan x nbins, per channel      */
+               double *cosines;    /* twiddle factors, nfft/2 values  */
+               double *sines;
+               long   *reverse;    /* bit reversal permutation        */
+              } roughness_plan;
+
+extern int    roughness_plan_open(roughness_plan *p,long nchan,double fs,
+                                  double width,double step);
+extern long   roughness_frames(const roughness_plan *p,long ncols);
+extern double roughness_rate(const roughness_plan *p);
+extern int    roughness_compute(const roughness_plan *p,const double *ani,
+                                long ncols,double *rough,double *bychan,
+                                double *byfreq);
+extern void   roughness_plan_close(roughness_plan *p);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( ROUGHNESS_H ) */
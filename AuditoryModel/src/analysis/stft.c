@@ -0,0 +1,529 @@
+/* stft.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    SHORT-TIME FOURIER TRANSFORM
+
+    Native version of IPEMCalcSpectrogram (Matlab's specgram): frames
+    of width samples every hop samples, weighted with a window and
+    transformed with a real FFT of nfft >= width points (zero
+    padded). Of every frame the magnitudes of bins 0..nfft/2 are
+    kept, divided by width/2 as IPEMCalcSpectrogram does, or their
+    level in dB. A signal shorter than one frame gives one frame
+    (zero padded); otherwise the frames that do not fit entirely are
+    dropped, as by specgram.
+
+    The FFT handles any size: the real transform of n points is a
+    complex one of n/2 points (n even) or of n points (n odd), done
+    recursively with radix 4, 2 and the other prime factors of that
+    size. A plan holds the window and the FFT tables; it is never
+    written to once opened, so that any number of threads can use it
+    at the same time.
+
+    A stream takes the signal a block at a time and hands out the
+    frames that are complete; the frames of a block are computed on
+    nthreads threads. For an overview, decimate frames are combined
+    into one output column, the maximum of their magnitudes per bin,
+    so that no peak is lost. Only the samples and the magnitudes of
+    one block are kept, whatever the length of the signal, and the
+    output is 32 bit floats.
+
+ ************** list of routines and their function ******************
+
+    stft_fft_open(f,n)
+      Set up a real FFT of n points. Returns 1 on success.
+    stft_fft_work(f)
+      Number of doubles of the work area of stft_fft_real.
+    stft_fft_real(f,x,re,im,work)
+      Transform x[0..n-1]: re and im receive bins 0..n/2.
+    stft_fft_inverse(f,re,im,x,work)
+      The inverse: x[0..n-1] from bins 0..n/2 (the others being their
+      complex conjugates), scaled by 1/n as Matlab's ifft.
+    stft_fft_close(f)
+      Release the FFT.
+    stft_window(name)
+      The window called name ('hanning', 'hann', 'hamming',
+      'blackman', 'bartlett', 'triang' or 'boxcar'), -1 if unknown.
+    stft_plan_open(p,fs,width,hop,nfft,window,values)
+      Set up frames of width samples every hop samples of a signal at
+      fs Hz, with an FFT of nfft points (0: the power of two >= width)
+      and one of the windows above (stft_user: the width values given
+      in values). Returns 1 on success.
+    stft_frames(p,length)
+      Number of frames of a signal of length samples.
+    stft_columns(p,length,decimate)
+      Number of output columns of it, decimate frames per column.
+    stft_rate(p,decimate)
+      Sample frequency of those columns (Hz).
+    stft_plan_close(p)
+      Release the plan.
+    stft_frame(p,x,avail,mags,work)
+      Magnitudes of the frame x[0..width-1] (bins 0..nfft/2), of
+      which only the first avail samples exist (the others are taken
+      to be 0); work holds stft_frame_work(p) doubles.
+    stft_frame_work(p)
+      Number of doubles of the work area of stft_frame.
+    stft_stream_open(s,p,output,decimate,nthreads)
+      Set up a stream of plan p, with output stft_magnitude or
+      stft_db and decimate frames per output column, computed on
+      nthreads threads (<= 0: parallel_threads()). Returns 1 on
+      success.
+    stft_stream_max(s,count)
+      Most columns that a block of count samples (or the end) can
+      complete.
+    stft_stream_block(s,x,count,out)
+      Consume x[0..count-1] and write the columns it completes to out
+      (nbins floats each). Returns their number, -1 if it failed.
+    stft_stream_end(s,out)
+      End of the signal: write the last, incomplete, column (and the
+      frame of a signal shorter than one frame). Returns the number of
+      columns written (0 or 1).
+    stft_stream_close(s)
+      Release the stream.
+    stft_compute(p,x,length,output,decimate,nthreads,out)
+      All columns of x[0..length-1] at once (stft_columns of them).
+      Returns their number, -1 if it failed.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <parallel.h>
+#include <stft.h>
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define frames_per_task   16    /* frames of a block per parallel task */
+#define frames_per_block  1024  /* frames of the blocks of stft_compute */
+
+/* FFT */
+
+int stft_fft_open(stft_fft *f,long n)
+{long k,m,p,n1,size,q,w;
+ int  l;
+
+ f->twr=f->twi=f->spr=f->spi=f->ltw=NULL;
+ if (n<1) return 0;
+ f->n=n; f->m=(n%2==0) ? n/2 : n;
+
+ /* radix 4 first, then 2, then the other primes */
+ f->nfac=0; f->maxfac=1;
+ for (m=f->m;m%4==0;m/=4) f->fac[f->nfac++]=4;
+ for (;m%2==0;m/=2) f->fac[f->nfac++]=2;
+ for (p=3;m>1;p+=2)
+ {if (p*p>m) p=m;
+  for (;m%p==0;m/=p) f->fac[f->nfac++]=p;
+ }
+ for (k=0;k<f->nfac;k++) if (f->fac[k]>f->maxfac) f->maxfac=f->fac[k];
+
+ /* level l splits n1 points into fac[l] parts of m points: the factors
+    exp(-2 pi i q k/n1), q=1..fac[l]-1, of butterfly k are stored
+    together, so that a butterfly reads them one after another */
+ for (l=0,n1=f->m,size=0;l<f->nfac;n1/=f->fac[l],l++)
+ {f->loff[l]=size; size+=2*(n1-n1/f->fac[l]);}
+ f->ltw=(double*)malloc((size+1)*sizeof(double));
+
+ f->twr=(double*)malloc(f->m*sizeof(double));
+ f->twi=(double*)malloc(f->m*sizeof(double));
+ f->spr=(double*)malloc((f->m+1)*sizeof(double));
+ f->spi=(double*)malloc((f->m+1)*sizeof(double));
+ if (!f->twr || !f->twi || !f->spr || !f->spi || !f->ltw) {stft_fft_close(f); return 0;}
+ for (k=0;k<f->m;k++)
+ {f->twr[k]=cos(2*M_PI*k/f->m); f->twi[k]=-sin(2*M_PI*k/f->m);}
+ for (k=0;k<=f->m;k++)
+ {f->spr[k]=cos(2*M_PI*k/n); f->spi[k]=-sin(2*M_PI*k/n);}
+ for (l=0,n1=f->m;l<f->nfac;n1/=f->fac[l],l++)
+ {p=f->fac[l];
+  for (k=0;k<n1/p;k++)
+     for (q=1;q<p;q++)
+     {w=f->loff[l]+2*(k*(p-1)+q-1);
+      f->ltw[w]=f->twr[q*k*(f->m/n1)]; f->ltw[w+1]=f->twi[q*k*(f->m/n1)];
+     }
+ }
+ return 1;
+}
+
+long stft_fft_work(const stft_fft *f)
+{
+ return 4*f->m+2*f->maxfac;
+}
+
+/* complex FFT of the n points x[0], x[s], x[2s], ... into y[0..n-1],
+   level being the index of the first factor of n */
+static void fft(const stft_fft *f,const double *xr,const double *xi,long s,
+                double *yr,double *yi,long n,int level,double *tr,double *ti)
+{long   p,m,q,u,k,w;
+ double ar,ai,br,bi,cr,ci,dr,di,sr,si;
+ double *y0r,*y0i,*y1r,*y1i,*y2r,*y2i,*y3r,*y3i;
+ const double *t;
+
+ if (n==1) {yr[0]=xr[0]; yi[0]=xi[0]; return;}
+ p=f->fac[level]; m=n/p;
+ if (m==1)
+    for (q=0;q<p;q++) {yr[q]=xr[q*s]; yi[q]=xi[q*s];}
+ else
+    for (q=0;q<p;q++)
+       fft(f,xr+q*s,xi+q*s,s*p,yr+q*m,yi+q*m,m,level+1,tr,ti);
+
+ /* butterfly k combines y[k], y[k+m], ... y[k+(p-1)*m] */
+ t=f->ltw+f->loff[level];
+ y0r=yr; y0i=yi; y1r=yr+m; y1i=yi+m;
+ if (p==2)
+    for (k=0;k<m;k++,t+=2)
+    {br=y1r[k]*t[0]-y1i[k]*t[1]; bi=y1r[k]*t[1]+y1i[k]*t[0];
+     y1r[k]=y0r[k]-br; y1i[k]=y0i[k]-bi;
+     y0r[k]+=br; y0i[k]+=bi;
+    }
+ else if (p==4)
+ {y2r=y1r+m; y2i=y1i+m; y3r=y2r+m; y3i=y2i+m;
+  for (k=0;k<m;k++,t+=6)
+  {/* a = y0+y2, b = y0-y2, c = y1+y3, d = y1-y3 (twiddled) */
+   sr=y1r[k]*t[0]-y1i[k]*t[1]; si=y1r[k]*t[1]+y1i[k]*t[0];
+   cr=y2r[k]*t[2]-y2i[k]*t[3]; ci=y2r[k]*t[3]+y2i[k]*t[2];
+   dr=y3r[k]*t[4]-y3i[k]*t[5]; di=y3r[k]*t[5]+y3i[k]*t[4];
+   ar=y0r[k]+cr; ai=y0i[k]+ci; br=y0r[k]-cr; bi=y0i[k]-ci;
+   cr=sr+dr; ci=si+di; dr=sr-dr; di=si-di;
+   y0r[k]=ar+cr; y0i[k]=ai+ci;
+   y1r[k]=br+di; y1i[k]=bi-dr;            /* b - i d */
+   y2r[k]=ar-cr; y2i[k]=ai-ci;
+   y3r[k]=br-di; y3i[k]=bi+dr;            /* b + i d */
+  }
+ }
+ else
+    for (k=0;k<m;k++,t+=2*(p-1))
+    {tr[0]=yr[k]; ti[0]=yi[k];
+     for (q=1;q<p;q++)
+     {tr[q]=yr[k+q*m]*t[2*q-2]-yi[k+q*m]*t[2*q-1];
+      ti[q]=yr[k+q*m]*t[2*q-1]+yi[k+q*m]*t[2*q-2];
+     }
+     for (u=0;u<p;u++)
+     {sr=si=0;
+      for (q=0;q<p;q++)
+      {w=((q*u)%p)*(f->m/p);
+       sr+=tr[q]*f->twr[w]-ti[q]*f->twi[w];
+       si+=tr[q]*f->twi[w]+ti[q]*f->twr[w];
+      }
+      yr[k+u*m]=sr; yi[k+u*m]=si;
+     }
+    }
+}
+
+void stft_fft_real(const stft_fft *f,const double *x,double *re,double *im,
+                   double *work)
+{long   m=f->m,k,i,j;
+ double *xr=work,*xi=xr+m,*yr=xi+m,*yi=yr+m,*tr=yi+m,*ti=tr+f->maxfac;
+ double er,ei,odr,odi;
+
+ if (f->n%2!=0)
+ {for (k=0;k<m;k++) {xr[k]=x[k]; xi[k]=0;}
+  fft(f,xr,xi,1,yr,yi,m,0,tr,ti);
+  for (k=0;k<=m/2;k++) {re[k]=yr[k]; im[k]=yi[k];}
+  return;
+ }
+
+ /* the even and odd samples as one complex signal of m points */
+ for (k=0;k<m;k++) {xr[k]=x[2*k]; xi[k]=x[2*k+1];}
+ fft(f,xr,xi,1,yr,yi,m,0,tr,ti);
+ for (k=0;k<=m;k++)
+ {i=k%m; j=(m-k)%m;
+  er=(yr[i]+yr[j])/2; ei=(yi[i]-yi[j])/2;
+  odr=(yi[i]+yi[j])/2; odi=(yr[j]-yr[i])/2;
+  re[k]=er+f->spr[k]*odr-f->spi[k]*odi;
+  im[k]=ei+f->spr[k]*odi+f->spi[k]*odr;
+ }
+}
+
+void stft_fft_inverse(const stft_fft *f,const double *re,const double *im,
+                      double *x,double *work)
+{long   m=f->m,k,j;
+ double *xr=work,*xi=xr+m,*yr=xi+m,*yi=yr+m,*tr=yi+m,*ti=tr+f->maxfac;
+ double er,ei,odr,odi,wr,wi;
+
+ /* ifft(X) = conj(fft(conj(X)))/m, of which only the real part is
+    needed for odd n */
+ if (f->n%2!=0)
+ {for (k=0;k<m;k++)
+  {j=(k<=m/2) ? k : m-k;
+   xr[k]=re[j]; xi[k]=(k<=m/2) ? -im[j] : im[j];
+  }
+  fft(f,xr,xi,1,yr,yi,m,0,tr,ti);
+  for (k=0;k<m;k++) x[k]=yr[k]/m;
+  return;
+ }
+
+ /* the spectra of the even and odd samples, as one complex signal of
+    m points: Z = E + i O (the reverse of the split of stft_fft_real) */
+ for (k=0;k<m;k++)
+ {er=(re[k]+re[m-k])/2; ei=(im[k]-im[m-k])/2;
+  wr=(re[k]-re[m-k])/2; wi=(im[k]+im[m-k])/2;
+  odr=wr*f->spr[k]+wi*f->spi[k]; odi=wi*f->spr[k]-wr*f->spi[k];
+  xr[k]=er-odi; xi[k]=-(ei+odr);
+ }
+ fft(f,xr,xi,1,yr,yi,m,0,tr,ti);
+ for (k=0;k<m;k++) {x[2*k]=yr[k]/m; x[2*k+1]=-yi[k]/m;}
+}
+
+void stft_fft_close(stft_fft *f)
+{
+ free(f->twr); free(f->twi); free(f->spr); free(f->spi); free(f->ltw);
+ f->twr=f->twi=f->spr=f->spi=f->ltw=NULL;
+}
+
+/* Plan */
+
+int stft_window(const char *name)
+{static const char *names[]={"hanning","hann","hamming","blackman",
+                             "bartlett","triang","boxcar"};
+ int i;
+
+ for (i=0;i<(int)(sizeof(names)/sizeof(names[0]));i++)
+    if (strcmp(name,names[i])==0) return i;
+ return -1;
+}
+
+static double window_value(int window,long i,long n)
+{long j;
+
+ if (window==stft_hanning) return 0.5*(1-cos(2*M_PI*(i+1)/(n+1)));
+ if (window==stft_boxcar || n==1) return 1;
+ switch (window)
+ {case stft_hann:
+    return 0.5*(1-cos(2*M_PI*i/(n-1)));
+  case stft_hamming:
+    return 0.54-0.46*cos(2*M_PI*i/(n-1));
+  case stft_blackman:
+    return 0.42-0.5*cos(2*M_PI*i/(n-1))+0.08*cos(4*M_PI*i/(n-1));
+  case stft_bartlett:
+    return (2*i<=n-1) ? 2.0*i/(n-1) : 2-2.0*i/(n-1);
+  case stft_triang:
+    j=((i<n-1-i) ? i : n-1-i)+1;
+    return (n%2!=0) ? 2.0*j/(n+1) : (2.0*j-1)/n;
+ }
+ return 1;
+}
+
+int stft_plan_open(stft_plan *p,double fs,long width,long hop,long nfft,
+                   int window,const double *values)
+{long i;
+
+ p->window=NULL; p->fft.twr=p->fft.twi=p->fft.spr=p->fft.spi=p->fft.ltw=NULL;
+ if (nfft==0) for (nfft=1;nfft<width;nfft*=2);
+ if (fs<=0 || width<1 || hop<1 || nfft<width) return 0;
+ if (window<stft_hanning || window>stft_user || (window==stft_user && values==NULL))
+    return 0;
+ p->fs=fs; p->width=width; p->hop=hop; p->nfft=nfft; p->nbins=nfft/2+1;
+ p->scale=2.0/width;
+ p->window=(double*)malloc(width*sizeof(double));
+ if (p->window==NULL || !stft_fft_open(&p->fft,nfft)) {stft_plan_close(p); return 0;}
+ for (i=0;i<width;i++)
+    p->window[i]=(window==stft_user) ? values[i] : window_value(window,i,width);
+ return 1;
+}
+
+long stft_frames(const stft_plan *p,long length)
+{
+ if (length<=0) return 0;
+ return (length<p->width) ? 1 : (length-p->width)/p->hop+1;
+}
+
+long stft_columns(const stft_plan *p,long length,long decimate)
+{
+ if (decimate<1) decimate=1;
+ return (stft_frames(p,length)+decimate-1)/decimate;
+}
+
+double stft_rate(const stft_plan *p,long decimate)
+{
+ if (decimate<1) decimate=1;
+ return p->fs/p->hop/decimate;
+}
+
+void stft_plan_close(stft_plan *p)
+{
+ free(p->window); p->window=NULL;
+ stft_fft_close(&p->fft);
+}
+
+void stft_frame(const stft_plan *p,const double *x,long avail,
+                float *mags,double *work)
+{double *xw=work,*re=xw+p->nfft,*im=re+p->nbins,*w=im+p->nbins;
+ long    i;
+
+ for (i=0;i<p->width;i++) xw[i]=(i<avail) ? x[i]*p->window[i] : 0;
+ for (;i<p->nfft;i++) xw[i]=0;
+ stft_fft_real(&p->fft,xw,re,im,w);
+ for (i=0;i<p->nbins;i++) mags[i]=(float)(p->scale*sqrt(re[i]*re[i]+im[i]*im[i]));
+}
+
+long stft_frame_work(const stft_plan *p)
+{
+ return p->nfft+2*p->nbins+stft_fft_work(&p->fft);
+}
+
+/* Stream */
+
+typedef struct{
+               stft_stream *s;
+               long         nframes;
+               int          failed;
+              } block_job;
+
+/* frames_per_task frames of the block (runs on a thread) */
+static void block_task(void *context,long index)
+{block_job   *job=(block_job*)context;
+ stft_stream *s=job->s;
+ const stft_plan *p=s->p;
+ long    f,last;
+ double *work;
+
+ work=(double*)malloc(stft_frame_work(p)*sizeof(double));
+ if (work==NULL) {job->failed=1; return;}
+ last=(index+1)*frames_per_task;
+ if (last>job->nframes) last=job->nframes;
+ for (f=index*frames_per_task;f<last;f++)
+    stft_frame(p,s->x+f*p->hop,p->width,s->frames+f*p->nbins,work);
+ free(work);
+}
+
+/* write the open column to out */
+static void write_column(stft_stream *s,float *out)
+{long k,nbins=s->p->nbins;
+
+ for (k=0;k<nbins;k++)
+    out[k]=(s->output!=stft_db) ? s->column[k]
+           : (s->column[k]>0) ? (float)(20*log10(s->column[k])) : (float)stft_floor_db;
+ s->ncol=0;
+}
+
+/* add a frame to the open column; write the column to out if it is
+   complete (returns 1 then) */
+static int add_frame(stft_stream *s,const float *mags,float *out)
+{long k,nbins=s->p->nbins;
+
+ if (s->ncol==0) memcpy(s->column,mags,nbins*sizeof(float));
+ else
+    for (k=0;k<nbins;k++) if (mags[k]>s->column[k]) s->column[k]=mags[k];
+ s->ncol++;
+ if (s->ncol<s->decimate) return 0;
+ write_column(s,out);
+ return 1;
+}
+
+int stft_stream_open(stft_stream *s,const stft_plan *p,int output,
+                     long decimate,long nthreads)
+{
+ s->p=p; s->output=output; s->decimate=(decimate<1) ? 1 : decimate;
+ s->nthreads=nthreads;
+ s->nx=s->size=s->skip=s->nframes=s->nalloc=s->ncol=0;
+ s->x=NULL; s->frames=NULL;
+ s->column=(float*)malloc(p->nbins*sizeof(float));
+ return s->column!=NULL;
+}
+
+long stft_stream_max(const stft_stream *s,long count)
+{
+ return (s->nx+count)/s->p->hop/s->decimate+2;
+}
+
+long stft_stream_block(stft_stream *s,const double *x,long count,float *out)
+{const stft_plan *p=s->p;
+ long      n,f,ncols=0,drop;
+ double   *tmp;
+ float    *ftmp;
+ block_job job;
+
+ /* samples between frames when the hop exceeds the width */
+ n=(s->skip<count) ? s->skip : count;
+ s->skip-=n; x+=n; count-=n;
+ if (s->nx+count>s->size)
+ {tmp=(double*)realloc(s->x,(s->nx+count)*sizeof(double));
+  if (tmp==NULL) return -1;
+  s->x=tmp; s->size=s->nx+count;
+ }
+ memcpy(s->x+s->nx,x,count*sizeof(double));
+ s->nx+=count;
+ if (s->nx<p->width) return 0;
+
+ job.s=s; job.failed=0;
+ job.nframes=(s->nx-p->width)/p->hop+1;
+ if (job.nframes>s->nalloc)
+ {ftmp=(float*)realloc(s->frames,job.nframes*p->nbins*sizeof(float));
+  if (ftmp==NULL) return -1;
+  s->frames=ftmp; s->nalloc=job.nframes;
+ }
+ parallel_for((job.nframes+frames_per_task-1)/frames_per_task,s->nthreads,
+              block_task,&job);
+ if (job.failed) return -1;
+ for (f=0;f<job.nframes;f++)
+    ncols+=add_frame(s,s->frames+f*p->nbins,out+ncols*p->nbins);
+ s->nframes+=job.nframes;
+
+ /* keep the samples of the frames to come */
+ drop=job.nframes*p->hop;
+ if (drop>=s->nx) {s->skip=drop-s->nx; s->nx=0;}
+ else {memmove(s->x,s->x+drop,(s->nx-drop)*sizeof(double)); s->nx-=drop;}
+ return ncols;
+}
+
+long stft_stream_end(stft_stream *s,float *out)
+{const stft_plan *p=s->p;
+ double *work;
+
+ /* a signal shorter than one frame is zero padded to one frame */
+ if (s->nframes==0 && s->nx>0)
+ {work=(double*)malloc(stft_frame_work(p)*sizeof(double));
+  if (work==NULL) return -1;
+  stft_frame(p,s->x,s->nx,s->column,work);
+  free(work);
+  s->nframes=1; s->nx=0; s->ncol=1;
+ }
+ if (s->ncol==0) return 0;
+ write_column(s,out);
+ return 1;
+}
+
+void stft_stream_close(stft_stream *s)
+{
+ free(s->x); free(s->frames); free(s->column);
+ s->x=NULL; s->frames=NULL; s->column=NULL;
+}
+
+long stft_compute(const stft_plan *p,const double *x,long length,int output,
+                  long decimate,long nthreads,float *out)
+{stft_stream s;
+ long        block=frames_per_block*p->hop,done,n,m,ncols=0;
+
+ /* in blocks, so that only one block of the signal is copied */
+ if (!stft_stream_open(&s,p,output,decimate,nthreads)) return -1;
+ for (done=0;done<length;done+=n)
+ {n=(length-done<block) ? length-done : block;
+  m=stft_stream_block(&s,x+done,n,out+ncols*p->nbins);
+  if (m<0) {stft_stream_close(&s); return -1;}
+  ncols+=m;
+ }
+ m=stft_stream_end(&s,out+ncols*p->nbins);
+ stft_stream_close(&s);
+ return (m<0) ? -1 : ncols+m;
+}
@@ -0,0 +1,122 @@
+/* stft.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( STFT_H )
+#define STFT_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define stft_max_factors  40    /* factors of an FFT size          */
+
+/* windows (as the Matlab functions of the same name) */
+#define stft_hanning   0        /* default of IPEMCalcSpectrogram  */
+#define stft_hann      1
+#define stft_hamming   2
+#define stft_blackman  3
+#define stft_bartlett  4
+#define stft_triang    5
+#define stft_boxcar    6
+#define stft_user      7        /* values given by the caller      */
+
+/* output */
+#define stft_magnitude 0        /* |X|/(width/2)                   */
+#define stft_db        1        /* 20*log10 of it                  */
+#define stft_floor_db  -300.0   /* dB value of a magnitude of 0    */
+
+/* real FFT of n points, any n (mixed radix) */
+typedef struct{
+               long    n;
+               long    m;          /* complex points: n/2 if n is   */
+                                   /* even, else n                  */
+               int     nfac;
+               long    fac[stft_max_factors];
+               long    maxfac;
+               double *twr,*twi;   /* exp(-2 pi i k/m), m values    */
+               double *ltw;        /* twiddle factors of the levels */
+               long    loff[stft_max_factors]; /* offsets in ltw    */
+               double *spr,*spi;   /* exp(-2 pi i k/n), m+1 values  */
+              } stft_fft;
+
+extern int  stft_fft_open(stft_fft *f,long n);
+extern long stft_fft_work(const stft_fft *f);
+extern void stft_fft_real(const stft_fft *f,const double *x,double *re,
+                          double *im,double *work);
+extern void stft_fft_inverse(const stft_fft *f,const double *re,
+                             const double *im,double *x,double *work);
+extern void stft_fft_close(stft_fft *f);
+
+/* everything that only depends on the frames and the transform */
+typedef struct{
+               double   fs;
+               long     width;     /* frame width (samples)         */
+               long     hop;       /* frame step (samples)          */
+               long     nfft;
+               long     nbins;     /* nfft/2+1                      */
+               double  *window;
+               double   scale;     /* 2/width                       */
+               stft_fft fft;
+              } stft_plan;
+
+extern int    stft_window(const char *name);
+extern int    stft_plan_open(stft_plan *p,double fs,long width,long hop,
+                             long nfft,int window,const double *values);
+extern long   stft_frames(const stft_plan *p,long length);
+extern long   stft_columns(const stft_plan *p,long length,long decimate);
+extern double stft_rate(const stft_plan *p,long decimate);
+extern void   stft_plan_close(stft_plan *p);
+extern void   stft_frame(const stft_plan *p,const double *x,long avail,
+                         float *mags,double *work);
+extern long   stft_frame_work(const stft_plan *p);
+
+/* frames of a signal that arrives a block at a time */
+typedef struct{
+               const stft_plan *p;
+               int      output;
+               long     decimate;  /* frames per output column       */
+               long     nthreads;
+               double  *x;         /* samples not consumed yet       */
+               long     nx,size;
+               long     skip;      /* samples to drop (hop > width)  */
+               long     nframes;   /* frames computed so far         */
+               float   *frames;    /* magnitudes of a block          */
+               long     nalloc;    /* frames allocated in frames     */
+               float   *column;    /* maximum over the open column   */
+               long     ncol;      /* frames in the open column      */
+              } stft_stream;
+
+extern int  stft_stream_open(stft_stream *s,const stft_plan *p,int output,
+                             long decimate,long nthreads);
+extern long stft_stream_max(const stft_stream *s,long count);
+extern long stft_stream_block(stft_stream *s,const double *x,long count,
+                              float *out);
+extern long stft_stream_end(stft_stream *s,float *out);
+extern void stft_stream_close(stft_stream *s);
+
+extern long stft_compute(const stft_plan *p,const double *x,long length,
+                         int output,long decimate,long nthreads,float *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( STFT_H ) */
@@ -26,55 +26,169 @@
     A U D I T O R Y  M O D E L  B A S E D  S P E E C H  A N A L Y S I S
  ***************************************************************************/
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <filenames.h>
 #include "audiprog.h"
 #include "audimod.h"
+#include "hcmbank.h"
+#include "audiparams.h"
+#include <anicache.h>
 
-static text_line infile,outfile;
-static int bytes;
-static int w,w1,w2;
-
-static text_line s;
-
-double  Tdecim;     /* delay introduced by decimation unit (ms)  */
-double  Tmodel;     /* delay introduced by rest of model (ms)    */
-double  fsmp=20.0;  /* internal sampling frequency = 1/Tsmp      */
-double  fssig=10.0; /* signal sampling frequency                 */
-double  Tframe=10;  /* time between successive frames (ms)       */
-int     ndecim;     /* number of decimation filters to use       */
-double  Tse;        /* time between successive envelope samples  */
-int     Ne;         /* Tsmp for envelope / Tsmp of model         */
-int     Nemask;     /* Ne-1 = mask for MOD replacement           */
-int     Nerl=5;     /* number of erl samples per frame           */
-double  Terl;       /* time between erl samples in frame         */
-int     shift;      /* pitch comes from SHIFT frames behind      */
-int     nchan=20;   /* number of filterbank channels             */
-double  uc1=2.0;    /* ucp of first channel                      */
-double  duc=0.85;   /* spacing between succesive ucp's           */
-int     n;          /* time index                                */
-
-rvector fc;         /* BPF central frequencies                   */
-rvector uc;         /* corresponding critical band units         */
-ivector x2;         /* is there a need to upsample after BPF?    */
-ivector step;       /* time steps used in analysis channels      */
-ivector stepmask;   /* stepmask=step-1 = mask for MOD replacement*/
+static per_thread text_line infile,outfile;
+static per_thread int bytes;
+static per_thread int w,w1,w2;
+
+static per_thread text_line s;
+
+static per_thread text_line cache_dir;   /* ANI cache, not used if empty */
+static per_thread double    cache_size;  /* size bound of the cache (MB) */
+static per_thread int       from_memory; /* signal in memory, not in infile */
+
+per_thread double  Tdecim;     /* delay introduced by decimation unit (ms)  */
+per_thread double  Tmodel;     /* delay introduced by rest of model (ms)    */
+per_thread double  Tpitch;     /* extra delay of the pitch stage (ms)       */
+per_thread double  fsmp=20.0;  /* internal sampling frequency = 1/Tsmp      */
+per_thread double  fssig=10.0; /* signal sampling frequency                 */
+per_thread double  Tframe=10;  /* time between successive frames (ms)       */
+per_thread int     ndecim;     /* number of decimation filters to use       */
+per_thread double  Tse;        /* time between successive envelope samples  */
+per_thread int     Ne;         /* Tsmp for envelope / Tsmp of model         */
+per_thread int     Nemask;     /* Ne-1 = mask for MOD replacement           */
+per_thread int     Nerl=5;     /* number of erl samples per frame           */
+per_thread double  Terl;       /* time between erl samples in frame         */
+per_thread int     shift;      /* pitch comes from SHIFT frames behind      */
+per_thread int     nchan=20;   /* number of filterbank channels             */
+per_thread double  uc1=2.0;    /* ucp of first channel                      */
+per_thread double  duc=0.85;   /* spacing between succesive ucp's           */
+per_thread int     chan_scale=scale_cbu; /* scale of uc1, duc and chan_pos */
+per_thread int     chan_count=0; /* number of chan_pos, 0 if equally spaced   */
+per_thread rvector chan_pos;   /* channel positions on chan_scale (1..)     */
+per_thread int     n;          /* time index                                */
+per_thread double  range_start=0;    /* start of the part to analyse (s)      */
+per_thread double  range_duration=-1; /* its duration (s), <0: up to the end  */
+per_thread double  range_preroll=def_preroll; /* analysed (and dropped) before */
+
+per_thread rvector fc;         /* BPF central frequencies                   */
+per_thread rvector uc;         /* corresponding critical band units         */
+per_thread ivector x2;         /* is there a need to upsample after BPF?    */
+per_thread ivector step;       /* time steps used in analysis channels      */
+per_thread ivector stepmask;   /* stepmask=step-1 = mask for MOD replacement*/
 /* JPM: 20/10/98: new implementation of channel selection ********/
-int     max_step;   /* maximum step encountered in channels      */
-int     nmod;       /* time modulo max_step                      */
-int     low_ch[16]; /* lowest channel to process for different   */
+per_thread int     max_step;   /* maximum step encountered in channels      */
+per_thread int     nmod;       /* time modulo max_step                      */
+per_thread int     low_ch[16]; /* lowest channel to process for different   */
                     /* values of nmod                            */
 /*****************************************************************/
-double  decim[5+1]; /* decimation products                       */
-ivector indx;       /* index in decimation product array         */
-rvector ybpf;       /* BPF outputs at multiples of step.Tsmp     */
+per_thread double  decim[5+1]; /* decimation products                       */
+per_thread qval    qdecim[5+1];/* the same in fixed point (q_sig)           */
+per_thread ivector indx;       /* index in decimation product array         */
+per_thread rvector ybpf;       /* BPF outputs at multiples of step.Tsmp     */
+per_thread qval    qybpf[max_nchan+1]; /* the same in fixed point (q_sig)   */
+
+per_thread rvector yhcm;       /* HCM outputs at multiples of Tse           */
+per_thread rvector yhcm1;      /* previous HCM outputs at multiples of Tse  */
+per_thread rvector ev,erl;     /* virtual tone, roughness+loudness comps.   */
+per_thread rvector prev_erl;   /* previous roughness+loudness components    */
+per_thread rvector yres;       /* xxx outputs at multiples of step.Tsmp     */
+per_thread double  factor;     /* multiplication factor for input samples   */
+per_thread int     norm_mode=norm_none; /* how factor is derived from the signal */
+per_thread double  norm_level=-20; /* RMS level (dB) for norm_rms            */
+per_thread int     kernel=kernel_double; /* kernel_double or kernel_fixed    */
+per_thread int     outformat=outformat_text; /* format of the envelope output file */
+per_thread text_line pitch_file;  /* pitch track, not computed if empty */
+per_thread text_line pyramid_file; /* decimated ANI, not written if empty */
+per_thread int     pyramid_levels=ani_pyr_def_levels; /* levels of the pyramid */
+per_thread int     write_dumps=1; /* write the responses and outfile.dat   */
+
+
+int cache_key(anicache_key key,double *level)
+/**********************************************************************
+    The key covers the decoded signal (only the part that is analysed),
+    everything that determines the model and the format of the output
+    file. The level of the signal (peak, RMS) is measured in the same
+    pass, which keeps the samples for the analysis.
+ **********************************************************************/
+{anicache_hash c;
+ int           version=audiprog_version;
 
-rvector yhcm;       /* HCM outputs at multiples of Tse           */
-rvector yhcm1;      /* previous HCM outputs at multiples of Tse  */
-rvector ev,erl;     /* virtual tone, roughness+loudness comps.   */
-rvector prev_erl;   /* previous roughness+loudness components    */
-rvector yres;       /* xxx outputs at multiples of step.Tsmp     */
-double  factor;     /* multiplication factor for input samples   */
+ anicache_hash_init(&c);
+ anicache_hash_add(&c,&version,sizeof(version));
+ anicache_hash_add(&c,&nchan,sizeof(nchan));
+ anicache_hash_add(&c,&uc1,sizeof(uc1));
+ anicache_hash_add(&c,&duc,sizeof(duc));
+ /* (only if the channels are not placed as before, to keep the keys of
+    the results that are in caches already) */
+ if ((chan_scale!=scale_cbu) || (chan_count>0))
+ {anicache_hash_add(&c,&chan_scale,sizeof(chan_scale));
+  anicache_hash_add(&c,&chan_count,sizeof(chan_count));
+  anicache_hash_add(&c,chan_pos,sizeof(rvector));
+ }
+ if ((range_start>0) || (range_duration>=0))
+ {anicache_hash_add(&c,&range_start,sizeof(range_start));
+  anicache_hash_add(&c,&range_duration,sizeof(range_duration));
+  anicache_hash_add(&c,&range_preroll,sizeof(range_preroll));
+ }
+ anicache_hash_add(&c,&fssig,sizeof(fssig));
+ /* a normalized signal is hashed before it is scaled: the key holds the
+    rule instead of the factor (which is 1 otherwise) */
+ if (norm_mode==norm_none) anicache_hash_add(&c,&factor,sizeof(factor));
+ else
+ {anicache_hash_add(&c,&norm_mode,sizeof(norm_mode));
+  anicache_hash_add(&c,&norm_level,sizeof(norm_level));
+ }
+ anicache_hash_add(&c,&outformat,sizeof(outformat));
+ if (kernel!=kernel_double) anicache_hash_add(&c,&kernel,sizeof(kernel));
+ if (!measure_level(infile,&c,&level[0],&level[1],!from_memory)) return 0;
+ anicache_hash_final(&c,key);
+ return 1;
+}
 
+int level_key(anicache_key key)
+/**********************************************************************
+    The level of a sound file is kept in the cache directory as well,
+    under a key that recognizes the file without decoding it: from its
+    device, inode, size and modification time (in ns where the system
+    has it) and its first and last 64 kB. This is a heuristic: a file
+    rewritten in place within the resolution of the clock, with the
+    same size and the same head and tail, gets the level of the old
+    contents. Returns 0 if there is no cache or no file.
+ **********************************************************************/
+{anicache_hash c;
+ struct stat   st;
+ FILE         *f;
+ char          buf[65536];
+ long long     size,mtime,mtime_ns=0,dev,ino;
+ int           version=audiprog_version;
+
+ if ((cache_dir[0]=='\0') || from_memory || (stat(infile,&st)!=0)) return 0;
+ f=fopen(infile,"rb");
+ if (f==NULL) return 0;
+ size=(long long)st.st_size; mtime=(long long)st.st_mtime;
+ dev=(long long)st.st_dev; ino=(long long)st.st_ino;
+#if defined(__APPLE__)
+ mtime_ns=(long long)st.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+ mtime_ns=(long long)st.st_mtim.tv_nsec;
+#endif
+ anicache_hash_init(&c);
+ anicache_hash_add(&c,&version,sizeof(version));
+ anicache_hash_add(&c,&size,sizeof(size));
+ anicache_hash_add(&c,&mtime,sizeof(mtime));
+ anicache_hash_add(&c,&mtime_ns,sizeof(mtime_ns));
+ anicache_hash_add(&c,&dev,sizeof(dev));
+ anicache_hash_add(&c,&ino,sizeof(ino));
+ anicache_hash_add(&c,&bytes,sizeof(bytes));
+ anicache_hash_add(&c,&fssig,sizeof(fssig));
+ anicache_hash_add(&c,&range_start,sizeof(range_start));
+ anicache_hash_add(&c,&range_duration,sizeof(range_duration));
+ anicache_hash_add(&c,buf,fread(buf,1,sizeof(buf),f));
+ if ((size>(long long)sizeof(buf)) && (fseek(f,-(long)sizeof(buf),SEEK_END)==0))
+    anicache_hash_add(&c,buf,fread(buf,1,sizeof(buf),f));
+ fclose(f);
+ anicache_hash_final(&c,key);
+ return 1;
+}
 
 long analyse_signal(const char* inOutputFile)
 /**********************************************************************
@@ -85,23 +199,64 @@ long analyse_signal(const char* inOutputFile)
  **********************************************************************/
 {int        vuv;
  int        last;
+ int        failed=0;
+ int        cached,keyed,fetched,known;
  parameters frame;
+ anicache_key key,lkey;
+ double     level[2]={0,0};   /* peak and RMS of the signal */
+ double     start=log_clock(),elapsed,duration;
+ log_field  fields[6];
+
+ /* the cache holds files: not used if the envelopes go to a stream,
+    nor if a pitch track or a pyramid has to be computed as well */
+ cached=(cache_dir[0]!='\0') && write_dumps && (pitch_file[0]=='\0')
+        && (pyramid_file[0]=='\0');
+ /* a normalized signal needs its level before the analysis: from the
+    cache directory, or from the pass that computes the key anyway, or
+    else from a pass of its own (which keeps the samples, so that the
+    file is not decoded twice) */
+ keyed=(norm_mode!=norm_none) && level_key(lkey);
+ fetched=keyed && anicache_fetch_data(cache_dir,lkey,".lvl",level,sizeof(level));
+ known=(norm_mode==norm_none) || fetched;
+ if (cached) known=cached=cache_key(key,level);
+ else if (!known) known=measure_level(infile,NULL,&level[0],&level[1],!from_memory);
+ if (keyed && known && !fetched) anicache_store_data(cache_dir,lkey,".lvl",level,sizeof(level));
+ set_factor(level[0],level[1]);
+ if (cached && anicache_fetch(cache_dir,key,inOutputFile))
+ {fields[0].name="file"; fields[0].text=infile;
+  fields[1].name="key"; fields[1].text=key;
+  log_record(log_info,"taken from the cache",fields,2);
+  return 0;
+ }
 
  if (!init_analysis(infile,inOutputFile)) return -1;
 
- printf("Analysing %s\n",infile); 
- if (!open_writefile(outfile)) 
- {printf("\nerror opening %s\n",outfile); return -1;}
+ log_message(log_debug,"analysing %s",infile);
+ if (write_dumps && !open_writefile(outfile)) 
+ {log_message(log_error,"could not open %s",outfile); return -1;}
  do 
  {vuv=one_frame(&last,frame);
-  write_frame(vuv,nspect,frame);
+  if (write_dumps) write_frame(vuv,nspect,frame);
+  if (HCMBank_EnvelopeFileError() || signal_failed()) {last=1; failed=1;}
+  if (HCMBank_FrameRangeDone()) last=1;
  } 
  while (!last);
- close_writefile(); /* readfile is closed in one_frame !!!! */
- printf("nsamp: %d\n",n);
+ if (write_dumps) close_writefile(); /* readfile is closed in one_frame !!!! */
  finish_analysis();	/* KT 19990525 */
+ if (failed || log_enabled(log_info))
+ {elapsed=log_clock()-start; duration=n/(1000*fsmp);
+  fields[0].name="file";       fields[0].text=infile;
+  fields[1].name="nchan";      fields[1].text=NULL; fields[1].value=nchan;
+  fields[2].name="fs";         fields[2].text=NULL; fields[2].value=1000*fssig;
+  fields[3].name="duration";   fields[3].text=NULL; fields[3].value=duration;
+  fields[4].name="elapsed";    fields[4].text=NULL; fields[4].value=elapsed;
+  fields[5].name="throughput"; fields[5].text=NULL;
+  fields[5].value=(elapsed>0) ? duration/elapsed : 0;
+  log_record(failed ? log_error : log_info,failed ? "analysis failed" : "analysed",fields,6);
+ }
+ if (cached && !failed) anicache_store(cache_dir,key,inOutputFile,cache_size);
  
- return 0;
+ return failed ? -1 : 0;
 }
 
 void file_information(long inSoundFileFormat)
@@ -116,8 +271,7 @@ void file_information(long inSoundFileFormat)
  strcpy(s,"format (0=samples,1=bytes,2=wave,3=b16,4=b08,5=pcm) ");
  get_one_integer(usual,s,&w);
 */
- w = inSoundFileFormat;
- if (w != 2) { printf("KT MUST CHECK NON-WAV FORMAT !!!!!!!!!!!!"); } // TBI
+ w = inSoundFileFormat; /* 2: any sound file, see library/decoder.c */
  bytes=(w==1);
  strcpy(filename_prefix,"");
  if (w>1) set_sigioread_format(w);
@@ -129,43 +283,104 @@ void file_information(long inSoundFileFormat)
 // -----------------------------------------------------------------------------
 // Main entry point for the auditory model
 
-long AudiProg (long inNumOfChannels, double inFirstFreq, double inFreqDist,
-			const char* inInputFileName, const char* inInputFilePath,
-			const char* inOutputFileName, const char* inOutputFilePath,
-			double inSampleFrequency, long inSoundFileFormat)
+long AudiProg (const audiprog_params* p)
 {
 	long theLength = 0;
 	long theResult = 0;
+	long theNumOfChannels = p->nchan;
+	long c;
 	char theOutputFile[256]; 
 
-	file_information(inSoundFileFormat); 
+	// Messages of this analysis go to its own sink (NULL: the default one)
+	log_set_sink(p->log_sink);
+
+	file_information(p->sound_format); 
+	if (p->signal != NULL) set_sigioread_memory(p->signal,p->signal_length);
+	else if (p->source != NULL) set_sigioread_source(p->source);
+	from_memory = (p->signal != NULL) || (p->source != NULL);
 	
 	// Setup input file
-	theLength = strlen(inInputFilePath);
+	theLength = strlen(p->input_path);
 	if (theLength == 0) infile[0] = '\0';
 	else
 	{
-		strcpy(infile,inInputFilePath);
+		strcpy(infile,p->input_path);
 		strcat(infile,"/");
 	}
-	strcat(infile,inInputFileName);
+	strcat(infile,p->input_file);
 	
 	// Setup output file
-	theLength = strlen(inOutputFilePath);
+	theLength = strlen(p->output_path);
 	if (theLength == 0) theOutputFile[0] = '\0';
 	else
 	{
-		strcpy(theOutputFile,inOutputFilePath);
+		strcpy(theOutputFile,p->output_path);
 		strcat(theOutputFile,"/");
 	}
-	strcat(theOutputFile,inOutputFileName);
+	strcat(theOutputFile,p->output_file);
 
 	strcpy(outfile,"outfile.dat");
+	outformat = (p->output_format == 1) ? outformat_binary : outformat_text;
+
+	// Envelopes sent to a stream (server) or a sink (mex): no files are written at all
+	HCMBank_SetEnvelopeStream(p->output_stream);
+	HCMBank_SetEnvelopeSink(p->output_sink);
+	write_dumps = (p->output_stream == NULL) && (p->output_sink == NULL);
+
+	// Setup the ANI cache
+	if (p->cache_dir == NULL) cache_dir[0] = '\0';
+	else strcpy(cache_dir,p->cache_dir);
+	cache_size = (p->cache_size > 0) ? p->cache_size : anicache_def_size;
+	// (a source is read once: there is no pass for the key before the analysis)
+	if (p->source != NULL) cache_dir[0] = '\0';
+
+	// Pitch track (optional)
+	if (p->pitch_file == NULL) pitch_file[0] = '\0';
+	else strcpy(pitch_file,p->pitch_file);
+
+	// Pyramid of the ANI (optional)
+	if (p->pyramid_file == NULL) pyramid_file[0] = '\0';
+	else strcpy(pyramid_file,p->pyramid_file);
+	pyramid_levels = (p->pyramid_levels > 0) ? p->pyramid_levels : ani_pyr_def_levels;
+	if (pyramid_levels > ani_pyr_max_levels) pyramid_levels = ani_pyr_max_levels;
+
+	// Placement of the channels: a list of positions sets the number of channels
+	chan_scale = (p->chan_scale >= 0) ? p->chan_scale : scale_cbu;
+	chan_count = 0;
+	memset(chan_pos,0,sizeof(chan_pos));
+	if ((p->chan_positions != NULL) && (p->npositions > 0))
+	{
+		theNumOfChannels = p->npositions;
+		if (p->npositions <= max_nchan)
+		{
+			chan_count = p->npositions;
+			for (c = 1; c <= chan_count; c++) chan_pos[c] = p->chan_positions[c-1];
+		}
+	}
+
+	// Part of the signal to analyse (default: all of it)
+	range_start = (p->start > 0) ? p->start : 0;
+	range_duration = (p->duration >= 0) ? p->duration : -1;
+	range_preroll = (p->preroll >= 0) ? p->preroll : def_preroll;
+
+	// Level of the input (default: the samples as they are)
+	norm_mode = ((p->normalization == norm_peak) || (p->normalization == norm_rms)) ? p->normalization : norm_none;
+	norm_level = p->level;
+	if ((p->source != NULL) && (norm_mode != norm_none))
+	{
+		log_message(log_warning,"the level of a source cannot be measured in advance: not normalized");
+		norm_mode = norm_none;
+	}
+
+	// Arithmetic of the model (default: double precision)
+	kernel = (p->kernel == kernel_fixed) ? kernel_fixed : kernel_double;
 
 	theResult = startup_audiprog(bytes,&nspect,&nr_of_par,
-								 inNumOfChannels,inFirstFreq,inFreqDist,inSampleFrequency);
-	if (theResult != 0) return theResult;
+								 theNumOfChannels,p->first_freq,p->freq_dist,p->sample_freq);
+	if (theResult == 0) theResult = analyse_signal(theOutputFile);
+	drop_kept();
 
-	return analyse_signal(theOutputFile);
+	log_set_sink(NULL);
+	return theResult;
 }
 
@@ -29,21 +29,49 @@
 #include "filterbank.h"
 #include "hcmbank.h"
 
-/* KT 19990525
-#include "ecebank.h"
+#include "ecebank.h"
 #include "cpu.h"
-*/
+#include <anicache.h>
+#include <limits.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 
 #define width      16
+#define block    1024            /* input samples read, OMEF'd and upsampled at once */
+#define max_kept (1L<<24)        /* samples kept in memory by measure_level; more are
+                                    spilled to a temporary file that is mapped */
 
-static double      delay;             /* delay introduced by model    */
-static parameters  par[width-1+1];            
-static long        par_ptr;           /* pointer to most recent frame */
-static int         one_byte;
-static double      tend,tout;
-static double      t,Tsmp;
-static long        pitch_delay;       /* get pitch from frame[n+pitch_delay] */
-static int         auto_factor;
+static per_thread double      delay;             /* delay introduced by model    */
+static per_thread parameters  par[width-1+1];            
+static per_thread long        par_ptr;           /* pointer to most recent frame */
+static per_thread int         one_byte;
+static per_thread double      tend,tout;
+static per_thread double      t,Tsmp;
+static per_thread long        pitch_delay;       /* get pitch from frame[n+pitch_delay] */
+static per_thread int         pitch_on;          /* run the pitch stage?         */
+static per_thread double      tpitch;            /* time of next pitch frame     */
+static per_thread int         plan_ready=0;      /* modules set up for plan_* */
+static per_thread int         plan_pitch;
+static per_thread long        plan_nchan;
+static per_thread double      plan_uc1,plan_duc,plan_fssig;
+static per_thread int         plan_scale,plan_count;
+static per_thread rvector     plan_pos;
+static per_thread double      omef_out[block];   /* OMEF output of the block     */
+static per_thread double      df0_out[2*block];  /* DF0 output at fsmp=2fssig   */
+static per_thread qval        qomef_out[block];  /* the same for kernel_fixed   */
+static per_thread qval        qdf0_out[2*block];
+static per_thread long        block_pos;         /* next sample of the block     */
+static per_thread long        block_last;        /* last signal sample, or -1    */
+static per_thread int         block_eof;         /* signal read completely?      */
+static per_thread long long   range_first;       /* first signal sample read     */
+static per_thread long long   range_lead;        /* samples of the pre-roll      */
+static per_thread long long   range_count;       /* samples read, -1: all        */
+static per_thread long long   range_skip;        /* frames of the pre-roll       */
+static per_thread long long   range_frames;      /* frames written, -1: all      */
+static per_thread double      range_time;        /* of the first frame written   */
+static per_thread double     *kept=NULL;         /* range read by measure_level  */
+static per_thread size_t      kept_mapped=0;     /* bytes of kept if it is mapped */
 
 
 void setup_modules()
@@ -59,12 +87,15 @@ void setup_modules()
  setup_hcmbank(); 
 
 /* KT 19990525
- setup_ecebank(); 
- setup_cpu();
+ setup_ecebank(); 
+ setup_cpu();
 
- pitch_delay=shift;
- if (pitch_delay>7) printf("%s\n","Error: Tframe must be > 3 ms (for pitch)");
+ pitch_delay=shift;
+ if (pitch_delay>7) printf("%s\n","Error: Tframe must be > 3 ms (for pitch)");
 */
+ /* optional pitch stage: it has its own frame clock (see one_frame) */
+ if (pitch_file[0]!='\0') {setup_ecebank(); setup_cpu();}
+ else {Tpitch=0; shift=0;}
 }
 
 void init_modules(const char* inOutputFileName)
@@ -75,9 +106,15 @@ void init_modules(const char* inOutputFileName)
  init_hcmbank(inOutputFileName); 
 
 /* KT 19990525
- init_ecebank(); 
- init_cpu();
+ init_ecebank(); 
+ init_cpu();
 */
+ pitch_on=(pitch_file[0]!='\0');
+ if (pitch_on)
+ {init_ecebank();
+  if (!init_cpu(pitch_file))
+     log_message(log_error,"the pitch file \"%s\" could not be opened for writing",pitch_file);
+ }
 }
 
 /* Finalize modules */
@@ -85,6 +122,7 @@ void init_modules(const char* inOutputFileName)
 void finish_modules()
 {
 	finish_hcmbank();
+	if (pitch_on) finish_cpu();
 }
 
 long specify_parameters(long inNumOfChannels, double inFirstFreq, double inFreqDist, double inSampleFrequency)
@@ -92,12 +130,13 @@ long specify_parameters(long inNumOfChannels, double inFirstFreq, double inFreqD
 	/* KT adapted */
 	if (inNumOfChannels > max_nchan)
 	{
-		printf("ERROR:\nToo many channels! Max. = 40");
+		log_message(log_error,"too many channels (%ld), max. = %d",inNumOfChannels,max_nchan);
 		return -1;
 	}
 	nchan = inNumOfChannels;	// given, checked with max_nchan
 	uc1 = inFirstFreq;			// given
 	duc = inFreqDist;			// given
+	if (!check_channels()) return -1;	// placed by chan_scale, chan_pos
 	fssig = inSampleFrequency/1000;	// (kHz) should better be extracted from sound file...
 	// Tframe stays fixed to 10 (time between frames)
 	// Nerl stays fixed to 5 (number of erl samples/frame)
@@ -136,34 +175,224 @@ long startup_audiprog(int bytes,int *nspect,int *npar,
  theResult = specify_parameters(inNumOfChannels,inFirstFreq,inFreqDist,inSampleFrequency);
  if (theResult == 0)
  {
-	 setup_modules(); 
+	 /* the coefficients only depend on these parameters: if they did not
+	    change since the previous analysis in this thread (and no plots of
+	    the responses have to be written), the modules are still set up */
+	 if (write_dumps || !plan_ready || (plan_nchan != nchan) || (plan_uc1 != uc1)
+	     || (plan_duc != duc) || (plan_fssig != fssig)
+	     || (plan_scale != chan_scale) || (plan_count != chan_count)
+	     || (memcmp(plan_pos,chan_pos,sizeof(rvector)) != 0)
+	     || (plan_pitch != (pitch_file[0] != '\0')))
+	 {
+		 setup_modules();
+		 plan_ready = 1; plan_nchan = nchan;
+		 plan_uc1 = uc1; plan_duc = duc; plan_fssig = fssig;
+		 plan_scale = chan_scale; plan_count = chan_count;
+		 memcpy(plan_pos,chan_pos,sizeof(rvector));
+		 plan_pitch = (pitch_file[0] != '\0');
+	 }
+
 	 delay=Tdecim+Tmodel; 
-	 printf("%s%7.3f%7.3f%7.3f%4d\n","Td,Tm,delay,Ne =",Tdecim,Tmodel,delay,Ne);
+	 log_message(log_debug,"%s%7.3f%7.3f%7.3f%4d","Td,Tm,delay,Ne =",Tdecim,Tmodel,delay,Ne);
 	 *nspect=nchan; 
 	 *npar=nchan+Nerl+3;
  }
  return theResult;
 }
 
-void init_factor(text_line filename)
-{
- double smax,sn;
- int last;
-
- if (open_readfile(filename))
- {
-   smax=0; sn=0; last=0;
-   do
-   {
-     sn=new_sample(one_byte,&last);
-     smax=max(smax,fabs(sn));
+static FILE *spill_kept(long nkept)
+/* move the nkept samples kept in memory to a temporary file */
+{FILE *spill=NULL;
+
+#if !defined(_WIN32)
+ spill=tmpfile();
+ if ((spill!=NULL) && (fwrite(kept,sizeof(double),nkept,spill)!=(size_t)nkept))
+ {fclose(spill); spill=NULL;}
+#endif
+ if (spill==NULL)
+    log_message(log_warning,"more than %ld samples cannot be kept: the file is decoded again",max_kept);
+ else log_message(log_debug,"more than %ld samples: kept in a temporary file",max_kept);
+ free(kept); kept=NULL;
+ return spill;
+}
+
+static int map_kept(FILE *spill,long nkept)
+/* map the nkept samples in spill (which is closed) as kept */
+{int res=0;
+
+#if !defined(_WIN32)
+ void *p;
+
+ if ((nkept>0) && (fflush(spill)==0))
+ {p=mmap(NULL,nkept*sizeof(double),PROT_READ,MAP_PRIVATE,fileno(spill),0);
+  if (p!=MAP_FAILED) {kept=(double*)p; kept_mapped=nkept*sizeof(double); res=1;}
+ }
+#endif
+ fclose(spill);  /* the mapping stays valid (and the file with it) */
+ return res;
+}
+
+int measure_level(text_line filename,anicache_hash *c,double *peak,double *rms,
+                  int keep)
+/**********************************************************************
+  One pass over the samples that the analysis reads, a block at a
+  time: the peak and the RMS of the range (without the pre-roll) and,
+  if c is not NULL, all samples are added to the hash (with the zero
+  that marks the end, as new_sample delivers them).
+  If keep is set, the samples are kept as well and the analysis that
+  follows reads them from there instead of decoding the file a second
+  time; drop_kept releases them. Up to max_kept samples are kept in
+  memory, the samples of a longer range go to a temporary file that
+  is mapped into memory at the end. Only if that fails (or on Windows,
+  or beyond INT_MAX samples) is the file decoded again, with a warning.
+ **********************************************************************/
+{double    buf[block],x,sum=0,top=0,*grown;
+ long long pos=0,count=0;
+ long      k,n,last,from,nkept=0,size=0;
+ FILE     *spill=NULL;
+
+ drop_kept();
+ if (!open_range(filename)) return 0;
+ do
+ {last=new_samples(one_byte,buf,block);
+  if (c!=NULL) anicache_hash_add(c,buf,((last<0) ? block : last+1)*sizeof(double));
+  n=(last<0) ? block : last;
+  if (keep && (spill==NULL) && (nkept+block>size))
+  {size=(size==0) ? 64*block : 2*size;
+   grown=(size<=max_kept) ? (double*)realloc(kept,size*sizeof(double)) : NULL;
+   if (grown!=NULL) kept=grown;
+   else
+   {spill=spill_kept(nkept);
+    if (spill==NULL) keep=0;
    }
-   while (!last);
-   factor=max(1.0,0.75/smax);
-   close_readfile(); /* !!!!! */
+  }
+  if (keep && (nkept>INT_MAX-block))
+  {log_message(log_warning,"%s is too long to be kept: it is decoded again",filename);
+   keep=0;
+  }
+  if (keep && (spill!=NULL) && (fwrite(buf,sizeof(double),n,spill)!=(size_t)n))
+  {log_message(log_warning,"the samples of %s could not be spilled: it is decoded again",filename);
+   keep=0;
+  }
+  if (keep && (spill==NULL)) memcpy(kept+nkept,buf,n*sizeof(double));
+  if (keep) nkept+=n;
+  else if (spill!=NULL) {fclose(spill); spill=NULL;}
+  else if (kept!=NULL) {free(kept); kept=NULL;}
+  from=(pos<range_lead) ? (long)min(range_lead-pos,(long long)block) : 0;
+  for (k=from;k<((last<0) ? block : last);k++)
+  {x=buf[k]; sum+=x*x;
+   if (fabs(x)>top) top=fabs(x);
+  }
+  if (k>from) count+=k-from;
+  pos+=block;
+ }
+ while (last<0);
+ close_signal();
+ if (spill!=NULL)
+ {keep=map_kept(spill,nkept);
+  if (!keep) log_message(log_warning,"the samples of %s could not be mapped: it is decoded again",filename);
  }
+ if (signal_failed()) {drop_kept(); return 0;}
+ if (keep) set_sigioread_part(kept,nkept,range_first);
+ *peak=top;
+ *rms=(count>0) ? sqrt(sum/count) : 0;
+ return 1;
+}
+
+void drop_kept()
+/* read the sound file again, after measure_level kept its samples */
+{
+ if (kept==NULL) return;
+ set_sigioread_memory(NULL,0);
+#if !defined(_WIN32)
+ if (kept_mapped>0) munmap(kept,kept_mapped);
+ else
+#endif
+ free(kept);
+ kept=NULL; kept_mapped=0;
+}
+
+void set_factor(double peak,double rms)
+/* the factor for the samples from the level of the signal */
+{
+ if ((norm_mode==norm_peak) && (peak>0)) factor=max(1.0,0.75/peak);
+ else if ((norm_mode==norm_rms) && (rms>0)) factor=pow(10.0,norm_level/20)/rms;
  else factor=1.0;
- printf("factor = %f\n",factor);
+ log_message(log_debug,"factor = %f",factor);
+}
+
+void read_block()
+/**********************************************************************
+  Read the next block of input samples (zeroes after the end of the
+  signal) and run it through the OMEF and, if fsmp<>fssig, through
+  the upsampler, so that the per sample stages in one_frame only
+  have to pick up the results. block_last is the index of the last
+  sample of the signal in this block (-1 if it is not in it). The
+  fixed point kernel gets the samples in q_sig, saturated at +-16.
+ **********************************************************************/
+{long k;
+
+ if (block_eof)
+ {block_last=-1;
+  for (k=0;k<block;k++) omef_out[k]=0;
+ }
+ else
+ {block_last=new_samples(one_byte,omef_out,block);
+  if (block_last>=0) {block_eof=1; close_signal();}
+  for (k=0;k<block;k++) omef_out[k]=factor*omef_out[k];
+ }
+ if (kernel==kernel_fixed)
+ {for (k=0;k<block;k++) qomef_out[k]=q_from(omef_out[k],q_sig);
+  omef_qblock(qomef_out,qomef_out,block);
+  if (fsmp!=fssig) upsample_qblock(qomef_out,qdf0_out,block);
+ }
+ else
+ {omef_block(omef_out,omef_out,block);
+  if (fsmp!=fssig) upsample_block(omef_out,df0_out,block);
+ }
+ block_pos=0;
+}
+
+long long frames_before(long long s)
+/* number of frames (at multiples of Ne.Tsmp) before signal sample s */
+{long long r=round_int(fsmp/fssig)*s;
+
+ return (r+Ne-1)/Ne;
+}
+
+void setup_range()
+/**********************************************************************
+  Reading starts the pre-roll before the range, rounded down to a
+  multiple of 16 samples: n then has the same phase in every channel
+  step and decimation as when the whole signal is analysed, so that
+  after the pre-roll the frames only differ by the settling of the
+  filter states. The frames of the pre-roll are not written.
+ **********************************************************************/
+{long long first,last;
+
+ first=(long long)floor(range_start*1000*fssig+0.5);
+ if (first<0) first=0;
+ range_first=first-(long long)floor(range_preroll*1000*fssig+0.5);
+ if (range_first<0) range_first=0;
+ range_first-=range_first%16;
+ range_lead=first-range_first;
+ range_skip=frames_before(first)-frames_before(range_first);
+ range_time=frames_before(first)*Ne/(1000*fsmp);
+ if (range_duration<0) {range_count=-1; range_frames=-1;}
+ else
+ {last=first+(long long)floor(range_duration*1000*fssig+0.5);
+  range_count=last-range_first;
+  range_frames=frames_before(last)-frames_before(first);
+ }
+}
+
+int open_range(text_line filename)
+/* open the signal at the first sample of the pre-roll */
+{
+ setup_range();
+ if (!open_signal(filename)) return 0;
+ if (!seek_signal(range_first,range_count)) {close_signal(); return 0;}
+ return 1;
 }
 
 int init_analysis(text_line filename,const char* inOutputFileName)
@@ -175,11 +404,14 @@ int init_analysis(text_line filename,const char* inOutputFileName)
  **********************************************************************/
 {int m,p;
 
- if (auto_factor) init_factor(filename);
+ setup_range();
+ HCMBank_SetFrameRange(range_skip,range_frames,range_time);
  init_modules(inOutputFileName); n=0; nmod=0; t=0; tout=delay+Tframe; tend=0; 
+ tpitch=delay+Tpitch+Tframe;
  Tsmp=1/fsmp; par_ptr=0; 
  for (m=0;m<=width-1;m++) for (p=1;p<=nchan+Nerl+3;p++) par[m][p]=0;
- return open_readfile(filename);
+ block_pos=block; block_eof=0;
+ return open_range(filename);
 }
 
 /* Finalize analysis of one file */
@@ -187,6 +419,8 @@ int init_analysis(text_line filename,const char* inOutputFileName)
 void finish_analysis()
 {
 	finish_modules();
+	/* the analysis of a range may stop before its last block is read */
+	if (!block_eof) {block_eof=1; close_signal();}
 }
 
 int one_frame(int *last,parameters frame)
@@ -197,33 +431,51 @@ int one_frame(int *last,parameters frame)
  if (tend!=0) *last=1; else *last=0; 
  if (n==0) cnt=shift+1; else cnt=1;
  do
- {if (*last) sn=0;
-  else 
-  {sn=factor*new_sample(one_byte,last);
-   if (*last) {tend=n*Tsmp+delay+2*Tframe; close_readfile();}
-  }
-  sn=omef(sn); 
-  decimate(sn); 
-  filterbank(); 
-  hcmbank(); 
+ {if (block_pos==block) read_block();
+  if (!*last && block_pos==block_last)
+  {*last=1; tend=n*Tsmp+delay+2*Tframe;}
+  if (kernel==kernel_fixed)
+  {decimate_q(qomef_out[block_pos],qdf0_out[2*block_pos]);
+   filterbank_q();
+   hcmbank_q();
+  }
+  else
+  {sn=omef_out[block_pos]; 
+   decimate(sn,df0_out[2*block_pos]); 
+   filterbank(); 
+   hcmbank(); 
+  }
 
 /* KT 19990525
-  ecebank(); 
-  cpu();
+  ecebank(); 
+  cpu();
 */
+  if (pitch_on) {ecebank(); cpu();}
   if (fsmp!=fssig) 
   {sn=0; n++; t=t+Tsmp; 
    nmod++; if (nmod==max_step) nmod=0;
-   decimate(sn); 
-   filterbank(); 
-   hcmbank(); 
+   if (kernel==kernel_fixed)
+   {decimate_q(0,qdf0_out[2*block_pos+1]);
+    filterbank_q();
+    hcmbank_q();
+   }
+   else
+   {decimate(sn,df0_out[2*block_pos+1]); 
+    filterbank(); 
+    hcmbank(); 
+   }
 
 /* KT 19990525
-   ecebank(); 
-   cpu();
+   ecebank(); 
+   cpu();
 */
+   if (pitch_on) {ecebank(); cpu();}
   }
-  n++; t=t+Tsmp; nmod++; if (nmod==max_step) nmod=0;
+  n++; t=t+Tsmp; nmod++; if (nmod==max_step) nmod=0; block_pos++;
+  /* the pitch frames are not the frames below: the ECE delays the pitch
+     by Tpitch, but the ANI (and thus the end of the analysis) is not */
+  if (pitch_on && ((n & Nemask)==0) && (t>=tpitch))
+  {pitch_frame(); tpitch=tpitch+Tframe;}
   if (((n & Nemask)==0) && (t>=tout))  
   {if (par_ptr==width-1) par_ptr=0; else par_ptr++;
 
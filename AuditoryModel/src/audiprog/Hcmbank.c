@@ -21,6 +21,7 @@
 
 #include "audiprog.h"
 #include "hcmbank.h"
+#include <aniio.h>
 
 #define  tau1      8.0       /* smallest time constant (ms) of LPF     */
 #define  tau2     40.0       /* largest time constant (ms) of LPF      */
@@ -47,36 +48,186 @@ typedef struct{
                double wn1,wn2; /* state vector of 2nd order cell      */
               } eefdata;
 
-static double   bias;               /* bias in gain control branch         */
-static double   factor2;            /* fsat/sqr(bias)                      */
-static hcmdata  hcmd[max_nchan+1];  /* coefficients + state vars of hcm's  */
-static eefdata  eefd[max_nchan+1];  /* coefficients + state vars of eef's  */
+/* the same in fixed point: coefficients in q_coef, z and q in q_sig, w2
+   in q_int and the firing rates in q_rate (see qformat.h) */
+typedef struct{
+               qval a1q,a2q,g1q,c1,c2;
+               qval zn,w1n,qn;
+               qval w2n;
+               qval fn,qfac;
+               qacc e1,e2;       /* rounding errors of w1n and w2n   */
+              } qhcmdata;
+
+typedef struct{
+               qval b,b1,b2,g1,g2;
+               qval y1n,wn1,wn2;
+              } qeefdata;
+
+static per_thread double   bias;               /* bias in gain control branch         */
+static per_thread double   factor2;            /* fsat/sqr(bias)                      */
+static per_thread hcmdata  hcmd[max_nchan+1];  /* coefficients + state vars of hcm's  */
+static per_thread eefdata  eefd[max_nchan+1];  /* coefficients + state vars of eef's  */
+static per_thread qhcmdata qhcmd[max_nchan+1]; /* the same for the fixed kernel       */
+static per_thread qeefdata qeefd[max_nchan+1];
+static per_thread qval     qbias,qfsat,qyref;  /* q_sig                               */
+static per_thread qval     qfactor2;           /* q_rate                              */
 
-static FILE*    sEnvelopeFile = NULL;	/* The file in which the envelopes of
+static per_thread FILE*    sEnvelopeFile = NULL;	/* The file in which the envelopes of
 							               the firing probabilities are stored */
 							            /* KT 19990525 */
+static per_thread ani_writer sANIWriter;           /* used if outformat is binary     */
+static per_thread rvector    sEnvelopes;           /* envelopes of the current frame  */
+static per_thread FILE*      sEnvelopeStream = NULL; /* if set, used instead of a file */
+static per_thread const ani_sink* sEnvelopeSink = NULL; /* if set, used instead of a file */
+static per_thread int        sSinkFailed = 0;
+static per_thread FILE*      sPyramidFile = NULL;  /* decimated envelopes, if requested */
+static per_thread ani_pyr_writer sPyramidWriter;
+static per_thread int        sOpenFailed = 0;      /* an output could not be opened */
+static per_thread long long  sFramesToSkip = 0;    /* frames of the pre-roll left */
+static per_thread long long  sFramesLeft = -1;     /* frames still to write, -1: all */
+static per_thread double     sStartTime = 0;       /* time of the first frame written (s) */
 
 /* ----- Down from here: KT 19990525 ----- */
 
+/* Close the firing probability envelope file. */
+void HCMBank_CloseEnvelopeFile ()
+{
+	if (sEnvelopeFile == NULL) return;
+	if (outformat == outformat_binary) ani_close_write(&sANIWriter);
+	if (sEnvelopeFile == sEnvelopeStream) fflush(sEnvelopeFile);
+	else fclose(sEnvelopeFile);
+	sEnvelopeFile = NULL;
+}
+
+/* Send the envelopes to an open stream (e.g. a socket) instead of to the
+   output file; the stream is not closed. NULL restores the output file. */
+void HCMBank_SetEnvelopeStream (FILE* inStream)
+{
+	sEnvelopeStream = inStream;
+}
+
+/* Hand the envelopes to a sink (e.g. a buffer in memory) instead of writing
+   them to the output file. NULL restores the output file. */
+void HCMBank_SetEnvelopeSink (const ani_sink* inSink)
+{
+	sEnvelopeSink = inSink;
+}
+
+/* Only write inCount frames (all if inCount < 0) after skipping the first
+   inSkip ones, e.g. the pre-roll before a part of the signal; inStartTime
+   is the time of the first frame written. Call before init_hcmbank. */
+void HCMBank_SetFrameRange (long long inSkip, long long inCount, double inStartTime)
+{
+	sFramesToSkip = inSkip;
+	sFramesLeft = inCount;
+	sStartTime = inStartTime;
+}
+
+/* Returns nonzero once all the frames of the range are written */
+int HCMBank_FrameRangeDone ()
+{
+	return (sFramesLeft == 0);
+}
+
+/* Returns nonzero if the envelope file or the pyramid file could not be
+   opened, or if writing to one of them (or to the sink) failed */
+int HCMBank_EnvelopeFileError ()
+{
+	if (sOpenFailed) return 1;
+	if ((sPyramidFile != NULL) && (sPyramidWriter.failed || ferror(sPyramidFile))) return 1;
+	if (sEnvelopeSink != NULL) return sSinkFailed;
+	return (sEnvelopeFile != NULL) && ferror(sEnvelopeFile);
+}
+
 /* Open the firing probability envelope file.
    Returns 1 on success, 0 on failure */
 int HCMBank_OpenEnvelopeFile (const char* inFileNameWithPath)
 {
-	sEnvelopeFile = fopen(inFileNameWithPath,"wb");
-	return (sEnvelopeFile == NULL) ? 0 : 1;
+	int p;
+	rvector theFreqs;
+
+	if (sEnvelopeSink != NULL)
+	{
+		for (p = 1; p <= nchan; p++) theFreqs[p] = 1000*fc[p];
+		sSinkFailed = !sEnvelopeSink->begin(sEnvelopeSink->context,nchan,1000*fsmp/Ne,&theFreqs[1]);
+		return !sSinkFailed;
+	}
+	if (sEnvelopeStream != NULL) sEnvelopeFile = sEnvelopeStream;
+	else sEnvelopeFile = fopen(inFileNameWithPath,"wb");
+	if (sEnvelopeFile == NULL) return 0;
+	if (outformat == outformat_binary)
+	{
+		/* binary ANI: frame rate and centre frequencies in Hz */
+		for (p = 1; p <= nchan; p++) theFreqs[p] = 1000*fc[p];
+		if (!ani_open_write(&sANIWriter,sEnvelopeFile,nchan,1000*fsmp/Ne,sStartTime,&theFreqs[1]))
+		{
+			HCMBank_CloseEnvelopeFile();
+			return 0;
+		}
+	}
+	return 1;
 }
 
-/* Close the firing probability envelope file. */
-void HCMBank_CloseEnvelopeFile ()
+/* Open the pyramid file, which gets the envelopes at ever coarser time
+   scales (see library/aniio.h) next to the output file, stream or sink.
+   Returns 1 on success, 0 on failure */
+int HCMBank_OpenPyramidFile (const char* inFileNameWithPath, int inNumOfLevels)
 {
-	fclose(sEnvelopeFile);
-	sEnvelopeFile = NULL;
+	int p;
+	rvector theFreqs;
+
+	sPyramidFile = fopen(inFileNameWithPath,"wb");
+	if (sPyramidFile == NULL) return 0;
+	for (p = 1; p <= nchan; p++) theFreqs[p] = 1000*fc[p];
+	if (!ani_pyr_open_write(&sPyramidWriter,sPyramidFile,nchan,inNumOfLevels,1000*fsmp/Ne,sStartTime,&theFreqs[1]))
+	{
+		ani_pyr_close_write(&sPyramidWriter);
+		fclose(sPyramidFile);
+		sPyramidFile = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+/* Write the coarser levels and the index, and close the pyramid file. */
+void HCMBank_ClosePyramidFile ()
+{
+	if (sPyramidFile == NULL) return;
+	if (!ani_pyr_close_write(&sPyramidWriter))
+		log_message(log_error,"the pyramid file could not be written completely");
+	fclose(sPyramidFile);
+	sPyramidFile = NULL;
+}
+
+/* Write the envelopes of one frame */
+void HCMBank_WriteEnvelopes ()
+{
+	int p;
+
+	if (sFramesToSkip > 0) { sFramesToSkip--; return; }
+	if (sFramesLeft == 0) return;
+	if (sFramesLeft > 0) sFramesLeft--;
+	if (sPyramidFile != NULL) ani_pyr_write_frame(&sPyramidWriter,&sEnvelopes[1]);
+	if (sEnvelopeSink != NULL)
+	{
+		if (!sSinkFailed) sSinkFailed = !sEnvelopeSink->frame(sEnvelopeSink->context,&sEnvelopes[1]);
+		return;
+	}
+	if (sEnvelopeFile == NULL) return;
+	if (outformat == outformat_binary)
+		ani_write_frame(&sANIWriter,&sEnvelopes[1]);
+	else
+	{
+		for (p = 1; p <= nchan; p++) fprintf(sEnvelopeFile,"%.10lf ",sEnvelopes[p]);
+		fprintf(sEnvelopeFile,"\n");
+	}
 }
 
 /* Finalize HCM bank */
 void finish_hcmbank ()
 {
 	HCMBank_CloseEnvelopeFile();
+	HCMBank_ClosePyramidFile();
 }
 
 /* end of KT changes */
@@ -96,7 +247,7 @@ void write_eef()
  long prev_s;
  double f,fs,y,ydb;
 
- if (open_writefile("eef.dat")) 
+ if (write_dumps && open_writefile("eef.dat")) 
  {for (i=1;i<=100;i++)
   {f=i*fsmp/1600; fprintf(writefile,"%7.3f",f); prev_s=0;
    for (p=1;p<=nchan;p++) if (step[p]!=prev_s)
@@ -125,7 +276,7 @@ void write_lpf()
  long prev_s;
  double f,fs,y,ydb;
 
- if (open_writefile("lpf.dat")) 
+ if (write_dumps && open_writefile("lpf.dat")) 
  {for (i=1;i<=100;i++)
   {f=i/200.0; fprintf(writefile,"%7.3f",f); prev_s=0;
    for (p=1;p<=nchan;p++) if (step[p]!=prev_s) 
@@ -185,6 +336,16 @@ void setup_hcmbank()
           /* 0.25 because f(0) = 4w(0) = 4g2.f(0)/(1+b1+b2) */
  }
  bias=sqrt(yref*fsat/fspont)-sqrt(yref); factor2=fsat/pow(bias,2.0);
+ for (p=1;p<=nchan;p++)
+ {qhcmd[p].a1q=q_from(hcmd[p].a1q,q_coef); qhcmd[p].a2q=q_from(hcmd[p].a2q,q_coef);
+  qhcmd[p].g1q=q_from(hcmd[p].g1q,q_coef);
+  qhcmd[p].c1=q_from(hcmd[p].c1,q_coef); qhcmd[p].c2=q_from(hcmd[p].c2,q_coef);
+  qeefd[p].b=q_from(eefd[p].b,q_coef);
+  qeefd[p].b1=q_from(eefd[p].b1,q_coef); qeefd[p].b2=q_from(eefd[p].b2,q_coef);
+  qeefd[p].g1=q_from(eefd[p].g1,q_coef); qeefd[p].g2=q_from(eefd[p].g2,q_coef);
+ }
+ qbias=q_from(bias,q_sig); qfsat=q_from(fsat,q_sig); qyref=q_from(yref,q_sig);
+ qfactor2=q_from(factor2,q_rate);
  write_lpf(); write_eef();
 }
 
@@ -216,12 +377,24 @@ void init_hcmbank(const char* inOutputFileName)
   hcmd[p].fn=fspont; 
   eefd[p].y1n=fspont; eefd[p].wn1=0.25*fspont; eefd[p].wn2=eefd[p].wn1;
   yhcm[p]=fspont; yhcm1[p]=yhcm[p];
+  qhcmd[p].zn=qyref; qhcmd[p].qn=qyref; qhcmd[p].qfac=0;
+  qhcmd[p].w1n=qyref; qhcmd[p].w2n=q_from(hcmd[p].w2n,q_int);
+  qhcmd[p].fn=q_from(fspont,q_rate); qhcmd[p].e1=0; qhcmd[p].e2=0;
+  qeefd[p].y1n=q_from(fspont,q_rate); qeefd[p].wn1=q_from(0.25*fspont,q_rate);
+  qeefd[p].wn2=qeefd[p].wn1;
  }
 
  /* Initialization for the envelope output file */	/* KT 19990525 */
+ sOpenFailed = 0;
  if (!HCMBank_OpenEnvelopeFile(inOutputFileName))
  {
-	printf("\nERROR: the output file \"%s\" could not be opened for writing...\n", inOutputFileName);
+	sOpenFailed = 1;
+	log_message(log_error,"the output file \"%s\" could not be opened for writing", inOutputFileName);
+ }
+ if ((pyramid_file[0] != '\0') && !HCMBank_OpenPyramidFile(pyramid_file,pyramid_levels))
+ {
+	sOpenFailed = 1;
+	log_message(log_error,"the pyramid file \"%s\" could not be opened for writing", pyramid_file);
  }
 }
 
@@ -265,12 +438,75 @@ void hcmbank()
   if (compute_en)
   {
 	yhcm1[p]=yhcm[p]; yhcm[p]=new_w+2*eefd[p].wn1+eefd[p].wn2;
-	fprintf(sEnvelopeFile,"%.10lf ",(yhcm[p] < 0) ? 0 : yhcm[p]);	/* KT 19990525 */
+	sEnvelopes[p] = (yhcm[p] < 0) ? 0 : yhcm[p];	/* KT 19990525 */
   }
   eefd[p].wn2=eefd[p].wn1; eefd[p].wn1=new_w;
  }
- if (compute_en) fprintf(sEnvelopeFile,"\n");	/* KT 19990525 */
+ if (compute_en) HCMBank_WriteEnvelopes();	/* KT 19990525 */
 }
 
-
-
+static qacc q_sqrt(qacc a)
+/* the integer square root (rounded down) of a >= 0 */
+{qacc r=0,b=(qacc)1<<62;
+
+ while (b>a) b>>=2;
+ while (b!=0)
+ {if (a>=r+b) {a-=r+b; r=(r>>1)+b;} else r>>=1;
+  b>>=2;
+ }
+ return r;
+}
+
+void hcmbank_q()
+/**********************************************************************
+   hcmbank in fixed point, from qybpf. The two LPF cells integrate over
+   8 and 40 ms, so their rounding errors are fed back into the next
+   sample (as in iir_qcells). The AGC gain fsat/(bias+sqrt(q))^2 is
+   computed with an integer square root and one 64 bit division per
+   envelope sample.
+ **********************************************************************/
+{int    p,compute_en;
+ qacc   acc,d;
+ qval   zn1,fn1,new_w2,new_w;
+ qhcmdata *h;
+ qeefdata *e;
+
+ compute_en=((n & Nemask)==0);
+ for (p=low_ch[nmod];p<=nchan;p++)
+ {h=&qhcmd[p]; e=&qeefd[p];
+  zn1=h->zn; fn1=h->fn;
+  acc=(qacc)qybpf[p]+qyref; h->zn=(acc>0) ? q_sat(acc) : 0;
+  acc=(qacc)h->g1q*((qacc)h->zn+zn1)+(qacc)h->c1*h->w1n+h->e1;
+  h->w1n=q_sat(q_round(acc,q_coef)); h->e1=acc-((qacc)h->w1n<<q_coef);
+  acc=((qacc)h->w1n<<(q_coef+q_int-q_sig))+(qacc)h->c2*h->w2n+h->e2;
+  new_w2=q_sat(q_round(acc,q_coef)); h->e2=acc-((qacc)new_w2<<q_coef);
+  if (compute_en)
+  {acc=(qacc)h->a1q*new_w2-(qacc)h->a2q*h->w2n;
+   h->qn=q_sat(q_round(acc,q_coef+q_int-q_sig));
+   h->qfac=0;
+  }
+  h->w2n=new_w2;
+  if (h->zn<=0) h->fn=0;
+  else if (h->qn<=0) h->fn=q_sat(q_mul(qfactor2,h->zn,q_sig));
+       else
+       {if (h->qfac==0)
+        {d=qbias+q_sqrt((qacc)h->qn<<q_sig);       /* q_sig */
+         d=q_round(d*d,q_sig+q_sig-34);           /* d^2 with 34 fraction bits */
+         h->qfac=q_sat((((qacc)qfsat<<(34+q_rate-q_sig))+d/2)/d);
+        }
+        h->fn=q_sat(q_mul(h->qfac,h->zn,q_sig));
+       }
+
+  acc=(qacc)e->g1*((qacc)h->fn+fn1)+(qacc)e->b*e->y1n;
+  e->y1n=q_sat(q_round(acc,q_coef));
+  acc=(qacc)e->g2*e->y1n-(qacc)e->b1*e->wn1-(qacc)e->b2*e->wn2;
+  new_w=q_sat(q_round(acc,q_coef));
+  if (compute_en)
+  {
+	yhcm1[p]=yhcm[p]; yhcm[p]=q_to((qacc)new_w+2*(qacc)e->wn1+e->wn2,q_rate);
+	sEnvelopes[p] = (yhcm[p] < 0) ? 0 : yhcm[p];
+  }
+  e->wn2=e->wn1; e->wn1=new_w;
+ }
+ if (compute_en) HCMBank_WriteEnvelopes();
+}
@@ -24,9 +24,15 @@
 
 #include <command.h>
 #include <pario.h>
+#include <anicache.h>
 
 extern long startup_audiprog(int bytes,int *nspect,int *npar,
 							 long inNumOfChannels,double inFirstFreq,double inFreqDist,double inSampleFrequency);
+extern int open_range(text_line filename);
+extern int measure_level(text_line filename,anicache_hash *c,double *peak,double *rms,
+                         int keep);
+extern void drop_kept();
+extern void set_factor(double peak,double rms);
 extern int init_analysis(text_line filename,const char* inOutputFileName);
 extern int one_frame(int *last,parameters frame);
 extern void finish_analysis();
@@ -0,0 +1,73 @@
+/* audiparams.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/***************************************************************************
+   The parameters of one run of the auditory model (AudiProg), and the
+   entry point itself. Unlike audiprog.h this header declares none of
+   the globals of the model, so that the API modules can include it.
+   Unset fields (zero, NULL) choose the defaults noted below; negative
+   values do so too where zero is meaningful.
+ ***************************************************************************/
+
+#if !defined( AUDIPARAMS_H )
+#define AUDIPARAMS_H
+
+#include <stdio.h>
+#include <aniio.h>
+#include <logging.h>
+#include <decoder.h>
+
+typedef struct{
+               long        nchan;          /* channels of the filterbank    */
+               double      first_freq;     /* first channel, on chan_scale  */
+               double      freq_dist;      /* spacing, on chan_scale        */
+               const char *input_file;     /* sound file and its directory  */
+               const char *input_path;     /* ("" for none)                 */
+               const char *output_file;    /* envelopes and their directory */
+               const char *output_path;
+               double      sample_freq;    /* of signal (Hz)                */
+               long        sound_format;   /* 2: any sound file (decoder.c) */
+               long        output_format;  /* outformat_text or _binary     */
+               const double *signal;       /* samples in memory instead of  */
+               long        signal_length;  /* the sound file, or NULL       */
+               const decoder_source *source; /* or samples from a source    */
+               FILE       *output_stream;  /* envelopes to a stream ...     */
+               const ani_sink *output_sink; /* ... or a sink, or NULL       */
+               const char *cache_dir;      /* ANI cache, NULL for none      */
+               double      cache_size;     /* its limit (MB), 0: default    */
+               const char *pitch_file;     /* pitch track, NULL for none    */
+               const char *pyramid_file;   /* ANI pyramid, NULL for none    */
+               long        pyramid_levels; /* 0: ani_pyr_def_levels         */
+               const log_sink *log_sink;   /* messages, NULL: default sink  */
+               long        chan_scale;     /* scale_cbu ... (-1: cbu)       */
+               const double *chan_positions; /* channels at these positions */
+               long        npositions;     /* (overrides nchan), or NULL    */
+               double      start;          /* part of the signal (s),       */
+               double      duration;       /* duration -1: up to the end    */
+               double      preroll;        /* -1: def_preroll               */
+               long        normalization;  /* norm_none, norm_peak, norm_rms */
+               double      level;          /* of norm_rms (dB)              */
+               long        kernel;         /* kernel_double or kernel_fixed */
+              } audiprog_params;
+
+extern long AudiProg(const audiprog_params *p);
+
+#endif /* !defined( AUDIPARAMS_H ) */
@@ -27,6 +27,8 @@
 #include <command.h>
 #include <pario.h>
 #include <sigio.h>
+#include <logging.h>
+#include "qformat.h"
 
 #if !defined( AUDIPROG_H )
 #define AUDIPROG_H
@@ -35,47 +37,82 @@
 #define max_nchan    40        /* maximum number of channels */
 #define fspont       0.05      /* spontaneous firing rate */
 
+#define audiprog_version  1    /* increase when the output changes  */
+#define def_preroll       0.5  /* signal analysed before a range (s) */
+
+#define outformat_text    0    /* envelopes written as text lines   */
+#define outformat_binary  1    /* envelopes written as binary ANI   */
+
+#define scale_cbu         0    /* channels placed in critical band units */
+#define scale_erb         1    /* ... in ERB-rate units (Glasberg/Moore) */
+#define scale_bark        2    /* ... in Bark (Traunmueller)            */
+#define scale_hz          3    /* ... in Hz                             */
+
+#define norm_none         0    /* input samples used as they are         */
+#define norm_peak         1    /* raised to a peak of 0.75 (never lowered) */
+#define norm_rms          2    /* scaled to an RMS level of norm_level dB */
+
+#define kernel_double     0    /* the model in double precision          */
+#define kernel_fixed      1    /* in 32 bit fixed point (qformat.h)      */
+
 typedef double rvector[max_nchan+1];
 typedef long   ivector[max_nchan+1];
 
-extern double  Tdecim;     /* delay introduced by decimation unit (ms)  */
-extern double  Tmodel;     /* delay introduced by rest of model (ms)    */
-extern double  fsmp;       /* internal sampling frequency = 1/Tsmp      */
-extern double  fssig;      /* signal sampling frequency                 */
-extern double  Tframe;     /* time between successive frames (ms)       */
-extern int     ndecim;     /* number of decimation filters to use       */
-extern double  Tse;        /* time between successive envelope samples  */
-extern int     Ne;         /* Tsmp for envelope / Tsmp of model         */
-extern int     Nemask;     /* Ne-1 = mask for MOD replacement           */
-extern int     Nerl;       /* number of erl samples per frame           */
-extern double  Terl;       /* time between erl samples in frame         */
-extern int     shift;      /* pitch comes from SHIFT frames behind      */
-extern int     nchan;      /* number of filterbank channels             */
-extern double  uc1;        /* ucp of first channel                      */
-extern double  duc;        /* spacing between succesive ucp's           */
-extern int     n;          /* time index                                */
+extern per_thread double  Tdecim;     /* delay introduced by decimation unit (ms)  */
+extern per_thread double  Tmodel;     /* delay introduced by rest of model (ms)    */
+extern per_thread double  Tpitch;     /* extra delay of the pitch stage (ms)       */
+extern per_thread double  fsmp;       /* internal sampling frequency = 1/Tsmp      */
+extern per_thread double  fssig;      /* signal sampling frequency                 */
+extern per_thread double  Tframe;     /* time between successive frames (ms)       */
+extern per_thread int     ndecim;     /* number of decimation filters to use       */
+extern per_thread double  Tse;        /* time between successive envelope samples  */
+extern per_thread int     Ne;         /* Tsmp for envelope / Tsmp of model         */
+extern per_thread int     Nemask;     /* Ne-1 = mask for MOD replacement           */
+extern per_thread int     Nerl;       /* number of erl samples per frame           */
+extern per_thread double  Terl;       /* time between erl samples in frame         */
+extern per_thread int     shift;      /* pitch comes from SHIFT frames behind      */
+extern per_thread int     nchan;      /* number of filterbank channels             */
+extern per_thread double  uc1;        /* ucp of first channel                      */
+extern per_thread double  duc;        /* spacing between succesive ucp's           */
+extern per_thread int     chan_scale; /* scale of uc1, duc and chan_pos            */
+extern per_thread int     chan_count; /* number of chan_pos, 0 if equally spaced   */
+extern per_thread rvector chan_pos;   /* channel positions on chan_scale (1..)     */
+extern per_thread int     n;          /* time index                                */
+extern per_thread double  range_start;    /* start of the part to analyse (s)      */
+extern per_thread double  range_duration; /* its duration (s), <0: up to the end   */
+extern per_thread double  range_preroll;  /* signal analysed (and dropped) before  */
 
-extern rvector fc;         /* BPF central frequencies                   */
-extern rvector uc;         /* corresponding critical band units         */
-extern ivector x2;         /* is there a need to upsample after BPF?    */
-extern ivector step;       /* time steps used in analysis channels      */
-extern ivector stepmask;   /* stepmask=step-1 = mask for MOD replacement*/
+extern per_thread rvector fc;         /* BPF central frequencies                   */
+extern per_thread rvector uc;         /* corresponding critical band units         */
+extern per_thread ivector x2;         /* is there a need to upsample after BPF?    */
+extern per_thread ivector step;       /* time steps used in analysis channels      */
+extern per_thread ivector stepmask;   /* stepmask=step-1 = mask for MOD replacement*/
 /* JPM: 20/10/98: new implementation of channel selection ***************/
-extern int     max_step;   /* maximum step encountered in channels      */
-extern int     nmod;       /* time modulo max_step                      */
-extern int     low_ch[16]; /* lowest channel to process for different   */
+extern per_thread int     max_step;   /* maximum step encountered in channels      */
+extern per_thread int     nmod;       /* time modulo max_step                      */
+extern per_thread int     low_ch[16]; /* lowest channel to process for different   */
                            /* values of nmod                            */
 /************************************************************************/
-extern double  decim[5+1]; /* decimation products                       */
-extern ivector indx;       /* index in decimation product array         */
-extern rvector ybpf;       /* BPF outputs at multiples of step.Tsmp     */
+extern per_thread double  decim[5+1]; /* decimation products                       */
+extern per_thread qval    qdecim[5+1];/* the same in fixed point (q_sig)           */
+extern per_thread ivector indx;       /* index in decimation product array         */
+extern per_thread rvector ybpf;       /* BPF outputs at multiples of step.Tsmp     */
+extern per_thread qval    qybpf[max_nchan+1]; /* the same in fixed point (q_sig)   */
 
-extern rvector yhcm;       /* HCM outputs at multiples of Tse           */
-extern rvector yhcm1;      /* previous HCM outputs at multiples of Tse  */
-extern rvector ev,erl;     /* virtual tone, roughness+loudness comps.   */
-extern rvector prev_erl;   /* previous roughness+loudness components    */
-extern rvector yres;       /* xxx outputs at multiples of step.Tsmp     */
-extern double  factor;     /* multiplication factor for input samples   */
+extern per_thread rvector yhcm;       /* HCM outputs at multiples of Tse           */
+extern per_thread rvector yhcm1;      /* previous HCM outputs at multiples of Tse  */
+extern per_thread rvector ev,erl;     /* virtual tone, roughness+loudness comps.   */
+extern per_thread rvector prev_erl;   /* previous roughness+loudness components    */
+extern per_thread rvector yres;       /* xxx outputs at multiples of step.Tsmp     */
+extern per_thread double  factor;     /* multiplication factor for input samples   */
+extern per_thread int     norm_mode;  /* how factor is derived from the signal     */
+extern per_thread double  norm_level; /* RMS level (dB) for norm_rms               */
+extern per_thread int     kernel;     /* kernel_double or kernel_fixed             */
+extern per_thread int     outformat;  /* format of the envelope output file        */
+extern per_thread text_line pitch_file; /* pitch track, not computed if empty */
+extern per_thread text_line pyramid_file; /* decimated ANI, not written if empty */
+extern per_thread int     pyramid_levels; /* number of levels of the pyramid      */
+extern per_thread int     write_dumps;/* write the responses and outfile.dat       */
 
 #endif /* AUDIPROG_H */
 
@@ -29,33 +29,59 @@
 
 #define max_nbuf 32
 
-static double  Terlbuf;       /* time between computations of erl_sum */
-static long    Nerlbuf;       /* ratio between Terlbuf and Tse */
-static double  erl_buf[max_nbuf-1+1];
+static per_thread double  Terlbuf;       /* time between computations of erl_sum */
+static per_thread long    Nerlbuf;       /* ratio between Terlbuf and Tse */
+static per_thread double  erl_buf[max_nbuf-1+1];
                               /* contains last (Tframe/Tse) samples erl_sum */
-static long    pbuf;          /* Tframe/Tse */
-static long    nbuf;          /* pointer to most recent sample in buffer */
+static per_thread long    pbuf;          /* Tframe/Tse */
+static per_thread long    nbuf;          /* pointer to most recent sample in buffer */
+static per_thread FILE   *pitchfile=NULL; /* T0, evidence and vuv of each frame */
+static per_thread long    nframe;        /* nr. of frames passed to extract_pitch */
 
 
 void setup_cpu()
 {
  Nerlbuf=round_int(Terl*fsmp);
  Terlbuf=(double)Nerlbuf/fsmp;
- printf("%s%4d\n","Nerlbuf =",Nerlbuf);
+ log_message(log_debug,"%s%4ld","Nerlbuf =",Nerlbuf);
  nbuf=1+round_int(Tframe/Terlbuf); 
  setup_pitch();
- if (nbuf>max_nbuf) printf("ERROR: Nerl too large for CPU\n");
- else printf("%s%4d%4d\n","nbuf,Nerl =",nbuf,Nerl);
+ if (nbuf>max_nbuf) log_message(log_error,"Nerl too large for CPU");
+ else log_message(log_debug,"%s%4ld%4d","nbuf,Nerl =",nbuf,Nerl);
 }
 
-void init_cpu()
+int init_cpu(const char* inPitchFileName)
 /**********************************************************************
-   Initialize the state variables of the CPU module
+   Initialize the state variables of the CPU module, and open the file
+   for the pitch track. Returns 0 if the file could not be opened.
  **********************************************************************/
 {int p;
 
  pbuf=0; for (p=0;p<=max_nbuf-1;p++) erl_buf[p]=nchan*fspont;
- init_pitch();
+ init_pitch(); nframe=0;
+ pitchfile=fopen(inPitchFileName,"w");
+ return (pitchfile!=NULL);
+}
+
+void pitch_frame()
+/**********************************************************************
+   Extract the pitch of a frame and write a line "T0 evidence vuv" to
+   the pitch file, with T0 in ms (0 if unvoiced). Because extract_pitch
+   has a delay of SHIFT frames, the first SHIFT calls produce no line:
+   line m of the file is then the frame at time m.Tframe.
+ **********************************************************************/
+{long   T0;
+ double evid;
+
+ extract_pitch(&T0,&evid); nframe++;
+ if ((pitchfile!=NULL) && (nframe>shift))
+    fprintf(pitchfile,"%.4f %.6f %d\n",T0/fsmp,evid,(T0!=0));
+}
+
+void finish_cpu()
+{
+ if (pitchfile!=NULL) fclose(pitchfile);
+ pitchfile=NULL;
 }
 
 void cpu()
@@ -25,7 +25,9 @@
 #include <pario.h>
 
 extern void setup_cpu();
-extern void init_cpu();
+extern int init_cpu(const char* inPitchFileName);
+extern void pitch_frame();
+extern void finish_cpu();
 extern void cpu();
 extern void results(double dt,parameters par);
 
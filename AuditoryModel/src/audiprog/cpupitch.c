@@ -43,31 +43,52 @@ typedef struct{
 
 typedef struct{
                long     nex;         /* nr. of peaks */
-               long     tmax[30+1];  /* locations */
-               double   ampl[30+1];  /* amplitudes */
+               long    *tmax;        /* locations [1..max_peaks] */
+               double  *ampl;        /* amplitudes [1..max_peaks] */
               } peakdata; /* peaks in autocorrelation function */
 
-static double    Tse2;               /* Tse/2 = time unit for pitch analysis  */
-static extrdata  extrd[max_nchan+1]; /* data about extrema in evp(n.Tse)      */
-static double    R[200+1];           /* autocorrelation function (time x Tse2)*/
-static peakdata  peaks[31+1];
-static long      ptr;                /* pointer to current peakdata (in Tse2) */
-static long      prev_T0;            /* previous value of T0 (in Tse2)        */
-static long      max_T0;             /* maximum value of T0 (in Tse2)         */
-static long      Nwindow;            /* window length (in Tse2)               */
-static long      min_dn;             /* minimum time between extrema (in Tse2)*/
-static long      scope;              /* nr. of frames to consider for T0,evid */
+static per_thread double    Tse2;               /* Tse/2 = time unit for pitch analysis  */
+static per_thread extrdata  extrd[max_nchan+1]; /* data about extrema in evp(n.Tse)      */
+static per_thread double   *R=NULL;             /* autocorrelation function (time x Tse2)*/
+                                                /* R[m], m=0..max_T0                     */
+static per_thread peakdata *peaks=NULL;         /* peaks[0..scope-1]                     */
+static per_thread long     *peak_mem=NULL;      /* storage of the tmax of all peaks      */
+static per_thread double   *ampl_mem=NULL;      /* storage of the ampl of all peaks      */
+static per_thread long      max_peaks;          /* max. nr. of peaks in R                */
+static per_thread long      ptr;                /* pointer to current peakdata (in Tse2) */
+static per_thread long      prev_T0;            /* previous value of T0 (in Tse2)        */
+static per_thread long      max_T0;             /* maximum value of T0 (in Tse2)         */
+static per_thread long      Nwindow;            /* window length (in Tse2)               */
+static per_thread long      min_dn;             /* minimum time between extrema (in Tse2)*/
+static per_thread long      scope;              /* nr. of frames to consider for T0,evid */
 
 
 
 void setup_pitch()
-{
+/*********************************************************************
+   R and the peak tables are sized after max_T0 (which grows with the
+   sampling frequency) instead of being fixed. A peak in R needs at
+   least two lags, so R holds at most (max_T0-min_dn)/2+1 peaks.
+ *********************************************************************/
+{long i;
+
  Tse2=0.5*Tse; min_dn=round_int(min_dt/Tse2); max_T0=round_int(max_pitch/Tse2);
- printf("%s%7.3f%4d%4d\n","Tse2,min_dn,max_T0 =",Tse2,min_dn,max_T0);
- assert(max_T0<=200); /* R[m], m=0..max_T0 */
+ log_message(log_debug,"%s%7.3f%4ld%4ld","Tse2,min_dn,max_T0 =",Tse2,min_dn,max_T0);
  Nwindow=round_int((double)Twindow/Tse2);
  shift=round_int(20.0/Tframe); scope=2*(shift)+1;
- printf("%s%4d%4d\n","CPUPITCH: Scope and shift = ",scope,shift);
+ log_message(log_debug,"%s%4ld%4d","CPUPITCH: Scope and shift = ",scope,shift);
+
+ max_peaks=(max_T0-min_dn)/2+1;
+ free(R); free(peaks); free(peak_mem); free(ampl_mem);
+ R=(double*)malloc((max_T0+1)*sizeof(double));
+ peaks=(peakdata*)malloc(scope*sizeof(peakdata));
+ peak_mem=(long*)malloc(scope*(max_peaks+1)*sizeof(long));
+ ampl_mem=(double*)malloc(scope*(max_peaks+1)*sizeof(double));
+ assert((R!=NULL) && (peaks!=NULL) && (peak_mem!=NULL) && (ampl_mem!=NULL));
+ for (i=0;i<scope;i++)
+ {peaks[i].tmax=&peak_mem[i*(max_peaks+1)];
+  peaks[i].ampl=&ampl_mem[i*(max_peaks+1)];
+ }
 }
 
 void init_pitch()
@@ -77,7 +98,7 @@ void init_pitch()
  {extrd[p].search_max=0; extrd[p].indx=0;
   for (m=0;m<=nextr-1;m++) {extrd[p].sum[m]=0; extrd[p].tmax[m]=-900;}
  }
- ptr=0; prev_T0=0; for (m=0;m<=7;m++) peaks[m].nex=0;
+ ptr=0; prev_T0=0; for (m=0;m<=scope-1;m++) peaks[m].nex=0;
 }
 
 
@@ -148,8 +169,10 @@ static void autocorrelation_analysis()
    {k=m;
     do
     {dt=extrd[p].tmax[k]-extrd[p].tmax[m];
-     if (dt<max_T0) if (extrd[p].sum[m]<extrd[p].sum[k]) R[dt]+=extrd[p].sum[m];
-                    else R[dt]+=extrd[p].sum[k];
+     if ((dt>=0) && (dt<max_T0))
+     {if (extrd[p].sum[m]<extrd[p].sum[k]) R[dt]+=extrd[p].sum[m];
+      else R[dt]+=extrd[p].sum[k];
+     }
      k++; if (k==nextr) k=0;
     }
     while (k!=last);
@@ -184,7 +207,7 @@ void determine_peaks_in_R()
   }
   else if (y<extr) extr=y;
        else if (y>1.25*(extr+epsilon))
-         {search_max=1; extr=y; assert(indx<=30); peaks[ptr].tmax[indx]=m;}
+         {search_max=1; extr=y; assert(indx<=max_peaks); peaks[ptr].tmax[indx]=m;}
  }
  peaks[ptr].nex=indx-1;
 }
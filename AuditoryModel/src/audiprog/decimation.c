@@ -23,6 +23,7 @@
 
 #include "audiprog.h"
 #include "decimation.h"
+#include "iirblock.h"
 
 #define  order    3        /* order of decimation filter at 2fssig    */
 #define  nh       8        /* 2.nh+1 = length of decimation filter h  */
@@ -34,30 +35,32 @@
 
 
 typedef double state_array[ndel-1+1];
-
-typedef struct{
-               double a1,a2; /* coefficients of numerator              */
-               double b1,b2; /* coefficients of denominator            */
-               double w1,w2; /* cell's state variables                 */
-              } celldata;
+typedef qval   qstate_array[ndel-1+1];
 
 typedef struct{
                double   gain;
                celldata cell[order+1];
               } lpfdata;
 
-static double  zhp;             /* pole of HPF in OMEF                     */
-static double  gain;            /* gain-factor in OMEF                     */
-static double  b1,b2;           /* denominator coefficients of OMEF        */
-static double  xhp,yhp;         /* state variables of HPF in OMEF          */
-static double  yn1,yn2;         /* state variables of OMEF                 */
+static per_thread double  zhp;             /* pole of HPF in OMEF                     */
+static per_thread double  gain;            /* gain-factor in OMEF                     */
+static per_thread double  b1,b2;           /* denominator coefficients of OMEF        */
+static per_thread double  xhp,yhp;         /* state variables of HPF in OMEF          */
+static per_thread double  yn1,yn2;         /* state variables of OMEF                 */
+
+static per_thread double  h[nh2+1];        /* h of decimation filters: h[0]..h[2.nh]  */
+static per_thread state_array d0,d1,d2,d3; /* state vectors of the decimation filters */
+static per_thread long         ptrin[4+1]; /* ptrin[j] points to where to add input   */
+static per_thread long         Td[4+1];    /* Td[j] : delay with respect to input     */
 
-static double  h[nh2+1];        /* h of decimation filters: h[0]..h[2.nh]  */
-static state_array d0,d1,d2,d3; /* state vectors of the decimation filters */
-static long         ptrin[4+1]; /* ptrin[j] points to where to add input   */
-static long         Td[4+1];    /* Td[j] : delay with respect to input     */
+static per_thread lpfdata  DF0;            /* special decimation filter DF0           */
 
-static lpfdata  DF0;            /* special decimation filter DF0           */
+/* the fixed point kernel (see qformat.h): coefficients and states */
+static per_thread qval     qzhp,qgainh,qb1,qb2; /* OMEF (q_coef)                     */
+static per_thread qval     qxhp,qyhp,qyn1,qyn2; /* its state variables (q_sig)     */
+static per_thread qval     qh[nh2+1];       /* h (q_tap)                               */
+static per_thread qstate_array qd0,qd1,qd2,qd3; /* delay lines (q_sig)              */
+static per_thread qcelldata qDF0[order];    /* DF0, its gain in the first cell         */
 
 
 double h2_omef(double f)
@@ -73,7 +76,7 @@ void write_omef()
 {int i;
  double f,y,ydb;
 
- if (open_writefile("omef.dat")) 
+ if (write_dumps && open_writefile("omef.dat")) 
  {for (i=1;i<=100;i++)
   {f=i*fssig/200; y=gain*sqrt(h2_omef(f)+1.0E-06); ydb=8.68*log(y);
    fprintf(writefile,"%7.3f%8.4f%7.2f\n",f,y,ydb);
@@ -94,7 +97,7 @@ void write_decim()
 {int i;
  double f,y,ydb;
 
- if (open_writefile("decim.dat"))
+ if (write_dumps && open_writefile("decim.dat"))
  {for (i=1;i<=100;i++)
   {f=i*fssig/200; y=h_decim(f,fssig); ydb=8.68*log(y);
    fprintf(writefile,"%7.3f%8.4f%7.2f\n",f,y,ydb);
@@ -121,20 +124,48 @@ void setup_omef()
  }
  while (fabs(alpha-1.0)>=0.05);
  zhp=1-2*pi*fhp/fssig; gain=1+b1+b2;
+ qzhp=q_from(zhp,q_coef); qgainh=q_from(gain,q_coef);
+ qb1=q_from(b1,q_coef); qb2=q_from(b2,q_coef);
  write_omef();
 }
 
 void init_omef()
 {
  xhp=0; yhp=0; yn1=0; yn2=0;
+ qxhp=0; qyhp=0; qyn1=0; qyn2=0;
 }
 
-double omef(double xn)
-{double yn;
+void omef_block(const double *xn,double *yn,long count)
+/**********************************************************************
+  Filter count samples xn[0..count-1] with the OMEF and write the
+  result into yn (yn may be xn). The state variables are kept in
+  registers for the whole block.
+ **********************************************************************/
+{long   i;
+ double x,y,xh=xhp,yh=yhp,y1=yn1,y2=yn2;
+
+ for (i=0;i<count;i++)
+ {x=xn[i];
+  yh=zhp*yh+x-xh; xh=x;
+  y=gain*yh-b1*y1-b2*y2; y2=y1; y1=y;
+  yn[i]=y;
+ }
+ xhp=xh; yhp=yh; yn1=y1; yn2=y2;
+}
 
- yhp=zhp*yhp+xn-xhp; xhp=xn;
- yn=gain*yhp-b1*yn1-b2*yn2; yn2=yn1; yn1=yn;
- return yn;
+void omef_qblock(const qval *xn,qval *yn,long count)
+/* omef_block in fixed point: samples in q_sig */
+{long   i;
+ qval   x,y,xh=qxhp,yh=qyhp,y1=qyn1,y2=qyn2;
+
+ for (i=0;i<count;i++)
+ {x=xn[i];
+  yh=q_sat(q_mul(qzhp,yh,q_coef)+x-xh); xh=x;
+  y=q_sat(q_round((qacc)qgainh*yh-(qacc)qb1*y1-(qacc)qb2*y2,q_coef));
+  y2=y1; y1=y;
+  yn[i]=y;
+ }
+ qxhp=xh; qyhp=yh; qyn1=y1; qyn2=y2;
 }
 
 void design_DF0()
@@ -235,6 +266,7 @@ void setup_decimation()
 */
 
  for (m=1;m<=nh;m++) h[nh+m]=h[nh-m];
+ for (m=0;m<=nh2;m++) qh[m]=q_from(h[m],q_tap);
 
 /*********************************************************************
   The delay lines are used as ring buffers, and ptrin points at the
@@ -251,7 +283,10 @@ void setup_decimation()
        /* estimated delay of DF0 is 8 samples */
  Tdecim=Td[1]/fssig;
  write_decim();
- if (fsmp!=fssig) {design_DF0();}
+ if (fsmp!=fssig)
+ {design_DF0();
+  for (m=1;m<=order;m++) iir_qcell_design(&qDF0[m-1],&DF0.cell[m],(m==1) ? DF0.gain : 1);
+ }
 
 }
 
@@ -268,9 +303,33 @@ void init_decimation()
  ptrin[1]=0; for (m=0;m<=ndel-1;m++) d1[m]=0;
  ptrin[2]=0; for (m=0;m<=ndel-1;m++) d2[m]=0;
  ptrin[3]=0; for (m=0;m<=ndel-1;m++) d3[m]=0;
+ for (m=0;m<order;m++)
+ {qDF0[m].x1=qDF0[m].x2=qDF0[m].y1=qDF0[m].y2=0; qDF0[m].e=0;}
+ for (m=0;m<=ndel-1;m++) {qd0[m]=0; qd1[m]=0; qd2[m]=0; qd3[m]=0;}
  n=0;
 }
 
+void upsample_block(const double *xn,double *yn,long count)
+/**********************************************************************
+  Double the sampling frequency of count samples xn[0..count-1]:
+  insert a zero after every sample and apply DF0. The 2.count
+  results are written into yn (which must not overlap xn), and are
+  to be passed to decimate one by one.
+ **********************************************************************/
+{long i;
+
+ for (i=count-1;i>=0;i--) {yn[i+i]=xn[i]; yn[i+i+1]=0;}
+ iir_cells(DF0.gain,&DF0.cell[1],order,yn,yn,count+count);
+}
+
+void upsample_qblock(const qval *xn,qval *yn,long count)
+/* upsample_block in fixed point */
+{long i;
+
+ for (i=count-1;i>=0;i--) {yn[i+i]=xn[i]; yn[i+i+1]=0;}
+ iir_qcells(qDF0,order,yn,yn,count+count);
+}
+
 void decimation(long j,double *xn,state_array d)
 {long nd,m; 
 
@@ -280,12 +339,13 @@ void decimation(long j,double *xn,state_array d)
  for (m=1;m<=nh2;m++) {nd++; if (nd==ndel) nd=0; *xn=*xn+h[m]*(d[nd]);}
 }
 
-void decimate(double xn)
+void decimate(double xn,double yn)
 /**********************************************************************
   Decimation processor:
     - product at fsmp=2fssig is obtained by doubling the samples, 
       inserting zeroes at the odd positions, applying an IIRF and 
-      adding a delay Td[0]
+      adding a delay Td[0]; the IIRF output yn comes from
+      upsample_block (it is not used if fsmp=fssig)
     - products at fssig, fssig/2, fssig/4 [and fssig/8] are obtained
       by a cascade of 2 or 3 FIR decimation filters whose outputs are
       downsampled (factor 2) and fed to the next filter, and whose 
@@ -296,16 +356,10 @@ void decimate(double xn)
   the decimation products as much as possible.
  **********************************************************************/
 {long t,m;
- double x,yn;
 
  if (fsmp==fssig) t=n+n; 
  else 
- {t=n; yn=DF0.gain*xn;
-  for (m=1;m<=order;m++) 
-  {x=yn-DF0.cell[m].b1*DF0.cell[m].w1-DF0.cell[m].b2*DF0.cell[m].w2; 
-   yn=x+DF0.cell[m].a1*DF0.cell[m].w1+DF0.cell[m].a2*DF0.cell[m].w2; 
-   DF0.cell[m].w2=DF0.cell[m].w1; DF0.cell[m].w1=x;
-  }
+ {t=n;
   m=ptrin[0]-1; if (m<0) m=m+ndel; ptrin[0]=m; d0[m]=2*yn;
   m=m+Td[0]; if (m>=ndel) m=m-ndel; decim[1]=d0[m];
  }
@@ -318,13 +372,57 @@ void decimate(double xn)
    m=ptrin[2]+Td[2]; if (m>=ndel) m=m-ndel;
    decim[3]=d2[m];
    if (t % 8==0)
-     if (ndecim<3) decim[4]=xn;
-     else
-     {decimation(3,&xn,d3);
-      m=ptrin[3]+Td[3]; if (m>=ndel) m=m-ndel;
-      decim[4]=d3[m]; if (t % 16==0) decim[5]=xn;
-     }
+   {if (ndecim<3) decim[4]=xn;
+    else
+    {decimation(3,&xn,d3);
+     m=ptrin[3]+Td[3]; if (m>=ndel) m=m-ndel;
+     decim[4]=d3[m]; if (t % 16==0) decim[5]=xn;
+    }
+   }
   }
  }
 }
 
+void qdecimation(long j,qval *xn,qstate_array d)
+{long nd,m;
+ qacc acc;
+
+ nd=ptrin[j]-1; if (nd<0) nd=nd+ndel; ptrin[j]=nd;
+ d[nd]=*xn;
+ acc=(qacc)qh[0]*(*xn);
+ for (m=1;m<=nh2;m++) {nd++; if (nd==ndel) nd=0; acc+=(qacc)qh[m]*d[nd];}
+ *xn=q_sat(q_round(acc,q_tap));
+}
+
+void decimate_q(qval xn,qval yn)
+/**********************************************************************
+  decimate in fixed point: the products go to qdecim. The FIR sums are
+  formed in 64 bits and rounded once.
+ **********************************************************************/
+{long t,m;
+
+ if (fsmp==fssig) t=n+n;
+ else
+ {t=n;
+  m=ptrin[0]-1; if (m<0) m=m+ndel; ptrin[0]=m; qd0[m]=q_sat(2*(qacc)yn);
+  m=m+Td[0]; if (m>=ndel) m=m-ndel; qdecim[1]=qd0[m];
+ }
+ if (t % 2==0)
+ {qdecimation(1,&xn,qd1);
+  m=ptrin[1]+Td[1]; if (m>=ndel) m=m-ndel;
+  qdecim[2]=qd1[m];
+  if (t % 4==0)
+  {qdecimation(2,&xn,qd2);
+   m=ptrin[2]+Td[2]; if (m>=ndel) m=m-ndel;
+   qdecim[3]=qd2[m];
+   if (t % 8==0)
+   {if (ndecim<3) qdecim[4]=xn;
+    else
+    {qdecimation(3,&xn,qd3);
+     m=ptrin[3]+Td[3]; if (m>=ndel) m=m-ndel;
+     qdecim[4]=qd3[m]; if (t % 16==0) qdecim[5]=xn;
+    }
+   }
+  }
+ }
+}
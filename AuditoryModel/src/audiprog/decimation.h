@@ -22,12 +22,18 @@
 #if !defined( DECIMATION_H )
 #define DECIMATION_H
 
+#include "qformat.h"
+
 extern void setup_decimation();
 extern void setup_omef();
 extern void init_decimation();
 extern void init_omef();
-extern void decimate(double xn);
-extern double omef(double xn);
+extern void decimate(double xn,double yn);
+extern void omef_block(const double *xn,double *yn,long count);
+extern void upsample_block(const double *xn,double *yn,long count);
+extern void omef_qblock(const qval *xn,qval *yn,long count);
+extern void upsample_qblock(const qval *xn,qval *yn,long count);
+extern void decimate_q(qval xn,qval yn);
 
 #endif /* !defined( DECIMATION_H ) */
 
@@ -24,8 +24,8 @@
 #define  tauS1   11.0           /* smallest time constant in ECE      */
 #define  tauS2   33.0           /* largest time constant in ECE       */
 
-static double  ch1,sh1,cl1,sl1;        /* coefficients of hpf1,lpf1          */
-static double  ch2,sh2,cl2,sl2;        /* coefficients of hpf2,lpf2          */
+static per_thread double  ch1,sh1,cl1,sl1;        /* coefficients of hpf1,lpf1          */
+static per_thread double  ch2,sh2,cl2,sl2;        /* coefficients of hpf2,lpf2          */
 
 
 void setup_ecebank()
@@ -41,7 +41,7 @@ void setup_ecebank()
  ch1=exp(-Tse/(0.35*tauS1));   sh1=0.5*(1+ch1);
  cl2=exp(-Tse/tauS2);          sl2=0.5*(1-cl2);
  ch2=exp(-Tse/(0.35*tauS2));   sh2=0.5*(1+ch2);
- Tmodel+=0.35*tauS1;
+ Tpitch=0.35*tauS1; /* KT: not in Tmodel, the ANI does not pass the ECE */
 }
 
 void init_ecebank()
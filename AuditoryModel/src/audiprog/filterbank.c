@@ -21,25 +21,28 @@
 
 #include "audiprog.h"
 #include "filterbank.h"
+#include "iirblock.h"
 
 #define  ncel     2          /* number of 2nd-order cells per BPF      */
 #define  f0       1.5        /* min. f (kHz) for which u(f)~ln(f)      */
 #define  ratio    0.20       /* rel. width of critical band for f>f0   */
 #define  min_bw   0.07       /* min. value of the critical bandwidth   */
 
-typedef struct{
-               double a1,a2;  /* coefficients of numerator   */
-               double b1,b2;  /* coefficients of denominator */
-               double w1,w2;  /* cell's state variables      */
-              } celldata;
 typedef struct{
                double    gain;
                celldata  cell[ncel+1];
               } bpfdata;
 
-static double   ca,cb,cc;
-static double   cd,u0;
-static bpfdata  bpfd[max_nchan+1];       /* BPF filter coeffs and states     */
+/* the same in fixed point: the gain is spread over the cells, so that
+   each has a gain of 1 at fc and none of them over- or underflows */
+typedef struct{
+               qcelldata cell[ncel];
+              } qbpfdata;
+
+static per_thread double   ca,cb,cc;
+static per_thread double   cd,u0;
+static per_thread bpfdata  bpfd[max_nchan+1];       /* BPF filter coeffs and states     */
+static per_thread qbpfdata qbpfd[max_nchan+1];      /* the same for the fixed kernel    */
 
 double u(double f)
 {if (f<=f0) return ca*atan(cb*f); else return cc*log(f)+cd;
@@ -50,6 +53,49 @@ double umin1(double ut)
  if (ut<=u0) return sin(ut/ca)/cos(ut/ca)/cb; else return exp((ut-cd)/cc);
 }
 
+double scale_freq(int scale,double v)
+/*********************************************************************
+   Frequency (kHz) of position v on a channel scale
+     scale_cbu  : critical band units of the model, f = umin1(v)
+     scale_erb  : ERB-rate units, v = 21.4.log10(4.37.f+1)
+     scale_bark : Bark, v = 26.81.f/(1.96+f)-0.53
+     scale_hz   : f = v/1000
+ *********************************************************************/
+{switch (scale)
+ {case scale_erb:  return (pow(10.0,v/21.4)-1)/4.37;
+  case scale_bark: return 1.96*(v+0.53)/(26.28-v);
+  case scale_hz:   return v/1000;
+  default:         return umin1(v);
+ }
+}
+
+double chan_position(int p)
+{if (chan_count>0) return chan_pos[p]; else return uc1+(p-1)*duc;
+}
+
+int check_channels()
+/*********************************************************************
+   The channels must lie on their scale above 0 Hz, in increasing
+   order: the selection of the channels to compute at time n (low_ch)
+   relies on the steps of the channels not increasing with p.
+ *********************************************************************/
+{int    p;
+ double v,vmin,vmax;
+
+ if ((chan_scale<scale_cbu) || (chan_scale>scale_hz))
+ {log_message(log_error,"unknown channel scale %d",chan_scale); return 0;}
+ vmin=(chan_scale==scale_bark) ? -0.53 : 0;
+ vmax=(chan_scale==scale_bark) ? 26.28 : HUGE_VAL;
+ for (p=1;p<=nchan;p++)
+ {v=chan_position(p);
+  if ((v<=vmin) || (v>=vmax))
+  {log_message(log_error,"channel %d (%g) is not on the scale",p,v); return 0;}
+  if ((p>1) && (v<=chan_position(p-1)))
+  {log_message(log_error,"channel %d is not above channel %d",p,p-1); return 0;}
+ }
+ return 1;
+}
+
 void define_bplp(double fs,double f1,double f2,double *kbp,double *cos_fie)
 /*********************************************************************
   Analog bandpass to digital lowpass transform
@@ -94,24 +140,27 @@ void lpbp2(double kbp,double cos_fie,double re,double im,
  *beta2=(pow(d,2.0)+pow(im_sy,2.0))/ry;
 }
 
+double h2_cell(double f,double fs,celldata *c)
+/* the square of the frequency response of one cell in f */
+{double r,c1,c2,s1,s2;
+
+ r=2*pi*f/fs; 
+ c1=cos(r); c2=cos(2*r); 
+ s1=sin(r); s2=2*s1*c1;
+ return (pow(1+c->a1*c1+c->a2*c2,2.0)+pow(c->a1*s1+c->a2*s2,2.0))
+        /(pow(1+c->b1*c1+c->b2*c2,2.0)+pow(c->b1*s1+c->b2*s2,2.0));
+}
+
 double h2(double f,double fs,bpfdata *bpfd)
 /*******************************************************************
    Compute the square of the bandpass frequency response in f (the
    sampling frequency is fs) in case the gain is 1.
  *******************************************************************/
-{double resp,r,c1,c2,s1,s2;
+{double resp;
  int m;
 
- r=2*pi*f/fs; 
- c1=cos(r); c2=cos(2*r); 
- s1=sin(r); s2=2*s1*c1;
  resp=1; 
- for (m=1;m<=ncel;m++) 
- {resp=resp*((pow(1+bpfd->cell[m].a1*c1+bpfd->cell[m].a2*c2,2.0)
-              +pow(bpfd->cell[m].a1*s1+bpfd->cell[m].a2*s2,2.0))
-       /(pow(1+bpfd->cell[m].b1*c1+bpfd->cell[m].b2*c2,2.0)
-         +pow(bpfd->cell[m].b1*s1+bpfd->cell[m].b2*s2,2.0)));
- }
+ for (m=1;m<=ncel;m++) resp=resp*h2_cell(f,fs,&bpfd->cell[m]);
  return resp;
 }
  
@@ -166,11 +215,23 @@ void butterworth(double fc,double uc,double fs,bpfdata *bpfd)
  bpfd->gain=1/sqrt(h2(fc,fs,bpfd));
 }
 
+void qbutterworth(double fc,double fs,bpfdata *bpfd,qbpfdata *qbpfd)
+/* the fixed point version of a Butterworth bandpass filter */
+{int    m;
+ double g,rest=bpfd->gain;
+
+ for (m=1;m<=ncel;m++)
+ {g=(m<ncel) ? 1/sqrt(h2_cell(fc,fs,&bpfd->cell[m])) : rest;
+  iir_qcell_design(&qbpfd->cell[m-1],&bpfd->cell[m],g);
+  rest=rest/g;
+ }
+}
+
 void write_filterbank()
 {int i,p;
  double ut,f,fs,y,umax;
 
- if (open_writefile("filters.dat")) 
+ if (write_dumps && open_writefile("filters.dat")) 
  {umax=uc[nchan]+4;
   for (i=1;i<=200;i++)
   {ut=i*umax/200; f=umin1(ut); fprintf(writefile,"%7.3f%7.3f",f,ut);
@@ -196,6 +257,10 @@ void setup_filterbank()
    that the harmonics of the main components introduced by the hair
    cell models do not give rise to aliasing products which have to be
    ruled out.
+ Placement of the channels
+   Channel p lies at uc1+(p-1)*duc, or at chan_pos[p] if a list was
+   given, on the scale chan_scale. Whatever the scale, every filter
+   is one critical band wide (uc[p]=u(fc[p])).
  Selection of channel sampling frequency fsk
    If fc <= 0.125*fsmp then search for an fsk = fsmp/2^k that is not
    smaller than fse = 1/Tse and that is not smaller than the minimum
@@ -205,7 +270,7 @@ void setup_filterbank()
 #define alpha 0.125
 
  int    p,k;
- double fsk,r;
+ double fsk,r,v;
  FILE* theFilterFrequenciesFile = NULL;
 
  cc=1/ratio;
@@ -214,27 +279,32 @@ void setup_filterbank()
 /** AV **
  printf("ca,cb,cc,cd,u0: %10.5g %10.5g %10.5g %10.5g %10.5g\n",ca,cb,cc,cd,u0);
  ********/
- r=uc1+(nchan-1)*duc; r=umin1(r);
+ for (p=1;p<=nchan;p++)
+ {v=chan_position(p);
+  if (chan_scale==scale_cbu) {uc[p]=v; fc[p]=umin1(v);}
+  else {fc[p]=scale_freq(chan_scale,v); uc[p]=u(fc[p]);}
+ }
+ r=fc[nchan];
  if (r<=alpha*fssig) fsmp=fssig; else fsmp=2*fssig;
  Ne=round_int(Tse*fsmp); if (Ne>16) Ne=16; Nemask=Ne-1;
- printf("\nFilterbank data: fssig = %.3f kHz en fsmp = %.3f kHz\n",fssig,fsmp);
+ log_message(log_debug,"filterbank: fssig = %.3f kHz, fsmp = %.3f kHz",fssig,fsmp);
  
  /* open a file for the filter frequencies */ 
- theFilterFrequenciesFile = fopen("FilterFrequencies.txt","w");
- if (theFilterFrequenciesFile == NULL)
-	 printf("Error: Could not open output file FilterFrequencies.txt, but continuing program execution.");
+ if (write_dumps) theFilterFrequenciesFile = fopen("FilterFrequencies.txt","w");
+ if (write_dumps && (theFilterFrequenciesFile == NULL))
+	 log_message(log_warning,"could not open FilterFrequencies.txt, continuing without it");
 
  for (p=1;p<=nchan;p++)
  {
-   uc[p]=uc1+(p-1)*duc; fc[p]=umin1(uc[p]);
    fsk=fsmp; r=fc[p]/fsk; step[p]=1; indx[p]=1;
    while ((r<=0.125) && (step[p]<Ne))
    { indx[p]++; step[p]=2*step[p]; r=2*r; fsk=0.5*fsk; }
    stepmask[p]=step[p]-1;
    butterworth(fc[p],uc[p],fsk,&bpfd[p]);
-   printf("%3ld: fc(kHz),fsk(kHz),uc(cbu),step = %7.3f%7.3f%7.3f%3ld%3ld\n",p,
+   qbutterworth(fc[p],fsk,&bpfd[p],&qbpfd[p]);
+   log_message(log_debug,"%3d: fc(kHz),fsk(kHz),uc(cbu),step = %7.3f%7.3f%7.3f%3ld%3ld",p,
      fc[p],fsk,uc[p],indx[p],step[p]);
-   if (fc[p]>0.5*fsmp) printf("error: fc too high\n");
+   if (fc[p]>0.5*fsmp) log_message(log_warning,"fc of channel %d too high",p);
    
    /* write the filter frequencies */
    if (theFilterFrequenciesFile != NULL)
@@ -242,20 +312,25 @@ void setup_filterbank()
  }
 
  /* close the file */
- fclose(theFilterFrequenciesFile);
+ if (theFilterFrequenciesFile != NULL) fclose(theFilterFrequenciesFile);
 
  Tmodel=0.5;
  write_filterbank();
  max_step=step[1];
 /*** JPM: 20/10/98: new implementation of channel selection ***********/
- printf("low_ch: ");
- for (k=0;k<=max_step-1;k++)
- {
-   low_ch[k]=nchan+1;
-   for (p=1;p<=nchan;p++) if (k%step[p]==0) low_ch[k]=min(low_ch[k],p);
-   printf("%i ",low_ch[k]);
+ for (k=0;k<=max_step-1;k++)
+ {
+   low_ch[k]=nchan+1;
+   for (p=1;p<=nchan;p++) if (k%step[p]==0) low_ch[k]=min(low_ch[k],p);
  }
- printf("\n");
+ if (log_enabled(log_debug))
+ {char line[log_max_text];
+  int  len=0;
+  for (k=0;(k<=max_step-1) && (len<log_max_text-8);k++)
+     len+=sprintf(line+len," %i",low_ch[k]);
+  line[len]='\0';
+  log_message(log_debug,"low_ch:%s",line);
+ }
 /**********************************************************************/
 }
 
@@ -266,8 +341,12 @@ void init_filterbank()
 {int p,k;
 
  for (p=1;p<=nchan;p++)
- {yres[p]=0; ybpf[p]=0;
+ {yres[p]=0; ybpf[p]=0; qybpf[p]=0;
   for (k=1;k<=ncel;k++) {bpfd[p].cell[k].w1=0; bpfd[p].cell[k].w2=0;}
+  for (k=0;k<ncel;k++)
+  {qbpfd[p].cell[k].x1=qbpfd[p].cell[k].x2=0;
+   qbpfd[p].cell[k].y1=qbpfd[p].cell[k].y2=0; qbpfd[p].cell[k].e=0;
+  }
  }
 }
 
@@ -284,13 +363,20 @@ void filterbank()
  for (p=1;p<=nchan;p++) if ((n & stepmask[p])==0)
 */
  {y=bpfd[p].gain*decim[indx[p]];
-  for (m=1;m<=ncel;m++)
-  {x=y-bpfd[p].cell[m].b1*bpfd[p].cell[m].w1
-     -bpfd[p].cell[m].b2*bpfd[p].cell[m].w2;
-   y=x+bpfd[p].cell[m].a1*bpfd[p].cell[m].w1
-     +bpfd[p].cell[m].a2*bpfd[p].cell[m].w2;
-   bpfd[p].cell[m].w2=bpfd[p].cell[m].w1; bpfd[p].cell[m].w1=x;
-  }
+  for (m=1;m<=ncel;m++) iir_cell(bpfd[p].cell[m],x,y);
   ybpf[p]=y;
  }
 }
+
+void filterbank_q()
+/* filterbank in fixed point: qdecim to qybpf */
+{int    m,p;
+ qacc   acc;
+ qval   x,y;
+
+ for (p=low_ch[nmod];p<=nchan;p++)
+ {y=qdecim[indx[p]];
+  for (m=0;m<ncel;m++) iir_qcell(qbpfd[p].cell[m],acc,x,y);
+  qybpf[p]=y;
+ }
+}
@@ -22,9 +22,11 @@
 #if !defined( FILTERBANK_H )
 #define FILTERBANK_H
 
+extern int  check_channels();
 extern void setup_filterbank();
 extern void init_filterbank();
 extern void filterbank();
+extern void filterbank_q();
 
 #endif /* !defined( FILTERBANK_H ) */
 
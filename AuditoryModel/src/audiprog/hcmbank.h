@@ -22,10 +22,20 @@
 #if !defined( HCMBANK_H )
 #define HCMBANK_H
 
+#include <aniio.h>
+
 extern void setup_hcmbank();
 extern void init_hcmbank(const char* inOutputFileName);
 extern void hcmbank();
+extern void hcmbank_q();
 extern void finish_hcmbank ();
+extern void HCMBank_SetEnvelopeStream (FILE* inStream);
+extern void HCMBank_SetEnvelopeSink (const ani_sink* inSink);
+extern int HCMBank_EnvelopeFileError ();
+extern void HCMBank_SetFrameRange (long long inSkip, long long inCount, double inStartTime);
+extern int HCMBank_FrameRangeDone ();
+extern int HCMBank_OpenPyramidFile (const char* inFileNameWithPath, int inNumOfLevels);
+extern void HCMBank_ClosePyramidFile ();
 
 #endif /* !defined( HCMBANK_H ) */
 
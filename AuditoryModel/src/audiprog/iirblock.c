@@ -0,0 +1,151 @@
+/* iirblock.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "iirblock.h"
+
+/* cells per pass: their state variables are kept in registers */
+#define  group    3
+
+
+static void one_cell(double gain,celldata *c,const double *xn,double *yn,
+                     long count)
+{long   i;
+ double a1=c->a1,a2=c->a2,b1=c->b1,b2=c->b2,w1=c->w1,w2=c->w2,x,y;
+
+ for (i=0;i<count;i++)
+ {y=gain*xn[i];
+  x=y-b1*w1-b2*w2; y=x+a1*w1+a2*w2; w2=w1; w1=x;
+  yn[i]=y;
+ }
+ c->w1=w1; c->w2=w2;
+}
+
+static void two_cells(double gain,celldata *c,const double *xn,double *yn,
+                      long count)
+{long   i;
+ double a11=c[0].a1,a21=c[0].a2,b11=c[0].b1,b21=c[0].b2;
+ double a12=c[1].a1,a22=c[1].a2,b12=c[1].b1,b22=c[1].b2;
+ double w11=c[0].w1,w21=c[0].w2,w12=c[1].w1,w22=c[1].w2,x,y;
+
+ for (i=0;i<count;i++)
+ {y=gain*xn[i];
+  x=y-b11*w11-b21*w21; y=x+a11*w11+a21*w21; w21=w11; w11=x;
+  x=y-b12*w12-b22*w22; y=x+a12*w12+a22*w22; w22=w12; w12=x;
+  yn[i]=y;
+ }
+ c[0].w1=w11; c[0].w2=w21; c[1].w1=w12; c[1].w2=w22;
+}
+
+static void three_cells(double gain,celldata *c,const double *xn,double *yn,
+                        long count)
+{long   i;
+ double a11=c[0].a1,a21=c[0].a2,b11=c[0].b1,b21=c[0].b2;
+ double a12=c[1].a1,a22=c[1].a2,b12=c[1].b1,b22=c[1].b2;
+ double a13=c[2].a1,a23=c[2].a2,b13=c[2].b1,b23=c[2].b2;
+ double w11=c[0].w1,w21=c[0].w2,w12=c[1].w1,w22=c[1].w2;
+ double w13=c[2].w1,w23=c[2].w2,x,y;
+
+ for (i=0;i<count;i++)
+ {y=gain*xn[i];
+  x=y-b11*w11-b21*w21; y=x+a11*w11+a21*w21; w21=w11; w11=x;
+  x=y-b12*w12-b22*w22; y=x+a12*w12+a22*w22; w22=w12; w12=x;
+  x=y-b13*w13-b23*w23; y=x+a13*w13+a23*w23; w23=w13; w13=x;
+  yn[i]=y;
+ }
+ c[0].w1=w11; c[0].w2=w21; c[1].w1=w12; c[1].w2=w22;
+ c[2].w1=w13; c[2].w2=w23;
+}
+
+void iir_cells(double gain,celldata *cell,int ncel,const double *xn,
+               double *yn,long count)
+/**********************************************************************
+  Filter count samples xn[0..count-1] with the cascade of the ncel
+  second order cells cell[0..ncel-1], preceded by a gain:
+      x  = y - b1.w1 - b2.w2
+      y  = x + a1.w1 + a2.w2     (w2 = w1, w1 = x)
+  with y = gain.xn at the input of the first cell, and write the
+  output of the last cell into yn (yn may be xn).
+  Up to 3 cells are run sample by sample in one pass over the block,
+  with their state variables in registers; longer cascades take more
+  passes. The result is identical to filtering one sample at a time,
+  so that count=1 can be used where only one sample is available.
+ **********************************************************************/
+{int k;
+
+ for (k=0;k<ncel;k+=group)
+ {switch ((ncel-k<group) ? ncel-k : group)
+  {case 1: one_cell(gain,cell+k,xn,yn,count); break;
+   case 2: two_cells(gain,cell+k,xn,yn,count); break;
+   case 3: three_cells(gain,cell+k,xn,yn,count); break;
+  }
+  gain=1; xn=yn;
+ }
+}
+
+/* Fixed point */
+
+qval q_from(double x,int f)
+{double y=floor(x*q_one(f)+0.5);
+
+ return (y>=(double)q_max) ? q_max : ((y<=(double)q_min) ? q_min : (qval)y);
+}
+
+qgain q_gain(double g)
+{qgain r;
+ int   e;
+
+ r.m=q_from(frexp(g,&e),30); r.s=30-e;
+ if (r.s<1) {r.m=q_max; r.s=1;}       /* too large: saturated       */
+ if (r.s>62) {r.m=0; r.s=1;}          /* too small (or 0): 0        */
+ return r;
+}
+
+void iir_qcell_design(qcelldata *q,const celldata *c,double gain)
+/* the cell c preceded by gain in fixed point, with its states cleared */
+{
+ q->g=q_gain(gain);
+ q->a1=q_from(c->a1,q_coef); q->a2=q_from(c->a2,q_coef);
+ q->b1=q_from(c->b1,q_coef); q->b2=q_from(c->b2,q_coef);
+ q->x1=q->x2=q->y1=q->y2=0; q->e=0;
+}
+
+void iir_qcells(qcelldata *cell,int ncel,const qval *xn,qval *yn,long count)
+/**********************************************************************
+  Filter count samples xn[0..count-1] (q_sig) with the cascade of the
+  fixed point cells cell[0..ncel-1], each preceded by its gain:
+      y = g.x + a1.x1 + a2.x2 - b1.y1 - b2.y2
+  The sum is formed in 64 bits; the rounding error of y is added to
+  the next sum (first order error feedback), so that the noise of the
+  rounding is not amplified by poles close to z=1 (the cells of the
+  low channels). yn may be xn.
+ **********************************************************************/
+{long i;
+ int  k;
+ qacc acc;
+ qval x,y;
+
+ for (i=0;i<count;i++)
+ {y=xn[i];
+  for (k=0;k<ncel;k++) iir_qcell(cell[k],acc,x,y);
+  yn[i]=y;
+ }
+}
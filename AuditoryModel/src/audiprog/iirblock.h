@@ -0,0 +1,66 @@
+/* iirblock.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( IIRBLOCK_H )
+#define IIRBLOCK_H
+
+#include "qformat.h"
+
+typedef struct{
+               double a1,a2; /* coefficients of numerator              */
+               double b1,b2; /* coefficients of denominator            */
+               double w1,w2; /* cell's state variables                 */
+              } celldata;
+
+/* filter sample y in place with cell c, one sample at a time (x: scratch) */
+#define iir_cell(c,x,y) {x=(y)-(c).b1*(c).w1-(c).b2*(c).w2; \
+                         y=x+(c).a1*(c).w1+(c).a2*(c).w2;   \
+                         (c).w2=(c).w1; (c).w1=x;}
+
+extern void iir_cells(double gain,celldata *cell,int ncel,const double *xn,
+                      double *yn,long count);
+
+/* the same cell in fixed point (see qformat.h), in direct form I */
+typedef struct{
+               qgain g;      /* gain at the input of the cell          */
+               qval  a1,a2;  /* coefficients of numerator (q_coef)     */
+               qval  b1,b2;  /* coefficients of denominator (q_coef)   */
+               qval  x1,x2;  /* previous inputs, after the gain        */
+               qval  y1,y2;  /* previous outputs                       */
+               qacc  e;      /* rounding error of the previous output  */
+              } qcelldata;
+
+/* filter sample y (q_sig) in place with cell c (acc,x: scratch) */
+#define iir_qcell(c,acc,x,y) {x=q_scale(y,(c).g);                         \
+                  acc=((qacc)x<<q_coef)+(qacc)(c).a1*(c).x1               \
+                      +(qacc)(c).a2*(c).x2-(qacc)(c).b1*(c).y1            \
+                      -(qacc)(c).b2*(c).y2+(c).e;                         \
+                  y=q_sat(q_round(acc,q_coef));                           \
+                  (c).e=acc-((qacc)y<<q_coef);                            \
+                  if (((c).e>q_cell_emax) || ((c).e<-q_cell_emax)) (c).e=0; \
+                  (c).x2=(c).x1; (c).x1=x; (c).y2=(c).y1; (c).y1=y;}
+#define q_cell_emax  ((qacc)1<<q_coef)
+
+extern void iir_qcell_design(qcelldata *q,const celldata *c,double gain);
+extern void iir_qcells(qcelldata *cell,int ncel,const qval *xn,qval *yn,
+                       long count);
+
+#endif /* !defined( IIRBLOCK_H ) */
@@ -0,0 +1,87 @@
+/* qformat.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/***************************************************************************
+   Fixed point arithmetic of the integer kernel (kernel_fixed).
+
+   A value is a 32 bit integer v that stands for v/2^f, written Qi.f
+   (i integer bits including the sign, i+f=32). Products and sums are
+   formed in 64 bits and rounded to the nearest (halves up) when they
+   are brought back to 32 bits. Results that do not fit are saturated
+   (clipped to the largest or smallest value of the format), they
+   never wrap around. The formats of the kernel:
+
+     q_sig   Q4.27   samples, OMEF, decimation products, BPF outputs,
+                     input of the haircell models    (+-16, 7.5e-9)
+     q_rate  Q10.21  AGC gain, firing rates, EEF and envelopes
+                                                     (+-1024, 4.8e-7)
+     q_int   Q12.19  the slow integrator (w2) of the haircell LPF
+                                                     (+-4096, 1.9e-6)
+     q_coef  Q2.29   coefficients of the IIR cells   (+-4)
+     q_tap   Q1.30   taps of the FIR decimation filters (+-1)
+
+   Gains of arbitrary size (the BPF gains range from 1e-6 to 1) are a
+   mantissa in Q1.30 between 0.5 and 1 with a shift (qgain).
+   Since only integer operations are used once the coefficients are
+   rounded, the kernel gives the same result on every host. It is
+   scalar and slower than the double kernel (64 bit products, rounding
+   and saturation of every result); bench/fixbench measures both.
+ ***************************************************************************/
+
+#if !defined( QFORMAT_H )
+#define QFORMAT_H
+
+#define q_sig    27
+#define q_rate   21
+#define q_int    19
+#define q_coef   29
+#define q_tap    30
+
+#define q_max    2147483647
+#define q_min    (-q_max-1)
+
+typedef int       qval;      /* 32 bit fixed point value              */
+typedef long long qacc;      /* 64 bit product or accumulator         */
+
+typedef struct{
+               qval m;       /* mantissa, Q1.30                       */
+               int  s;       /* the gain is m/2^s                     */
+              } qgain;
+
+/* a 64 bit value clipped to 32 bits */
+#define q_sat(a)       ((a)>q_max ? q_max : ((a)<q_min ? q_min : (qval)(a)))
+/* a 64 bit value with f fraction bits too many, rounded */
+#define q_round(a,f)   (((a)+((qacc)1<<((f)-1)))>>(f))
+/* the product of a and b, rounded to f fraction bits fewer */
+#define q_mul(a,b,f)   q_round((qacc)(a)*(b),f)
+/* a in format f1 converted to format f2 (f1>f2) */
+#define q_conv(a,f1,f2) q_sat(q_round((qacc)(a),(f1)-(f2)))
+/* a scaled with gain g */
+#define q_scale(a,g)   q_sat(q_round((qacc)(a)*(g).m,(g).s))
+
+#define q_one(f)       ((double)((qacc)1<<(f)))
+#define q_to(a,f)      ((double)(a)/q_one(f))
+
+/* in iirblock.c */
+extern qval  q_from(double x,int f);   /* x in format f, saturated   */
+extern qgain q_gain(double g);         /* g > 0 as a gain            */
+
+#endif /* !defined( QFORMAT_H ) */
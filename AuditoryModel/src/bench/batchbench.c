@@ -0,0 +1,150 @@
+/* batchbench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    BENCHMARK OF THE BATCH SCHEDULING
+
+    Schedules corpora with different distributions of file lengths
+    the way IPEMAuditoryModelBatch does (files longer than 1.5
+    segments split into segments of about 60 s, or shorter down to
+    10 s to have 8 tasks per thread, with a pre-roll of 0.5 s, run
+    with parallel_steal), and as one task per file handed out in list
+    order (parallel_for). A task sleeps for a time
+    proportional to the duration of its signal, so that the result
+    only depends on the scheduling, not on the number of processors
+    of the host. Reports the fraction of the time the threads were
+    busy (utilization) and the time relative to a perfect schedule
+    of the signal (without pre-rolls) over the threads.
+
+    Usage: batchbench [threads, default 8]
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "logging.h"
+#include "parallel.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define  segment      60.0     /* s */
+#define  min_segment  10.0     /* s */
+#define  per_thread      8     /* tasks */
+#define  preroll       0.5     /* s */
+#define  ideal         2.0     /* s of a perfect schedule of a corpus */
+#define  ncorpora      5
+
+typedef struct{
+               double *cost;       /* s of signal (with the pre-roll) */
+               double  scale;      /* s of sleep per s of signal      */
+               double *busy;       /* s of each task                  */
+              } corpus;
+
+static void pause(double seconds)
+{
+#if defined(_WIN32)
+ Sleep((DWORD)(1000*seconds+0.5));
+#else
+ struct timespec t;
+
+ t.tv_sec=(time_t)seconds; t.tv_nsec=(long)(1e9*(seconds-t.tv_sec));
+ nanosleep(&t,NULL);
+#endif
+}
+
+static void task(void *context,long i)
+{corpus *c=(corpus*)context;
+ double  start=log_clock();
+
+ pause(c->cost[i]*c->scale);
+ c->busy[i]=log_clock()-start;
+}
+
+static double length(int k,long i,long *count)
+/* duration (s) of file i of corpus k, and the number of files */
+{
+ switch (k)
+ {case 0: *count=2000; return 5;                       /* all short      */
+  case 1: *count=1010; return (i%101==100) ? 7200 : 5; /* some 2 h among */
+  case 2: *count=21;   return (i==20) ? 7200 : 5;      /* last one long  */
+  case 3: *count=500;                                  /* 1 s .. 2 h     */
+          return exp(log(7200.0)*((i*7919)%500)/499.0);
+  default: *count=64; return 30+60*(i%3);              /* 30, 90, 150 s  */
+ }
+}
+
+static const char *names[ncorpora]={"2000 x 5 s","1000 x 5 s, 10 x 2 h",
+                                    "20 x 5 s, then 2 h","500, 1 s .. 2 h",
+                                    "64 of 30, 90, 150 s"};
+
+static void run(corpus *c,long count,long nthreads,int steal,double signal,
+                const char *label)
+{double start,time,busy=0;
+ long   i;
+
+ start=log_clock();
+ if (steal) parallel_steal(count,c->cost,nthreads,task,c);
+ else parallel_for(count,nthreads,task,c);
+ time=log_clock()-start;
+ for (i=0;i<count;i++) busy+=c->busy[i];
+ printf("  %-22s %6ld tasks %7.1f %% busy %6.2f x ideal\n",label,count,
+        100*busy/(nthreads*time),time/(signal*c->scale/nthreads));
+}
+
+int main(int argc,char *argv[])
+{long    nthreads=8,count,i,s,n,ntasks;
+ int     k;
+ double  d,signal,seg;
+ corpus  c;
+
+ if (argc>1) nthreads=atol(argv[1]);
+ if (nthreads<1) nthreads=1;
+ printf("%ld threads\n",nthreads);
+ for (k=0;k<ncorpora;k++)
+ {length(k,0,&count);
+  signal=0;
+  for (i=0;i<count;i++) signal+=length(k,i,&count);
+  seg=segment;
+  if (seg>signal/(per_thread*nthreads)) seg=signal/(per_thread*nthreads);
+  if (seg<min_segment) seg=min_segment;
+  c.cost=malloc((count+(long)(2*7200/seg)*count)*sizeof(double));
+  c.busy=malloc((count+(long)(2*7200/seg)*count)*sizeof(double));
+  if ((c.cost==NULL) || (c.busy==NULL)) return 1;
+  c.scale=ideal*nthreads/signal;
+  printf("%s\n",names[k]);
+  for (i=0;i<count;i++) c.cost[i]=length(k,i,&count);
+  run(&c,count,nthreads,0,signal,"whole files, in order");
+  for (i=0,ntasks=0;i<count;i++)
+  {d=length(k,i,&count); n=1;
+   if (d>1.5*seg) n=(long)floor(d/seg+0.5);
+   for (s=0;s<n;s++) c.cost[ntasks++]=d/n+((s>0) ? preroll : 0);
+  }
+  run(&c,ntasks,nthreads,1,signal,"segments, stealing");
+  free(c.cost); free(c.busy);
+ }
+ return 0;
+}
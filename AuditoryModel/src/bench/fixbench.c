@@ -0,0 +1,178 @@
+/* fixbench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    ERROR AND THROUGHPUT OF THE FIXED POINT KERNEL
+
+    Runs the auditory model with akDouble and with akFixed on a set
+    of test stimuli and reports, per stimulus, the deviation of the
+    fixed point ANI from the double precision one (largest absolute
+    difference, largest value of the reference, RMS difference
+    relative to the RMS of the reference and the same as a signal to
+    noise ratio) and the throughput of both kernels (seconds of
+    signal per second).
+
+    The synthetic stimuli (white noise, a pure tone, a logarithmic
+    sweep, a click train and very soft noise at -60 dB) are used if
+    no sound files are given.
+
+    Usage: fixbench [-fs Hz (default 22050)] [-s seconds (default 10)]
+                    [sound file ...]
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "IPEMAuditoryModel.h"
+
+#define  nstimuli  5
+
+typedef struct{
+               double *values;
+               long    nchan,nframes,size;
+              } frames;
+
+static int begin_frames(void *context,long nchan,double frame_rate,
+                        const double *freqs)
+{frames *f=(frames*)context;
+
+ (void)frame_rate; (void)freqs;
+ f->nchan=nchan; f->nframes=0;
+ return 1;
+}
+
+static int put_frame(void *context,const double *values)
+{frames *f=(frames*)context;
+ double *tmp;
+
+ if ((f->nframes+1)*f->nchan>f->size)
+ {f->size=(f->size==0) ? 65536 : 2*f->size;
+  tmp=(double*)realloc(f->values,f->size*sizeof(double));
+  if (tmp==NULL) return 0;
+  f->values=tmp;
+ }
+ memcpy(f->values+f->nframes*f->nchan,values,f->nchan*sizeof(double));
+ f->nframes++;
+ return 1;
+}
+
+static double seconds(clock_t start)
+{
+ return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+/* the ANI of the signal (or of the file if x is NULL) with kernel k */
+static double run(long k,const char *file,const double *x,long len,double fs,
+                  frames *f)
+{ani_sink sink;
+ clock_t  start;
+ long     res;
+
+ sink.context=f; sink.begin=begin_frames; sink.frame=put_frame;
+ f->nframes=0;
+ IPEMAuditoryModel_Setup(-1,-1,-1,file,NULL,NULL,NULL,fs,-1);
+ if (x!=NULL) IPEMAuditoryModel_SetInputSignal(x,len);
+ IPEMAuditoryModel_SetOutputSink(&sink);
+ IPEMAuditoryModel_SetKernel(k);
+ start=clock();
+ res=IPEMAuditoryModel_Process();
+ return (res==0) ? seconds(start) : -1;
+}
+
+static void stimulus(int s,double *x,long len,double fs,const char **name)
+{static const char *names[nstimuli]={"white noise","tone 1 kHz",
+                     "sweep 50 Hz-10 kHz","clicks 4 Hz","noise -60 dB"};
+ long   i;
+ double t;
+
+ *name=names[s];
+ srand(1);
+ for (i=0;i<len;i++)
+ {t=i/fs;
+  switch (s)
+  {case 0: x[i]=0.3*(2.0*rand()/RAND_MAX-1); break;
+   case 1: x[i]=0.5*sin(2*3.14159265358979*1000*t); break;
+   case 2: x[i]=0.5*sin(2*3.14159265358979*50*len/fs/log(200.0)
+                        *(exp(log(200.0)*i/len)-1)); break;
+   case 3: x[i]=((i%(long)(fs/4))==0) ? 0.9 : 0; break;
+   case 4: x[i]=0.001*(2.0*rand()/RAND_MAX-1); break;
+  }
+ }
+}
+
+static void report(const char *name,double seconds_of_signal,double fs,
+                   const char *file,const double *x,long len)
+{frames ref={NULL,0,0,0},fix={NULL,0,0,0};
+ double td,tf,d,dmax=0,rmax=0,se=0,sr=0;
+ long   i,count;
+
+ td=run(akDouble,file,x,len,fs,&ref);
+ tf=run(akFixed,file,x,len,fs,&fix);
+ if ((td<0) || (tf<0) || (ref.nframes!=fix.nframes))
+ {printf("%-22s  failed\n",name); free(ref.values); free(fix.values); return;}
+ count=ref.nframes*ref.nchan;
+ for (i=0;i<count;i++)
+ {d=fabs(fix.values[i]-ref.values[i]);
+  if (d>dmax) dmax=d;
+  if (fabs(ref.values[i])>rmax) rmax=fabs(ref.values[i]);
+  se+=d*d; sr+=ref.values[i]*ref.values[i];
+ }
+ if (seconds_of_signal<0) seconds_of_signal=ref.nframes/(fs/2.0);
+ printf("%-22s %9.2e %8.3f %9.2e %7.1f %9.1f %9.1f %6.2f\n",name,dmax,rmax,
+        (sr>0) ? sqrt(se/sr) : 0,(se>0) ? 10*log10(sr/se) : 999.9,
+        (td>0) ? seconds_of_signal/td : 0,(tf>0) ? seconds_of_signal/tf : 0,
+        (tf>0) ? td/tf : 0);
+ free(ref.values); free(fix.values);
+}
+
+int main(int argc,char *argv[])
+{double      fs=22050,dur=10,*x;
+ long        len;
+ int         a=1,s;
+ const char *name;
+
+ while ((a+1<argc) && (argv[a][0]=='-'))
+ {if (strcmp(argv[a],"-fs")==0) fs=atof(argv[a+1]);
+  else if (strcmp(argv[a],"-s")==0) dur=atof(argv[a+1]);
+  else {printf("usage: %s [-fs Hz] [-s seconds] [sound file ...]\n",argv[0]); return 1;}
+  a+=2;
+ }
+ printf("fs = %.0f Hz\n\n",fs);
+ printf("%-22s %9s %8s %9s %7s %9s %9s %6s\n","stimulus","max|err|","max|ref|",
+        "rel rms","SNR dB","double x","fixed x","ratio");
+ if (a<argc)
+ {for (;a<argc;a++) report(argv[a],-1,fs,argv[a],NULL,0);
+  return 0;
+ }
+ len=(long)(dur*fs);
+ x=(double*)malloc(len*sizeof(double));
+ if (x==NULL) {printf("error: out of memory\n"); return 1;}
+ for (s=0;s<nstimuli;s++)
+ {stimulus(s,x,len,fs,&name);
+  report(name,dur,fs,NULL,x,len);
+ }
+ free(x);
+ return 0;
+}
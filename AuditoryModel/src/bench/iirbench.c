@@ -0,0 +1,143 @@
+/* iirbench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    BENCHMARK OF THE BLOCK IIR STAGES
+
+    Times the OMEF and the upsampler (DF0) of the decimation unit, and
+    a bank of Butterworth bandpass cascades as in the filterbank, once
+    one sample at a time (count=1 per call, as the model used to run
+    them) and once per block of 256, 1024 and 4096 samples. The block
+    results are checked to be identical to the per sample results.
+
+    Usage: iirbench [seconds of signal at 22.05 kHz, default 60]
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "audiprog.h"
+#include "decimation.h"
+#include "iirblock.h"
+
+#define  nbank   40         /* channels of the bandpass bank */
+#define  nbpf     2         /* cells per bandpass filter     */
+
+static double seconds(clock_t start)
+{
+ return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+/* OMEF + DF0 of the whole signal in blocks of count samples */
+static double run_front(const double *xn,double *yn,double *tmp,long len,
+                        long count)
+{long    i,k;
+ clock_t start=clock();
+
+ init_omef(); init_decimation();
+ for (i=0;i<len;i+=count)
+ {k=(len-i<count) ? len-i : count;
+  omef_block(xn+i,tmp,k);
+  upsample_block(tmp,yn+i+i,k);
+ }
+ return seconds(start);
+}
+
+/* resonator like cascades with their centre frequencies spread */
+static void design_bank(celldata bank[nbank][nbpf])
+{int    p,m;
+ double theta,r;
+
+ for (p=0;p<nbank;p++)
+    for (m=0;m<nbpf;m++)
+    {theta=pi*(0.01+0.4*p/nbank)*(1+0.02*m); r=0.98-0.002*p;
+     bank[p][m].a1=0; bank[p][m].a2=-1;
+     bank[p][m].b1=-2*r*cos(theta); bank[p][m].b2=r*r;
+     bank[p][m].w1=bank[p][m].w2=0;
+    }
+}
+
+/* the bank on the whole signal, channel p's output at yn+p*len */
+static double run_bank(const double *xn,double *yn,long len,long count)
+{static celldata bank[nbank][nbpf];
+ long    i,k;
+ int     p;
+ clock_t start;
+
+ design_bank(bank);
+ start=clock();
+ if (count==1)
+ {for (i=0;i<len;i++)
+     for (p=0;p<nbank;p++) iir_cells(0.01,bank[p],nbpf,xn+i,yn+p*len+i,1);
+ }
+ else
+ {for (i=0;i<len;i+=count)
+  {k=(len-i<count) ? len-i : count;
+   for (p=0;p<nbank;p++) iir_cells(0.01,bank[p],nbpf,xn+i,yn+p*len+i,k);
+  }
+ }
+ return seconds(start);
+}
+
+int main(int argc,char *argv[])
+{static const long counts[]={256,1024,4096};
+ long    len,i,c;
+ double *xn,*ref,*out,*tmp,t1,tb;
+
+ fssig=22.05; fsmp=2*fssig; ndecim=2; write_dumps=0;
+ setup_omef(); setup_decimation();
+
+ len=(long)(((argc>1) ? atof(argv[1]) : 60)*1000*fssig);
+ if (len<1) len=1;
+ xn=(double*)malloc(len*sizeof(double));
+ ref=(double*)malloc(nbank*len*sizeof(double));
+ out=(double*)malloc(nbank*len*sizeof(double));
+ tmp=(double*)malloc(4096*sizeof(double));
+ if (!xn || !ref || !out || !tmp) {printf("error: out of memory\n"); return 1;}
+ srand(1);
+ for (i=0;i<len;i++) xn[i]=2.0*rand()/RAND_MAX-1;
+
+ printf("%ld samples at %.2f kHz\n\n",len,fssig);
+ printf("OMEF + DF0      Msamples/s  speedup\n");
+ t1=run_front(xn,ref,tmp,len,1);
+ printf("  per sample    %10.2f\n",len/t1/1e6);
+ for (c=0;c<3;c++)
+ {tb=run_front(xn,out,tmp,len,counts[c]);
+  printf("  block %4ld    %10.2f  %7.2f%s\n",counts[c],len/tb/1e6,t1/tb,
+         memcmp(ref,out,2*len*sizeof(double)) ? "  (results differ!)" : "");
+ }
+
+ printf("\n%d x %d cells   Msamples/s  speedup\n",nbank,nbpf);
+ t1=run_bank(xn,ref,len,1);
+ printf("  per sample    %10.2f\n",len/t1/1e6);
+ for (c=0;c<3;c++)
+ {tb=run_bank(xn,out,len,counts[c]);
+  printf("  block %4ld    %10.2f  %7.2f%s\n",counts[c],len/tb/1e6,t1/tb,
+         memcmp(ref,out,nbank*len*sizeof(double)) ? "  (results differ!)" : "");
+ }
+
+ free(xn); free(ref); free(out); free(tmp);
+ return 0;
+}
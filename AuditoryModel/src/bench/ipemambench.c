@@ -0,0 +1,163 @@
+/* ipemambench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    BLOCKS THROUGH THE SHARED LIBRARY
+
+    Analyses a signal with the interface of libipemam (ipemam.h), a
+    block at a time, for several block sizes, with two contexts of
+    one plan used in turn, and compares the frames with those of the
+    whole signal analysed at once in memory (IPEMAuditoryModel.h):
+    reports per block size the number of frames, the largest absolute
+    difference and the throughput (seconds of signal per second).
+    Linked against the shared library, as a binding would be; the
+    reference comes from the objects of the model, linked in as well,
+    since the library exports nothing but ipemam.h.
+
+    Usage: ipemambench [-fs Hz (default 22050)] [-s seconds (default 10)]
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ipemam.h"
+#include "IPEMAuditoryModel.h"
+
+#define  nsizes  6
+
+typedef struct{
+               double *values;
+               long    nchan,nframes,size;
+              } frames;
+
+static int begin_frames(void *context,long nchan,double frame_rate,
+                        const double *freqs)
+{frames *f=(frames*)context;
+
+ (void)frame_rate; (void)freqs;
+ f->nchan=nchan; f->nframes=0;
+ return 1;
+}
+
+static int put_frame(void *context,const double *values)
+{frames *f=(frames*)context;
+ double *tmp;
+
+ if ((f->nframes+1)*f->nchan>f->size)
+ {f->size=(f->size==0) ? 65536 : 2*f->size;
+  tmp=(double*)realloc(f->values,f->size*sizeof(double));
+  if (tmp==NULL) return 0;
+  f->values=tmp;
+ }
+ memcpy(f->values+f->nframes*f->nchan,values,f->nchan*sizeof(double));
+ f->nframes++;
+ return 1;
+}
+
+static long drain(ipemam_context *c,int64_t available,double *out,long nchan,
+                  long *nframes,long max)
+/* read the frames of c behind the ones in out; -1 if it failed */
+{long got;
+
+ if (available<0) return -1;
+ while ((available>0) && (*nframes<max))
+ {got=ipemam_read(c,out+(*nframes)*nchan,max-*nframes);
+  *nframes+=got; available-=got;
+  if (got==0) break;
+ }
+ return 0;
+}
+
+int main(int argc,char *argv[])
+{static const long sizes[nsizes]={1,64,1000,1024,4096,65536};
+ ipemam_params   params;
+ ipemam_plan    *plan;
+ ipemam_context *c[2];
+ frames          ref={NULL,0,0,0};
+ ani_sink        sink;
+ double          fs=22050,dur=10,*x,*out,d,dmax;
+ long            len,i,k,s,nchan,nframes,max,failed;
+ clock_t         start;
+ unsigned        seed=1;
+ int             a=1;
+
+ while ((a+1<argc) && (argv[a][0]=='-'))
+ {if (strcmp(argv[a],"-fs")==0) fs=atof(argv[a+1]);
+  else if (strcmp(argv[a],"-s")==0) dur=atof(argv[a+1]);
+  else {printf("usage: %s [-fs Hz] [-s seconds]\n",argv[0]); return 1;}
+  a+=2;
+ }
+ len=(long)(dur*fs);
+ x=(double*)malloc(len*sizeof(double));
+ if (x==NULL) {printf("error: out of memory\n"); return 1;}
+ for (i=0;i<len;i++)
+ {seed=seed*1103515245+12345;
+  x[i]=0.3*(2.0*((seed>>8)&0xffff)/0xffff-1)*(1+sin(2*3.14159265358979*i/fs));
+ }
+
+ /* the reference: the whole signal at once */
+ sink.context=&ref; sink.begin=begin_frames; sink.frame=put_frame;
+ IPEMAuditoryModel_Setup(-1,-1,-1,NULL,NULL,NULL,NULL,fs,-1);
+ IPEMAuditoryModel_SetInputSignal(x,len);
+ IPEMAuditoryModel_SetOutputSink(&sink);
+ start=clock();
+ if (IPEMAuditoryModel_Process()!=0) {printf("error: the analysis failed\n"); return 1;}
+ d=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+ ipemam_params_init(&params); params.fs=fs;
+ plan=ipemam_plan_create(&params);
+ c[0]=(plan!=NULL) ? ipemam_context_create(plan) : NULL;
+ c[1]=(plan!=NULL) ? ipemam_context_create(plan) : NULL;
+ ipemam_plan_destroy(plan);   /* the contexts do not need it */
+ if ((c[0]==NULL) || (c[1]==NULL)) {printf("error: no context\n"); return 1;}
+ nchan=ipemam_channels(c[0]);
+ max=ref.nframes+1024;
+ out=(double*)malloc(max*nchan*sizeof(double));
+ if (out==NULL) {printf("error: out of memory\n"); return 1;}
+ printf("ABI %d, %ld channels, %.1f frames/s, %.1f s of noise at %.0f Hz: %ld frames\n\n",
+        ipemam_version(),nchan,ipemam_frame_rate(c[0]),dur,fs,ref.nframes);
+ printf("%8s %8s %12s %10s\n","block","frames","max|diff|","x signal");
+ printf("%8s %8ld %12s %10.1f\n","whole",ref.nframes,"-",(d>0) ? dur/d : 0);
+ for (s=0;s<nsizes;s++)
+ {/* the same signal, a block at a time, on each context in turn */
+  for (k=0;k<2;k++)
+  {nframes=0; failed=0;
+   start=clock();
+   for (i=0;(i<len) && !failed;i+=sizes[s])
+      failed=drain(c[k],ipemam_process(c[k],x+i,(len-i<sizes[s]) ? len-i : sizes[s]),
+                   out,nchan,&nframes,max);
+   if (!failed) failed=drain(c[k],ipemam_flush(c[k]),out,nchan,&nframes,max);
+   d=(double)(clock()-start)/CLOCKS_PER_SEC;
+   if (failed) {printf("%8ld  failed\n",sizes[s]); continue;}
+   dmax=(nframes==ref.nframes) ? 0 : -1;
+   for (i=0;(dmax>=0) && (i<nframes*nchan);i++)
+      if (fabs(out[i]-ref.values[i])>dmax) dmax=fabs(out[i]-ref.values[i]);
+   printf("%8ld %8ld %12.3g %10.1f\n",sizes[s],nframes,dmax,(d>0) ? dur/d : 0);
+  }
+ }
+ ipemam_context_destroy(c[0]); ipemam_context_destroy(c[1]);
+ free(out); free(x); free(ref.values);
+ return 0;
+}
@@ -0,0 +1,194 @@
+/* numabench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    THROUGHPUT OF THE BATCH THREADS PER NUMBER OF NUMA NODES
+
+    Runs two analyses per thread of synthetic noise with the auditory
+    model in memory (the way IPEMAuditoryModelBatch runs its tasks,
+    with parallel_steal), with the threads placed on the processors
+    of 1, 2, ... NUMA nodes (parallel_set_nodes) and without
+    placement, and reports per configuration the number of threads,
+    the throughput (seconds of signal per second of wall clock time),
+    the throughput per thread, the speed up over one node and the
+    fraction of the tasks whose signal, allocated and written by the
+    task itself, ended up on the node of the processor that ran it
+    (Linux only, "-" elsewhere).
+
+    Usage: numabench [-fs Hz (default 22050)] [-s seconds (default 5)]
+
+ *********************************************************************/
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IPEMAuditoryModel.h"
+#include "parallel.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+typedef struct{
+               double  fs,dur;
+               long   *ok;         /* analysis succeeded              */
+               long   *local;      /* signal on the node of the task  */
+              } bench;
+
+static double now()
+{
+#if defined(_WIN32)
+ return GetTickCount()/1000.0;
+#else
+ struct timespec t;
+
+ clock_gettime(CLOCK_MONOTONIC,&t);
+ return t.tv_sec+1e-9*t.tv_nsec;
+#endif
+}
+
+static int begin_frames(void *context,long nchan,double frame_rate,
+                        const double *freqs)
+{
+ (void)context; (void)nchan; (void)frame_rate; (void)freqs;
+ return 1;
+}
+
+static int drop_frame(void *context,const double *values)
+{
+ (void)context; (void)values;
+ return 1;
+}
+
+static long on_own_node(const double *x)
+/* 1 if the page of x is on the node the thread runs on, 0 if not,
+   -1 if unknown */
+{
+#if defined(__linux__)
+ unsigned cpu,node;
+ void    *page=(void*)x;
+ int      status=-1;
+
+ if (syscall(SYS_getcpu,&cpu,&node,NULL)!=0) return -1;
+ if (syscall(SYS_move_pages,0,1L,&page,NULL,&status,0)!=0) return -1;
+ return (status<0) ? -1 : (status==(int)node);
+#else
+ return -1;
+#endif
+}
+
+static void task(void *context,long i)
+{bench   *b=(bench*)context;
+ ani_sink sink;
+ log_sink quiet={NULL,log_to_stream,0};
+ long     n,len=(long)(b->dur*b->fs);
+ double  *x=(double*)malloc(len*sizeof(double));
+ unsigned seed=(unsigned)i+1;
+
+ b->ok[i]=0; b->local[i]=-1;
+ if (x==NULL) return;
+ for (n=0;n<len;n++)
+ {seed=seed*1103515245+12345;
+  x[n]=0.3*(2.0*((seed>>8)&0xffff)/0xffff-1);
+ }
+ sink.context=NULL; sink.begin=begin_frames; sink.frame=drop_frame;
+ IPEMAuditoryModel_Setup(-1,-1,-1,NULL,NULL,NULL,NULL,b->fs,-1);
+ IPEMAuditoryModel_SetInputSignal(x,len);
+ IPEMAuditoryModel_SetOutputSink(&sink);
+ IPEMAuditoryModel_SetLogSink(&quiet);
+ b->ok[i]=(IPEMAuditoryModel_Process()==0);
+ b->local[i]=on_own_node(x+len/2);
+ free(x);
+}
+
+static double run(bench *b,long nnodes,long *nthreads,double *local)
+/* throughput (s of signal per s) with placement on nnodes nodes */
+{long   t,count,known=0,near=0,failed=0;
+ double start,elapsed;
+
+ parallel_set_nodes(nnodes);
+ *nthreads=parallel_threads();
+ count=2*(*nthreads);
+ b->ok=(long*)malloc(count*sizeof(long));
+ b->local=(long*)malloc(count*sizeof(long));
+ if ((b->ok==NULL) || (b->local==NULL))
+ {free(b->ok); free(b->local); return -1;}
+ start=now();
+ parallel_steal(count,NULL,*nthreads,task,b);
+ elapsed=now()-start;
+ for (t=0;t<count;t++)
+ {if (!b->ok[t]) failed++;
+  if (b->local[t]>=0) {known++; near+=b->local[t];}
+ }
+ *local=(known>0) ? 100.0*near/known : -1;
+ free(b->ok); free(b->local);
+ parallel_set_nodes(0);
+ if (failed>0) return -1;
+ return (elapsed>0) ? count*b->dur/elapsed : 0;
+}
+
+static void report(const char *name,long nthreads,double rate,double base,
+                   double local)
+{
+ if (rate<0) {printf("%-10s %8ld  failed\n",name,nthreads); return;}
+ printf("%-10s %8ld %10.1f %10.1f",name,nthreads,rate,rate/nthreads);
+ if (base>0) printf(" %8.2f",rate/base); else printf(" %8s","-");
+ if (local>=0) printf(" %8.1f\n",local); else printf(" %8s\n","-");
+}
+
+int main(int argc,char *argv[])
+{bench  b;
+ long   n,nnodes=parallel_nodes(),nthreads;
+ double rate,base=0,local;
+ char   name[32];
+ int    a=1;
+
+ b.fs=22050; b.dur=5;
+ while ((a+1<argc) && (argv[a][0]=='-'))
+ {if (strcmp(argv[a],"-fs")==0) b.fs=atof(argv[a+1]);
+  else if (strcmp(argv[a],"-s")==0) b.dur=atof(argv[a+1]);
+  else {printf("usage: %s [-fs Hz] [-s seconds]\n",argv[0]); return 1;}
+  a+=2;
+ }
+ printf("%ld NUMA node(s), %ld processor(s), fs = %.0f Hz, %.1f s per task\n\n",
+        nnodes,parallel_processors(),b.fs,b.dur);
+ printf("%-10s %8s %10s %10s %8s %8s\n","placement","threads","x signal",
+        "x/thread","speedup","local %");
+ rate=run(&b,0,&nthreads,&local);
+ report("none",nthreads,rate,0,local);
+ for (n=1;n<=nnodes;n++)
+ {rate=run(&b,n,&nthreads,&local);
+  if (n==1) base=rate;
+  sprintf(name,"%ld node%s",n,(n>1) ? "s" : "");
+  report(name,nthreads,rate,(n>1) ? base : 0,local);
+ }
+ return 0;
+}
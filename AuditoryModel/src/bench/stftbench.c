@@ -0,0 +1,183 @@
+/* stftbench.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    BENCHMARK OF THE SHORT-TIME FOURIER TRANSFORM
+
+    Checks the real FFT of analysis/stft.c against a direct DFT for
+    sizes with all kinds of factors (largest error relative to the
+    largest magnitude) and its inverse against the signal it was
+    computed from (relative to the largest sample), and the columns of a streamed STFT, for
+    several block sizes, and of an overview against those of the
+    whole signal at once (largest difference). Then reports the
+    speed of the STFT of a noisy chirp (frames of 40 ms every 10 ms,
+    FFT of 1024 points, hanning window, as IPEMCalcSpectrogram) per
+    number of threads, in seconds of signal per second.
+
+    Usage: stftbench [seconds, default 600]
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "parallel.h"
+#include "stft.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs        22050.0
+#define  nsizes    12
+#define  nblocks   4
+#define  overview  8
+
+static double now()
+{
+#if defined(_WIN32)
+ return GetTickCount()/1000.0;
+#else
+ struct timespec t;
+ clock_gettime(CLOCK_MONOTONIC,&t);
+ return t.tv_sec+t.tv_nsec*1e-9;
+#endif
+}
+
+static double fft_error(long n,double *inverse)
+{stft_fft f;
+ double  *x,*y,*re,*im,*work,sr,si,max=0,err=0,d;
+ long     i,k;
+
+ *inverse=-1;
+ if (!stft_fft_open(&f,n)) return -1;
+ x=malloc(n*sizeof(double)); y=malloc(n*sizeof(double)); re=malloc((n/2+1)*sizeof(double));
+ im=malloc((n/2+1)*sizeof(double)); work=malloc(stft_fft_work(&f)*sizeof(double));
+ for (i=0;i<n;i++) x[i]=rand()/(double)RAND_MAX-0.5;
+ stft_fft_real(&f,x,re,im,work);
+ for (k=0;k<=n/2;k++)
+ {sr=si=0;
+  for (i=0;i<n;i++)
+  {sr+=x[i]*cos(2*M_PI*(double)((i*k)%n)/n);
+   si-=x[i]*sin(2*M_PI*(double)((i*k)%n)/n);
+  }
+  d=hypot(re[k]-sr,im[k]-si);
+  if (d>err) err=d;
+  if (hypot(sr,si)>max) max=hypot(sr,si);
+ }
+ if (max>0) err/=max;
+ stft_fft_inverse(&f,re,im,y,work);
+ for (*inverse=max=0,i=0;i<n;i++)
+ {if (fabs(x[i]-y[i])>*inverse) *inverse=fabs(x[i]-y[i]);
+  if (fabs(x[i])>max) max=fabs(x[i]);
+ }
+ if (max>0) *inverse/=max;
+ free(x); free(y); free(re); free(im); free(work);
+ stft_fft_close(&f);
+ return err;
+}
+
+static double largest_difference(const float *a,const float *b,long n)
+{double d,max=0;
+ long   i;
+
+ for (i=0;i<n;i++) {d=fabs((double)a[i]-b[i]); if (d>max) max=d;}
+ return max;
+}
+
+int main(int argc,char *argv[])
+{static const long sizes[nsizes]={1,2,3,5,7,8,12,882,1000,1024,1103,4096};
+ static const long blocks[nblocks]={1,100,4096,1000000};
+ double   seconds=(argc>1) ? atof(argv[1]) : 600,t,phase=0,err,inverse;
+ long     length,i,k,b,ncols,n,m,nthreads,maxthreads;
+ double  *x;
+ float   *whole,*part,*over;
+ stft_plan   p;
+ stft_stream s;
+
+ printf("real FFT against a direct DFT, and inverse (relative error)\n");
+ for (i=0;i<nsizes;i++)
+ {err=fft_error(sizes[i],&inverse);
+  printf("  %6ld points %10.2e %10.2e\n",sizes[i],err,inverse);
+ }
+
+ length=(long)(seconds*fs);
+ x=malloc(length*sizeof(double));
+ for (i=0;i<length;i++)
+ {phase+=2*M_PI*(100+5000.0*i/length)/fs;
+  x[i]=0.5*sin(phase)+0.01*(rand()/(double)RAND_MAX-0.5);
+ }
+ if (x==NULL || !stft_plan_open(&p,fs,882,220,1024,stft_hanning,NULL))
+ {fprintf(stderr,"stftbench: out of memory\n"); return 1;}
+ ncols=stft_columns(&p,length,1);
+ whole=malloc(ncols*p.nbins*sizeof(float));
+ part=malloc((ncols+2)*p.nbins*sizeof(float));
+ over=malloc((ncols/overview+2)*p.nbins*sizeof(float));
+ if (whole==NULL || part==NULL || over==NULL)
+ {fprintf(stderr,"stftbench: out of memory\n"); return 1;}
+ stft_compute(&p,x,length,stft_magnitude,1,1,whole);
+ printf("%ld frames of %ld bins\n",ncols,p.nbins);
+
+ /* the same columns from a stream, whatever the blocks */
+ printf("streamed (largest difference)\n");
+ for (b=0;b<nblocks;b++)
+ {stft_stream_open(&s,&p,stft_magnitude,1,0);
+  for (i=0,n=0;i<length;i+=blocks[b])
+  {m=(length-i<blocks[b]) ? length-i : blocks[b];
+   n+=stft_stream_block(&s,x+i,m,part+n*p.nbins);
+  }
+  n+=stft_stream_end(&s,part+n*p.nbins);
+  stft_stream_close(&s);
+  printf("  blocks of %7ld %8ld frames %10.2e\n",blocks[b],n,
+         (n==ncols) ? largest_difference(whole,part,ncols*p.nbins) : -1.0);
+ }
+
+ /* the overview is the maximum over groups of frames */
+ n=stft_compute(&p,x,length,stft_magnitude,overview,0,over);
+ for (i=0;i<ncols;i++)
+    for (k=0;k<p.nbins;k++)
+       if (i%overview==0 || whole[i*p.nbins+k]>part[(i/overview)*p.nbins+k])
+          part[(i/overview)*p.nbins+k]=whole[i*p.nbins+k];
+ printf("overview of %d frames per column: %ld columns %10.2e\n",overview,n,
+        (n==stft_columns(&p,length,overview))
+        ? largest_difference(over,part,n*p.nbins) : -1.0);
+
+ maxthreads=parallel_threads();
+ if (maxthreads<4) maxthreads=4;
+ printf("speed (s of signal per s)\n");
+ for (nthreads=1;nthreads<=maxthreads;nthreads*=2)
+ {t=now();
+  stft_compute(&p,x,length,stft_db,1,nthreads,whole);
+  t=now()-t;
+  printf("  %3ld threads %10.0f\n",nthreads,seconds/t);
+ }
+
+ stft_plan_close(&p);
+ free(x); free(whole); free(part); free(over);
+ return 0;
+}
@@ -0,0 +1,447 @@
+/* ipemam.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    C INTERFACE OF THE SHARED LIBRARY (see ipemam.h)
+
+    The model keeps its state per thread. A context therefore runs it
+    on a thread of its own, which holds the state of that context and
+    nothing else: the model reads its signal from a source that hands
+    it the blocks given to ipemam_process, and writes the frames to a
+    sink that queues them in the context. ipemam_process returns once
+    the model has taken all the samples of the block and waits for
+    more, so that the calls are synchronous for the caller and the
+    block is not copied. The worker gets a small stack (worker_stack):
+    the state of the model is thread local, not on the stack, and the
+    deepest call of the model on a source uses some tens of KB.
+
+ ************** list of routines and their function ******************
+
+    ipemam_version()
+      ipemam_abi_version of the library.
+    ipemam_params_init(params), ipemam_file_options_init(options)
+      Fill in the default parameters or options (and size).
+    ipemam_scale(name), ipemam_normalization(name), ipemam_kernel(name)
+      The value called name, -1 if unknown.
+    ipemam_plan_create(params), ipemam_plan_destroy(plan)
+      Check and copy the parameters; NULL if they are invalid (or
+      size is not known).
+    ipemam_analyse_file(plan,input_file,input_path,output_file,
+                        output_path,options)
+      Analyse a sound file with the plan on the calling thread, and
+      write the ANI to the output file (as IPEMAuditoryModel_Process).
+      Returns 0 on success.
+    ipemam_context_create(plan), ipemam_context_destroy(context)
+      Start (and stop) the thread of a context and set up the model.
+      NULL if the model cannot be set up with the plan.
+    ipemam_channels(context), ipemam_frame_rate(context),
+    ipemam_frequencies(context,freqs)
+      Number of channels, frames per second and centre frequencies
+      (in Hz, freqs[0..nchan-1]) of the frames of the context.
+    ipemam_process(context,xn,count)
+      Run the model on the next count samples xn[0..count-1] (-1..+1,
+      at the sample frequency of the plan) of the signal. Returns the
+      number of frames that can be read, -1 if the analysis failed.
+    ipemam_flush(context)
+      End the signal: the frames of its end are computed. Returns as
+      ipemam_process; the next block starts a new signal.
+    ipemam_read(context,frames,count)
+      Move up to count frames (nchan values each, one frame after the
+      other) into frames. Returns the number of frames moved.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "ipemam.h"
+#include "IPEMAuditoryModel.h"
+
+#if ipemam_max_name != IPEMAuditoryModel_MaxNameLength
+#error ipemam_max_name differs from the model
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef CRITICAL_SECTION   mutex;
+typedef CONDITION_VARIABLE condition;
+typedef HANDLE             thread;
+#define mutex_init(m)      InitializeCriticalSection(m)
+#define mutex_lock(m)      EnterCriticalSection(m)
+#define mutex_unlock(m)    LeaveCriticalSection(m)
+#define mutex_free(m)      DeleteCriticalSection(m)
+#define cond_init(c)       InitializeConditionVariable(c)
+#define cond_wait(c,m)     SleepConditionVariableCS(c,m,INFINITE)
+#define cond_signal(c)     WakeAllConditionVariable(c)
+#define cond_free(c)
+#define routine(name)      static DWORD WINAPI name(LPVOID arg)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t    mutex;
+typedef pthread_cond_t     condition;
+typedef pthread_t          thread;
+#define mutex_init(m)      pthread_mutex_init(m,NULL)
+#define mutex_lock(m)      pthread_mutex_lock(m)
+#define mutex_unlock(m)    pthread_mutex_unlock(m)
+#define mutex_free(m)      pthread_mutex_destroy(m)
+#define cond_init(c)       pthread_cond_init(c,NULL)
+#define cond_wait(c,m)     pthread_cond_wait(c,m)
+#define cond_signal(c)     pthread_cond_broadcast(c)
+#define cond_free(c)       pthread_cond_destroy(c)
+#define routine(name)      static void *name(void *arg)
+#endif
+
+#define def_fs        22050.0
+#define worker_stack  (512*1024)  /* bytes, of the thread of a context */
+
+struct ipemam_plan_tag{
+               ipemam_params  params;
+               double        *positions;  /* copy, or NULL              */
+              };
+
+struct ipemam_context_tag{
+               ipemam_plan    plan;       /* copy, with its positions   */
+               thread         worker;
+               mutex          lock;
+               condition      changed;    /* any of the below changed   */
+               /* the signal, set by the caller */
+               const double  *xn;         /* block being consumed       */
+               int64_t        left;       /* samples of it still to go  */
+               int            eof;        /* flushed: no more blocks    */
+               int            quit;       /* being destroyed            */
+               /* the model, set by the worker */
+               int            waiting;    /* for samples                */
+               int            ready;      /* set up (begin was called)  */
+               int            finished;   /* the analysis ended         */
+               long           result;     /* of the analysis            */
+               long           nchan;
+               double         frame_rate;
+               double        *freqs;
+               /* the frames, queued by the worker, read by the caller */
+               double        *queue;
+               int64_t        head,tail;  /* frames queue[head..tail-1] */
+               int64_t        size;       /* frames room                */
+              };
+
+int32_t ipemam_version()
+{
+ return ipemam_abi_version;
+}
+
+void ipemam_params_init(ipemam_params *params)
+{
+ memset(params,0,sizeof(ipemam_params));
+ params->size=sizeof(ipemam_params);
+ params->nchan=40; params->first_freq=2.0; params->freq_dist=0.5;
+ params->fs=def_fs; params->scale=csCBU; params->positions=NULL;
+ params->npositions=0; params->kernel=akDouble;
+}
+
+void ipemam_file_options_init(ipemam_file_options *options)
+{
+ memset(options,0,sizeof(ipemam_file_options));
+ options->size=sizeof(ipemam_file_options);
+ options->output_format=aofText; options->cache_dir=NULL;
+ options->cache_size=-1; options->pyramid_file=NULL;
+ options->pyramid_levels=-1; options->start=-1; options->duration=-1;
+ options->preroll=-1; options->normalization=nmNone; options->level=-20;
+}
+
+int32_t ipemam_scale(const char *name)
+{
+ return (int32_t)IPEMAuditoryModel_ChannelScale(name);
+}
+
+int32_t ipemam_normalization(const char *name)
+{
+ return (int32_t)IPEMAuditoryModel_Normalization(name);
+}
+
+int32_t ipemam_kernel(const char *name)
+{
+ return (int32_t)IPEMAuditoryModel_Kernel(name);
+}
+
+ipemam_plan *ipemam_plan_create(const ipemam_params *params)
+{ipemam_plan *plan;
+ int32_t      count;
+
+ if ((params==NULL) || (params->size!=sizeof(ipemam_params))) return NULL;
+ count=(params->positions!=NULL) ? params->npositions : 0;
+ if (((count==0) && (params->nchan<=0)) || (count<0) || (params->fs<=0)
+     || (params->scale<csCBU) || (params->scale>csHz)
+     || ((params->kernel!=akDouble) && (params->kernel!=akFixed)))
+    return NULL;
+ plan=(ipemam_plan*)malloc(sizeof(ipemam_plan));
+ if (plan==NULL) return NULL;
+ plan->params=*params; plan->positions=NULL;
+ if (count>0)
+ {plan->positions=(double*)malloc(count*sizeof(double));
+  if (plan->positions==NULL) {free(plan); return NULL;}
+  memcpy(plan->positions,params->positions,count*sizeof(double));
+ }
+ plan->params.positions=plan->positions; plan->params.npositions=count;
+ return plan;
+}
+
+void ipemam_plan_destroy(ipemam_plan *plan)
+{
+ if (plan==NULL) return;
+ free(plan->positions); free(plan);
+}
+
+int32_t ipemam_analyse_file(const ipemam_plan *plan,const char *input_file,
+                            const char *input_path,const char *output_file,
+                            const char *output_path,
+                            const ipemam_file_options *options)
+{const ipemam_params *p=&plan->params;
+
+ if ((options==NULL) || (options->size!=sizeof(ipemam_file_options)))
+    return ipemam_error_param;
+ if (!IPEMAuditoryModel_Setup(p->nchan,p->first_freq,p->freq_dist,input_file,
+                              input_path,output_file,output_path,p->fs,-1)
+     || !IPEMAuditoryModel_SetCache(options->cache_dir,options->cache_size)
+     || !IPEMAuditoryModel_SetPyramidFile(options->pyramid_file,
+                                          options->pyramid_levels))
+    return ipemam_error_param;
+ IPEMAuditoryModel_SetOutputFormat(options->output_format);
+ IPEMAuditoryModel_SetChannels(p->scale,p->positions,p->npositions);
+ IPEMAuditoryModel_SetRange(options->start,options->duration,
+                            options->preroll);
+ IPEMAuditoryModel_SetNormalization(options->normalization,options->level);
+ IPEMAuditoryModel_SetKernel(p->kernel);
+ return (int32_t)IPEMAuditoryModel_Process();
+}
+
+/* Source and sink of the model, called on the worker */
+
+static long take_samples(void *context,double *xn,long count)
+/* the next count samples, fewer only at the end of the signal */
+{ipemam_context *c=(ipemam_context*)context;
+ long            got=0,k;
+
+ mutex_lock(&c->lock);
+ while (got<count)
+ {if (c->left>0)
+  {k=(c->left<count-got) ? c->left : count-got;
+   memcpy(xn+got,c->xn,k*sizeof(double));
+   c->xn+=k; c->left-=k; got+=k;
+  }
+  else if (c->eof || c->quit) break;
+  else
+  {c->waiting=1; cond_signal(&c->changed);
+   cond_wait(&c->changed,&c->lock);
+   c->waiting=0;
+  }
+ }
+ mutex_unlock(&c->lock);
+ return got;
+}
+
+static int begin_frames(void *context,long nchan,double frame_rate,
+                        const double *freqs)
+{ipemam_context *c=(ipemam_context*)context;
+ int             res=1;
+
+ mutex_lock(&c->lock);
+ if (c->freqs==NULL)
+ {c->freqs=(double*)malloc(nchan*sizeof(double));
+  if (c->freqs==NULL) res=0;
+  else memcpy(c->freqs,freqs,nchan*sizeof(double));
+  c->nchan=nchan; c->frame_rate=frame_rate;
+ }
+ c->ready=res; cond_signal(&c->changed);
+ mutex_unlock(&c->lock);
+ return res;
+}
+
+static int queue_frame(void *context,const double *values)
+{ipemam_context *c=(ipemam_context*)context;
+ double         *tmp;
+ int             res=1;
+
+ mutex_lock(&c->lock);
+ if ((c->tail==c->size) && (c->head>0))
+ {/* move the frames left to the front: the queue does not grow as
+     long as the caller keeps reading */
+  memmove(c->queue,c->queue+c->head*c->nchan,
+          (c->tail-c->head)*c->nchan*sizeof(double));
+  c->tail-=c->head; c->head=0;
+ }
+ if (c->tail==c->size)
+ {tmp=(double*)realloc(c->queue,2*(c->size+64)*c->nchan*sizeof(double));
+  if (tmp==NULL) res=0;
+  else {c->queue=tmp; c->size=2*(c->size+64);}
+ }
+ if (res) memcpy(c->queue+(c->tail++)*c->nchan,values,c->nchan*sizeof(double));
+ if (c->quit) res=0;
+ mutex_unlock(&c->lock);
+ return res;
+}
+
+routine(run_context)
+/* one analysis after the other, until the context is destroyed */
+{ipemam_context      *c=(ipemam_context*)arg;
+ const ipemam_params *p=&c->plan.params;
+ decoder_source       source;
+ ani_sink             sink;
+ long                 res;
+
+ source.context=c; source.read=take_samples;
+ sink.context=c; sink.begin=begin_frames; sink.frame=queue_frame;
+ do
+ {IPEMAuditoryModel_Setup(p->nchan,p->first_freq,p->freq_dist,NULL,NULL,NULL,
+                          NULL,p->fs,-1);
+  IPEMAuditoryModel_SetChannels(p->scale,p->positions,p->npositions);
+  IPEMAuditoryModel_SetKernel(p->kernel);
+  IPEMAuditoryModel_SetInputSource(&source);
+  IPEMAuditoryModel_SetOutputSink(&sink);
+  res=IPEMAuditoryModel_Process();
+  mutex_lock(&c->lock);
+  c->result=res; c->finished=1; cond_signal(&c->changed);
+  while (c->finished && !c->quit) cond_wait(&c->changed,&c->lock);
+  mutex_unlock(&c->lock);
+ }
+ while (!c->quit);
+ return 0;
+}
+
+/* Contexts */
+
+ipemam_context *ipemam_context_create(const ipemam_plan *plan)
+{ipemam_context *c;
+ int32_t         count=plan->params.npositions;
+ int             ok;
+#if !defined(_WIN32)
+ pthread_attr_t  attr;
+#endif
+
+ c=(ipemam_context*)calloc(1,sizeof(ipemam_context));
+ if (c==NULL) return NULL;
+ c->plan=*plan; c->plan.positions=NULL;
+ if (count>0)
+ {c->plan.positions=(double*)malloc(count*sizeof(double));
+  if (c->plan.positions==NULL) {free(c); return NULL;}
+  memcpy(c->plan.positions,plan->positions,count*sizeof(double));
+ }
+ c->plan.params.positions=c->plan.positions;
+ mutex_init(&c->lock); cond_init(&c->changed);
+#if defined(_WIN32)
+ c->worker=CreateThread(NULL,worker_stack,run_context,c,
+                        STACK_SIZE_PARAM_IS_A_RESERVATION,NULL);
+ ok=(c->worker!=NULL);
+#else
+ ok=(pthread_attr_init(&attr)==0);
+ if (ok)
+ {pthread_attr_setstacksize(&attr,worker_stack);
+  ok=(pthread_create(&c->worker,&attr,run_context,c)==0);
+  pthread_attr_destroy(&attr);
+ }
+#endif
+ if (!ok)
+ {mutex_free(&c->lock); cond_free(&c->changed);
+  free(c->plan.positions); free(c);
+  return NULL;
+ }
+ /* wait until the model is set up, or has given up */
+ mutex_lock(&c->lock);
+ while (!c->ready && !c->finished) cond_wait(&c->changed,&c->lock);
+ ok=c->ready && !c->finished;
+ mutex_unlock(&c->lock);
+ if (!ok) {ipemam_context_destroy(c); return NULL;}
+ return c;
+}
+
+void ipemam_context_destroy(ipemam_context *c)
+{
+ if (c==NULL) return;
+ mutex_lock(&c->lock);
+ c->quit=1; cond_signal(&c->changed);
+ mutex_unlock(&c->lock);
+#if defined(_WIN32)
+ WaitForSingleObject(c->worker,INFINITE); CloseHandle(c->worker);
+#else
+ pthread_join(c->worker,NULL);
+#endif
+ mutex_free(&c->lock); cond_free(&c->changed);
+ free(c->freqs); free(c->queue); free(c->plan.positions); free(c);
+}
+
+int32_t ipemam_channels(const ipemam_context *c)
+{
+ return (int32_t)c->nchan;
+}
+
+double ipemam_frame_rate(const ipemam_context *c)
+{
+ return c->frame_rate;
+}
+
+void ipemam_frequencies(const ipemam_context *c,double *freqs)
+{
+ memcpy(freqs,c->freqs,c->nchan*sizeof(double));
+}
+
+static void restart(ipemam_context *c)
+/* after an analysis has ended: start the next one (lock held) */
+{
+ c->finished=0; c->ready=0; c->eof=0; c->left=0;
+ cond_signal(&c->changed);
+ while (!c->ready && !c->finished) cond_wait(&c->changed,&c->lock);
+}
+
+int64_t ipemam_process(ipemam_context *c,const double *xn,int64_t count)
+{int64_t res;
+
+ mutex_lock(&c->lock);
+ if (c->finished) restart(c);
+ c->xn=xn; c->left=(count>0) ? count : 0; cond_signal(&c->changed);
+ while (!c->finished && ((c->left>0) || !c->waiting))
+    cond_wait(&c->changed,&c->lock);
+ /* the block must not be used after the call, not even by a failed
+    analysis */
+ c->xn=NULL; c->left=0;
+ res=(c->finished && (c->result!=0)) ? -1 : c->tail-c->head;
+ mutex_unlock(&c->lock);
+ return res;
+}
+
+int64_t ipemam_flush(ipemam_context *c)
+{int64_t res;
+
+ mutex_lock(&c->lock);
+ c->eof=1; cond_signal(&c->changed);
+ while (!c->finished) cond_wait(&c->changed,&c->lock);
+ res=(c->result!=0) ? -1 : c->tail-c->head;
+ mutex_unlock(&c->lock);
+ return res;
+}
+
+int64_t ipemam_read(ipemam_context *c,double *frames,int64_t count)
+{
+ mutex_lock(&c->lock);
+ if (count>c->tail-c->head) count=c->tail-c->head;
+ if (count<0) count=0;
+ memcpy(frames,c->queue+c->head*c->nchan,count*c->nchan*sizeof(double));
+ c->head+=count;
+ mutex_unlock(&c->lock);
+ return count;
+}
@@ -0,0 +1,155 @@
+/* ipemam.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( IPEMAM_H )
+#define IPEMAM_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*********************************************************************
+   C interface of the shared library libipemam: the auditory model
+   behind opaque handles, for bindings that link the library instead
+   of compiling the model themselves. This header is all a binding
+   needs: the library exports the ipemam_ functions only.
+
+   A plan holds the parameters of the model; it is not changed after
+   ipemam_plan_create and can be shared by any number of contexts on
+   any threads. A context runs the model on one signal at a time,
+   which it is given a block at a time (ipemam_process) and told the
+   end of (ipemam_flush); the frames of the auditory nerve image are
+   read out of it as they become available (ipemam_read). After a
+   flush the next block starts a new signal. Different contexts are
+   independent: the library has no state outside its handles.
+
+   Ownership of the buffers: the caller owns all the buffers it
+   passes. The library does not keep a pointer to any of them after
+   the call returns (the parameters and the channel positions are
+   copied by ipemam_plan_create, a block is consumed by
+   ipemam_process, frames are copied into the buffer of ipemam_read).
+   The handles are owned by the caller, who destroys them; a plan may
+   be destroyed before the contexts made from it.
+
+   A context is used by one thread at a time. The frames lag the
+   input by at most one block of the model (1024 samples) plus its
+   delay; the frames of the end of the signal follow the flush.
+
+   Cost of a context: the model keeps its state per thread, so every
+   context starts a thread of its own (with a stack of 512 KB) that
+   holds the state of the model (about 120 KB) and sleeps between the
+   calls. Creating one costs about as much as starting a thread;
+   reuse a context for the signals that are analysed one after the
+   other, and create one per signal that is analysed at the same time.
+ *********************************************************************/
+
+#define ipemam_abi_version  2    /* changes when the ABI breaks          */
+
+/* Values of the parameters below, as in IPEMAuditoryModel.h */
+enum {ipemam_scale_cbu = 0, ipemam_scale_erb, ipemam_scale_bark, ipemam_scale_hz };
+enum {ipemam_kernel_double = 0, ipemam_kernel_fixed };
+enum {ipemam_normalize_none = 0, ipemam_normalize_peak, ipemam_normalize_rms };
+enum {ipemam_output_text = 0, ipemam_output_binary };
+
+/* Result of ipemam_analyse_file for invalid options: a wrong size or a
+   name or path longer than ipemam_max_name characters */
+#define ipemam_error_param  (-2)
+#define ipemam_max_name     255
+
+typedef struct ipemam_plan_tag    ipemam_plan;
+typedef struct ipemam_context_tag ipemam_context;
+
+/*********************************************************************
+   Parameters of a plan. size must be sizeof(ipemam_params): new
+   members are only ever added at the end, so that a binding built
+   against an older header still works.
+ *********************************************************************/
+typedef struct{
+               int32_t       size;
+               int32_t       nchan;       /* number of channels (40)    */
+               double        first_freq;  /* first channel (2.0)        */
+               double        freq_dist;   /* between channels (0.5)     */
+               double        fs;          /* sample frequency (Hz)      */
+               int32_t       scale;       /* scale of the above (CBU)   */
+               const double *positions;   /* channels, NULL: spaced     */
+               int32_t       npositions;
+               int32_t       kernel;      /* arithmetic (double)        */
+              } ipemam_params;
+
+/*********************************************************************
+   Analysis of a sound file (ipemam_analyse_file), as the options of
+   IPEMAuditoryModel.h: NULL names and -1 values take the defaults.
+   size must be sizeof(ipemam_file_options).
+ *********************************************************************/
+typedef struct{
+               int32_t       size;
+               int32_t       output_format; /* of the ANI (text)        */
+               const char   *cache_dir;     /* ANI cache, NULL: none    */
+               double        cache_size;    /* MB                       */
+               const char   *pyramid_file;  /* NULL: no pyramid         */
+               int32_t       pyramid_levels;
+               double        start;         /* range (s), -1: all       */
+               double        duration;
+               double        preroll;
+               int32_t       normalization; /* of the input (none)      */
+               double        level;         /* RMS level (dB, -20)      */
+              } ipemam_file_options;
+
+extern int32_t ipemam_version();
+extern void ipemam_params_init(ipemam_params *params);
+extern void ipemam_file_options_init(ipemam_file_options *options);
+
+/* The value called name (e.g. "erb", "rms", "fixed"), -1 if unknown */
+extern int32_t ipemam_scale(const char *name);
+extern int32_t ipemam_normalization(const char *name);
+extern int32_t ipemam_kernel(const char *name);
+
+extern ipemam_plan *ipemam_plan_create(const ipemam_params *params);
+extern void ipemam_plan_destroy(ipemam_plan *plan);
+
+/* 0 on success, ipemam_error_param for invalid options, -1 if the
+   analysis failed */
+extern int32_t ipemam_analyse_file(const ipemam_plan *plan,
+                                   const char *input_file,
+                                   const char *input_path,
+                                   const char *output_file,
+                                   const char *output_path,
+                                   const ipemam_file_options *options);
+
+extern ipemam_context *ipemam_context_create(const ipemam_plan *plan);
+extern void ipemam_context_destroy(ipemam_context *context);
+extern int32_t ipemam_channels(const ipemam_context *context);
+extern double ipemam_frame_rate(const ipemam_context *context);
+extern void ipemam_frequencies(const ipemam_context *context,double *freqs);
+
+extern int64_t ipemam_process(ipemam_context *context,const double *xn,
+                              int64_t count);
+extern int64_t ipemam_flush(ipemam_context *context);
+extern int64_t ipemam_read(ipemam_context *context,double *frames,
+                           int64_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( IPEMAM_H ) */
@@ -0,0 +1,360 @@
+/* anicache.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    CONTENT ADDRESSED CACHE OF AUDITORY NERVE IMAGES
+
+    An entry is a copy of an output file of the model, stored as
+    <dir>/<key>.ani where the key is the SHA-256 of the decoded
+    signal, the model parameters and the version of the model. The
+    modification time of an entry is its last use; when the entries
+    together exceed the size bound, the least recently used ones are
+    removed. Entries are written to a temporary file in the same
+    directory and renamed, so that other processes sharing the cache
+    never see a partial entry.
+
+ ************** list of routines and their function ******************
+
+    anicache_hash_init(c), anicache_hash_add(c,data,size),
+    anicache_hash_final(c,key)
+      Compute a key (64 hex digits, '\0' terminated).
+    anicache_fetch(dir,key,filename)
+      If the entry exists, copy it to filename, mark it as used and
+      return 1, otherwise return 0.
+    anicache_store(dir,key,filename,max_size)
+      Copy filename into the cache, then evict entries until the
+      cache holds at most max_size MB. Returns 1 on success.
+    anicache_fetch_data(dir,key,ext,data,size),
+    anicache_store_data(dir,key,ext,data,size)
+      The same for a small entry of size bytes other than an ANI
+      (such as the level of a sound file), stored as <dir>/<key><ext>
+      where ext is a '.' and 3 characters. Storing one does not
+      evict: these entries are counted and removed with the ANIs
+      the next time an ANI is stored.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <anicache.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#define maxpath     1024
+#define stale_time  (24*3600)      /* age (s) of abandoned temporary files */
+
+/* SHA-256 (FIPS 180-2) */
+
+static const unsigned int k256[64]={
+ 0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+ 0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+ 0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+ 0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+ 0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+ 0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+ 0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+ 0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2};
+
+#define ror(x,n)  (((x)>>(n))|((x)<<(32-(n))))
+
+static void sha256_block(unsigned int *s,const unsigned char *p)
+{unsigned int w[64],a,b,c,d,e,f,g,h,t1,t2;
+ int i;
+
+ for (i=0;i<16;i++)
+    w[i]=((unsigned int)p[4*i]<<24)|((unsigned int)p[4*i+1]<<16)
+         |((unsigned int)p[4*i+2]<<8)|p[4*i+3];
+ for (i=16;i<64;i++)
+    w[i]=w[i-16]+(ror(w[i-15],7)^ror(w[i-15],18)^(w[i-15]>>3))
+         +w[i-7]+(ror(w[i-2],17)^ror(w[i-2],19)^(w[i-2]>>10));
+ a=s[0]; b=s[1]; c=s[2]; d=s[3]; e=s[4]; f=s[5]; g=s[6]; h=s[7];
+ for (i=0;i<64;i++)
+ {t1=h+(ror(e,6)^ror(e,11)^ror(e,25))+((e&f)^(~e&g))+k256[i]+w[i];
+  t2=(ror(a,2)^ror(a,13)^ror(a,22))+((a&b)^(a&c)^(b&c));
+  h=g; g=f; f=e; e=d+t1; d=c; c=b; b=a; a=t1+t2;
+ }
+ s[0]+=a; s[1]+=b; s[2]+=c; s[3]+=d; s[4]+=e; s[5]+=f; s[6]+=g; s[7]+=h;
+}
+
+void anicache_hash_init(anicache_hash *c)
+{
+ c->state[0]=0x6a09e667; c->state[1]=0xbb67ae85;
+ c->state[2]=0x3c6ef372; c->state[3]=0xa54ff53a;
+ c->state[4]=0x510e527f; c->state[5]=0x9b05688c;
+ c->state[6]=0x1f83d9ab; c->state[7]=0x5be0cd19;
+ c->length=0;
+}
+
+void anicache_hash_add(anicache_hash *c,const void *data,size_t size)
+{const unsigned char *p=(const unsigned char*)data;
+ size_t used,n;
+
+ while (size>0)
+ {used=(size_t)(c->length%64); n=64-used; if (n>size) n=size;
+  memcpy(c->block+used,p,n);
+  c->length+=n; p+=n; size-=n;
+  if (used+n==64) sha256_block(c->state,c->block);
+ }
+}
+
+void anicache_hash_final(anicache_hash *c,anicache_key key)
+{unsigned char pad[72];
+ unsigned long long bits;
+ size_t npad;
+ int i;
+
+ bits=8*c->length;
+ npad=(size_t)((c->length%64<56) ? 56-c->length%64 : 120-c->length%64);
+ memset(pad,0,sizeof(pad)); pad[0]=0x80;
+ for (i=0;i<8;i++) pad[npad+i]=(unsigned char)(bits>>(56-8*i));
+ anicache_hash_add(c,pad,npad+8);
+ for (i=0;i<32;i++)
+    sprintf(key+2*i,"%02x",(c->state[i/4]>>(24-8*(i%4)))&0xff);
+ key[anicache_keylen]='\0';
+}
+
+/* Files */
+
+static int copy_file(const char *from,FILE *to)
+{FILE  *f;
+ char   buf[65536];
+ size_t n;
+ int    res=1;
+
+ f=fopen(from,"rb");
+ if (f==NULL) return 0;
+ while ((n=fread(buf,1,sizeof(buf),f))>0)
+    if (fwrite(buf,1,n,to)!=n) {res=0; break;}
+ if (ferror(f)) res=0;
+ fclose(f);
+ return res;
+}
+
+static int entry_name(char *res,const char *dir,const anicache_key key,
+                      const char *ext)
+/* 0 if the path does not fit in maxpath */
+{int len=snprintf(res,maxpath,"%s/%s%s",dir,key,ext);
+
+ return (len>=0) && (len<maxpath);
+}
+
+static long next_temporary(void)
+/* a counter shared by the threads of a process */
+{static volatile long count=0;
+
+#if defined(_WIN32)
+ return InterlockedIncrement(&count);
+#elif defined(__GNUC__)
+ return __sync_add_and_fetch(&count,1);
+#else
+ return ++count;
+#endif
+}
+
+static int temporary_name(char *res,const char *dir,const anicache_key key)
+/* the process id and a counter tell concurrent writers apart */
+{int len=snprintf(res,maxpath,"%s/tmp-%ld-%lx-%s",dir,(long)getpid(),
+                  (unsigned long)next_temporary(),key);
+
+ return (len>=0) && (len<maxpath);
+}
+
+static int install(const char *tmpname,const char *name,int res)
+/* rename a complete temporary file to its entry, or remove it */
+{
+#if defined(_WIN32)
+ if (res) res=MoveFileExA(tmpname,name,MOVEFILE_REPLACE_EXISTING)!=0;
+#else
+ if (res) res=(rename(tmpname,name)==0);
+#endif
+ if (!res) remove(tmpname);
+ return res;
+}
+
+int anicache_fetch(const char *dir,const anicache_key key,const char *filename)
+{char  name[maxpath];
+ FILE *to;
+ int   res;
+
+ if (!entry_name(name,dir,key,".ani")) return 0;
+ to=fopen(filename,"wb");
+ if (to==NULL) return 0;
+ res=copy_file(name,to);
+ if (fclose(to)!=0) res=0;
+ if (res) utime(name,NULL); /* most recently used */
+ else remove(filename);
+ return res;
+}
+
+/* Eviction */
+
+typedef struct{
+               time_t mtime;
+               double size;
+               char   name[anicache_keylen+5];
+              } cache_entry;
+
+static int older(const void *a,const void *b)
+{time_t ta=((const cache_entry*)a)->mtime,tb=((const cache_entry*)b)->mtime;
+
+ return (ta<tb) ? -1 : ((ta>tb) ? 1 : 0);
+}
+
+static int is_entry(const char *name)
+{size_t len=strlen(name);
+
+ return (len==anicache_keylen+4) && (name[anicache_keylen]=='.');
+}
+
+static int is_temporary(const char *name)
+{
+ return strncmp(name,"tmp-",4)==0;
+}
+
+static void evict(const char *dir,double max_size)
+/*********************************************************************
+   Several processes may evict at the same time: entries that have
+   already disappeared are simply skipped.
+ *********************************************************************/
+{cache_entry *e=NULL,*tmp;
+ long         n=0,cap=0,i;
+ double       total=0;
+ char         path[maxpath];
+ struct stat  st;
+ time_t       now=time(NULL);
+ const char  *name;
+#if defined(_WIN32)
+ WIN32_FIND_DATAA fd;
+ HANDLE           h;
+
+ snprintf(path,maxpath,"%s/*",dir);
+ h=FindFirstFileA(path,&fd);
+ if (h==INVALID_HANDLE_VALUE) return;
+ do
+ {name=fd.cFileName;
+#else
+ DIR           *d;
+ struct dirent *de;
+
+ d=opendir(dir);
+ if (d==NULL) return;
+ while ((de=readdir(d))!=NULL)
+ {name=de->d_name;
+#endif
+  if (snprintf(path,maxpath,"%s/%s",dir,name)>=maxpath) continue;
+  if (is_temporary(name))
+  {if ((stat(path,&st)==0) && (now-st.st_mtime>stale_time)) remove(path);
+  }
+  else if (is_entry(name) && (stat(path,&st)==0))
+  {if (n==cap)
+   {cap=(cap==0) ? 256 : 2*cap;
+    tmp=(cache_entry*)realloc(e,cap*sizeof(cache_entry));
+    if (tmp==NULL) break;
+    e=tmp;
+   }
+   e[n].mtime=st.st_mtime; e[n].size=(double)st.st_size;
+   strcpy(e[n].name,name);
+   total+=e[n].size; n++;
+  }
+ }
+#if defined(_WIN32)
+ while (FindNextFileA(h,&fd));
+ FindClose(h);
+#else
+ closedir(d);
+#endif
+
+ if (total>max_size)
+ {qsort(e,n,sizeof(cache_entry),older);
+  for (i=0;(i<n) && (total>max_size);i++)
+  {snprintf(path,maxpath,"%s/%s",dir,e[i].name);
+   remove(path);
+   total-=e[i].size;
+  }
+ }
+ free(e);
+}
+
+int anicache_store(const char *dir,const anicache_key key,const char *filename,
+                   double max_size)
+/*********************************************************************
+   max_size in MB
+ *********************************************************************/
+{char  tmpname[maxpath],name[maxpath];
+ FILE *to;
+ int   res;
+
+ if (!entry_name(name,dir,key,".ani") || !temporary_name(tmpname,dir,key)) return 0;
+ to=fopen(tmpname,"wb");
+ if (to==NULL) return 0;
+ res=copy_file(filename,to);
+ if (fclose(to)!=0) res=0;
+ res=install(tmpname,name,res);
+ evict(dir,max_size*1024*1024);
+ return res;
+}
+
+/* Small entries */
+
+int anicache_fetch_data(const char *dir,const anicache_key key,const char *ext,
+                        void *data,size_t size)
+{char  name[maxpath];
+ FILE *f;
+ int   res;
+
+ if ((strlen(ext)!=4) || !entry_name(name,dir,key,ext)) return 0;
+ f=fopen(name,"rb");
+ if (f==NULL) return 0;
+ res=(fread(data,1,size,f)==size) && (fgetc(f)==EOF);
+ fclose(f);
+ if (res) utime(name,NULL);
+ return res;
+}
+
+int anicache_store_data(const char *dir,const anicache_key key,const char *ext,
+                        const void *data,size_t size)
+{char  tmpname[maxpath],name[maxpath];
+ FILE *to;
+ int   res;
+
+ if ((strlen(ext)!=4) || !entry_name(name,dir,key,ext)
+     || !temporary_name(tmpname,dir,key)) return 0;
+ to=fopen(tmpname,"wb");
+ if (to==NULL) return 0;
+ res=(fwrite(data,1,size,to)==size);
+ if (fclose(to)!=0) res=0;
+ return install(tmpname,name,res);
+}
@@ -0,0 +1,60 @@
+/* anicache.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( ANICACHE_H )
+#define ANICACHE_H
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define anicache_keylen    64            /* hex digits of a key (SHA-256)   */
+#define anicache_def_size  1024.0        /* default size bound (MB)         */
+
+typedef char anicache_key[anicache_keylen+1];
+
+/* SHA-256 over everything that determines an ANI */
+typedef struct{
+               unsigned int       state[8];
+               unsigned char      block[64];
+               unsigned long long length;  /* bytes hashed so far         */
+              } anicache_hash;
+
+extern void anicache_hash_init(anicache_hash *c);
+extern void anicache_hash_add(anicache_hash *c,const void *data,size_t size);
+extern void anicache_hash_final(anicache_hash *c,anicache_key key);
+
+extern int anicache_fetch(const char *dir,const anicache_key key,
+                          const char *filename);
+extern int anicache_store(const char *dir,const anicache_key key,
+                          const char *filename,double max_size);
+extern int anicache_fetch_data(const char *dir,const anicache_key key,
+                               const char *ext,void *data,size_t size);
+extern int anicache_store_data(const char *dir,const anicache_key key,
+                               const char *ext,const void *data,size_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( ANICACHE_H ) */
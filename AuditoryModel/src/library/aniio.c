@@ -0,0 +1,436 @@
+/* aniio.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    READ AND WRITE AUDITORY NERVE IMAGES IN BINARY FORMAT
+
+ ************** list of routines and their function ******************
+
+    ani_open_write(w,file,nchan,frame_rate,start_time,freqs)
+      Write the header of a binary ANI to an open file. start_time is
+      the time in the signal of the first frame (nonzero if only a
+      part of the signal was analysed). If the file
+      is not seekable (a pipe or a socket) the frame count is left
+      at -1, otherwise it is patched by ani_close_write.
+    ani_write_frame(w,values)
+      Append one frame (values[0..nchan-1]) to the file.
+    ani_close_write(w)
+      Patch the frame count and release the writer (the file itself
+      is not closed).
+    ani_map_open(m,filename)
+      Map a binary ANI read-only in memory and set up a view on it.
+      Several processes mapping the same file share the page cache.
+    ani_map_close(m)
+      Unmap the file.
+    ani_window(v,first,count)
+      Restrict a view to frames first..first+count-1 (no copy).
+    ani_row(v,chan), ani_column(v,frame)
+      Strided vector over all frames of one channel, or over all
+      channels of one frame (no copy).
+    ani_pyr_open_write(w,file,nchan,nlevels,frame_rate,start_time,freqs)
+      Write the header of a pyramid of nlevels levels to an open,
+      seekable file. start_time is the time of the first frame in the
+      signal, as for ani_open_write. Level 1 goes straight to the file, the coarser
+      levels to temporary files until ani_pyr_close_write.
+    ani_pyr_write_frame(w,values)
+      Add one frame of the ANI to every level of the pyramid.
+    ani_pyr_close_write(w)
+      Write the last (partial) bins, append the coarser levels and
+      fill in the index (the file itself is not closed).
+    ani_pyr_map_open(m,filename)
+      Map a pyramid read-only in memory and set up the min, max and
+      mean views on each level.
+    ani_pyr_map_close(m)
+      Unmap the file.
+    ani_pyr_choose(m,count,width)
+      Coarsest level that still has at least width bins for count
+      frames of the ANI (e.g. width = pixels of a plot), or 0 if the
+      full rate ANI is needed.
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <aniio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static unsigned int header_size(long nchan)
+{unsigned int size;
+
+ size=sizeof(ani_header)+nchan*sizeof(double);
+ return ((size+ani_align-1)/ani_align)*ani_align;
+}
+
+int ani_open_write(ani_writer *w,FILE *file,long nchan,
+                   double frame_rate,double start_time,const double *freqs)
+{ani_header h;
+ char pad[ani_align];
+ long p;
+
+ w->file=file; w->nchan=nchan; w->nframes=0;
+ w->frame=(float*)malloc(nchan*sizeof(float));
+ if ((file==NULL) || (w->frame==NULL)) return 0;
+
+ memset(&h,0,sizeof(h));
+ memcpy(h.magic,ani_magic,sizeof(ani_magic));
+ h.byte_order=ani_byte_order; h.version=ani_version;
+ h.header_size=header_size(nchan); h.nchan=nchan;
+ h.nframes=-1; h.frame_rate=frame_rate; h.start_time=start_time;
+ fwrite(&h,sizeof(h),1,file);
+ for (p=0;p<nchan;p++) fwrite(&freqs[p],sizeof(double),1,file);
+ memset(pad,0,sizeof(pad));
+ fwrite(pad,1,h.header_size-sizeof(h)-nchan*sizeof(double),file);
+ return !ferror(file);
+}
+
+int ani_write_frame(ani_writer *w,const double *values)
+{long p;
+
+ for (p=0;p<w->nchan;p++) w->frame[p]=(float)values[p];
+ if (fwrite(w->frame,sizeof(float),w->nchan,w->file)!=(size_t)w->nchan)
+    return 0;
+ w->nframes++;
+ return 1;
+}
+
+int ani_close_write(ani_writer *w)
+{long pos;
+ int  res=1;
+
+ if (w->file!=NULL)
+ {fflush(w->file);
+  pos=ftell(w->file);
+  if ((pos>=0) && (fseek(w->file,offsetof(ani_header,nframes),SEEK_SET)==0))
+  {res=(fwrite(&w->nframes,sizeof(w->nframes),1,w->file)==1);
+   fseek(w->file,pos,SEEK_SET);
+  }
+ }
+ free(w->frame); w->frame=NULL;
+ return res;
+}
+
+static int map_file(ani_map *m,const char *filename)
+{
+#if defined(_WIN32)
+ LARGE_INTEGER size;
+
+ m->file_handle=CreateFileA(filename,GENERIC_READ,FILE_SHARE_READ,NULL,
+                            OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+ if (m->file_handle==INVALID_HANDLE_VALUE) return 0;
+ if (!GetFileSizeEx(m->file_handle,&size) || (size.QuadPart==0))
+ {CloseHandle(m->file_handle); return 0;}
+ m->size=(size_t)size.QuadPart;
+ m->map_handle=CreateFileMappingA(m->file_handle,NULL,PAGE_READONLY,0,0,NULL);
+ if (m->map_handle==NULL) {CloseHandle(m->file_handle); return 0;}
+ m->base=MapViewOfFile(m->map_handle,FILE_MAP_READ,0,0,0);
+ if (m->base==NULL)
+ {CloseHandle(m->map_handle); CloseHandle(m->file_handle); return 0;}
+ return 1;
+#else
+ struct stat st;
+ int fd;
+
+ fd=open(filename,O_RDONLY);
+ if (fd<0) return 0;
+ if ((fstat(fd,&st)!=0) || (st.st_size==0)) {close(fd); return 0;}
+ m->size=(size_t)st.st_size;
+ m->base=mmap(NULL,m->size,PROT_READ,MAP_SHARED,fd,0);
+ close(fd); /* the mapping keeps the file alive */
+ if (m->base==MAP_FAILED) {m->base=NULL; return 0;}
+ return 1;
+#endif
+}
+
+int ani_map_open(ani_map *m,const char *filename)
+/*********************************************************************
+   The number of frames is derived from the file size, so that files
+   written to a pipe (nframes=-1) or files that are still being
+   written can be read as well.
+ *********************************************************************/
+{long long nframes;
+
+ memset(m,0,sizeof(*m));
+ if (!map_file(m,filename)) return 0;
+ if (m->size<sizeof(ani_header)) {ani_map_close(m); return 0;}
+ memcpy(&m->header,m->base,sizeof(ani_header));
+ if ((memcmp(m->header.magic,ani_magic,sizeof(ani_magic))!=0)
+     || (m->header.byte_order!=ani_byte_order)
+     || (m->header.version>ani_version) || (m->header.nchan==0)
+     || (m->header.header_size<header_size(m->header.nchan))
+     || (m->size<m->header.header_size))
+ {ani_map_close(m); return 0;}
+
+ nframes=(m->size-m->header.header_size)/(m->header.nchan*sizeof(float));
+ if ((m->header.nframes>=0) && (m->header.nframes<nframes))
+    nframes=m->header.nframes;
+ m->freqs=(const double*)((const char*)m->base+sizeof(ani_header));
+ m->view.data=(const float*)((const char*)m->base+m->header.header_size);
+ m->view.nchan=m->header.nchan; m->view.nframes=(long)nframes;
+ m->view.chan_stride=1; m->view.frame_stride=m->header.nchan;
+ m->view.first_frame=0; m->view.frame_rate=m->header.frame_rate;
+ return 1;
+}
+
+void ani_map_close(ani_map *m)
+{
+ if (m->base!=NULL)
+ {
+#if defined(_WIN32)
+  UnmapViewOfFile(m->base);
+  CloseHandle(m->map_handle); CloseHandle(m->file_handle);
+#else
+  munmap(m->base,m->size);
+#endif
+ }
+ memset(m,0,sizeof(*m));
+}
+
+ani_view ani_window(ani_view v,long first,long count)
+/*********************************************************************
+   The window is clipped to the frames that are present in v.
+ *********************************************************************/
+{
+ if (first<0) {count+=first; first=0;}
+ if (first>v.nframes) first=v.nframes;
+ if (count>v.nframes-first) count=v.nframes-first;
+ if (count<0) count=0;
+ v.data+=first*v.frame_stride;
+ v.first_frame+=first; v.nframes=count;
+ return v;
+}
+
+ani_vector ani_row(ani_view v,long chan)
+{ani_vector x;
+
+ x.data=v.data+chan*v.chan_stride; x.stride=v.frame_stride; x.length=v.nframes;
+ return x;
+}
+
+ani_vector ani_column(ani_view v,long frame)
+{ani_vector x;
+
+ x.data=v.data+frame*v.frame_stride; x.stride=v.chan_stride; x.length=v.nchan;
+ return x;
+}
+
+static long pyr_header_size(long nchan,int nlevels)
+{long size;
+
+ size=sizeof(ani_pyr_header)+nchan*sizeof(double)+nlevels*sizeof(ani_pyr_index);
+ return ((size+ani_align-1)/ani_align)*ani_align;
+}
+
+int ani_pyr_open_write(ani_pyr_writer *w,FILE *file,long nchan,int nlevels,
+                       double frame_rate,double start_time,const double *freqs)
+{ani_pyr_header h;
+ ani_pyr_index  index;
+ char pad[ani_align];
+ long p,size;
+ long long span;
+ int  k;
+
+ memset(w,0,sizeof(*w));
+ w->file=file; w->nchan=nchan; w->nlevels=nlevels; w->frame_rate=frame_rate;
+ if ((file==NULL) || (nchan<1) || (nlevels<1) || (nlevels>ani_pyr_max_levels))
+    return 0;
+ w->acc=(double*)malloc(3*nchan*nlevels*sizeof(double));
+ w->bin=(float*)malloc(3*nchan*sizeof(float));
+ for (k=1;k<nlevels;k++) w->spill[k]=tmpfile();
+ for (k=1;(k<nlevels) && (w->spill[k]!=NULL);k++);
+ if ((w->acc==NULL) || (w->bin==NULL) || (k<nlevels))
+ {ani_pyr_close_write(w); return 0;}
+
+ memset(&h,0,sizeof(h));
+ memcpy(h.magic,ani_pyr_magic,sizeof(ani_pyr_magic));
+ h.byte_order=ani_byte_order; h.version=ani_pyr_version;
+ w->header_size=pyr_header_size(nchan,nlevels);
+ h.header_size=w->header_size; h.nchan=nchan; h.nlevels=nlevels;
+ h.factor=ani_pyr_factor; h.nframes=0; h.frame_rate=frame_rate;
+ h.start_time=start_time;
+ fwrite(&h,sizeof(h),1,file);
+ for (p=0;p<nchan;p++) fwrite(&freqs[p],sizeof(double),1,file);
+ for (k=0,span=ani_pyr_factor;k<nlevels;k++,span*=ani_pyr_factor)
+ {index.offset=(k==0) ? w->header_size : 0;
+  index.nbins=(k==0) ? -1 : 0;
+  index.span=span; index.bin_rate=frame_rate/span;
+  fwrite(&index,sizeof(index),1,file);
+ }
+ memset(pad,0,sizeof(pad));
+ size=w->header_size-sizeof(h)-nchan*sizeof(double)-nlevels*sizeof(index);
+ for (;size>0;size-=ani_align) fwrite(pad,1,(size<ani_align) ? size : ani_align,file);
+ return !ferror(file);
+}
+
+static void pyr_add(ani_pyr_writer *w,int k,const double *mn,const double *mx,
+                    const double *sum,long long frames);
+
+/* write the open bin of level k and pass it on to level k+1 */
+static void pyr_emit(ani_pyr_writer *w,int k)
+{double *mn=w->acc+3*w->nchan*k,*mx=mn+w->nchan,*sum=mx+w->nchan;
+ FILE   *f=(k==0) ? w->file : w->spill[k];
+ long    p;
+
+ for (p=0;p<w->nchan;p++)
+ {w->bin[p]=(float)mn[p]; w->bin[w->nchan+p]=(float)mx[p];
+  w->bin[2*w->nchan+p]=(float)(sum[p]/w->frames[k]);
+ }
+ if (fwrite(w->bin,sizeof(float),3*w->nchan,f)!=(size_t)(3*w->nchan))
+    w->failed=1;
+ w->nbins[k]++;
+ if (k+1<w->nlevels) pyr_add(w,k+1,mn,mx,sum,w->frames[k]);
+ w->parts[k]=0; w->frames[k]=0;
+}
+
+static void pyr_add(ani_pyr_writer *w,int k,const double *mn,const double *mx,
+                    const double *sum,long long frames)
+{double *amn=w->acc+3*w->nchan*k,*amx=amn+w->nchan,*asum=amx+w->nchan;
+ long    p;
+
+ if (w->parts[k]==0)
+    for (p=0;p<w->nchan;p++) {amn[p]=mn[p]; amx[p]=mx[p]; asum[p]=sum[p];}
+ else
+    for (p=0;p<w->nchan;p++)
+    {if (mn[p]<amn[p]) amn[p]=mn[p];
+     if (mx[p]>amx[p]) amx[p]=mx[p];
+     asum[p]+=sum[p];
+    }
+ w->frames[k]+=frames;
+ if (++w->parts[k]==ani_pyr_factor) pyr_emit(w,k);
+}
+
+int ani_pyr_write_frame(ani_pyr_writer *w,const double *values)
+{
+ pyr_add(w,0,values,values,values,1);
+ w->nframes++;
+ return !w->failed;
+}
+
+int ani_pyr_close_write(ani_pyr_writer *w)
+/*********************************************************************
+   Bins that are still open are written as they are, starting at the
+   finest level, so that each level covers all frames of the ANI.
+ *********************************************************************/
+{ani_pyr_index index;
+ char buf[4096];
+ size_t nread;
+ long pos;
+ long long span=1;
+ int  k;
+
+ if ((w->file!=NULL) && (w->acc!=NULL) && (w->bin!=NULL))
+ {for (k=0;k<w->nlevels;k++) if (w->parts[k]>0) pyr_emit(w,k);
+  fseek(w->file,0,SEEK_END);
+  for (k=0;k<w->nlevels;k++)
+  {span*=ani_pyr_factor;
+   pos=(k==0) ? w->header_size : ftell(w->file);
+   if (k>0)
+   {rewind(w->spill[k]);
+    while ((nread=fread(buf,1,sizeof(buf),w->spill[k]))>0)
+       if (fwrite(buf,1,nread,w->file)!=nread) w->failed=1;
+   }
+   index.offset=pos; index.nbins=w->nbins[k]; index.span=span;
+   index.bin_rate=w->frame_rate/span;
+   if ((pos<0) || (fseek(w->file,sizeof(ani_pyr_header)+w->nchan*sizeof(double)
+                          +k*sizeof(ani_pyr_index),SEEK_SET)!=0))
+   {w->failed=1; break;}
+   fwrite(&index,sizeof(index),1,w->file);
+   fseek(w->file,0,SEEK_END);
+  }
+  if ((fseek(w->file,offsetof(ani_pyr_header,nframes),SEEK_SET)!=0)
+      || (fwrite(&w->nframes,sizeof(w->nframes),1,w->file)!=1))
+     w->failed=1;
+  fseek(w->file,0,SEEK_END);
+  fflush(w->file);
+  if (ferror(w->file)) w->failed=1;
+ }
+ for (k=1;k<ani_pyr_max_levels;k++)
+    if (w->spill[k]!=NULL) {fclose(w->spill[k]); w->spill[k]=NULL;}
+ free(w->acc); free(w->bin); w->acc=NULL; w->bin=NULL;
+ return !w->failed;
+}
+
+int ani_pyr_map_open(ani_pyr_map *m,const char *filename)
+/*********************************************************************
+   Level 1 can be read while the model is still writing the file (its
+   bins are counted from the file size, as for an ANI written to a
+   pipe); the coarser levels are empty until the writer is closed.
+ *********************************************************************/
+{ani_pyr_index index;
+ ani_pyr_level *level;
+ long long bins;
+ long nchan;
+ int  l;
+
+ memset(m,0,sizeof(*m));
+ if (!map_file(&m->map,filename)) return 0;
+ if (m->map.size<sizeof(ani_pyr_header)) {ani_pyr_map_close(m); return 0;}
+ memcpy(&m->header,m->map.base,sizeof(ani_pyr_header));
+ nchan=m->header.nchan;
+ if ((memcmp(m->header.magic,ani_pyr_magic,sizeof(ani_pyr_magic))!=0)
+     || (m->header.byte_order!=ani_byte_order)
+     || (m->header.version>ani_pyr_version) || (nchan==0)
+     || (m->header.nlevels<1) || (m->header.nlevels>ani_pyr_max_levels)
+     || (m->header.header_size<pyr_header_size(nchan,m->header.nlevels))
+     || (m->map.size<m->header.header_size))
+ {ani_pyr_map_close(m); return 0;}
+
+ m->freqs=(const double*)((const char*)m->map.base+sizeof(ani_pyr_header));
+ for (l=1;l<=(int)m->header.nlevels;l++)
+ {memcpy(&index,(const char*)(m->freqs+nchan)+(l-1)*sizeof(index),sizeof(index));
+  bins=0;
+  if ((index.offset>=m->header.header_size) && (index.offset<=(long long)m->map.size))
+     bins=((long long)m->map.size-index.offset)/(3*nchan*sizeof(float));
+  if ((index.nbins>=0) && (index.nbins<bins)) bins=index.nbins;
+  if (bins==0) index.offset=m->header.header_size;
+  level=&m->level[l];
+  level->span=index.span;
+  level->min.data=(const float*)((const char*)m->map.base+index.offset);
+  level->min.nchan=nchan; level->min.nframes=(long)bins;
+  level->min.chan_stride=1; level->min.frame_stride=3*nchan;
+  level->min.first_frame=0; level->min.frame_rate=index.bin_rate;
+  level->max=level->mean=level->min;
+  level->max.data+=nchan; level->mean.data+=2*nchan;
+ }
+ return 1;
+}
+
+void ani_pyr_map_close(ani_pyr_map *m)
+{
+ ani_map_close(&m->map);
+ memset(m,0,sizeof(*m));
+}
+
+int ani_pyr_choose(const ani_pyr_map *m,long long count,long width)
+{int l,best=0;
+
+ for (l=1;l<=(int)m->header.nlevels;l++)
+    if ((m->level[l].span>0) && (count/m->level[l].span>=width)) best=l;
+ return best;
+}
@@ -0,0 +1,215 @@
+/* aniio.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( ANIIO_H )
+#define ANIIO_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define ani_magic       "IPEMANI"     /* 8 bytes, including the '\0'       */
+#define ani_byte_order  0x01020304    /* written in the writer's byte order */
+#define ani_version     1
+#define ani_align       64            /* alignment of the sample data       */
+
+/*********************************************************************
+   Fixed part of the header of a binary ANI file (64 bytes). It is
+   followed by nchan doubles with the centre frequencies (in Hz) of
+   the channels, and padding up to header_size. The samples start at
+   header_size and are stored frame by frame as 32 bit floats, with
+   the channel index running fastest (the same order as the lines of
+   the text output).
+ *********************************************************************/
+typedef struct{
+               char         magic[8];
+               unsigned int byte_order;
+               unsigned int version;
+               unsigned int header_size; /* offset of the samples        */
+               unsigned int nchan;
+               long long    nframes;     /* -1 if the output was streamed */
+               double       frame_rate;  /* in Hz                         */
+               double       start_time;  /* of frame 0 in the signal (s) */
+               double       reserved[2];
+              } ani_header;
+
+/* Writer */
+
+typedef struct{
+               FILE      *file;
+               long       nchan;
+               long long  nframes;
+               float     *frame;        /* conversion buffer             */
+              } ani_writer;
+
+extern int ani_open_write(ani_writer *w,FILE *file,long nchan,
+                          double frame_rate,double start_time,
+                          const double *freqs);
+extern int ani_write_frame(ani_writer *w,const double *values);
+extern int ani_close_write(ani_writer *w);
+
+/*********************************************************************
+   A sink receives the frames of an ANI as they are computed, e.g. to
+   store them in memory instead of in a file. begin is called once
+   with the number of channels, the frame rate (Hz) and the centre
+   frequencies (Hz), then frame once per frame with nchan values.
+   Either returns 0 to abort the analysis.
+ *********************************************************************/
+typedef struct{
+               void  *context;
+               int  (*begin)(void *context,long nchan,double frame_rate,
+                             const double *freqs);
+               int  (*frame)(void *context,const double *values);
+              } ani_sink;
+
+/* Reader */
+
+/*********************************************************************
+   A view is a zero-copy (channel,frame) window on ANI samples:
+   element (c,f) lives at data[f*frame_stride+c*chan_stride]. A vector
+   is one strided row (all frames of a channel) or column (all
+   channels of a frame) of a view.
+ *********************************************************************/
+typedef struct{
+               const float *data;
+               long         nchan,nframes;
+               long         chan_stride,frame_stride;
+               long         first_frame; /* index of frame 0 in the file */
+               double       frame_rate;
+              } ani_view;
+
+typedef struct{
+               const float *data;
+               long         stride;
+               long         length;
+              } ani_vector;
+
+typedef struct{
+               void         *base;      /* start of the mapping          */
+               size_t        size;      /* length of the mapping         */
+               const double *freqs;     /* centre frequencies (Hz)       */
+               ani_header    header;
+               ani_view      view;      /* view on the entire file       */
+#if defined(_WIN32)
+               void         *file_handle;
+               void         *map_handle;
+#endif
+              } ani_map;
+
+#define ani_at(v,c,f)  ((v).data[(long)(f)*(v).frame_stride+(long)(c)*(v).chan_stride])
+#define ani_elem(x,i)  ((x).data[(long)(i)*(x).stride])
+
+extern int ani_map_open(ani_map *m,const char *filename);
+extern void ani_map_close(ani_map *m);
+extern ani_view ani_window(ani_view v,long first,long count);
+extern ani_vector ani_row(ani_view v,long chan);
+extern ani_vector ani_column(ani_view v,long frame);
+
+/* Pyramid */
+
+#define ani_pyr_magic       "IPEMPYR"  /* 8 bytes, including the '\0'       */
+#define ani_pyr_version     2          /* 2: start_time                      */
+#define ani_pyr_factor      4          /* each level is 4x coarser           */
+#define ani_pyr_max_levels  12
+#define ani_pyr_def_levels  6
+
+/*********************************************************************
+   A pyramid file holds progressively decimated versions of an ANI,
+   so that a viewer can read an overview of a long ANI without
+   touching the full rate data. Bin b of level l (1..nlevels) covers
+   frames b*4^l..(b+1)*4^l-1 of the ANI (the last bin of a level may
+   cover less) and stores, as 32 bit floats, the minimum, the maximum
+   and the mean of each channel over those frames: nchan minima,
+   nchan maxima, then nchan means.
+   The fixed part of the header (64 bytes) is followed by nchan
+   doubles with the centre frequencies (in Hz), nlevels index entries
+   and padding up to header_size. The levels follow, finest first.
+ *********************************************************************/
+typedef struct{
+               char         magic[8];
+               unsigned int byte_order;
+               unsigned int version;
+               unsigned int header_size; /* offset of the first level    */
+               unsigned int nchan;
+               unsigned int nlevels;
+               unsigned int factor;      /* decimation between levels    */
+               long long    nframes;     /* frames of the ANI            */
+               double       frame_rate;  /* of the ANI, in Hz            */
+               double       start_time;  /* of ANI frame 0 in the signal */
+                                         /* (s), 0 in version 1 files    */
+               double       reserved[1];
+              } ani_pyr_header;
+
+typedef struct{
+               long long    offset;      /* of the first bin in the file */
+               long long    nbins;
+               long long    span;        /* ANI frames per bin (4^l)     */
+               double       bin_rate;    /* bins per second              */
+              } ani_pyr_index;
+
+typedef struct{
+               FILE      *file;
+               long       nchan;
+               int        nlevels;
+               long long  nframes;
+               double     frame_rate;
+               long       header_size;
+               double    *acc;          /* min, max, sum of each level   */
+               long long  frames[ani_pyr_max_levels]; /* in the open bin */
+               int        parts[ani_pyr_max_levels];  /* bins (frames) of
+                                                         the level below */
+               long long  nbins[ani_pyr_max_levels];
+               FILE      *spill[ani_pyr_max_levels];  /* levels 2..      */
+               float     *bin;          /* conversion buffer             */
+               int        failed;
+              } ani_pyr_writer;
+
+extern int ani_pyr_open_write(ani_pyr_writer *w,FILE *file,long nchan,
+                              int nlevels,double frame_rate,
+                              double start_time,const double *freqs);
+extern int ani_pyr_write_frame(ani_pyr_writer *w,const double *values);
+extern int ani_pyr_close_write(ani_pyr_writer *w);
+
+/* the three views of a level share the frame rate bin_rate */
+typedef struct{
+               ani_view      min,max,mean;
+               long long     span;      /* ANI frames per bin            */
+              } ani_pyr_level;
+
+typedef struct{
+               ani_map       map;       /* only the mapping is used      */
+               const double *freqs;     /* centre frequencies (Hz)       */
+               ani_pyr_header header;
+               ani_pyr_level level[ani_pyr_max_levels+1]; /* 1..nlevels */
+              } ani_pyr_map;
+
+extern int ani_pyr_map_open(ani_pyr_map *m,const char *filename);
+extern void ani_pyr_map_close(ani_pyr_map *m);
+extern int ani_pyr_choose(const ani_pyr_map *m,long long count,long width);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( ANIIO_H ) */
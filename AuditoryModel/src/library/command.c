@@ -20,22 +20,23 @@
 ------------------------------------------------------------------------------*/
 
 #include <command.h>
-
-cmnd_modes cmnd_mode=normal;
-int        submit_mode=0;
-srcds      cmnd_src=inpt;
-int        nr_of_seq;
-int        seq_cntr;
-int        read_ptr;
-int        write_ptr;
-text_line  answer;
-text_line  item;
-FILE       *seq_buffer;
-FILE       *ascii_file;
-FILE       *out_file;
-FILE       *readfile;
-FILE       *writefile;
-text_line  tmp_filename;
+#include <logging.h>
+
+per_thread cmnd_modes cmnd_mode=normal;
+per_thread int        submit_mode=0;
+per_thread srcds      cmnd_src=inpt;
+per_thread int        nr_of_seq;
+per_thread int        seq_cntr;
+per_thread int        read_ptr;
+per_thread int        write_ptr;
+per_thread text_line  answer;
+per_thread text_line  item;
+per_thread FILE       *seq_buffer;
+per_thread FILE       *ascii_file;
+per_thread FILE       *out_file;
+per_thread FILE       *readfile;
+per_thread FILE       *writefile;
+per_thread text_line  tmp_filename;
 
 /***************************************************************************
 
@@ -68,7 +69,7 @@ variables
 ***************************************************************************/
 
 #if !defined(_WIN32)
-int remove_uncompressed_file=0;
+per_thread int remove_uncompressed_file=0;
 #endif /* !defined(_WIN32) */
 
 int round_int(double a)
@@ -211,7 +212,8 @@ void get_string(srcds source,const char *question)
  {if (source==usual) source=cmnd_src;
   switch (source) 
   {case inpt:   if (!submit_mode) printf("%s",question); 
-                gets(answer); break;
+                if (fgets(answer,maxstrlen,stdin)==NULL) strcpy(answer,"");
+                answer[strcspn(answer,"\r\n")]='\0'; break;
    case ascii:  fgets(answer,maxstrlen,ascii_file); 
                 if (feof(ascii_file)) strcpy(answer,""); break;
    case buffer: fgets(answer,maxstrlen,seq_buffer); 
@@ -480,7 +482,7 @@ int open_readfile(const char *filename)
  readfile=fopen(filename,"rb");
 #if defined(_WIN32)
  if (readfile==NULL)
- {printf("error opening %s\n",filename); return 0;}
+ {log_message(log_error,"could not open %s",filename); return 0;}
 #else
  remove_uncompressed_file=0;
  if (readfile==NULL)
@@ -495,7 +497,7 @@ int open_readfile(const char *filename)
    readfile=fopen(tmp,"rb");
    remove_uncompressed_file=1;
   }
-  else {printf("error opening %s\n",filename); return 0;}
+  else {log_message(log_error,"could not open %s",filename); return 0;}
  }
 #endif /* defined(_WIN32) */
  read_ptr=0; return (!feof(readfile));
@@ -30,6 +30,14 @@
 
 #define maxstrlen 1024
 
+/* the state of the model lives in globals; every thread gets its own
+   copy, so that several analyses can run concurrently */
+#if defined(_MSC_VER)
+#define per_thread __declspec(thread)
+#else
+#define per_thread __thread
+#endif
+
 #if !defined (_WIN32)
 #define max(a,b)    (((a) > (b)) ? (a) : (b))
 #define min(a,b)    (((a) < (b)) ? (a) : (b))
@@ -41,21 +49,21 @@ typedef enum cmnd_modes_t cmnd_modes;
 typedef enum srcds_t srcds;
 typedef char text_line[maxstrlen+1];
 
-extern cmnd_modes cmnd_mode;
-extern int        submit_mode;
-extern srcds      cmnd_src;
-extern int        nr_of_seq;
-extern int        seq_cntr;
-extern int        read_ptr;
-extern int        write_ptr;
-extern text_line  answer;
-extern text_line  item;
-extern FILE       *seq_buffer;
-extern FILE       *ascii_file;
-extern FILE       *out_file;
-extern FILE       *readfile;
-extern FILE       *writefile;
-extern text_line  tmp_filename;
+extern per_thread cmnd_modes cmnd_mode;
+extern per_thread int        submit_mode;
+extern per_thread srcds      cmnd_src;
+extern per_thread int        nr_of_seq;
+extern per_thread int        seq_cntr;
+extern per_thread int        read_ptr;
+extern per_thread int        write_ptr;
+extern per_thread text_line  answer;
+extern per_thread text_line  item;
+extern per_thread FILE       *seq_buffer;
+extern per_thread FILE       *ascii_file;
+extern per_thread FILE       *out_file;
+extern per_thread FILE       *readfile;
+extern per_thread FILE       *writefile;
+extern per_thread text_line  tmp_filename;
 
 extern int round_int(double a);
 extern int strindex(const char *s,const char *t);
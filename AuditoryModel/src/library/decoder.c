@@ -0,0 +1,719 @@
+/* decoder.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    DECODERS FOR SOUND FILES
+
+    Sound files are read through a decoder, chosen from the first
+    bytes of the file. Each decoder delivers blocks of samples mixed
+    down to mono (the average of the channels) in -1..+1, so that the
+    model can read its input straight from wav, aiff or flac files
+    without converting them to a temporary wav file first.
+
+    formats
+      wav    RIFF WAVE: PCM (8 bit unsigned, 16/24/32 bit), IEEE float
+             (32/64 bit), A-law and mu-law, also as WAVE_FORMAT_
+             EXTENSIBLE
+      aiff   AIFF and AIFC: PCM (8..32 bit, big or little endian
+             'sowt'), float ('fl32', 'fl64'), A-law and mu-law
+      au     Sun/NeXT .au/.snd: PCM (8..32 bit), float, double,
+             A-law and mu-law
+      flac   FLAC, all subframe types, up to 32 bit and 8 channels;
+             the CRC-8 of every frame header and the CRC-16 of every
+             frame are checked
+
+    8 bit unsigned samples c are centred: (c-128)/128. (The reader
+    that preceded the decoders delivered c/256, between 0 and 1.)
+    Reading stops at a damaged frame (FLAC): decoder_read then
+    delivers less than asked for and the failed field is set.
+
+ ************** list of routines and their function ******************
+
+    decoder_open(d,file)
+      Recognize the format of file (opened for binary reading, at its
+      start), read its header and prepare d for reading the samples.
+      Returns 1 on success.
+    decoder_read(d,xn,count)
+      Read up to count samples into xn. Returns the number of samples
+      read, less than count only at the end of the file.
+    decoder_seek(d,frame)
+      Continue reading at sample frame (counted from the start of the
+      file, beyond its end: at the end). PCM files are positioned
+      directly; FLAC files are decoded up to the sample, which only
+      works right after decoder_open. Returns 1 on success.
+    decoder_close(d)
+      Release the state of the decoder (the file is not closed).
+
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <decoder.h>
+#include <logging.h>
+
+#define  pcm_frames    4096     /* frames converted at once            */
+#define  flac_buffer  65536     /* bytes read from a FLAC file at once */
+#define  flac_ring       16     /* bytes fetched, not yet in the CRCs  */
+
+typedef unsigned char BYTE;
+
+/*--------------------------------------------------------------------
+    PCM (wav, aiff, au)
+  --------------------------------------------------------------------*/
+
+enum {pcm_signed_le,pcm_signed_be,pcm_unsigned,pcm_float_le,pcm_float_be,
+      pcm_ulaw,pcm_alaw};
+
+typedef struct{
+               int        encoding;
+               int        bytes;     /* bytes per sample in the file  */
+               long long  left;      /* bytes of samples left, or -1  */
+               long long  size;      /* bytes of samples, or -1       */
+               long       start;     /* file offset of the samples    */
+               BYTE      *raw;
+              } pcm_state;
+
+static unsigned long get_le(const BYTE *c,int bytes)
+{unsigned long v=0;
+
+ while (bytes-->0) v=(v<<8)|c[bytes];
+ return v;
+}
+
+static unsigned long get_be(const BYTE *c,int bytes)
+{unsigned long v=0;
+ int i;
+
+ for (i=0;i<bytes;i++) v=(v<<8)|c[i];
+ return v;
+}
+
+static double ulaw(BYTE c)
+{int v;
+
+ c=~c; v=(((c&0x0f)<<3)+0x84)<<((c&0x70)>>4);
+ return ((c&0x80) ? 0x84-v : v-0x84)/32768.0;
+}
+
+static double alaw(BYTE c)
+{int v,e;
+
+ c^=0x55; e=(c&0x70)>>4; v=(c&0x0f)<<4;
+ v=(e==0) ? v+8 : (v+0x108)<<(e-1);
+ return ((c&0x80) ? v : -v)/32768.0;
+}
+
+static double pcm_sample(const pcm_state *p,const BYTE *c)
+{unsigned long u;
+ unsigned int   v;
+ float          f;
+ double         x;
+ unsigned long long w;
+ int            i;
+
+ switch (p->encoding)
+ {case pcm_unsigned: return (c[0]-128)/128.0;
+  case pcm_ulaw:     return ulaw(c[0]);
+  case pcm_alaw:     return alaw(c[0]);
+  case pcm_signed_le:
+  case pcm_signed_be:
+   u=(p->encoding==pcm_signed_le) ? get_le(c,p->bytes) : get_be(c,p->bytes);
+   x=(double)(u&((1UL<<(8*p->bytes-1))-1));
+   if (u&(1UL<<(8*p->bytes-1))) x-=(double)(1UL<<(8*p->bytes-1));
+   return x/(double)(1UL<<(8*p->bytes-1));
+  default: /* float */
+   for (w=0,i=0;i<p->bytes;i++)
+      w=(w<<8)|c[(p->encoding==pcm_float_be) ? i : p->bytes-1-i];
+   if (p->bytes==4) {v=(unsigned int)w; memcpy(&f,&v,4); return f;}
+   memcpy(&x,&w,8); return x;
+ }
+}
+
+static long pcm_read(decoder *d,double *xn,long count)
+{pcm_state *p=(pcm_state*)d->state;
+ long       frame=d->channels*p->bytes,done=0,want,got,i;
+ int        ch;
+ double     x;
+ const BYTE *c;
+
+ while (done<count)
+ {want=(count-done<pcm_frames) ? count-done : pcm_frames;
+  if ((p->left>=0) && (want*frame>p->left)) want=(long)(p->left/frame);
+  got=(want>0) ? (long)(fread(p->raw,1,want*frame,d->file)/frame) : 0;
+  if (p->left>=0) p->left-=got*frame;
+  for (i=0,c=p->raw;i<got;i++)
+  {for (x=0,ch=0;ch<d->channels;ch++,c+=p->bytes) x+=pcm_sample(p,c);
+   xn[done+i]=(d->channels==1) ? x : x/d->channels;
+  }
+  done+=got;
+  if (got<want || want==0) break;
+ }
+ return done;
+}
+
+static int pcm_seek(decoder *d,long long frame)
+{pcm_state *p=(pcm_state*)d->state;
+ long long  offset=frame*d->channels*p->bytes;
+
+ if ((p->size>=0) && (offset>p->size)) offset=p->size;
+ if ((p->start<0) || (fseek(d->file,(long)(p->start+offset),SEEK_SET)!=0))
+    return 0;
+ if (p->size>=0) p->left=p->size-offset;
+ return 1;
+}
+
+static void pcm_close(decoder *d)
+{pcm_state *p=(pcm_state*)d->state;
+
+ if (p!=NULL) free(p->raw);
+ free(p); d->state=NULL;
+}
+
+/* set up the PCM state once the header is read */
+static int pcm_start(decoder *d,int encoding,int bytes,long long left)
+{pcm_state *p;
+
+ if (d->channels<1 || bytes<1 || bytes>8) return 0;
+ if ((encoding==pcm_signed_le || encoding==pcm_signed_be) && bytes>4)
+    return 0;
+ if ((encoding==pcm_float_le || encoding==pcm_float_be)
+     && bytes!=4 && bytes!=8) return 0;
+ p=(pcm_state*)malloc(sizeof(pcm_state));
+ if (p==NULL) return 0;
+ p->raw=(BYTE*)malloc(pcm_frames*d->channels*bytes);
+ if (p->raw==NULL) {free(p); return 0;}
+ p->encoding=encoding; p->bytes=bytes; p->left=left; p->size=left;
+ p->start=ftell(d->file);
+ d->state=p;
+ if (left>=0) d->frames=left/(d->channels*bytes);
+ return 1;
+}
+
+/* skip n bytes of the file */
+static int skip(FILE *file,long long n)
+{
+ return (n<=0) || (fseek(file,(long)n,SEEK_CUR)==0);
+}
+
+/*--------------------------------------------------------------------
+    wav
+  --------------------------------------------------------------------*/
+
+static int wav_probe(const BYTE *head,long size)
+{
+ return (size>=12) && !memcmp(head,"RIFF",4) && !memcmp(head+8,"WAVE",4);
+}
+
+static int wav_open(decoder *d)
+{BYTE          c[40];
+ unsigned long size,tag=0;
+ int           bits=0,encoding;
+ long          n;
+
+ if (fread(c,1,12,d->file)!=12) return 0;
+ while (fread(c,1,8,d->file)==8)
+ {size=get_le(c+4,4);
+  if (!memcmp(c,"fmt ",4))
+  {n=(size<40) ? (long)size : 40;
+   if (size<16 || fread(c,1,n,d->file)!=(size_t)n) return 0;
+   tag=get_le(c,2); d->channels=(int)get_le(c+2,2);
+   d->rate=(double)get_le(c+4,4); bits=(int)get_le(c+14,2);
+   if (tag==0xfffe && n>=26) tag=get_le(c+24,2);
+   if (!skip(d->file,(long long)size-n+(size&1))) return 0;
+  }
+  else if (!memcmp(c,"data",4))
+  {d->bits=bits;
+   switch (tag)
+   {case 1: encoding=(bits<=8) ? pcm_unsigned : pcm_signed_le; break;
+    case 3: encoding=pcm_float_le; break;
+    case 6: encoding=pcm_alaw; bits=8; break;
+    case 7: encoding=pcm_ulaw; bits=8; break;
+    default: return 0;
+   }
+   return pcm_start(d,encoding,(bits+7)/8,
+                    (size==0 || size==0xffffffffUL) ? -1 : (long long)size);
+  }
+  else if (!skip(d->file,(long long)size+(size&1))) return 0;
+ }
+ return 0;
+}
+
+/*--------------------------------------------------------------------
+    aiff
+  --------------------------------------------------------------------*/
+
+static int aiff_probe(const BYTE *head,long size)
+{
+ return (size>=12) && !memcmp(head,"FORM",4)
+        && (!memcmp(head+8,"AIFF",4) || !memcmp(head+8,"AIFC",4));
+}
+
+/* 80 bit IEEE extended (the sample rate) */
+static double extended(const BYTE *c)
+{int    e=(int)(get_be(c,2)&0x7fff);
+ double m=(double)get_be(c+2,4)*4294967296.0+(double)get_be(c+6,4);
+
+ if (e==0 && m==0) return 0;
+ m=ldexp(m,e-16383-63);
+ return (c[0]&0x80) ? -m : m;
+}
+
+static int aiff_open(decoder *d)
+{BYTE          c[26];
+ unsigned long size,offset;
+ int           aifc,comm=0,encoding=pcm_signed_be,bytes=0;
+ long          at=-1,n;
+ long long     length=0;
+
+ if (fread(c,1,12,d->file)!=12) return 0;
+ aifc=!memcmp(c+8,"AIFC",4);
+ while (fread(c,1,8,d->file)==8)
+ {size=get_be(c+4,4);
+  if (!memcmp(c,"COMM",4))
+  {n=(size<22) ? (long)size : 22;
+   if (size<18 || fread(c,1,n,d->file)!=(size_t)n) return 0;
+   d->channels=(int)get_be(c,2); d->frames=(long long)get_be(c+2,4);
+   d->bits=(int)get_be(c+6,2); d->rate=extended(c+8);
+   bytes=(d->bits+7)/8; comm=1;
+   if (aifc && n>=22)
+   {if (!memcmp(c+18,"sowt",4)) encoding=pcm_signed_le;
+    else if (!memcmp(c+18,"fl32",4) || !memcmp(c+18,"FL32",4))
+    {encoding=pcm_float_be; bytes=4;}
+    else if (!memcmp(c+18,"fl64",4) || !memcmp(c+18,"FL64",4))
+    {encoding=pcm_float_be; bytes=8;}
+    else if (!memcmp(c+18,"ulaw",4) || !memcmp(c+18,"ULAW",4))
+    {encoding=pcm_ulaw; bytes=1;}
+    else if (!memcmp(c+18,"alaw",4) || !memcmp(c+18,"ALAW",4))
+    {encoding=pcm_alaw; bytes=1;}
+    else if (memcmp(c+18,"NONE",4) && memcmp(c+18,"twos",4)) return 0;
+   }
+   if (!skip(d->file,(long long)size-n+(size&1))) return 0;
+  }
+  else if (!memcmp(c,"SSND",4))
+  {if (size<8 || fread(c,1,8,d->file)!=8) return 0;
+   offset=get_be(c,4);
+   at=ftell(d->file)+(long)offset; length=(long long)size-8-offset;
+   if (comm) break;
+   if (!skip(d->file,(long long)size-8+(size&1))) return 0;
+  }
+  else if (!skip(d->file,(long long)size+(size&1))) return 0;
+ }
+ if (!comm || at<0 || fseek(d->file,at,SEEK_SET)!=0) return 0;
+ if (d->frames*d->channels*bytes<length) length=d->frames*d->channels*bytes;
+ return pcm_start(d,encoding,bytes,length);
+}
+
+/*--------------------------------------------------------------------
+    au
+  --------------------------------------------------------------------*/
+
+static int au_probe(const BYTE *head,long size)
+{
+ return (size>=24) && !memcmp(head,".snd",4);
+}
+
+static int au_open(decoder *d)
+{BYTE          c[24];
+ unsigned long offset,size;
+ int           encoding,bytes;
+
+ if (fread(c,1,24,d->file)!=24) return 0;
+ offset=get_be(c+4,4); size=get_be(c+8,4);
+ d->rate=(double)get_be(c+16,4); d->channels=(int)get_be(c+20,4);
+ switch (get_be(c+12,4))
+ {case 1:  encoding=pcm_ulaw;      bytes=1; d->bits=8; break;
+  case 2:  encoding=pcm_signed_be; bytes=1; d->bits=8; break;
+  case 3:  encoding=pcm_signed_be; bytes=2; d->bits=16; break;
+  case 4:  encoding=pcm_signed_be; bytes=3; d->bits=24; break;
+  case 5:  encoding=pcm_signed_be; bytes=4; d->bits=32; break;
+  case 6:  encoding=pcm_float_be;  bytes=4; d->bits=32; break;
+  case 7:  encoding=pcm_float_be;  bytes=8; d->bits=64; break;
+  case 27: encoding=pcm_alaw;      bytes=1; d->bits=8; break;
+  default: return 0;
+ }
+ if (offset<24 || !skip(d->file,(long long)offset-24)) return 0;
+ return pcm_start(d,encoding,bytes,(size==0xffffffffUL) ? -1 : (long long)size);
+}
+
+/*--------------------------------------------------------------------
+    flac
+  --------------------------------------------------------------------*/
+
+typedef struct{
+               BYTE       buf[flac_buffer];
+               long       pos,len;
+               unsigned long long cache;   /* bits not yet used ...    */
+               int        nbits;           /* ... in its lowest nbits  */
+               int        error;
+               BYTE       ring[flac_ring]; /* the last bytes fetched   */
+               long long  fetched,crc_pos; /* bytes fetched, in CRCs   */
+               unsigned   crc8,crc16;
+               int        bps;             /* from STREAMINFO          */
+               long       max_block;
+               long long *s[8];            /* samples of the channels  */
+               double    *mono;            /* samples of the frame     */
+               long       length,next;     /* in mono                  */
+              } flac_state;
+
+static int flac_probe(const BYTE *head,long size)
+{
+ return (size>=4) && !memcmp(head,"fLaC",4);
+}
+
+/* add the bytes up to (not including) byte upto of the file to the
+   CRCs (CRC-8 polynomial 0x07, CRC-16 polynomial 0x8005) */
+static void flac_crc(flac_state *f,long long upto)
+{unsigned c;
+ int      i;
+
+ for (;f->crc_pos<upto;f->crc_pos++)
+ {c=f->ring[f->crc_pos%flac_ring];
+  f->crc8^=c; f->crc16^=c<<8;
+  for (i=0;i<8;i++)
+  {f->crc8=(f->crc8&0x80) ? (f->crc8<<1)^0x07 : f->crc8<<1;
+   f->crc16=(f->crc16&0x8000) ? (f->crc16<<1)^0x8005 : f->crc16<<1;
+  }
+  f->crc8&=0xff; f->crc16&=0xffff;
+ }
+}
+
+/* bytes of the file used so far (at a byte boundary) */
+#define flac_used(f)  ((f)->fetched-(f)->nbits/8)
+
+/* make sure at least 57 bits are cached, unless the file ends; the
+   bytes whose bits are all used go into the CRCs before they can
+   leave the ring */
+static int flac_fill(decoder *d,flac_state *f)
+{
+ while (f->nbits<=56)
+ {if (f->pos==f->len)
+  {f->len=(long)fread(f->buf,1,flac_buffer,d->file); f->pos=0;
+   if (f->len==0) return f->nbits>0;
+  }
+  flac_crc(f,f->fetched-(f->nbits+7)/8);
+  f->ring[f->fetched++%flac_ring]=f->buf[f->pos];
+  f->cache=(f->cache<<8)|f->buf[f->pos++]; f->nbits+=8;
+ }
+ return 1;
+}
+
+/* next n bits (n<=56) */
+static unsigned long long flac_bits(decoder *d,flac_state *f,int n)
+{
+ if (n==0) return 0;
+ if (f->nbits<n) flac_fill(d,f);
+ if (f->nbits<n) {f->error=1; f->nbits=0; return 0;}
+ f->nbits-=n;
+ return (f->cache>>f->nbits)&((1ULL<<n)-1);
+}
+
+static long long flac_signed(decoder *d,flac_state *f,int n)
+{unsigned long long u=flac_bits(d,f,n);
+
+ if (n>0 && (u>>(n-1))&1) return (long long)u-(long long)(1ULL<<(n-1))
+                                  -(long long)(1ULL<<(n-1));
+ return (long long)u;
+}
+
+/* number of 0 bits before the next 1 bit */
+static long long flac_unary(decoder *d,flac_state *f)
+{long long q=0;
+
+ for (;;)
+ {if (f->nbits==0 && !flac_fill(d,f)) {f->error=1; return 0;}
+  f->nbits--;
+  if ((f->cache>>f->nbits)&1) return q;
+  q++;
+ }
+}
+
+static int flac_residual(decoder *d,flac_state *f,long long *s,long n,
+                         int order)
+{int  method,porder,k,rb,pbits,escape;
+ long i=order,cnt,p,j;
+ unsigned long long u;
+
+ method=(int)flac_bits(d,f,2);
+ if (method>1) return 0;
+ porder=(int)flac_bits(d,f,4);
+ pbits=method ? 5 : 4; escape=method ? 31 : 15;
+ if ((n>>porder)<order || ((n>>porder)<<porder)!=n) return 0;
+ for (p=0;p<(1L<<porder);p++)
+ {cnt=(n>>porder)-((p==0) ? order : 0);
+  k=(int)flac_bits(d,f,pbits);
+  if (k==escape)
+  {rb=(int)flac_bits(d,f,5);
+   for (j=0;j<cnt;j++) s[i++]=flac_signed(d,f,rb);
+  }
+  else
+   for (j=0;j<cnt;j++)
+   {u=((unsigned long long)flac_unary(d,f)<<k)|flac_bits(d,f,k);
+    s[i++]=(long long)(u>>1)^-(long long)(u&1);
+   }
+  if (f->error) return 0;
+ }
+ return 1;
+}
+
+static int flac_subframe(decoder *d,flac_state *f,long long *s,long n,int bps)
+{int       type,wasted=0,order,precision,shift,j;
+ long      i;
+ long long c[32];
+ unsigned long long sum;                  /* wraps on damaged data */
+
+ if (flac_bits(d,f,1)) return 0;
+ type=(int)flac_bits(d,f,6);
+ if (flac_bits(d,f,1)) {wasted=1; while (!flac_bits(d,f,1) && !f->error) wasted++;}
+ bps-=wasted;
+ if (bps<1) return 0;
+ if (type==0)
+ {s[0]=flac_signed(d,f,bps); for (i=1;i<n;i++) s[i]=s[0];}
+ else if (type==1)
+  for (i=0;i<n;i++) s[i]=flac_signed(d,f,bps);
+ else if (type>=8 && type<=12)
+ {order=type-8;
+  if (order>n) return 0;
+  for (i=0;i<order;i++) s[i]=flac_signed(d,f,bps);
+  if (!flac_residual(d,f,s,n,order)) return 0;
+  for (i=order;i<n;i++)
+     switch (order)
+     {case 1: s[i]+=s[i-1]; break;
+      case 2: s[i]+=2*s[i-1]-s[i-2]; break;
+      case 3: s[i]+=3*s[i-1]-3*s[i-2]+s[i-3]; break;
+      case 4: s[i]+=4*s[i-1]-6*s[i-2]+4*s[i-3]-s[i-4]; break;
+     }
+ }
+ else if (type>=32)
+ {order=(type&31)+1;
+  if (order>n) return 0;
+  for (i=0;i<order;i++) s[i]=flac_signed(d,f,bps);
+  precision=(int)flac_bits(d,f,4)+1;
+  if (precision==16) return 0;
+  shift=(int)flac_signed(d,f,5);
+  if (shift<0) return 0;
+  for (j=0;j<order;j++) c[j]=flac_signed(d,f,precision);
+  if (!flac_residual(d,f,s,n,order)) return 0;
+  for (i=order;i<n;i++)
+  {for (sum=0,j=0;j<order;j++)
+      sum+=(unsigned long long)c[j]*(unsigned long long)s[i-1-j];
+   s[i]+=(long long)sum>>shift;
+  }
+ }
+ else return 0;
+ if (wasted) for (i=0;i<n;i++) s[i]*=(1LL<<wasted);
+ return !f->error;
+}
+
+/* decode the next frame into mono, returns 0 at the end of the file */
+static int flac_frame(decoder *d,flac_state *f)
+{static const int  sizes[8]={0,8,12,0,16,20,24,32};
+ int       code,assignment,channels,bps,ch,size_code,rate_code,b;
+ unsigned  crc;
+ long      n,i;
+ long long l,r,m;
+ double    x,scale;
+
+ /* find the sync code at a byte boundary */
+ f->nbits-=f->nbits%8;
+ for (;;)
+ {b=(int)flac_bits(d,f,8);
+  if (f->error) return 0;
+  if (b!=0xff) continue;
+  b=(int)flac_bits(d,f,8);
+  if (f->error) return 0;
+  if ((b&0xfe)==0xf8) break;
+  if (b==0xff) f->nbits+=8;            /* look at it again */
+ }
+ /* the CRCs start at the sync code (which is still in the ring) */
+ f->crc_pos=flac_used(f)-2; f->crc8=f->crc16=0;
+ code=(int)flac_bits(d,f,4); rate_code=(int)flac_bits(d,f,4);
+ assignment=(int)flac_bits(d,f,4); size_code=(int)flac_bits(d,f,3);
+ flac_bits(d,f,1);
+ b=(int)flac_bits(d,f,8);                /* UTF-8 coded frame number */
+ for (i=(b&0x80) ? 1 : 0;i<7 && ((b<<i)&0x80);i++) ;
+ for (i--;i>0;i--) flac_bits(d,f,8);
+ if (code==1) n=192;
+ else if (code>=2 && code<=5) n=576L<<(code-2);
+ else if (code==6) n=(long)flac_bits(d,f,8)+1;
+ else if (code==7) n=(long)flac_bits(d,f,16)+1;
+ else if (code>=8) n=256L<<(code-8);
+ else {d->failed=1; return 0;}
+ if (rate_code==12) flac_bits(d,f,8);
+ else if (rate_code==13 || rate_code==14) flac_bits(d,f,16);
+ flac_crc(f,flac_used(f)); crc=f->crc8;
+ if (!f->error && (flac_bits(d,f,8)!=crc))
+ {log_message(log_error,"FLAC frame header CRC mismatch");
+  d->failed=1; return 0;
+ }
+ bps=(size_code==0) ? f->bps : sizes[size_code];
+ channels=(assignment<8) ? assignment+1 : 2;
+ if (f->error || bps==0 || assignment>10 || n>f->max_block
+     || channels>d->channels) {d->failed=1; return 0;}
+
+ for (ch=0;ch<channels;ch++)
+ {b=bps;
+  if ((assignment==8 && ch==1) || (assignment==9 && ch==0)
+      || (assignment==10 && ch==1)) b++;  /* side channel */
+  if (!flac_subframe(d,f,f->s[ch],n,b)) {d->failed=1; return 0;}
+ }
+ f->nbits-=f->nbits%8;
+ flac_crc(f,flac_used(f)); crc=f->crc16;
+ if (flac_bits(d,f,16)!=crc || f->error)
+ {log_message(log_error,"FLAC frame CRC mismatch");
+  d->failed=1; return 0;
+ }
+
+ for (i=0;i<n;i++)
+    switch (assignment)
+    {case 8:  f->s[1][i]=f->s[0][i]-f->s[1][i]; break;
+     case 9:  f->s[0][i]+=f->s[1][i]; break;
+     case 10: m=f->s[0][i]*2|(f->s[1][i]&1); l=(m+f->s[1][i])>>1;
+              r=(m-f->s[1][i])>>1; f->s[0][i]=l; f->s[1][i]=r; break;
+    }
+ scale=1/ldexp(1.0,bps-1);
+ for (i=0;i<n;i++)
+ {for (x=0,ch=0;ch<channels;ch++) x+=f->s[ch][i]*scale;
+  f->mono[i]=(channels==1) ? x : x/channels;
+ }
+ f->length=n; f->next=0;
+ return 1;
+}
+
+static int flac_open(decoder *d)
+{BYTE        c[34];
+ flac_state *f;
+ unsigned long size;
+ int         last=0,ch;
+
+ if (fread(c,1,4,d->file)!=4) return 0;
+ d->channels=0;
+ while (!last)
+ {if (fread(c,1,4,d->file)!=4) return 0;
+  last=c[0]&0x80; size=get_be(c+1,3);
+  if ((c[0]&0x7f)==0 && size>=34)
+  {if (fread(c,1,34,d->file)!=34) return 0;
+   d->rate=(double)(get_be(c+10,3)>>4);
+   d->channels=((c[12]>>1)&7)+1;
+   d->bits=(((c[12]&1)<<4)|(c[13]>>4))+1;
+   d->frames=((long long)(c[13]&0x0f)<<32)|(long long)get_be(c+14,4);
+   if (d->frames==0) d->frames=-1;
+   if (!skip(d->file,(long long)size-34)) return 0;
+   size=get_be(c+2,2);                  /* maximum block size */
+   if (size<16) size=65535;
+   f=(flac_state*)calloc(1,sizeof(flac_state));
+   if (f==NULL) return 0;
+   d->state=f; f->bps=d->bits; f->max_block=(long)size;
+   f->mono=(double*)malloc(size*sizeof(double));
+   if (f->mono==NULL) return 0;
+   for (ch=0;ch<d->channels;ch++)
+   {f->s[ch]=(long long*)malloc(size*sizeof(long long));
+    if (f->s[ch]==NULL) return 0;
+   }
+  }
+  else if (!skip(d->file,(long long)size)) return 0;
+ }
+ return (d->state!=NULL);
+}
+
+static long flac_read(decoder *d,double *xn,long count)
+{flac_state *f=(flac_state*)d->state;
+ long        done=0,k;
+
+ while (done<count)
+ {if ((f->next==f->length) && (d->failed || !flac_frame(d,f))) break;
+  k=f->length-f->next; if (k>count-done) k=count-done;
+  memcpy(xn+done,f->mono+f->next,k*sizeof(double));
+  f->next+=k; done+=k;
+ }
+ return done;
+}
+
+static void flac_close(decoder *d)
+{flac_state *f=(flac_state*)d->state;
+ int         ch;
+
+ if (f!=NULL)
+ {for (ch=0;ch<8;ch++) free(f->s[ch]);
+  free(f->mono);
+ }
+ free(f); d->state=NULL;
+}
+
+/*--------------------------------------------------------------------
+    the decoders
+  --------------------------------------------------------------------*/
+
+static const decoder_format formats[]={
+ {"wav", wav_probe, wav_open, pcm_read, pcm_seek,pcm_close},
+ {"aiff",aiff_probe,aiff_open,pcm_read, pcm_seek,pcm_close},
+ {"au",  au_probe,  au_open,  pcm_read, pcm_seek,pcm_close},
+ {"flac",flac_probe,flac_open,flac_read,NULL,    flac_close}
+};
+
+int decoder_open(decoder *d,FILE *file)
+{BYTE head[decoder_head];
+ long size;
+ int  k;
+
+ memset(d,0,sizeof(decoder));
+ d->file=file; d->frames=-1;
+ size=(long)fread(head,1,decoder_head,file);
+ if (fseek(file,0,SEEK_SET)!=0) return 0;
+ for (k=0;k<(int)(sizeof(formats)/sizeof(formats[0]));k++)
+    if (formats[k].probe(head,size))
+    {d->format=&formats[k];
+     if (formats[k].open(d) && d->channels>0) return 1;
+     log_message(log_error,"unsupported or damaged %s file",formats[k].name);
+     decoder_close(d);
+     return 0;
+    }
+ log_message(log_error,"unknown sound file format");
+ return 0;
+}
+
+long decoder_read(decoder *d,double *xn,long count)
+{
+ return (d->format==NULL) ? 0 : d->format->read(d,xn,count);
+}
+
+int decoder_seek(decoder *d,long long frame)
+{double    skipped[pcm_frames];
+ long long pos=0;
+ long      want;
+
+ if (d->format==NULL) return 0;
+ if (d->format->seek!=NULL) return d->format->seek(d,frame);
+ /* from the start of the samples: read up to frame */
+ while (pos<frame)
+ {want=(frame-pos<pcm_frames) ? (long)(frame-pos) : pcm_frames;
+  if (d->format->read(d,skipped,want)<want) break;
+  pos+=want;
+ }
+ return 1;
+}
+
+void decoder_close(decoder *d)
+{
+ if (d->format!=NULL) d->format->close(d);
+ d->format=NULL;
+}
@@ -0,0 +1,87 @@
+/* decoder.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( DECODER_H )
+#define DECODER_H
+
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define decoder_head   64     /* bytes passed to the probes          */
+
+typedef struct decoder_tag decoder;
+
+/*********************************************************************
+   A decoder format recognizes its files from their first bytes
+   (probe), reads the header and leaves the file at the first sample
+   (open), and then delivers the samples count at a time, mixed down
+   to mono and scaled to -1..+1 (read returns the number of samples
+   delivered, less than count only at the end of the file). seek
+   moves to a sample (frame) directly; formats without it are read
+   and the samples thrown away. Adding a format is adding one of
+   these to the table in decoder.c.
+ *********************************************************************/
+typedef struct{
+               const char *name;
+               int       (*probe)(const unsigned char *head,long size);
+               int       (*open)(decoder *d);
+               long      (*read)(decoder *d,double *xn,long count);
+               int       (*seek)(decoder *d,long long frame);
+               void      (*close)(decoder *d);
+              } decoder_format;
+
+struct decoder_tag{
+               const decoder_format *format;
+               FILE      *file;
+               double     rate;        /* sample frequency (Hz)          */
+               int        channels;
+               int        bits;        /* bits per sample in the file    */
+               long long  frames;      /* samples per channel, -1 if not */
+                                       /* known in advance               */
+               void      *state;       /* owned by the format            */
+               int        failed;      /* reading stopped at damaged data */
+              };
+
+/*********************************************************************
+   A source delivers the samples of a signal that is neither a file
+   nor in memory as a whole, e.g. one that arrives a block at a time:
+   read puts count samples (-1..+1) into xn and returns how many it
+   delivered, less than count only at the end of the signal. It is
+   read once, from the start: it cannot seek.
+ *********************************************************************/
+typedef struct{
+               void  *context;
+               long (*read)(void *context,double *xn,long count);
+              } decoder_source;
+
+extern int  decoder_open(decoder *d,FILE *file);
+extern long decoder_read(decoder *d,double *xn,long count);
+extern int  decoder_seek(decoder *d,long long frame);
+extern void decoder_close(decoder *d);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( DECODER_H ) */
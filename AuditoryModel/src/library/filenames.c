@@ -50,13 +50,13 @@
 #include <filenames.h>
 
 
-int        filename_type=1;
-text_line  subdir_prefix="s";  
-text_line  filename_prefix="z";
-text_line  input_extension="";
-text_line  output_extension="";
-text_line  input_directory="";
-text_line  output_directory=""; 
+per_thread int        filename_type=1;
+per_thread text_line  subdir_prefix="s";  
+per_thread text_line  filename_prefix="z";
+per_thread text_line  input_extension="";
+per_thread text_line  output_extension="";
+per_thread text_line  input_directory="";
+per_thread text_line  output_directory=""; 
 
 
 void define_filenameformat(srcds io)
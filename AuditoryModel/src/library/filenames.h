@@ -24,13 +24,13 @@
 
 #include "command.h"
 
-extern int        filename_type;  
-extern text_line  subdir_prefix;
-extern text_line  filename_prefix;
-extern text_line  input_extension;
-extern text_line  output_extension;
-extern text_line  input_directory;
-extern text_line  output_directory; 
+extern per_thread int        filename_type;  
+extern per_thread text_line  subdir_prefix;
+extern per_thread text_line  filename_prefix;
+extern per_thread text_line  input_extension;
+extern per_thread text_line  output_extension;
+extern per_thread text_line  input_directory;
+extern per_thread text_line  output_directory; 
 
 extern void define_filenameformat(srcds io);
 extern void type1_name(char *res,int nr);
@@ -0,0 +1,137 @@
+/* logging.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    DIAGNOSTIC MESSAGES
+
+    The modules of the model report through log_message and
+    log_record instead of printing to stdout. The messages go to the
+    sink of the calling thread; without one, only warnings and errors
+    are written, to stderr. Messages above the level of the sink are
+    dropped before they are formatted, and formatting uses a buffer
+    on the stack: nothing is allocated.
+
+    levels
+      log_error    the analysis (or part of it) could not be done
+      log_warning  something is wrong, but the analysis goes on
+      log_info     one line per analysis: input, result, speed
+      log_debug    parameters of the modules, per channel
+
+ ************** list of routines and their function ******************
+
+    log_set_sink(sink)
+      Send the messages of this thread to sink (not copied, it must
+      stay valid while it is set); NULL restores the default.
+    log_enabled(level)
+      Nonzero if messages of this level reach the sink, e.g. to skip
+      preparing a message that takes work.
+    log_message(level,format,...)
+      Format a message as printf does and pass it to the sink.
+    log_record(level,text,fields,nfields)
+      Pass a message with nfields structured fields to the sink.
+    log_to_stream(context,level,text,fields,nfields)
+      Sink function writing one line per message, with the fields as
+      name=value, to the FILE* context (stderr if NULL).
+    log_clock()
+      Wall clock time in seconds, to measure the speed of analyses.
+
+ *********************************************************************/
+
+#include <stdarg.h>
+#include <command.h>
+#include <logging.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static const log_sink default_sink={NULL,log_to_stream,log_warning};
+static per_thread const log_sink *sink=NULL;
+
+void log_set_sink(const log_sink *s)
+{
+ sink=s;
+}
+
+int log_enabled(int level)
+{
+ return level<=((sink!=NULL) ? sink : &default_sink)->level;
+}
+
+void log_message(int level,const char *format,...)
+{const log_sink *s=(sink!=NULL) ? sink : &default_sink;
+ char    text[log_max_text];
+ va_list args;
+
+ if ((level>s->level) || (s->message==NULL)) return;
+ va_start(args,format);
+ vsnprintf(text,sizeof(text),format,args);
+ va_end(args);
+ s->message(s->context,level,text,NULL,0);
+}
+
+void log_record(int level,const char *text,const log_field *fields,int nfields)
+{const log_sink *s=(sink!=NULL) ? sink : &default_sink;
+
+ if ((level>s->level) || (s->message==NULL)) return;
+ s->message(s->context,level,text,fields,nfields);
+}
+
+void log_to_stream(void *context,int level,const char *text,
+                   const log_field *fields,int nfields)
+/*********************************************************************
+   The line is written with a single fputs, so that lines of threads
+   sharing the stream do not get mixed up.
+ *********************************************************************/
+{static const char *prefix[]={"error: ","warning: ","",""};
+ FILE *f=(context!=NULL) ? (FILE*)context : stderr;
+ char  line[2*log_max_text];
+ int   k,len;
+
+ len=snprintf(line,sizeof(line),"%s%s",prefix[(level<0) ? 0 : (level>3) ? 3 : level],text);
+ for (k=0;(k<nfields) && (len<(int)sizeof(line));k++)
+ {if (fields[k].text!=NULL)
+     len+=snprintf(line+len,sizeof(line)-len," %s=%s",fields[k].name,fields[k].text);
+  else
+     len+=snprintf(line+len,sizeof(line)-len," %s=%g",fields[k].name,fields[k].value);
+ }
+ if (len>=(int)sizeof(line)-1) len=sizeof(line)-2;
+ line[len]='\n'; line[len+1]='\0';
+ fputs(line,f);
+}
+
+double log_clock()
+{
+#if defined(_WIN32)
+ LARGE_INTEGER count,freq;
+
+ QueryPerformanceCounter(&count); QueryPerformanceFrequency(&freq);
+ return (double)count.QuadPart/freq.QuadPart;
+#else
+ struct timespec t;
+
+ clock_gettime(CLOCK_MONOTONIC,&t);
+ return t.tv_sec+1e-9*t.tv_nsec;
+#endif
+}
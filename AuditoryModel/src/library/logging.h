@@ -0,0 +1,80 @@
+/* logging.h */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+#if !defined( LOGGING_H )
+#define LOGGING_H
+
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define log_error      0
+#define log_warning    1
+#define log_info       2
+#define log_debug      3
+
+#define log_max_text   256    /* longest message (longer is truncated)  */
+
+/*********************************************************************
+   A field is one named value of a structured record: a text if text
+   is not NULL, a number otherwise.
+ *********************************************************************/
+typedef struct{
+               const char *name;
+               const char *text;
+               double      value;
+              } log_field;
+
+/*********************************************************************
+   A sink receives the messages of the model up to (and including)
+   level. The message and the fields only live during the call. The
+   sink is chosen per thread, so that analyses running at the same
+   time can each send their messages somewhere else.
+ *********************************************************************/
+typedef struct{
+               void  *context;
+               void (*message)(void *context,int level,const char *text,
+                               const log_field *fields,int nfields);
+               int    level;
+              } log_sink;
+
+extern void log_set_sink(const log_sink *sink);
+extern int  log_enabled(int level);
+#if defined(__GNUC__)
+#define log_format  __attribute__((format(printf,2,3))) /* check the arguments */
+#else
+#define log_format
+#endif
+
+extern void log_message(int level,const char *format,...) log_format;
+extern void log_record(int level,const char *text,const log_field *fields,
+                       int nfields);
+extern void log_to_stream(void *context,int level,const char *text,
+                          const log_field *fields,int nfields);
+extern double log_clock();
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !defined( LOGGING_H ) */
@@ -79,10 +79,10 @@ Exported types
 #include <command.h>
 #include <pario.h>
 
-int  nr_of_par=22;      /* nr of parameters/frame    */
-int  nspect=20;         /* nr of spectral parameters */
-int  parformat=0;       /* inputfile format (0=DSPS) */
-int  partype=8;         /* parameter type            */
+per_thread int  nr_of_par=22;      /* nr of parameters/frame    */
+per_thread int  nspect=20;         /* nr of spectral parameters */
+per_thread int  parformat=0;       /* inputfile format (0=DSPS) */
+per_thread int  partype=8;         /* parameter type            */
  
 
 double spectral_parameter(int p)
@@ -22,14 +22,16 @@
 #if !defined( PARIO_H )
 #define PARIO_H
 
+#include <command.h>
+
 #define  npar_max   80	/* maximum number of parameters/frame */
  
 typedef double parameters[npar_max+1];
  
-extern int  nr_of_par;      /* nr of parameters/frame	 */
-extern int  nspect;         /* nr of spectral parameters */
-extern int  parformat;      /* inputfile format (0=DSPS) */
-extern int  partype;        /* parameter type		 */
+extern per_thread int  nr_of_par;      /* nr of parameters/frame	 */
+extern per_thread int  nspect;         /* nr of spectral parameters */
+extern per_thread int  parformat;      /* inputfile format (0=DSPS) */
+extern per_thread int  partype;        /* parameter type		 */
  
 extern int read_frame(parameters par);
 extern void write_frame(int code,int n_per_line,parameters par); 
@@ -45,6 +45,31 @@
       Read a sample sn (byte or 12-bit word) from readfile, and
       assume it is in the range (-1,+1). The boolean LAST is set as
       soon as the last sample of the file is read
+    new_samples(bytes,xn,count) : integer
+      Read count samples into xn, as count calls of new_sample would,
+      but a block at a time for sound files and signals in memory.
+      Returns the index of the sample for which LAST is set (the
+      samples after it are 0), or -1 if the end is not reached yet.
+    set_sigioread_memory(signal,length)
+      Read the samples from signal[0..length-1] (in -1,+1) instead
+      of from a file, until the next call of set_sigioread_format.
+    set_sigioread_part(signal,length,first)
+      The same for samples first..first+length-1 of a signal (e.g.
+      a range of a sound file that was decoded already): seeking
+      takes sample first as signal[0].
+    set_sigioread_source(source)
+      The same for the samples delivered by source (see decoder.h),
+      which can only be read once: opening it again does not rewind
+      it, and seeking reads the samples and throws them away.
+    open_signal(filename), close_signal()
+      Open and close readfile, or rewind the signal in memory.
+    seek_signal(first,count)
+      Right after open_signal: continue reading at sample first and
+      read count samples at most (all of them if count<0). LAST is
+      then set after the last of these samples.
+    signal_failed()
+      Whether the reading of the sound file that was opened last
+      stopped at damaged data (see decoder.c), also after close_signal.
     write_sample(bytes,last_sample,x)
       Write a sample x (in -1,+1) to writefile. Use the byte or 12-bit
       representation. The samples are accumulated until there are
@@ -55,53 +80,46 @@
 
 #include <command.h>
 #include <sigio.h>
+#include <decoder.h>
+#include <logging.h>
 
 #define  mu  100
 
 #define  BYTE unsigned char
  
-double etab[128+1]; 
-int    ctab[2048+1];
-BYTE   rbuf[66+1];
-BYTE   tbuf[66+1];
-BYTE   wbuf[66+1];
-int    eo_rbuf=0; 
-int    unsig;
-int    size;
-int    wavefiles=0;
-int    binary;
-int    msb_first;
+per_thread double etab[128+1]; 
+per_thread int    ctab[2048+1];
+per_thread BYTE   rbuf[66+1];
+per_thread BYTE   tbuf[66+1];
+per_thread BYTE   wbuf[66+1];
+per_thread int    eo_rbuf=0; 
+per_thread int    unsig;
+per_thread int    size;
+per_thread int    decoded=0;
+per_thread decoder dec;
+per_thread int    binary;
+per_thread int    msb_first;
+per_thread const double *memsig=NULL;
+per_thread long   memlen;
+per_thread long long memfirst=0;  /* signal sample in memsig[0] */
+per_thread const decoder_source *memsrc=NULL;
+per_thread long long sigleft=-1;  /* samples left to read, -1: all */
 
 void set_sigioread_format(int format)
 /*********************************************************************
    Input file format: 0 = our sample format (.adc)
                       1 = our bytes  format (.sam)
-                      2 = wave file  format
+                      2 = sound file (wav, aiff/aifc, au/snd, flac)
                       3 = plain 16 bit format (.b16) (MSB first)
                       4 = plain  8 bit format (.b08) (MSB first)
                       5 = plain 16 bit format (.pcm) (MSB last) (=le)
-   Wave file format: (between brackets: number of bytes)
-        (4) 1. Magic word: "RIFF"
-        (4) 2. length of the file, after the magic word
-        (4) 3. Magic word 2: "wave"
-        (4) 4. Magic word 3: "fmt "  (=format)
-        (4) 5. length of the subsequent format header
-        (2) 6. filetype, 10 is PCM
-        (2) 7. nr of channels, 10 is mono
-        (4) 8. sampling rate in Hz, e.g. 0h 0h 56h 22h is 22050 Hz
-                AV: c4[0]=34 c4[1]=86 c4[2]=0 c4[3]=0 (22.56kHz: 2*16+2=34
-                en 5*16+6=86)
-        (4) 9. average number of bytes per second
-        (2) 10. block align (?)
-        (2) 11. sample width: 8 = byte, unsigned, 16 = word, 2-complement,
-                             32 = long, 2-complement
-        (4) 12. Magic word: "data"
-        (4) 13. length of the subsequent datablok
+   Sound files are read through the decoder chosen from their header
+   (see decoder.c), which mixes multichannel files down to mono.
 **********************************************************************/
 {
- wavefiles=0;
+ decoded=0; memsig=NULL; memsrc=NULL;
  switch (format)
- {case 2: wavefiles=1; break;
+ {case 2: decoded=1; break;
   case 3: binary=1; unsig=0; size=2; msb_first=1; break;
   case 5: binary=1; unsig=0; size=2; msb_first=0; break;
   case 4: binary=1; unsig=0; size=1; break;
@@ -109,6 +127,70 @@ void set_sigioread_format(int format)
  }
 }
 
+void set_sigioread_memory(const double *signal,long length)
+{
+ memsig=signal; memlen=length; memfirst=0;
+}
+
+void set_sigioread_part(const double *signal,long length,long long first)
+{
+ memsig=signal; memlen=length; memfirst=first;
+}
+
+void set_sigioread_source(const decoder_source *source)
+{
+ memsrc=source;
+}
+
+int open_signal(const char *filename)
+{
+ sigleft=-1;
+ if (memsig!=NULL) {read_ptr=0; return 1;}
+ if (memsrc!=NULL) return 1;
+ if (!open_readfile(filename)) return 0;
+ if (decoded)
+ {if (!decoder_open(&dec,readfile)) {close_readfile(); return 0;}
+  log_message(log_debug,"%s file: %d channel(s), %.0f Hz, %d bit",dec.format->name,
+         dec.channels,dec.rate,dec.bits);
+ }
+ return 1;
+}
+
+int seek_signal(long long first,long long count)
+{int    last=0;
+ double skip[1024];
+ long   k;
+
+ if (memsig!=NULL)
+ {first-=memfirst;
+  read_ptr=(first<=0) ? 0 : (first<memlen) ? (int)first : (int)memlen;
+ }
+ else if (first>0)
+ {if (memsrc!=NULL)
+  {for (;first>0;first-=k)
+   {k=(first<1024) ? (long)first : 1024;
+    if (memsrc->read(memsrc->context,skip,k)<k) break;
+   }
+  }
+  else if (decoded) {if (!decoder_seek(&dec,first)) return 0;}
+  else while ((first-->0) && !last) new_sample(0,&last);
+ }
+ sigleft=count;
+ return 1;
+}
+
+void close_signal()
+{
+ if ((memsig!=NULL) || (memsrc!=NULL)) return;
+ if (decoded) decoder_close(&dec);
+ close_readfile();
+}
+
+int signal_failed()
+{
+ return (memsig==NULL) && (memsrc==NULL) && decoded && dec.failed;
+}
+
 void startup_sigio()
 {double rx;
  int     i;
@@ -137,40 +219,6 @@ int compression(double x)
  }
 }
  
-void read_header()
-{BYTE c4[4];
- BYTE c2[2];
-
- fread(&c4,1,4,readfile); /* 1 */
- fread(&c4,1,4,readfile); /* 2 */
- fread(&c4,1,4,readfile); /* 3 */
- fread(&c4,1,4,readfile); /* 4 */
- fread(&c4,1,4,readfile); /* 5 */
- fread(&c2,1,2,readfile); /* 6 */
- fread(&c2,1,2,readfile); /* 7 */
- fread(&c4,1,4,readfile); /* 8 */
-
-printf("sampling frequency (hexa): %d %d %d %d\n",c4[0],c4[1],c4[2],c4[3]);
-
- fread(&c4,1,4,readfile); /* 9 */
- fread(&c2,1,2,readfile); /* 10 */
- fread(&c2,1,2,readfile); /* 11 */
-
-printf("sample width: %d\n",c2[0]);
-
- switch (c2[0])
- {case 8: unsig=1; size=1; break;
-  case 16: unsig=0; size=2; break;
-  case 32: unsig=0; size=4; break;
- }
- fread(&c4,1,4,readfile); /* 12 */
- fread(&c4,1,4,readfile); /* 13 */
-/*
- eo_rbuf=c4[0]+256*(c4[1]+256*(c4[2]+256*(c4[3]))) / size;
-*/
- eo_rbuf=c4[0]+256*(c4[1]+256*(c4[2]+256*(c4[3])));
-}
-
 void read_new_record()
 {int nwrd;
 
@@ -183,43 +231,9 @@ void read_new_record()
  }
 }
  
-double one_wave_sample(int *last)
-/**************************************************
- De variabele unsig wordt blijkbaar niet gebruikt,
- in tegenstelling tot de Pascal-versie.
-***************************************************/
-{BYTE c2[2];
- BYTE c1;
- BYTE c4[4];
- short signed int i;
- signed int i2;
- double x;
-
- if (!read_ptr) read_header();
- if (read_ptr>=eo_rbuf) {*last=1; return 0;}
- switch (size)
- {case 1: fread(&c1,1,size,readfile); read_ptr++;
-          i=c1; x=(double)i/256.00;
-          *last=0; return x;
-          break;
-  case 2: fread(&c2,1,size,readfile); read_ptr+=2;
-          i2=c2[1]*256+c2[0]; 
-          if (i2>=32768) i2=i2-65536;
-          x=(double)i2/32768.0;
-          *last=0; return x;
-          break;
-  case 4: fread(&c4,1,size,readfile); read_ptr+=4;
-          i2=c4[1]*256+c4[0]; x=(double)i2/65536.0;
-          i2=c4[2]+256*c4[3]; x+=i2; x=x/32768.0; if (x>=1) x=x-2; 
-          *last=0; return x;
-          break;
- }
- printf("-- Error in SIGIO (one_wave_sample), please check\n"); return 0;
-}
-
 double one_binary_sample(int *last)
-{static BYTE c2[2];
- static BYTE c1;
+{static per_thread BYTE c2[2];
+ static per_thread BYTE c1;
  BYTE c2vol[2];
  BYTE c1vol;
  short signed int i;
@@ -244,14 +258,28 @@ double one_binary_sample(int *last)
            break;
   }
  }
- printf("-- Error in SIGIO (one_binary_sample), please check\n"); return 0;
+ log_message(log_error,"unknown sample format in SIGIO (one_binary_sample)"); return 0;
 }
 
 double new_sample(int bytes,int *last)
-{int ixn;
+{int    ixn;
+ double x;
 
+ if (sigleft==0) {*last=1; return 0;}
+ if (sigleft>0) sigleft--;
+ if (memsig!=NULL)
+ {if (read_ptr>=memlen) {*last=1; return 0;}
+  *last=0; return memsig[read_ptr++];
+ }
+ if (memsrc!=NULL)
+ {*last=(memsrc->read(memsrc->context,&x,1)!=1);
+  return (*last) ? 0 : x;
+ }
  if (binary) return one_binary_sample(last);
- if (wavefiles) return one_wave_sample(last);
+ if (decoded)
+ {*last=(decoder_read(&dec,&x,1)!=1);
+  return (*last) ? 0 : x;
+ }
 
  if (read_ptr==0) read_new_record(); 
  *last=0;
@@ -265,6 +293,34 @@ double new_sample(int bytes,int *last)
  }
 }
 
+long new_samples(int bytes,double *xn,long count)
+{long k,got=-1,want=count;
+ int  last=0;
+
+ if (memsig!=NULL || memsrc!=NULL || decoded)
+ {if ((sigleft>=0) && (sigleft<count)) count=(long)sigleft;
+  if (memsig!=NULL)
+  {got=(memlen-read_ptr<count) ? memlen-read_ptr : count;
+   if (got<0) got=0;
+   memcpy(xn,memsig+read_ptr,got*sizeof(double)); read_ptr+=got;
+  }
+  else if (memsrc!=NULL) got=(count>0) ? memsrc->read(memsrc->context,xn,count) : 0;
+  else got=decoder_read(&dec,xn,count);
+  if (sigleft>=0) sigleft-=got;
+  if (got==want) return -1;
+  for (k=got;k<want;k++) xn[k]=0;
+  return got;
+ }
+ for (k=0;k<count;k++)
+ {if (last) xn[k]=0;
+  else
+  {xn[k]=new_sample(bytes,&last);
+   if (last) got=k;
+  }
+ }
+ return last ? got : -1;
+}
+
 void BYTE_substr(BYTE *resstring,const BYTE *origstring,int start,int length)
 /****************************************************************************
   This function is the same as the function substr specified in command.c, 
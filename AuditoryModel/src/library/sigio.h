@@ -22,12 +22,22 @@
 #if !defined( SIGIO_H )
 #define SIGIO_H
 
+#include <decoder.h>
+
 extern void startup_sigio();
 extern double expansion(int indx);
 extern int compression(double x);
 extern double new_sample(int bytes,int *last);
+extern long new_samples(int bytes,double *xn,long count);
 extern void write_sample(int bytes,int last,double x);
 extern void set_sigioread_format(int format);
+extern void set_sigioread_memory(const double *signal,long length);
+extern void set_sigioread_part(const double *signal,long length,long long first);
+extern void set_sigioread_source(const decoder_source *source);
+extern int open_signal(const char *filename);
+extern int seek_signal(long long first,long long count);
+extern void close_signal();
+extern int signal_failed();
 
 #endif /* !defined( SIGIO_H ) */
 
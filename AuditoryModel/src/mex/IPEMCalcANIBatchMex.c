@@ -0,0 +1,322 @@
+/***********************************************************************
+Mex gateway computing the auditory nerve images of a batch of signals:
+
+  [ANIs,ANIFreqs,FilterFreqs] = ...
+    IPEMCalcANIBatchMex(Signals,fs,nchan,uc1,duc,downsample,scale,positions,
+                        NumOfThreads)
+
+  Signals       : cell array of mono signals (row or column, double or
+                  single) in -1..+1
+  fs            : sample frequency of the signals (Hz), normally 22050:
+                  one for all, or one per signal
+  nchan, uc1, duc, downsample, scale, positions
+                : as for IPEMCalcANIMex, the same for all signals
+  NumOfThreads  : threads to use (default: one per processor)
+
+Every signal is analysed as IPEMCalcANIMex does (20 ms of silence before
+and after, frames of the silences removed, downsampling with the filter
+of resample), all in one call: the signals are handed out to a pool of
+threads, the longest first, so that the interpreter is not the limit.
+The storage of every ANI is allocated before the threads start, in the
+class of the ANI, and the threads write the columns straight into it.
+
+ANIs is a cell array of the size of Signals with the ANI of every signal
+(single if that signal is single, otherwise double), ANIFreqs an array of
+the same size with their sample frequencies (Hz) and FilterFreqs a cell
+array with the centre frequencies (Hz) of their channels (columns).
+
+*************************************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mex.h"
+#include "mexargs.h"
+#include "ipemam.h"
+#include "anisink.h"
+#include "parallel.h"
+
+#define cPadTime	0.020	/* silence added before and after the signal (s) */
+
+/* one signal of the batch */
+typedef struct
+{
+  const void* data;		/* the samples, as passed in */
+  int isSingle;
+  long length;
+  double sampleFreq;
+  anisink_buffer ANI;		/* see analysis/anisink.c */
+  anisink_writer writer;	/* to storage, then to overflow */
+  void* storage;		/* of the ANI: mxMalloc'ed, nchan x capacity */
+  long nchan;
+  long capacity;
+  void* overflow;		/* malloc'ed, the columns beyond capacity */
+  long overflowCapacity;
+  double* freqs;		/* centre frequencies of the channels (Hz) */
+  int ok;
+} BatchSignal;
+
+/* everything shared by the threads */
+typedef struct
+{
+  BatchSignal* signals;
+  ipemam_params params;		/* but the sample frequency */
+  long factor;
+} Batch;
+
+
+/* column k of the ANI of a signal (runs on a thread, so the storage is
+   not grown: columns beyond the estimate go to a malloc'ed overflow) */
+static int store_column(void* inContext, long inColumn, const double* inValues)
+{
+  BatchSignal* s = (BatchSignal*) inContext;
+  size_t theSize = s->isSingle ? sizeof(float) : sizeof(double);
+  void* theColumn;
+  long p;
+
+  if (inColumn < s->capacity) theColumn = (char*) s->storage + inColumn*s->nchan*theSize;
+  else
+  {
+    inColumn -= s->capacity;
+    if (inColumn == s->overflowCapacity)
+    {
+      theColumn = realloc(s->overflow,(2*inColumn + 16)*s->nchan*theSize);
+      if (theColumn == NULL) return 0;
+      s->overflow = theColumn;
+      s->overflowCapacity = 2*inColumn + 16;
+    }
+    theColumn = (char*) s->overflow + inColumn*s->nchan*theSize;
+  }
+  if (s->isSingle)
+    for (p = 0; p < s->nchan; p++) ((float*) theColumn)[p] = (float) inValues[p];
+  else memcpy(theColumn,inValues,s->nchan*sizeof(double));
+  return 1;
+}
+
+
+/* padding, model and downsampling of one signal (runs on a thread, so
+   with malloc instead of mxMalloc) */
+static void compute_signal(void* inContext, long inIndex)
+{
+  Batch* theBatch = (Batch*) inContext;
+  BatchSignal* s = theBatch->signals + inIndex;
+  double* theSignal;
+  ipemam_params theParams = theBatch->params;
+  ipemam_plan* thePlan;
+  ipemam_context* theContext;
+  long theNumOfZeros, theTotal, i;
+
+  s->ok = 0;
+  theNumOfZeros = (long) floor(cPadTime*s->sampleFreq + 0.5);
+  theTotal = s->length + 2*theNumOfZeros;
+  theSignal = (double*) calloc(theTotal,sizeof(double));
+  if (theSignal == NULL) return;
+  if (s->isSingle)
+    for (i = 0; i < s->length; i++) theSignal[theNumOfZeros + i] = ((const float*) s->data)[i];
+  else
+    memcpy(theSignal + theNumOfZeros,s->data,s->length*sizeof(double));
+
+  /* a context of its own for every signal, as they are of any rate */
+  theParams.fs = s->sampleFreq;
+  thePlan = ipemam_plan_create(&theParams);
+  theContext = (thePlan != NULL) ? ipemam_context_create(thePlan) : NULL;
+  ipemam_plan_destroy(thePlan);
+  if ((theContext != NULL) && (ipemam_channels(theContext) == s->nchan))
+  {
+    s->writer.context = s;
+    s->writer.column = store_column;
+    s->freqs = (double*) malloc(ipemam_channels(theContext)*sizeof(double));
+    if (s->freqs != NULL) ipemam_frequencies(theContext,s->freqs);
+    s->ok = (s->freqs != NULL)
+      && anisink_open(&s->ANI,theContext,s->sampleFreq,theTotal,theNumOfZeros,theBatch->factor,&s->writer)
+      && anisink_run(&s->ANI,theContext,theSignal,theTotal);
+  }
+  if (theContext != NULL) ipemam_context_destroy(theContext);
+  free(theSignal);
+}
+
+
+/* the channels and an estimate of the columns of every signal, from one
+   context per sample frequency, and the storage of its ANI */
+static int allocate_signals(BatchSignal* inSignals, long inCount, const Batch* inBatch)
+{
+  ipemam_params theParams = inBatch->params;
+  ipemam_plan* thePlan;
+  ipemam_context* theContext;
+  double theFrameRate = 0;
+  long theNumOfChannels = 0, theNumOfZeros, i;
+
+  theParams.fs = 0;
+  for (i = 0; i < inCount; i++)
+  {
+    BatchSignal* s = inSignals + i;
+    if (s->sampleFreq != theParams.fs)
+    {
+      theParams.fs = s->sampleFreq;
+      thePlan = ipemam_plan_create(&theParams);
+      theContext = (thePlan != NULL) ? ipemam_context_create(thePlan) : NULL;
+      ipemam_plan_destroy(thePlan);
+      if (theContext == NULL) return 0;
+      theNumOfChannels = ipemam_channels(theContext);
+      theFrameRate = ipemam_frame_rate(theContext);
+      ipemam_flush(theContext);	/* ends its (empty) analysis quietly */
+      ipemam_context_destroy(theContext);
+    }
+    theNumOfZeros = (long) floor(cPadTime*s->sampleFreq + 0.5);
+    s->nchan = theNumOfChannels;
+    s->capacity = anisink_capacity(s->sampleFreq,theFrameRate,s->length + 2*theNumOfZeros,
+				   inBatch->factor);
+    s->storage = mxMalloc(s->capacity*s->nchan*(s->isSingle ? sizeof(float) : sizeof(double)));
+  }
+  return 1;
+}
+
+
+/* the ANI of a signal, in the storage the threads filled */
+static mxArray* take_ani(BatchSignal* s)
+{
+  size_t theSize = s->isSingle ? sizeof(float) : sizeof(double);
+  long theNumOfColumns = s->ANI.ncols;
+  mxArray* theANI = mxCreateNumericMatrix(0,0,s->isSingle ? mxSINGLE_CLASS : mxDOUBLE_CLASS,mxREAL);
+
+  if (theNumOfColumns > 0)
+  {
+    s->storage = mxRealloc(s->storage,theNumOfColumns*s->nchan*theSize);
+    if (theNumOfColumns > s->capacity)
+      memcpy((char*) s->storage + s->capacity*s->nchan*theSize,s->overflow,
+	     (theNumOfColumns - s->capacity)*s->nchan*theSize);
+    mxSetData(theANI,s->storage);
+    mxSetM(theANI,s->nchan);
+    mxSetN(theANI,theNumOfColumns);
+  }
+  else mxFree(s->storage);
+  s->storage = NULL;
+  return theANI;
+}
+
+
+static void free_signals(BatchSignal* inSignals, long inCount)
+{
+  long i;
+
+  for (i = 0; i < inCount; i++)
+  {
+    anisink_close(&inSignals[i].ANI);
+    if (inSignals[i].storage != NULL) mxFree(inSignals[i].storage);
+    free(inSignals[i].overflow);
+    free(inSignals[i].freqs);
+  }
+  mxFree(inSignals);
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theNumOfSignals, theNumOfRates, theThreads = 0, i, k;
+  const mxArray* theCell;
+  char* theChannelScaleName;
+  double* theCosts;
+  BatchSignal* theSignals;
+  anisink_buffer* b;
+  Batch theBatch;
+  mxArray* theANI;
+  mxArray* theOut[3];
+
+  if (nrhs < 2)
+    mexErrMsgTxt("usage: [ANIs,ANIFreqs,FilterFreqs] = IPEMCalcANIBatchMex(Signals,fs,nchan,uc1,duc,downsample,scale,positions,NumOfThreads)");
+  if (!mxIsCell(prhs[0]))
+    mexErrMsgTxt("IPEMCalcANIBatchMex: the signals must be a cell array");
+  if (!mxIsDouble(prhs[1]) || mxIsComplex(prhs[1]))
+    mexErrMsgTxt("IPEMCalcANIBatchMex: the sample frequencies must be real doubles");
+  theNumOfSignals = (long) mxGetNumberOfElements(prhs[0]);
+  theNumOfRates = (long) mxGetNumberOfElements(prhs[1]);
+  if ((theNumOfRates != 1) && (theNumOfRates != theNumOfSignals))
+    mexErrMsgTxt("IPEMCalcANIBatchMex: give one sample frequency, or one per signal");
+
+  memset(&theBatch,0,sizeof(theBatch));
+  ipemam_params_init(&theBatch.params);
+  theBatch.factor = 1;
+  if (is_given(nrhs,prhs,2)) theBatch.params.nchan = (int32_t) mxGetScalar(prhs[2]);
+  if (is_given(nrhs,prhs,3)) theBatch.params.first_freq = mxGetScalar(prhs[3]);
+  if (is_given(nrhs,prhs,4)) theBatch.params.freq_dist = mxGetScalar(prhs[4]);
+  if (is_given(nrhs,prhs,5)) theBatch.factor = (long) mxGetScalar(prhs[5]);
+  if (theBatch.factor < 1)
+    mexErrMsgTxt("IPEMCalcANIBatchMex: the downsampling factor must be a positive integer");
+  if (is_given(nrhs,prhs,6))
+  {
+    theChannelScaleName = mxArrayToString(prhs[6]);
+    theBatch.params.scale = ipemam_scale(theChannelScaleName);
+    mxFree(theChannelScaleName);
+    if (theBatch.params.scale == -1)
+      mexErrMsgTxt("IPEMCalcANIBatchMex: the scale must be 'cbu', 'erb', 'bark' or 'hz'");
+  }
+  if (is_given(nrhs,prhs,7))
+  {
+    if (!mxIsDouble(prhs[7]) || mxIsComplex(prhs[7]))
+      mexErrMsgTxt("IPEMCalcANIBatchMex: the channel positions must be a real double vector");
+    theBatch.params.positions = mxGetPr(prhs[7]);
+    theBatch.params.npositions = (int32_t) mxGetNumberOfElements(prhs[7]);
+  }
+  if (is_given(nrhs,prhs,8)) theThreads = (long) mxGetScalar(prhs[8]);
+
+  /* the threads only read the signals, they do not touch the mxArrays */
+  theSignals = (BatchSignal*) mxCalloc(theNumOfSignals > 0 ? theNumOfSignals : 1,sizeof(BatchSignal));
+  theCosts = (double*) mxMalloc((theNumOfSignals > 0 ? theNumOfSignals : 1)*sizeof(double));
+  for (i = 0; i < theNumOfSignals; i++)
+  {
+    theCell = mxGetCell(prhs[0],i);
+    if ((theCell == NULL) || !(mxIsDouble(theCell) || mxIsSingle(theCell)) || mxIsComplex(theCell)
+	|| (mxGetM(theCell) > 1 && mxGetN(theCell) > 1))
+    {
+      mxFree(theSignals);
+      mxFree(theCosts);
+      mexErrMsgTxt("IPEMCalcANIBatchMex: every signal must be a real (mono) vector");
+    }
+    theSignals[i].data = mxGetData(theCell);
+    theSignals[i].isSingle = mxIsSingle(theCell);
+    theSignals[i].length = (long) mxGetNumberOfElements(theCell);
+    theSignals[i].sampleFreq = mxGetPr(prhs[1])[(theNumOfRates == 1) ? 0 : i];
+    if (!(theSignals[i].sampleFreq > 0))
+    {
+      mxFree(theSignals);
+      mxFree(theCosts);
+      mexErrMsgTxt("IPEMCalcANIBatchMex: the sample frequencies must be positive");
+    }
+    theCosts[i] = theSignals[i].length + 2*cPadTime*theSignals[i].sampleFreq;
+  }
+  theBatch.signals = theSignals;
+  if (!allocate_signals(theSignals,theNumOfSignals,&theBatch))
+  {
+    free_signals(theSignals,theNumOfSignals);
+    mxFree(theCosts);
+    mexErrMsgTxt("IPEMCalcANIBatchMex: the auditory model failed");
+  }
+
+  /* each signal runs in a context of its own, on one of the threads */
+  parallel_steal(theNumOfSignals,theCosts,theThreads,compute_signal,&theBatch);
+  mxFree(theCosts);
+  for (i = 0; i < theNumOfSignals; i++)
+    if (!theSignals[i].ok)
+    {
+      free_signals(theSignals,theNumOfSignals);
+      mexErrMsgTxt("IPEMCalcANIBatchMex: the auditory model failed");
+    }
+
+  theOut[0] = mxCreateCellArray(mxGetNumberOfDimensions(prhs[0]),mxGetDimensions(prhs[0]));
+  theOut[1] = mxCreateNumericArray(mxGetNumberOfDimensions(prhs[0]),mxGetDimensions(prhs[0]),
+				   mxDOUBLE_CLASS,mxREAL);
+  theOut[2] = mxCreateCellArray(mxGetNumberOfDimensions(prhs[0]),mxGetDimensions(prhs[0]));
+  for (i = 0; i < theNumOfSignals; i++)
+  {
+    b = &theSignals[i].ANI;
+    mxSetCell(theOut[0],i,take_ani(&theSignals[i]));
+    anisink_close(b);
+    mxGetPr(theOut[1])[i] = b->frame_rate/b->factor;
+    theANI = mxCreateDoubleMatrix(b->nchan,1,mxREAL);
+    memcpy(mxGetPr(theANI),theSignals[i].freqs,b->nchan*sizeof(double));
+    mxSetCell(theOut[2],i,theANI);
+  }
+  free_signals(theSignals,theNumOfSignals);
+
+  for (k = 0; k < ((nlhs < 1) ? 1 : nlhs); k++) plhs[k] = theOut[k];
+  for (; k < 3; k++) mxDestroyArray(theOut[k]);
+}
@@ -0,0 +1,179 @@
+/***********************************************************************
+Mex gateway computing an auditory nerve image directly from a signal:
+
+  [ANI,ANIFreq,FilterFreqs] = IPEMCalcANIMex(signal,fs,nchan,uc1,duc,downsample,
+                                             scale,positions)
+
+It does what IPEMCalcANI.m does with IPEMProcessAuditoryModelSafe, but
+without any files: the signal is handed to a context of libipemam (see
+ipemam.h) a block at a time, and the frames it returns are downsampled
+in memory (analysis/anisink.c), straight into the storage of the ANI.
+
+  signal      : mono signal (row or column, double or single) in -1..+1
+  fs          : sample frequency of the signal (Hz), normally 22050
+  nchan       : number of channels (default 40)
+  uc1         : first channel (cbu, default 2.0)
+  duc         : distance between channels (cbu, default 0.5)
+  downsample  : integer downsampling factor of the ANI (default 1)
+  scale       : scale of uc1, duc and positions: 'cbu' (default), 'erb',
+                'bark' or 'hz'
+  positions   : channel positions on that scale, in increasing order,
+                instead of nchan channels equally spaced from uc1 on
+
+Empty or missing arguments get their default value. Like IPEMCalcANI.m,
+the signal is surrounded by 20 ms of silence and the frames computed
+for those silences are removed again. Downsampling uses the anti-aliasing
+filter of Matlab's resample (windowed sinc, 10 zero crossings on each
+side, Kaiser window with beta 5). The ANI is single if the signal is
+single, otherwise double; ANIFreq is its sample frequency (Hz) and
+FilterFreqs the centre frequencies (Hz) of the channels (column).
+
+*************************************************************************/
+#include <math.h>
+#include <string.h>
+#include "mex.h"
+#include "mexargs.h"
+#include "ipemam.h"
+#include "anisink.h"
+
+#define cPadTime	0.020	/* silence added before and after the signal (s) */
+
+/* the storage of the ANI, filled a column at a time (see anisink.h) */
+typedef struct
+{
+  void* data;			/* mxMalloc'ed, nchan x capacity */
+  long capacity;
+  long nchan;
+  int isSingle;
+} ANIStorage;
+
+static int store_column(void* inContext, long inColumn, const double* inValues)
+{
+  ANIStorage* s = (ANIStorage*) inContext;
+  size_t theSize = s->isSingle ? sizeof(float) : sizeof(double);
+  float* theSingle;
+  long p;
+
+  if (inColumn == s->capacity)
+  {
+    s->capacity *= 2;
+    s->data = mxRealloc(s->data,s->capacity*s->nchan*theSize);
+  }
+  if (s->isSingle)
+  {
+    theSingle = (float*) s->data + inColumn*s->nchan;
+    for (p = 0; p < s->nchan; p++) theSingle[p] = (float) inValues[p];
+  }
+  else memcpy((double*) s->data + inColumn*s->nchan,inValues,s->nchan*sizeof(double));
+  return 1;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  ipemam_params theParams;
+  ipemam_plan* thePlan;
+  ipemam_context* theContext;
+  anisink_buffer theBuffer;
+  anisink_writer theWriter;
+  ANIStorage theStorage;
+  double theSampleFrequency;
+  long theLength, theNumOfZeros, theTotal, theFactor = 1, i;
+  double* theSignal;
+  int isSingle, isOK;
+  char* theChannelScaleName;
+  mxArray* theANI;
+  mxArray* theFilterFreqs;
+
+  if (nrhs < 2)
+    mexErrMsgTxt("usage: [ANI,ANIFreq,FilterFreqs] = IPEMCalcANIMex(signal,fs,nchan,uc1,duc,downsample,scale,positions)");
+  if (!(mxIsDouble(prhs[0]) || mxIsSingle(prhs[0])) || mxIsComplex(prhs[0])
+      || (mxGetM(prhs[0]) > 1 && mxGetN(prhs[0]) > 1))
+    mexErrMsgTxt("IPEMCalcANIMex: the signal must be a real (mono) vector");
+
+  theSampleFrequency = mxGetScalar(prhs[1]);
+  ipemam_params_init(&theParams);
+  theParams.fs = theSampleFrequency;
+  if (is_given(nrhs,prhs,2)) theParams.nchan = (int32_t) mxGetScalar(prhs[2]);
+  if (is_given(nrhs,prhs,3)) theParams.first_freq = mxGetScalar(prhs[3]);
+  if (is_given(nrhs,prhs,4)) theParams.freq_dist = mxGetScalar(prhs[4]);
+  if (is_given(nrhs,prhs,5)) theFactor = (long) mxGetScalar(prhs[5]);
+  if (theFactor < 1)
+    mexErrMsgTxt("IPEMCalcANIMex: the downsampling factor must be a positive integer");
+  if (is_given(nrhs,prhs,6))
+  {
+    theChannelScaleName = mxArrayToString(prhs[6]);
+    theParams.scale = ipemam_scale(theChannelScaleName);
+    mxFree(theChannelScaleName);
+    if (theParams.scale == -1)
+      mexErrMsgTxt("IPEMCalcANIMex: the scale must be 'cbu', 'erb', 'bark' or 'hz'");
+  }
+  if (is_given(nrhs,prhs,7))
+  {
+    if (!mxIsDouble(prhs[7]) || mxIsComplex(prhs[7]))
+      mexErrMsgTxt("IPEMCalcANIMex: the channel positions must be a real double vector");
+    theParams.positions = mxGetPr(prhs[7]);
+    theParams.npositions = (int32_t) mxGetNumberOfElements(prhs[7]);
+  }
+  isSingle = mxIsSingle(prhs[0]);
+
+  /* the model is fed the signal between two silences */
+  theLength = (long) mxGetNumberOfElements(prhs[0]);
+  theNumOfZeros = (long) floor(cPadTime*theSampleFrequency + 0.5);
+  theTotal = theLength + 2*theNumOfZeros;
+  theSignal = (double*) mxCalloc(theTotal,sizeof(double));
+  if (isSingle)
+    for (i = 0; i < theLength; i++)
+      theSignal[theNumOfZeros + i] = ((const float*) mxGetData(prhs[0]))[i];
+  else
+    memcpy(theSignal + theNumOfZeros,mxGetPr(prhs[0]),theLength*sizeof(double));
+
+  thePlan = ipemam_plan_create(&theParams);
+  theContext = (thePlan != NULL) ? ipemam_context_create(thePlan) : NULL;
+  ipemam_plan_destroy(thePlan);
+  if (theContext == NULL)
+  {
+    mxFree(theSignal);
+    mexErrMsgTxt("IPEMCalcANIMex: the auditory model failed");
+  }
+
+  /* Start processing */
+  theFilterFreqs = mxCreateDoubleMatrix(ipemam_channels(theContext),1,mxREAL);
+  ipemam_frequencies(theContext,mxGetPr(theFilterFreqs));
+  /* the columns go straight into the storage of the ANI, in its class */
+  theStorage.nchan = ipemam_channels(theContext);
+  theStorage.isSingle = isSingle;
+  theStorage.capacity = anisink_capacity(theSampleFrequency,ipemam_frame_rate(theContext),
+					 theTotal,theFactor);
+  theStorage.data = mxMalloc(theStorage.capacity*theStorage.nchan
+			     *(isSingle ? sizeof(float) : sizeof(double)));
+  theWriter.context = &theStorage;
+  theWriter.column = store_column;
+  isOK = anisink_open(&theBuffer,theContext,theSampleFrequency,theTotal,theNumOfZeros,theFactor,&theWriter)
+    && anisink_run(&theBuffer,theContext,theSignal,theTotal);
+  ipemam_context_destroy(theContext);
+  mxFree(theSignal);
+  if (!isOK)
+  {
+    anisink_close(&theBuffer);
+    mxFree(theStorage.data);
+    mxDestroyArray(theFilterFreqs);
+    mexErrMsgTxt("IPEMCalcANIMex: the auditory model failed");
+  }
+
+  theANI = mxCreateNumericMatrix(0,0,isSingle ? mxSINGLE_CLASS : mxDOUBLE_CLASS,mxREAL);
+  if (theBuffer.ncols > 0)
+  {
+    mxSetData(theANI,mxRealloc(theStorage.data,theBuffer.ncols*theStorage.nchan
+			       *(isSingle ? sizeof(float) : sizeof(double))));
+    mxSetM(theANI,theStorage.nchan);
+    mxSetN(theANI,theBuffer.ncols);
+  }
+  else mxFree(theStorage.data);
+
+  plhs[0] = theANI;
+  if (nlhs > 1) plhs[1] = mxCreateDoubleScalar(theBuffer.frame_rate/theBuffer.factor);
+  if (nlhs > 2) plhs[2] = theFilterFreqs;
+  else mxDestroyArray(theFilterFreqs);
+  anisink_close(&theBuffer);
+}
@@ -0,0 +1,138 @@
+/***********************************************************************
+Mex gateway to the native descriptor bank (analysis/descbank.c):
+
+  [Descriptors,DescriptorFreq] = ...
+    IPEMCalcDescriptorsMex(Signal,fs,FrameWidth,FrameStep,Mask,Freqs,
+                           RolloffFraction,ZeroTolerance,FFTSize,Window,
+                           NumOfThreads)
+
+  Signal          : a mono signal (row or column), analysed frame by
+                    frame with an FFT, or a multichannel signal (one
+                    channel per row, typically an ANI), analysed across
+                    its channels; double or single
+  fs              : sample frequency of Signal (Hz)
+  FrameWidth      : frame width (samples or columns)
+  FrameStep       : interval between successive frames (idem)
+  Mask            : bitmask of the descriptors to compute:
+                      1 = centroid (IPEMCalcCentroid, Hz)
+                      2 = centroid width (IPEMCalcCentroidWidth, Hz)
+                      4 = rolloff frequency (IPEMGetRolloff, Hz)
+                      8 = zero-crossing rate (IPEMCalcZeroCrossingRate,
+                          mono signal only)
+                     16 = crest factor (IPEMGetCrestFactor)
+                     32 = flux (IPEMCalcFlux)
+  Freqs           : centre frequencies of the channels of a multichannel
+                    signal (default 1..number of channels)
+  RolloffFraction : fraction of the total for the rolloff (default 0.85)
+  ZeroTolerance   : values below it do not count as zero crossings
+                    (default 0)
+  FFTSize, Window : as for IPEMCalcSpectrogramMex (mono signal only;
+                    default: the power of two >= FrameWidth, 'hanning')
+  NumOfThreads    : threads to use (default: one per processor)
+
+Descriptors has one row per descriptor in Mask, in the order of the
+bits, and one column per frame; DescriptorFreq is its sample frequency
+(Hz). All descriptors come from the same pass over the frames: each
+frame of a mono signal is transformed once.
+
+*************************************************************************/
+#include "mex.h"
+#include "descbank.h"
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theRows, theColumns, theWidth, theStep, theFFTSize, theFrames, theCount, i;
+  int theWindow, isMono;
+  double theFs;
+  double *theSignal = NULL, *theConverted = NULL;
+  const double *theFreqs = NULL, *theValues = NULL;
+  const float* theSingle;
+  char theName[16];
+  descbank_params theParams;
+  stft_plan thePlan;
+  mxArray* theOut[2];
+
+  if (nrhs < 5)
+    mexErrMsgTxt("usage: [Descriptors,DescriptorFreq] = IPEMCalcDescriptorsMex(Signal,fs,FrameWidth,FrameStep,Mask,Freqs,RolloffFraction,ZeroTolerance,FFTSize,Window,NumOfThreads)");
+  if (!(mxIsDouble(prhs[0]) || mxIsSingle(prhs[0])) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMCalcDescriptorsMex: the signal must be a real matrix");
+
+  theRows = (long) mxGetM(prhs[0]);
+  theColumns = (long) mxGetN(prhs[0]);
+  isMono = (theRows == 1 || theColumns == 1);
+  theFs = mxGetScalar(prhs[1]);
+  theWidth = (long) mxGetScalar(prhs[2]);
+  theStep = (long) mxGetScalar(prhs[3]);
+  theParams.mask = (int) mxGetScalar(prhs[4]) & descbank_all;
+  if (nrhs > 5 && !mxIsEmpty(prhs[5]))
+  {
+    if (!mxIsDouble(prhs[5]) || (long) mxGetNumberOfElements(prhs[5]) != theRows)
+      mexErrMsgTxt("IPEMCalcDescriptorsMex: there must be one frequency per channel");
+    theFreqs = mxGetPr(prhs[5]);
+  }
+  theParams.rolloff = (nrhs > 6 && !mxIsEmpty(prhs[6])) ? mxGetScalar(prhs[6]) : 0.85;
+  theParams.tolerance = (nrhs > 7 && !mxIsEmpty(prhs[7])) ? mxGetScalar(prhs[7]) : 0;
+  theFFTSize = (nrhs > 8 && !mxIsEmpty(prhs[8])) ? (long) mxGetScalar(prhs[8]) : 0;
+  theWindow = stft_hanning;
+  if (nrhs > 9 && !mxIsEmpty(prhs[9]))
+  {
+    if (mxIsChar(prhs[9]))
+    {
+      mxGetString(prhs[9],theName,sizeof(theName));
+      if ((theWindow = stft_window(theName)) < 0)
+        mexErrMsgTxt("IPEMCalcDescriptorsMex: unknown window type");
+    }
+    else if (mxIsDouble(prhs[9]) && (long) mxGetNumberOfElements(prhs[9]) == theWidth)
+    {
+      theWindow = stft_user;
+      theValues = mxGetPr(prhs[9]);
+    }
+    else
+      mexErrMsgTxt("IPEMCalcDescriptorsMex: the window must be a name or FrameWidth values");
+  }
+  theParams.nthreads = (nrhs > 10 && !mxIsEmpty(prhs[10])) ? (long) mxGetScalar(prhs[10]) : 0;
+  if (!isMono && (theParams.mask & descbank_zcr))
+    mexErrMsgTxt("IPEMCalcDescriptorsMex: the zero-crossing rate needs a mono signal");
+  if (theWidth < 1 || theStep < 1)
+    mexErrMsgTxt("IPEMCalcDescriptorsMex: invalid frame width or step");
+
+  /* the threads read the signal as doubles */
+  if (mxIsDouble(prhs[0]))
+    theSignal = mxGetPr(prhs[0]);
+  else
+  {
+    theSingle = (const float*) mxGetData(prhs[0]);
+    theConverted = (double*) mxMalloc(theRows*theColumns*sizeof(double));
+    for (i = 0; i < theRows*theColumns; i++) theConverted[i] = theSingle[i];
+    theSignal = theConverted;
+  }
+
+  if (isMono)
+  {
+    if (!stft_plan_open(&thePlan,theFs,theWidth,theStep,theFFTSize,theWindow,theValues))
+      mexErrMsgTxt("IPEMCalcDescriptorsMex: invalid FFT size (or out of memory)");
+    theFrames = stft_frames(&thePlan,theRows*theColumns);
+    theOut[0] = mxCreateDoubleMatrix(descbank_rows(theParams.mask),theFrames,mxREAL);
+    theCount = descbank_signal(&thePlan,theSignal,theRows*theColumns,&theParams,mxGetPr(theOut[0]));
+    stft_plan_close(&thePlan);
+  }
+  else
+  {
+    theFrames = descbank_ani_frames(theColumns,theWidth,theStep);
+    theOut[0] = mxCreateDoubleMatrix(descbank_rows(theParams.mask),theFrames,mxREAL);
+    theCount = descbank_ani(theSignal,theRows,theColumns,theFreqs,theWidth,theStep,&theParams,mxGetPr(theOut[0]));
+  }
+  if (theConverted != NULL) mxFree(theConverted);
+  if (theCount != theFrames)
+  {
+    mxDestroyArray(theOut[0]);
+    mexErrMsgTxt("IPEMCalcDescriptorsMex: out of memory");
+  }
+  theOut[1] = mxCreateDoubleScalar(theFs/theStep);
+
+  /* plhs only has room for the outputs that were asked for */
+  for (i = 0; i < 2; i++)
+    if (i < ((nlhs < 1) ? 1 : nlhs)) plhs[i] = theOut[i];
+    else mxDestroyArray(theOut[i]);
+}
@@ -0,0 +1,104 @@
+/***********************************************************************
+Mex gateway to the streaming onset detector (analysis/onset.c):
+
+  [OnsetSignal,OnsetFreq,OnsetTimes,OnsetStrengths] = ...
+    IPEMCalcOnsetsMex(ANI,ANIFreq)
+
+  ANI        : auditory nerve image (double or single, rows = channels)
+  ANIFreq    : sample frequency of the ANI (Hz)
+
+OnsetSignal and OnsetFreq are the outputs of IPEMCalcOnsetsFromANI.m,
+which calls this gateway when it is available. OnsetTimes (s) and
+OnsetStrengths list the non-zero values of OnsetSignal (row vectors).
+The ANI is fed to the detector frame by frame: none of the intermediate
+signals of the Matlab version (RMS, peaks, upsampled peaks, onset
+pattern) is ever held for the whole ANI.
+
+*************************************************************************/
+#include <string.h>
+#include "mex.h"
+#include "onset.h"
+
+#define cBlockSize	1024	/* columns converted at once from single */
+
+typedef struct
+{
+  long* index;
+  double* strength;
+  long count;
+  long capacity;
+} OnsetList;
+
+
+static void add_onset(void* inContext, long inIndex, double inStrength)
+{
+  OnsetList* theList = (OnsetList*) inContext;
+
+  if (theList->count == theList->capacity)
+  {
+    theList->capacity = (theList->capacity == 0) ? 64 : 2*theList->capacity;
+    theList->index = (long*) mxRealloc(theList->index,theList->capacity*sizeof(long));
+    theList->strength = (double*) mxRealloc(theList->strength,theList->capacity*sizeof(double));
+  }
+  theList->index[theList->count] = inIndex;
+  theList->strength[theList->count] = inStrength;
+  theList->count++;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theRows, theColumns, theLength, theDone, theBlock, i;
+  double *theBuffer, *theSignal;
+  const float* theSingle;
+  onset_state theDetector;
+  OnsetList theList;
+  mxArray* theOut[4];
+
+  if (nrhs < 2)
+    mexErrMsgTxt("usage: [OnsetSignal,OnsetFreq,OnsetTimes,OnsetStrengths] = IPEMCalcOnsetsMex(ANI,ANIFreq)");
+  if (!(mxIsDouble(prhs[0]) || mxIsSingle(prhs[0])) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMCalcOnsetsMex: the ANI must be a real matrix");
+
+  theRows = (long) mxGetM(prhs[0]);
+  theColumns = (long) mxGetN(prhs[0]);
+  memset(&theList,0,sizeof(theList));
+  if (!onset_open(&theDetector,theRows,mxGetScalar(prhs[1]),add_onset,&theList))
+    mexErrMsgTxt("IPEMCalcOnsetsMex: the sample frequency of the ANI is too low (or out of memory)");
+
+  if (mxIsDouble(prhs[0]))
+    onset_block(&theDetector,mxGetPr(prhs[0]),theColumns);
+  else
+  {
+    theSingle = (const float*) mxGetData(prhs[0]);
+    theBuffer = (double*) mxMalloc(cBlockSize*theRows*sizeof(double));
+    for (theDone = 0; theDone < theColumns; theDone += theBlock)
+    {
+      theBlock = (theColumns - theDone < cBlockSize) ? theColumns - theDone : cBlockSize;
+      for (i = 0; i < theBlock*theRows; i++) theBuffer[i] = theSingle[theDone*theRows + i];
+      onset_block(&theDetector,theBuffer,theBlock);
+    }
+    mxFree(theBuffer);
+  }
+  theLength = onset_finish(&theDetector);
+
+  theOut[0] = mxCreateDoubleMatrix(1,theLength,mxREAL);
+  theOut[1] = mxCreateDoubleScalar(theDetector.onset_fs);
+  theOut[2] = mxCreateDoubleMatrix(1,theList.count,mxREAL);
+  theOut[3] = mxCreateDoubleMatrix(1,theList.count,mxREAL);
+  theSignal = mxGetPr(theOut[0]);
+  for (i = 0; i < theList.count; i++)
+  {
+    theSignal[theList.index[i]] = theList.strength[i];
+    mxGetPr(theOut[2])[i] = theList.index[i]/theDetector.onset_fs;
+    mxGetPr(theOut[3])[i] = theList.strength[i];
+  }
+  onset_close(&theDetector);
+  mxFree(theList.index);
+  mxFree(theList.strength);
+
+  /* plhs only has room for the outputs that were asked for */
+  for (i = 0; i < 4; i++)
+    if (i < ((nlhs < 1) ? 1 : nlhs)) plhs[i] = theOut[i];
+    else mxDestroyArray(theOut[i]);
+}
@@ -0,0 +1,143 @@
+/***********************************************************************
+Mex gateway to the native STFT engine (analysis/stft.c):
+
+  [S,T,F] = IPEMCalcSpectrogramMex(Signal,fs,FrameWidth,FrameHop,FFTSize,
+                                   Window,OutputType,Decimate,NumOfThreads)
+
+  Signal        : mono signal (row or column, double or single)
+  fs            : sample frequency of the signal (Hz)
+  FrameWidth    : frame width (samples)
+  FrameHop      : interval between successive frames (samples)
+  FFTSize       : size of the FFT (>= FrameWidth, any size; 0 or empty:
+                  the power of two >= FrameWidth)
+  Window        : name of the window ('hanning' (default), 'hann',
+                  'hamming', 'blackman', 'bartlett', 'triang', 'boxcar')
+                  or a column of FrameWidth values
+  OutputType    : 'magnitude' (default) or 'db' (in any case)
+  Decimate      : frames per output column (default 1): a column holds
+                  the maximum of each bin over its frames, which gives an
+                  overview of a long signal without the full spectrogram
+  NumOfThreads  : threads to use (default: one per processor)
+
+S is a single matrix with one row per bin (0..FFTSize/2) and one column
+per output column, with magnitudes normalized as IPEMCalcSpectrogram
+does (|X|/(FrameWidth/2)) or their level in dB. T holds the start of the
+first frame of every column (s), F the frequencies of the bins (Hz).
+Frames are cut as specgram does; the complex spectrogram is never held
+in memory, and the frames are spread over the threads.
+
+*************************************************************************/
+#include <ctype.h>
+#include <string.h>
+#include "mex.h"
+#include "stft.h"
+
+#define cBlockSize	65536	/* samples converted at once from single */
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theLength, theWidth, theHop, theFFTSize, theDecimate, theThreads;
+  long theColumns, theDone, theBlock, theCount, i;
+  int theWindow, theOutput;
+  double theFs, *theBuffer, *theTimes, *theFreqs;
+  const double* theValues = NULL;
+  const float* theSingle;
+  char theName[16];
+  float* theData;
+  stft_plan thePlan;
+  stft_stream theStream;
+  mxArray* theOut[3];
+
+  if (nrhs < 4)
+    mexErrMsgTxt("usage: [S,T,F] = IPEMCalcSpectrogramMex(Signal,fs,FrameWidth,FrameHop,FFTSize,Window,OutputType,Decimate,NumOfThreads)");
+  if (!(mxIsDouble(prhs[0]) || mxIsSingle(prhs[0])) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMCalcSpectrogramMex: the signal must be a real vector");
+
+  theLength = (long) mxGetNumberOfElements(prhs[0]);
+  theFs = mxGetScalar(prhs[1]);
+  theWidth = (long) mxGetScalar(prhs[2]);
+  theHop = (long) mxGetScalar(prhs[3]);
+  theFFTSize = (nrhs > 4 && !mxIsEmpty(prhs[4])) ? (long) mxGetScalar(prhs[4]) : 0;
+  theWindow = stft_hanning;
+  if (nrhs > 5 && !mxIsEmpty(prhs[5]))
+  {
+    if (mxIsChar(prhs[5]))
+    {
+      mxGetString(prhs[5],theName,sizeof(theName));
+      if ((theWindow = stft_window(theName)) < 0)
+        mexErrMsgTxt("IPEMCalcSpectrogramMex: unknown window type");
+    }
+    else if (mxIsDouble(prhs[5]) && (long) mxGetNumberOfElements(prhs[5]) == theWidth)
+    {
+      theWindow = stft_user;
+      theValues = mxGetPr(prhs[5]);
+    }
+    else
+      mexErrMsgTxt("IPEMCalcSpectrogramMex: the window must be a name or FrameWidth values");
+  }
+  theOutput = stft_magnitude;
+  if (nrhs > 6 && !mxIsEmpty(prhs[6]))
+  {
+    if (!mxIsChar(prhs[6])) mexErrMsgTxt("IPEMCalcSpectrogramMex: OutputType must be 'magnitude' or 'db'");
+    mxGetString(prhs[6],theName,sizeof(theName));
+    for (i = 0; theName[i] != '\0'; i++) theName[i] = (char) tolower((unsigned char) theName[i]);
+    if (strcmp(theName,"db") == 0) theOutput = stft_db;
+    else if (strcmp(theName,"magnitude") != 0)
+      mexErrMsgTxt("IPEMCalcSpectrogramMex: OutputType must be 'magnitude' or 'db'");
+  }
+  theDecimate = (nrhs > 7 && !mxIsEmpty(prhs[7])) ? (long) mxGetScalar(prhs[7]) : 1;
+  theThreads = (nrhs > 8 && !mxIsEmpty(prhs[8])) ? (long) mxGetScalar(prhs[8]) : 0;
+  if (theDecimate < 1) theDecimate = 1;
+
+  if (!stft_plan_open(&thePlan,theFs,theWidth,theHop,theFFTSize,theWindow,theValues))
+    mexErrMsgTxt("IPEMCalcSpectrogramMex: invalid frame width, hop or FFT size (or out of memory)");
+  theColumns = stft_columns(&thePlan,theLength,theDecimate);
+  theOut[0] = mxCreateNumericMatrix(thePlan.nbins,theColumns,mxSINGLE_CLASS,mxREAL);
+  theData = (float*) mxGetData(theOut[0]);
+
+  if (mxIsDouble(prhs[0]))
+    theCount = stft_compute(&thePlan,mxGetPr(prhs[0]),theLength,theOutput,theDecimate,theThreads,theData);
+  else if (!stft_stream_open(&theStream,&thePlan,theOutput,theDecimate,theThreads))
+    theCount = -1;
+  else
+  {
+    /* the signal is converted (and analysed) a block at a time */
+    theSingle = (const float*) mxGetData(prhs[0]);
+    theBuffer = (double*) mxMalloc(cBlockSize*sizeof(double));
+    theCount = 0;
+    for (theDone = 0; theDone < theLength && theCount >= 0; theDone += theBlock)
+    {
+      theBlock = (theLength - theDone < cBlockSize) ? theLength - theDone : cBlockSize;
+      for (i = 0; i < theBlock; i++) theBuffer[i] = theSingle[theDone + i];
+      i = stft_stream_block(&theStream,theBuffer,theBlock,theData + theCount*thePlan.nbins);
+      theCount = (i < 0) ? -1 : theCount + i;
+    }
+    if (theCount >= 0)
+    {
+      i = stft_stream_end(&theStream,theData + theCount*thePlan.nbins);
+      theCount = (i < 0) ? -1 : theCount + i;
+    }
+    mxFree(theBuffer);
+    stft_stream_close(&theStream);
+  }
+  if (theCount != theColumns)
+  {
+    stft_plan_close(&thePlan);
+    mxDestroyArray(theOut[0]);
+    mexErrMsgTxt("IPEMCalcSpectrogramMex: out of memory");
+  }
+
+  theOut[1] = mxCreateDoubleMatrix(1,theColumns,mxREAL);
+  theOut[2] = mxCreateDoubleMatrix(thePlan.nbins,1,mxREAL);
+  theTimes = mxGetPr(theOut[1]);
+  theFreqs = mxGetPr(theOut[2]);
+  for (i = 0; i < theColumns; i++) theTimes[i] = i*theDecimate*theHop/theFs;
+  for (i = 0; i < thePlan.nbins; i++) theFreqs[i] = i*theFs/thePlan.nfft;
+  stft_plan_close(&thePlan);
+
+  /* plhs only has room for the outputs that were asked for */
+  for (i = 0; i < 3; i++)
+    if (i < ((nlhs < 1) ? 1 : nlhs)) plhs[i] = theOut[i];
+    else mxDestroyArray(theOut[i]);
+}
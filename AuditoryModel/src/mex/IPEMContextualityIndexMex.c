@@ -0,0 +1,58 @@
+/***********************************************************************
+Mex gateway to the native tonal context engine (analysis/context.c):
+
+  [Chords,ToneCenters,C1,C2,C3] = ...
+    IPEMContextualityIndexMex(PP,fs,snapshot,halfChords,halfToneCenters,extra)
+
+  PP               : periodicity pitch image (rows = periods)
+  fs               : sample frequency of PP (Hz)
+  snapshot         : column (1 based) of the chord image used for C1 and C2
+  halfChords       : half decay time of the chord image (s)
+  halfToneCenters  : half decay time of the tone center image (s)
+  extra            : number of silent columns appended to PP (default 0)
+
+The outputs are those of IPEMContextualityIndex.m, which resolves its own
+arguments (snapshot time, enlargement) and then calls this gateway when it
+is available. Both leaky integrations and the three correlation curves
+are computed in a single pass.
+
+*************************************************************************/
+#include "mex.h"
+#include "context.h"
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theRows, theColumns, theExtra = 0, theSnapShot, n;
+  mxArray* theOut[5];
+  int i;
+
+  if (nrhs < 5)
+    mexErrMsgTxt("usage: [Chords,ToneCenters,C1,C2,C3] = IPEMContextualityIndexMex(PP,fs,snapshot,halfChords,halfToneCenters,extra)");
+  if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMContextualityIndexMex: the periodicity pitch image must be a real double matrix");
+
+  theRows = (long) mxGetM(prhs[0]);
+  theColumns = (long) mxGetN(prhs[0]);
+  theSnapShot = (long) mxGetScalar(prhs[2]) - 1;
+  if ((nrhs > 5) && !mxIsEmpty(prhs[5])) theExtra = (long) mxGetScalar(prhs[5]);
+  if (theExtra < 0) theExtra = 0;
+  n = theColumns + theExtra;
+  if ((theSnapShot < 0) || (theSnapShot >= n))
+    mexErrMsgTxt("IPEMContextualityIndexMex: the snapshot lies outside the signal");
+
+  theOut[0] = mxCreateDoubleMatrix(theRows,n,mxREAL);
+  theOut[1] = mxCreateDoubleMatrix(theRows,n,mxREAL);
+  for (i = 2; i < 5; i++) theOut[i] = mxCreateDoubleMatrix(1,n,mxREAL);
+
+  if (!context_index(mxGetPr(prhs[0]),theRows,theColumns,theExtra,
+		     mxGetScalar(prhs[1]),mxGetScalar(prhs[3]),mxGetScalar(prhs[4]),
+		     theSnapShot,mxGetPr(theOut[0]),mxGetPr(theOut[1]),
+		     mxGetPr(theOut[2]),mxGetPr(theOut[3]),mxGetPr(theOut[4])))
+    mexErrMsgTxt("IPEMContextualityIndexMex: out of memory");
+
+  /* plhs only has room for the outputs that were asked for */
+  for (i = 0; i < 5; i++)
+    if (i < ((nlhs < 1) ? 1 : nlhs)) plhs[i] = theOut[i];
+    else mxDestroyArray(theOut[i]);
+}
@@ -0,0 +1,93 @@
+/***********************************************************************
+Mex gateway to the native feature bank (analysis/featbank.c):
+
+  [RMS,Flux,Envelope] = ...
+    IPEMFeatureBankMex(Signal,fs,features,width,step,attack,release)
+
+  Signal    : multichannel signal, one channel per row (double or single),
+              typically an auditory nerve image
+  fs        : sample frequency of Signal (Hz)
+  features  : bitmask of the features to compute:
+                1 = running RMS (IPEMCalcRMS)
+                2 = flux (IPEMCalcFlux)
+                4 = envelope (IPEMEnvelopeFollower)
+  width     : RMS window (samples)
+  step      : samples between RMS windows
+  attack    : envelope attack time (s)
+  release   : envelope release time (s, default attack)
+
+Outputs of features that were not asked for are empty. All features
+are computed in one pass over the signal; a single precision signal is
+converted block by block.
+
+*************************************************************************/
+#include "mex.h"
+#include "featbank.h"
+
+#define cBlockSize	1024	/* columns converted at once from single */
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theRows, theColumns, theWidth = 1, theStep = 1, theDone, theBlock, i;
+  int theMask;
+  double theAttack = 0, theRelease;
+  double *theRMS, *theFlux, *theEnvelope, *theBuffer = NULL;
+  const float* theSingle;
+  featbank_state theBank;
+  mxArray* theOut[3];
+
+  if (nrhs < 3)
+    mexErrMsgTxt("usage: [RMS,Flux,Envelope] = IPEMFeatureBankMex(Signal,fs,features,width,step,attack,release)");
+  if (!(mxIsDouble(prhs[0]) || mxIsSingle(prhs[0])) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMFeatureBankMex: the signal must be a real matrix");
+
+  theRows = (long) mxGetM(prhs[0]);
+  theColumns = (long) mxGetN(prhs[0]);
+  theMask = (int) mxGetScalar(prhs[2]);
+  if ((nrhs > 3) && !mxIsEmpty(prhs[3])) theWidth = (long) mxGetScalar(prhs[3]);
+  if ((nrhs > 4) && !mxIsEmpty(prhs[4])) theStep = (long) mxGetScalar(prhs[4]);
+  if ((nrhs > 5) && !mxIsEmpty(prhs[5])) theAttack = mxGetScalar(prhs[5]);
+  theRelease = theAttack;
+  if ((nrhs > 6) && !mxIsEmpty(prhs[6])) theRelease = mxGetScalar(prhs[6]);
+  if ((theMask & featbank_rms) && ((theWidth < 1) || (theStep < 1)))
+    mexErrMsgTxt("IPEMFeatureBankMex: the RMS width and step must be at least 1 sample");
+
+  theOut[0] = mxCreateDoubleMatrix((theMask & featbank_rms) ? theRows : 0,
+				   (theMask & featbank_rms) ? featbank_rms_frames(theColumns,theWidth,theStep) : 0,mxREAL);
+  theOut[1] = mxCreateDoubleMatrix((theMask & featbank_flux) ? 1 : 0,
+				   (theMask & featbank_flux) ? theColumns : 0,mxREAL);
+  theOut[2] = mxCreateDoubleMatrix((theMask & featbank_envelope) ? theRows : 0,
+				   (theMask & featbank_envelope) ? theColumns : 0,mxREAL);
+  theRMS = mxGetPr(theOut[0]);
+  theFlux = mxGetPr(theOut[1]);
+  theEnvelope = mxGetPr(theOut[2]);
+
+  if (!featbank_open(&theBank,theRows,theMask,mxGetScalar(prhs[1]),
+		     theWidth,theStep,theAttack,theRelease))
+    mexErrMsgTxt("IPEMFeatureBankMex: out of memory");
+
+  if (mxIsDouble(prhs[0]))
+    featbank_block(&theBank,mxGetPr(prhs[0]),theColumns,theRMS,theFlux,theEnvelope);
+  else
+  {
+    theSingle = (const float*) mxGetData(prhs[0]);
+    theBuffer = (double*) mxMalloc(cBlockSize*theRows*sizeof(double) + 1);
+    for (theDone = 0; theDone < theColumns; theDone += theBlock)
+    {
+      theBlock = (theColumns - theDone < cBlockSize) ? theColumns - theDone : cBlockSize;
+      for (i = 0; i < theBlock*theRows; i++) theBuffer[i] = theSingle[theDone*theRows + i];
+      i = featbank_block(&theBank,theBuffer,theBlock,theRMS,
+			 (theFlux != NULL) ? theFlux + theDone : NULL,
+			 (theEnvelope != NULL) ? theEnvelope + theDone*theRows : NULL);
+      if (theRMS != NULL) theRMS += i*theRows;
+    }
+    mxFree(theBuffer);
+  }
+  featbank_close(&theBank);
+
+  /* plhs only has room for the outputs that were asked for */
+  for (i = 0; i < 3; i++)
+    if (i < ((nlhs < 1) ? 1 : nlhs)) plhs[i] = theOut[i];
+    else mxDestroyArray(theOut[i]);
+}
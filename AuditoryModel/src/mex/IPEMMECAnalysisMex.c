@@ -0,0 +1,66 @@
+/***********************************************************************
+Mex gateway to the native MEC analysis (analysis/mec.c):
+
+  Values = IPEMMECAnalysisMex(Signal,MinPeriod,MaxPeriod,StepSize,...
+                              ValuesFreq,HalfDecayTime,NumOfThreads)
+
+  Signal         : (multi-channel) signal, one channel per row
+  MinPeriod      : minimum period (samples)
+  MaxPeriod      : maximum period (samples)
+  StepSize       : interval between evaluations (samples)
+  ValuesFreq     : sample frequency of the values (Hz)
+  HalfDecayTime  : half decay time of the leaky integration (s, 0 for none)
+  NumOfThreads   : threads to use (default: one per processor)
+
+Values is the cell array outValues of IPEMMECAnalysis.m, which converts
+its arguments to samples and then calls this gateway when it is
+available. The channels are analysed in parallel.
+
+*************************************************************************/
+#include "mex.h"
+#include "mec.h"
+#include "context.h"
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theChannels, theLength, theMinPeriod, theMaxPeriod, theStepSize;
+  long theFrames, theThreads = 0, c;
+  double theCoef;
+  double** theValues;
+  mxArray* theCell;
+  mxArray* theMatrix;
+
+  if (nrhs < 6)
+    mexErrMsgTxt("usage: Values = IPEMMECAnalysisMex(Signal,MinPeriod,MaxPeriod,StepSize,ValuesFreq,HalfDecayTime,NumOfThreads)");
+  if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMMECAnalysisMex: the signal must be a real double matrix");
+
+  theChannels = (long) mxGetM(prhs[0]);
+  theLength = (long) mxGetN(prhs[0]);
+  theMinPeriod = (long) mxGetScalar(prhs[1]);
+  theMaxPeriod = (long) mxGetScalar(prhs[2]);
+  theStepSize = (long) mxGetScalar(prhs[3]);
+  theCoef = context_coef(mxGetScalar(prhs[4]),mxGetScalar(prhs[5]));
+  if ((nrhs > 6) && !mxIsEmpty(prhs[6])) theThreads = (long) mxGetScalar(prhs[6]);
+  if ((theMinPeriod < 0) || (theMaxPeriod < theMinPeriod) || (theStepSize < 1))
+    mexErrMsgTxt("IPEMMECAnalysisMex: invalid periods or step size");
+
+  /* all outputs are allocated here: the threads do not call Matlab */
+  theFrames = mec_frames(theLength,theStepSize);
+  theCell = mxCreateCellMatrix(theChannels,1);
+  theValues = (double**) mxMalloc((theChannels+1)*sizeof(double*));
+  for (c = 0; c < theChannels; c++)
+  {
+    theMatrix = mxCreateDoubleMatrix(theMaxPeriod-theMinPeriod+1,theFrames,mxREAL);
+    theValues[c] = mxGetPr(theMatrix);
+    mxSetCell(theCell,c,theMatrix);
+  }
+
+  if (!mec_analysis(mxGetPr(prhs[0]),theChannels,theLength,theMinPeriod,theMaxPeriod,
+		    theStepSize,theCoef,theValues,theThreads))
+    mexErrMsgTxt("IPEMMECAnalysisMex: out of memory");
+  mxFree(theValues);
+
+  plhs[0] = theCell;
+}
@@ -0,0 +1,77 @@
+/***********************************************************************
+Mex gateway to the native MEC pattern extraction (analysis/mecsynth.c):
+
+  Patterns = IPEMMECExtractPatternsMex(Signal,StepSize,PatternLengths,...
+                                       TimeIndices,MaxLength,Rescale)
+
+  Signal          : (multi-channel) signal that was analysed, one channel
+                    per row
+  StepSize        : interval between the analysis moments (samples)
+  PatternLengths  : lengths of the patterns (samples), one row per channel
+                    and one column per element of TimeIndices
+  TimeIndices     : analysis moments to extract the patterns at (1 based,
+                    the columns of the output of IPEMMECAnalysis)
+  MaxLength       : rows of the patterns (the longest period, in samples)
+  Rescale         : if non-zero, every pattern is rescaled between 0 and 1
+
+Patterns is a cell array with, for every channel, a MaxLength x
+length(TimeIndices) matrix holding the patterns at those moments (zero
+padded), as the columns TimeIndices of the output of
+IPEMMECExtractPatterns.m, which calls this gateway when it is available.
+Only the moments asked for are extracted.
+
+*************************************************************************/
+#include "mex.h"
+#include "mecsynth.h"
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theChannels, theLength, theStepSize, theMoments, theMaxLength, thePatternLength;
+  long theMoment, c, i;
+  int theRescale;
+  const double *theLengths, *theIndices;
+  mxArray* theCell;
+  mxArray* theMatrix;
+
+  if (nrhs < 5)
+    mexErrMsgTxt("usage: Patterns = IPEMMECExtractPatternsMex(Signal,StepSize,PatternLengths,TimeIndices,MaxLength,Rescale)");
+  if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]))
+    mexErrMsgTxt("IPEMMECExtractPatternsMex: the signal must be a real double matrix");
+
+  theChannels = (long) mxGetM(prhs[0]);
+  theLength = (long) mxGetN(prhs[0]);
+  theStepSize = (long) mxGetScalar(prhs[1]);
+  theMoments = (long) mxGetNumberOfElements(prhs[3]);
+  theMaxLength = (long) mxGetScalar(prhs[4]);
+  theRescale = ((nrhs > 5) && !mxIsEmpty(prhs[5])) ? (mxGetScalar(prhs[5]) != 0) : 0;
+  if (!mxIsDouble(prhs[2]) || !mxIsDouble(prhs[3]) ||
+      (long) mxGetNumberOfElements(prhs[2]) != theChannels*theMoments)
+    mexErrMsgTxt("IPEMMECExtractPatternsMex: there must be one pattern length per channel and time index");
+  if ((theStepSize < 1) || (theMaxLength < 0))
+    mexErrMsgTxt("IPEMMECExtractPatternsMex: invalid step size or maximum length");
+  theLengths = mxGetPr(prhs[2]);
+  theIndices = mxGetPr(prhs[3]);
+
+  theCell = mxCreateCellMatrix(theChannels,1);
+  for (c = 0; c < theChannels; c++)
+  {
+    theMatrix = mxCreateDoubleMatrix(theMaxLength,theMoments,mxREAL);
+    for (i = 0; i < theMoments; i++)
+    {
+      theMoment = (long) theIndices[i] - 1;
+      thePatternLength = (long) theLengths[i*theChannels + c];
+      if ((theMoment < 0) || (thePatternLength < 0) || (thePatternLength > theMaxLength))
+      {
+        mxDestroyArray(theCell);
+        mxDestroyArray(theMatrix);
+        mexErrMsgTxt("IPEMMECExtractPatternsMex: time index or pattern length out of range");
+      }
+      mecsynth_extract(mxGetPr(prhs[0]) + c,theChannels,theLength,theStepSize,theMoment,
+                       thePatternLength,theRescale,mxGetPr(theMatrix) + i*theMaxLength);
+    }
+    mxSetCell(theCell,c,theMatrix);
+  }
+
+  plhs[0] = theCell;
+}
@@ -0,0 +1,114 @@
+/***********************************************************************
+Mex gateway to the native MEC resynthesis (analysis/mecsynth.c):
+
+  [Sound,IndividualSounds] = ...
+    IPEMMECSynthesisMex(Patterns,PatternFreq,OutputFreq,NumOfSamples,...
+                        NoiseBands,NoisePeriod,NoiseLevel,EnhanceContrast,...
+                        Seed,NumOfThreads)
+
+  Patterns         : cell array with the pattern (vector) of every channel
+  PatternFreq      : sample frequency of the patterns (Hz)
+  OutputFreq       : sample frequency of the output (Hz)
+  NumOfSamples     : length of the output (samples)
+  NoiseBands       : noise band of every channel (Hz), one row per channel
+                     with the low and high frequency (default: 0 to
+                     OutputFreq/2 for all channels)
+  NoisePeriod      : samples of noise computed per channel and repeated
+                     (default: NumOfSamples)
+  NoiseLevel       : level of the noise of every channel (dB, as in
+                     IPEMAdaptLevel, default -20)
+  EnhanceContrast  : if non-zero, the patterns are reshaped as
+                     ((P/max(abs(P))).^3)*max(abs(P))
+  Seed             : selects the random phases of the noise (default 0)
+  NumOfThreads     : threads to use (default: one per processor)
+
+Sound (1 x NumOfSamples) is the sum of the channels, IndividualSounds
+(channels x NumOfSamples, only computed when asked for) the channels
+themselves: the noise of a channel modulated by its repeated pattern,
+linearly interpolated to OutputFreq, as in IPEMMECSynthesis.m, which
+calls this gateway when it is available and adapts the level of Sound.
+The noise is one inverse FFT per channel; the output is computed in
+blocks, in parallel.
+
+*************************************************************************/
+#include <math.h>
+#include "mex.h"
+#include "mecsynth.h"
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theChannels, theSamples, thePeriod, theThreads, c, i;
+  int theContrast;
+  double thePatternFreq, theOutputFreq, theLevel, *theBands;
+  unsigned long theSeed;
+  const mxArray* thePattern;
+  mecsynth_pattern* thePatterns;
+  mecsynth_noise theNoise;
+  mxArray* theOut[2];
+
+  if (nrhs < 4)
+    mexErrMsgTxt("usage: [Sound,IndividualSounds] = IPEMMECSynthesisMex(Patterns,PatternFreq,OutputFreq,NumOfSamples,NoiseBands,NoisePeriod,NoiseLevel,EnhanceContrast,Seed,NumOfThreads)");
+  if (!mxIsCell(prhs[0]))
+    mexErrMsgTxt("IPEMMECSynthesisMex: the patterns must be a cell array");
+
+  theChannels = (long) mxGetNumberOfElements(prhs[0]);
+  thePatternFreq = mxGetScalar(prhs[1]);
+  theOutputFreq = mxGetScalar(prhs[2]);
+  theSamples = (long) mxGetScalar(prhs[3]);
+  thePeriod = ((nrhs > 5) && !mxIsEmpty(prhs[5])) ? (long) mxGetScalar(prhs[5]) : theSamples;
+  theLevel = ((nrhs > 6) && !mxIsEmpty(prhs[6])) ? mxGetScalar(prhs[6]) : -20;
+  theContrast = ((nrhs > 7) && !mxIsEmpty(prhs[7])) ? (mxGetScalar(prhs[7]) != 0) : 0;
+  theSeed = ((nrhs > 8) && !mxIsEmpty(prhs[8])) ? (unsigned long) mxGetScalar(prhs[8]) : 0;
+  theThreads = ((nrhs > 9) && !mxIsEmpty(prhs[9])) ? (long) mxGetScalar(prhs[9]) : 0;
+  if ((theChannels < 1) || (thePatternFreq <= 0) || (theOutputFreq <= 0) || (theSamples < 0))
+    mexErrMsgTxt("IPEMMECSynthesisMex: invalid patterns, sample frequencies or length");
+  if (thePeriod < 1) thePeriod = (theSamples > 0) ? theSamples : 1;
+
+  /* the noise bands, as a channels x 2 matrix */
+  theBands = (double*) mxMalloc(2*theChannels*sizeof(double));
+  if ((nrhs > 4) && !mxIsEmpty(prhs[4]))
+  {
+    if (!mxIsDouble(prhs[4]) || (long) mxGetNumberOfElements(prhs[4]) != 2*theChannels)
+      mexErrMsgTxt("IPEMMECSynthesisMex: there must be one noise band per channel");
+    for (i = 0; i < 2*theChannels; i++) theBands[i] = mxGetPr(prhs[4])[i];
+  }
+  else
+    for (c = 0; c < theChannels; c++)
+    {
+      theBands[c] = 0;
+      theBands[theChannels + c] = theOutputFreq/2;
+    }
+
+  thePatterns = (mecsynth_pattern*) mxMalloc(theChannels*sizeof(mecsynth_pattern));
+  for (c = 0; c < theChannels; c++)
+  {
+    thePattern = mxGetCell(prhs[0],c);
+    thePatterns[c].values = NULL;
+    thePatterns[c].length = 0;
+    thePatterns[c].norm = 0;
+    if ((thePattern == NULL) || mxIsEmpty(thePattern)) continue;
+    if (!mxIsDouble(thePattern) || mxIsComplex(thePattern))
+      mexErrMsgTxt("IPEMMECSynthesisMex: the patterns must be real double vectors");
+    thePatterns[c].values = mxGetPr(thePattern);
+    thePatterns[c].length = (long) mxGetNumberOfElements(thePattern);
+    for (i = 0; i < thePatterns[c].length; i++)
+      if (fabs(thePatterns[c].values[i]) > thePatterns[c].norm)
+        thePatterns[c].norm = fabs(thePatterns[c].values[i]);
+  }
+
+  if (!mecsynth_noise_open(&theNoise,theChannels,theBands,theOutputFreq,thePeriod,theLevel,theSeed))
+    mexErrMsgTxt("IPEMMECSynthesisMex: out of memory");
+  mxFree(theBands);
+
+  /* all outputs are allocated here: the threads do not call Matlab */
+  theOut[0] = mxCreateDoubleMatrix(1,theSamples,mxREAL);
+  theOut[1] = (nlhs > 1) ? mxCreateDoubleMatrix(theChannels,theSamples,mxREAL) : NULL;
+  mecsynth_render_all(&theNoise,thePatterns,thePatternFreq/theOutputFreq,theContrast,theSamples,
+                      mxGetPr(theOut[0]),(theOut[1] != NULL) ? mxGetPr(theOut[1]) : NULL,theThreads);
+  mecsynth_noise_close(&theNoise);
+  mxFree(thePatterns);
+
+  plhs[0] = theOut[0];
+  if (nlhs > 1) plhs[1] = theOut[1];
+}
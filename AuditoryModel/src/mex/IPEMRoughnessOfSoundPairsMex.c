@@ -0,0 +1,453 @@
+/***********************************************************************
+Mex gateway computing the roughness of all pairs of a set of sounds:
+
+  [Roughness,RoughnessFreq,Clipping] = ...
+    IPEMRoughnessOfSoundPairsMex(Sounds,fs,Checkpoint,NumOfThreads)
+
+  Sounds        : the sounds, one per row (all of the same length)
+  fs            : sample frequency of the sounds (Hz), normally 22050
+  Checkpoint    : file in which finished pairs are kept (default: none)
+  NumOfThreads  : threads to use (default: one per processor)
+
+For every pair i <= j, the sounds are mixed as in IPEMRoughnessOfSoundPairs.m
+(both adapted to -20 dB, and the mix as well), the auditory nerve image
+of the mix is computed in memory as by IPEMCalcANI (40 channels from 2 cbu
+every 0.5 cbu, downsampled by 4) and its roughness as by IPEMRoughnessFFT
+(frames of 0.2 s every 0.02 s). The pairs are handed out to a pool of
+threads; the weights, window and FFT tables of the roughness are set up
+once and shared by all of them (analysis/roughness.c).
+
+Roughness(i,j,:) = Roughness(j,i,:) is the roughness of the mix of sounds
+i and j, RoughnessFreq its sample frequency (Hz), and Clipping(i,j) 1 if
+the mix exceeds -1..+1.
+
+If a checkpoint file is given, the roughness of each pair is appended to it
+as soon as it is known. When the gateway is called again with the same
+file (and the same sounds, which is checked with their SHA-256), the pairs
+found there are not computed again, so that an interrupted batch resumes
+where it stopped.
+
+*************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mex.h"
+#include "mexargs.h"
+#include "ipemam.h"
+#include "anisink.h"
+#include "anicache.h"
+#include "roughness.h"
+#include "parallel.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#define cNumOfChannels	40		/* model parameters of IPEMCalcANI */
+#define cFirstCBU	2.0
+#define cCBUStep	0.5
+#define cFactor		4		/* downsampling of the ANI */
+#define cPadTime	0.020		/* silence added before and after the mix (s) */
+#define cFrameWidth	0.2		/* frames of IPEMRoughnessFFT (s) */
+#define cFrameStep	0.02
+#define cLevel		-20.0		/* level of the sounds and the mix (dB) */
+#define cPairsPerThread	4		/* pairs per thread between checkpoints */
+
+static const char cMagic[8] = {'I','P','E','M','R','P','C','1'};
+
+/* one pair that is being computed */
+typedef struct
+{
+  long first, second;
+  int clipping;
+  int ok;
+  long numOfFrames;
+  double* roughness;
+  long capacity;		/* values allocated in roughness */
+  long numOfChannels;		/* of the ANI (for the first pair) */
+  double ANIFreq;
+} PairResult;
+
+/* everything shared by the threads */
+typedef struct
+{
+  const double* sounds;		/* numOfSounds x length, one sound after another */
+  const double* gains;		/* to -20 dB */
+  long length;
+  double sampleFreq;
+  const roughness_plan* plan;	/* NULL for the very first pair */
+  PairResult* results;
+} PairBatch;
+
+/* checkpoint header */
+typedef struct
+{
+  double numOfSounds, length, sampleFreq;
+  anicache_key key;
+  double numOfChannels, ANIFreq, numOfFrames, roughnessFreq;
+} Checkpoint;
+
+
+/* 10^(dB/20)/RMS, as IPEMAdaptLevel */
+static double level_gain(const double* inSignal, long inLength)
+{
+  double theSum = 0;
+  long i;
+
+  for (i = 0; i < inLength; i++) theSum += inSignal[i]*inSignal[i];
+  return pow(10,cLevel/20 - log10(sqrt(theSum/inLength)));
+}
+
+
+/* mix, model and roughness of one pair (runs on a thread) */
+static void compute_pair(void* inContext, long inIndex)
+{
+  PairBatch* theBatch = (PairBatch*) inContext;
+  PairResult* r = theBatch->results + inIndex;
+  long theLength = theBatch->length, i;
+  const double* s1 = theBatch->sounds + r->first*theLength;
+  const double* s2 = theBatch->sounds + r->second*theLength;
+  double g1 = theBatch->gains[r->first], g2 = theBatch->gains[r->second];
+  double* theMix;
+  double theGain;
+  roughness_plan thePlan;
+  const roughness_plan* p = theBatch->plan;
+  anisink_buffer theBuffer;
+  ipemam_params theParams;
+  ipemam_plan* theModel;
+  ipemam_context* theContext;
+  long theZeros, theTotal;
+  int isOK;
+
+  r->ok = 0;
+  memset(&theBuffer,0,sizeof(theBuffer));
+  theZeros = (long) floor(cPadTime*theBatch->sampleFreq + 0.5);
+  theMix = (double*) calloc(theLength + 2*theZeros,sizeof(double));
+  if (theMix == NULL) return;
+
+  for (i = 0; i < theLength; i++) theMix[theZeros + i] = g1*s1[i] + g2*s2[i];
+  theGain = level_gain(theMix + theZeros,theLength);
+  r->clipping = 0;
+  for (i = 0; i < theLength; i++)
+  {
+    theMix[theZeros + i] *= theGain;
+    if (fabs(theMix[theZeros + i]) > 1) r->clipping = 1;
+  }
+
+  theTotal = theLength + 2*theZeros;
+  ipemam_params_init(&theParams);
+  theParams.nchan = cNumOfChannels;
+  theParams.first_freq = cFirstCBU;
+  theParams.freq_dist = cCBUStep;
+  theParams.fs = theBatch->sampleFreq;
+  theModel = ipemam_plan_create(&theParams);
+  theContext = (theModel != NULL) ? ipemam_context_create(theModel) : NULL;
+  ipemam_plan_destroy(theModel);
+  isOK = (theContext != NULL)
+    && anisink_open(&theBuffer,theContext,theBatch->sampleFreq,theTotal,theZeros,cFactor,NULL)
+    && anisink_run(&theBuffer,theContext,theMix,theTotal);
+  ipemam_context_destroy(theContext);
+  if (isOK)
+  {
+    r->numOfChannels = theBuffer.nchan;
+    r->ANIFreq = theBuffer.frame_rate/cFactor;
+    if (p == NULL && roughness_plan_open(&thePlan,r->numOfChannels,r->ANIFreq,cFrameWidth,cFrameStep))
+      p = &thePlan;
+    if (p != NULL)
+    {
+      r->numOfFrames = roughness_frames(p,theBuffer.ncols);
+      if (r->roughness == NULL) r->roughness = (double*) malloc((r->numOfFrames+1)*sizeof(double));
+      else if (r->numOfFrames >= r->capacity) r->numOfFrames = -1;
+      r->ok = (r->roughness != NULL) && (r->numOfFrames >= 0)
+	&& roughness_compute(p,theBuffer.ani,theBuffer.ncols,r->roughness,NULL,NULL);
+    }
+    if (p == &thePlan) roughness_plan_close(&thePlan);
+  }
+  anisink_close(&theBuffer);
+  free(theMix);
+}
+
+
+static int write_record(FILE* inFile, long inFirst, long inSecond, int inClipping,
+			const double* inRoughness, long inStride, long inNumOfFrames)
+{
+  double theValue;
+  long f;
+
+  theValue = inFirst; fwrite(&theValue,sizeof(double),1,inFile);
+  theValue = inSecond; fwrite(&theValue,sizeof(double),1,inFile);
+  theValue = inClipping; fwrite(&theValue,sizeof(double),1,inFile);
+  for (f = 0; f < inNumOfFrames; f++) fwrite(inRoughness + f*inStride,sizeof(double),1,inFile);
+  return (fflush(inFile) == 0) && !ferror(inFile);
+}
+
+
+/* Write the checkpoint anew to <name>.tmp and move it over the old one,
+   so that the pairs already finished survive an interruption */
+static int rewrite_checkpoint(const char* inFileName, const Checkpoint* inHeader,
+			      const char* inDone, const long* inFirst, const long* inSecond,
+			      long inNumOfPairs, long inNumOfSounds, const double* inRoughness,
+			      const double* inClipping, long inNumOfFrames)
+{
+  char theName[1024+4];		/* inFileName has at most 1023 characters */
+  FILE* theFile;
+  long k, n;
+  int isOK;
+
+  sprintf(theName,"%s.tmp",inFileName);
+  theFile = fopen(theName,"wb");
+  if (theFile == NULL) return 0;
+  isOK = (fwrite(cMagic,1,8,theFile) == 8) && (fwrite(inHeader,sizeof(Checkpoint),1,theFile) == 1);
+  for (k = 0; isOK && (k < inNumOfPairs); k++)
+    if (inDone[k])
+    {
+      n = inFirst[k] + inSecond[k]*inNumOfSounds;
+      isOK = write_record(theFile,inFirst[k],inSecond[k],(int) inClipping[n],
+			  inRoughness + n,inNumOfSounds*inNumOfSounds,inNumOfFrames);
+    }
+  if (fclose(theFile) != 0) isOK = 0;
+#if defined(_WIN32)
+  isOK = isOK && (MoveFileExA(theName,inFileName,MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+  isOK = isOK && (rename(theName,inFileName) == 0);
+#endif
+  if (!isOK) remove(theName);
+  return isOK;
+}
+
+
+static void store_pair(double* outRoughness, double* outClipping, long inNumOfSounds,
+		       long inFirst, long inSecond, int inClipping,
+		       const double* inRoughness, long inNumOfFrames)
+{
+  long f, n2 = inNumOfSounds*inNumOfSounds;
+
+  for (f = 0; f < inNumOfFrames; f++)
+  {
+    outRoughness[inFirst + inSecond*inNumOfSounds + f*n2] = inRoughness[f];
+    outRoughness[inSecond + inFirst*inNumOfSounds + f*n2] = inRoughness[f];
+  }
+  outClipping[inFirst + inSecond*inNumOfSounds] = inClipping;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  long theNumOfSounds, theLength, theNumOfPairs, theThreads = 0, theBatchSize;
+  long theDone = 0, theNext, theCount, theFrames, i, j, k;
+  size_t theRecordSize, theRead;
+  double theSampleFreq;
+  double* theSounds;
+  double* theGains;
+  double* theRoughness;
+  double* theClipping;
+  double* theRecord;
+  char* isDone;
+  long* theFirst;
+  long* theSecond;
+  char theFileName[1024] = "";
+  char theMagic[8];
+  FILE* theFile = NULL;
+  int isRewritten = 1;
+  Checkpoint theHeader, theOld;
+  anicache_hash theHash;
+  roughness_plan thePlan;
+  PairBatch theBatch;
+  PairResult* theResults;
+  mwSize theDims[3];
+  mxArray* theOut[3];
+
+  if (nrhs < 2)
+    mexErrMsgTxt("usage: [Roughness,RoughnessFreq,Clipping] = IPEMRoughnessOfSoundPairsMex(Sounds,fs,Checkpoint,NumOfThreads)");
+  if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || mxIsEmpty(prhs[0]))
+    mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the sounds must be a real double matrix");
+  theNumOfSounds = (long) mxGetM(prhs[0]);
+  theLength = (long) mxGetN(prhs[0]);
+  theSampleFreq = mxGetScalar(prhs[1]);
+  if (is_given(nrhs,prhs,2)
+      && (!mxIsChar(prhs[2]) || (mxGetString(prhs[2],theFileName,sizeof(theFileName)) != 0)))
+    mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: invalid checkpoint file name");
+  if (is_given(nrhs,prhs,3)) theThreads = (long) mxGetScalar(prhs[3]);
+  if (theThreads <= 0) theThreads = parallel_processors();
+
+  /* one sound after another, and their gains */
+  theSounds = (double*) mxMalloc(theNumOfSounds*theLength*sizeof(double));
+  theGains = (double*) mxMalloc(theNumOfSounds*sizeof(double));
+  for (i = 0; i < theNumOfSounds; i++)
+  {
+    for (k = 0; k < theLength; k++)
+      theSounds[i*theLength + k] = mxGetPr(prhs[0])[i + k*theNumOfSounds];
+    theGains[i] = level_gain(theSounds + i*theLength,theLength);
+    if (!mxIsFinite(theGains[i]))
+      mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the sounds must not be silent");
+  }
+
+  memset(&theHeader,0,sizeof(theHeader));
+  theHeader.numOfSounds = theNumOfSounds;
+  theHeader.length = theLength;
+  theHeader.sampleFreq = theSampleFreq;
+  anicache_hash_init(&theHash);
+  anicache_hash_add(&theHash,theSounds,theNumOfSounds*theLength*sizeof(double));
+  anicache_hash_add(&theHash,&theSampleFreq,sizeof(double));
+  anicache_hash_final(&theHash,theHeader.key);
+
+  /* the pairs, in the order of IPEMRoughnessOfSoundPairs.m */
+  theNumOfPairs = theNumOfSounds*(theNumOfSounds+1)/2;
+  theFirst = (long*) mxMalloc(theNumOfPairs*sizeof(long));
+  theSecond = (long*) mxMalloc(theNumOfPairs*sizeof(long));
+  isDone = (char*) mxCalloc(theNumOfPairs,1);
+  for (i = 0, k = 0; i < theNumOfSounds; i++)
+    for (j = i; j < theNumOfSounds; j++, k++) { theFirst[k] = i; theSecond[k] = j; }
+
+  theBatchSize = cPairsPerThread*theThreads;
+  theResults = (PairResult*) mxCalloc(theBatchSize,sizeof(PairResult));
+  theBatch.sounds = theSounds;
+  theBatch.gains = theGains;
+  theBatch.length = theLength;
+  theBatch.sampleFreq = theSampleFreq;
+  theBatch.plan = NULL;
+  theBatch.results = theResults;
+
+  /* an existing checkpoint must be one of the same sounds */
+  if (theFileName[0] != '\0') theFile = fopen(theFileName,"rb");
+  if (theFile != NULL)
+  {
+    if ((fread(theMagic,1,8,theFile) != 8) || (memcmp(theMagic,cMagic,8) != 0)
+	|| (fread(&theOld,sizeof(theOld),1,theFile) != 1))
+    {
+      fclose(theFile);
+      mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the checkpoint file is not valid");
+    }
+    if ((theOld.numOfSounds != theHeader.numOfSounds) || (theOld.length != theHeader.length)
+	|| (theOld.sampleFreq != theHeader.sampleFreq)
+	|| (memcmp(theOld.key,theHeader.key,anicache_keylen) != 0))
+    {
+      fclose(theFile);
+      mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the checkpoint file belongs to other sounds");
+    }
+    theHeader = theOld;
+  }
+  else
+  {
+    /* the first pair gives the size of the output */
+    theResults[0].first = theFirst[0];
+    theResults[0].second = theSecond[0];
+    compute_pair(&theBatch,0);
+    if (!theResults[0].ok)
+    {
+      free(theResults[0].roughness);
+      mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the auditory model failed");
+    }
+    theHeader.numOfChannels = theResults[0].numOfChannels;
+    theHeader.ANIFreq = theResults[0].ANIFreq;
+    theHeader.numOfFrames = theResults[0].numOfFrames;
+  }
+  theFrames = (long) theHeader.numOfFrames;
+  if (!roughness_plan_open(&thePlan,(long) theHeader.numOfChannels,theHeader.ANIFreq,cFrameWidth,cFrameStep))
+  {
+    if (theFile != NULL) fclose(theFile);
+    free(theResults[0].roughness);
+    mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: out of memory");
+  }
+  theHeader.roughnessFreq = roughness_rate(&thePlan);
+  theBatch.plan = &thePlan;
+
+  theDims[0] = theNumOfSounds; theDims[1] = theNumOfSounds; theDims[2] = theFrames;
+  theOut[0] = mxCreateNumericArray(3,theDims,mxDOUBLE_CLASS,mxREAL);
+  theOut[1] = mxCreateDoubleScalar(theHeader.roughnessFreq);
+  theOut[2] = mxCreateDoubleMatrix(theNumOfSounds,theNumOfSounds,mxREAL);
+  theRoughness = mxGetPr(theOut[0]);
+  theClipping = mxGetPr(theOut[2]);
+
+  if (theFile != NULL)
+  {
+    /* the pairs found in the checkpoint; a record cut off by an
+       interruption is dropped by writing the checkpoint anew */
+    theRecordSize = theFrames + 3;
+    theRecord = (double*) mxMalloc(theRecordSize*sizeof(double));
+    isRewritten = 0;
+    while ((theRead = fread(theRecord,sizeof(double),theRecordSize,theFile)) == theRecordSize)
+    {
+      i = (long) theRecord[0]; j = (long) theRecord[1];
+      if ((i < 0) || (i > j) || (j >= theNumOfSounds)) break;
+      k = i*theNumOfSounds - i*(i-1)/2 + (j - i);
+      store_pair(theRoughness,theClipping,theNumOfSounds,i,j,(int) theRecord[2],theRecord + 3,theFrames);
+      if (!isDone[k]) theDone++;
+      isDone[k] = 1;
+    }
+    if (theRead != 0) isRewritten = 1;
+    fclose(theFile);
+    mxFree(theRecord);
+  }
+  else
+  {
+    store_pair(theRoughness,theClipping,theNumOfSounds,theFirst[0],theSecond[0],
+	       theResults[0].clipping,theResults[0].roughness,theFrames);
+    free(theResults[0].roughness);
+    isDone[0] = 1;
+    theDone = 1;
+  }
+  for (k = 0; k < theBatchSize; k++)
+  {
+    theResults[k].roughness = (double*) mxMalloc((theFrames+1)*sizeof(double));
+    theResults[k].capacity = theFrames+1;
+  }
+
+  theFile = NULL;
+  if (theFileName[0] != '\0')
+  {
+    if (!isRewritten
+	|| rewrite_checkpoint(theFileName,&theHeader,isDone,theFirst,theSecond,theNumOfPairs,
+			      theNumOfSounds,theRoughness,theClipping,theFrames))
+      theFile = fopen(theFileName,"ab");
+    if (theFile == NULL)
+    {
+      roughness_plan_close(&thePlan);
+      mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: cannot write the checkpoint file");
+    }
+  }
+
+  /* the other pairs, a batch at a time */
+  for (theNext = 0; theDone < theNumOfPairs; )
+  {
+    for (theCount = 0; (theCount < theBatchSize) && (theNext < theNumOfPairs); theNext++)
+      if (!isDone[theNext])
+      {
+	theResults[theCount].first = theFirst[theNext];
+	theResults[theCount].second = theSecond[theNext];
+	theCount++;
+      }
+    parallel_for(theCount,theThreads,compute_pair,&theBatch);
+    for (k = 0; k < theCount; k++)
+    {
+      if (!theResults[k].ok || (theResults[k].numOfFrames != theFrames))
+      {
+	if (theFile != NULL) fclose(theFile);
+	roughness_plan_close(&thePlan);
+	mexErrMsgTxt("IPEMRoughnessOfSoundPairsMex: the auditory model failed");
+      }
+      store_pair(theRoughness,theClipping,theNumOfSounds,theResults[k].first,theResults[k].second,
+		 theResults[k].clipping,theResults[k].roughness,theFrames);
+      if ((theFile != NULL)
+	  && !write_record(theFile,theResults[k].first,theResults[k].second,theResults[k].clipping,
+			   theResults[k].roughness,1,theFrames))
+	mexWarnMsgTxt("IPEMRoughnessOfSoundPairsMex: cannot write the checkpoint file");
+    }
+    theDone += theCount;
+    mexPrintf("IPEMRoughnessOfSoundPairsMex: %ld of %ld pairs done\n",theDone,theNumOfPairs);
+  }
+
+  if (theFile != NULL) fclose(theFile);
+  roughness_plan_close(&thePlan);
+  for (k = 0; k < theBatchSize; k++) mxFree(theResults[k].roughness);
+  mxFree(theResults);
+  mxFree(isDone);
+  mxFree(theFirst);
+  mxFree(theSecond);
+  mxFree(theGains);
+  mxFree(theSounds);
+
+  for (k = 0; k < ((nlhs < 1) ? 1 : nlhs); k++) plhs[k] = theOut[k];
+  for (; k < 3; k++) mxDestroyArray(theOut[k]);
+}
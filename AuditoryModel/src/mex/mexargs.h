@@ -0,0 +1,16 @@
+/***********************************************************************
+Helpers shared by the mex gateways for their arguments.
+
+*************************************************************************/
+#ifndef MEXARGS_H
+#define MEXARGS_H
+
+#include "mex.h"
+
+/* argument i is given and not empty (an empty one gets its default) */
+static int is_given(int nrhs, const mxArray *prhs[], int i)
+{
+  return (nrhs > i) && !mxIsEmpty(prhs[i]);
+}
+
+#endif
@@ -0,0 +1,162 @@
+/* anitest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE BINARY ANI AND PYRAMID FILES
+
+    Writes an ANI and a pyramid of it with library/aniio.c to a
+    directory, maps both and compares what is read with what was
+    written: the headers (frame rate, start time, frame count, centre
+    frequencies), every sample of the ANI through the views, rows and
+    columns, and the minimum, maximum and mean of every bin of every
+    level of the pyramid, including the partial bins at the end.
+
+    Usage: anitest [directory for the files, default .]
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "aniio.h"
+
+#define  test_chan    5
+#define  test_frames  1000      /* not a multiple of 4^test_levels      */
+#define  test_levels  4
+#define  rate         200.0
+#define  start        1.25
+
+/* sample of channel c in frame f */
+static double value(long c,long f)
+{
+ return sin(0.01*f*(c+1))+0.001*c;
+}
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+static int test_ani(const char *path,const double *freqs)
+{ani_writer w;
+ ani_map    m;
+ ani_vector row,column;
+ ani_view   part;
+ double     x[test_chan];
+ FILE      *file;
+ long       c,f;
+ int        ok;
+
+ file=fopen(path,"wb");
+ ok=(file!=NULL) && ani_open_write(&w,file,test_chan,rate,start,freqs);
+ for (f=0;ok && f<test_frames;f++)
+ {for (c=0;c<test_chan;c++) x[c]=value(c,f);
+  ok=ani_write_frame(&w,x);
+ }
+ if (file!=NULL) {ok=ani_close_write(&w) && ok; fclose(file);}
+ if (!report("ani written",ok)) return 0;
+
+ if (!report("ani mapped",ani_map_open(&m,path))) return 0;
+ ok=(m.header.version==ani_version) && (m.header.nchan==test_chan)
+    && (m.header.nframes==test_frames) && (m.header.frame_rate==rate)
+    && (m.header.start_time==start);
+ for (c=0;c<test_chan;c++) ok=ok && (m.freqs[c]==freqs[c]);
+ report("ani header",ok);
+ for (f=0;ok && f<test_frames;f++)
+    for (c=0;c<test_chan;c++) ok=ok && (ani_at(m.view,c,f)==(float)value(c,f));
+ report("ani samples",ok);
+ part=ani_window(m.view,100,50);
+ row=ani_row(part,3); column=ani_column(part,7);
+ ok=ok && (part.nframes==50) && (row.length==50) && (column.length==test_chan);
+ for (f=0;ok && f<50;f++) ok=(ani_elem(row,f)==(float)value(3,100+f));
+ for (c=0;ok && c<test_chan;c++) ok=(ani_elem(column,c)==(float)value(c,107));
+ report("ani window, row, column",ok);
+ ani_map_close(&m);
+ return ok;
+}
+
+static int test_pyramid(const char *path,const double *freqs)
+{ani_pyr_writer w;
+ ani_pyr_map    m;
+ double         x[test_chan],mn,mx,sum,y;
+ FILE          *file;
+ long           c,f,b,span,bins,first,last;
+ int            l,ok;
+
+ file=fopen(path,"w+b");
+ ok=(file!=NULL) && ani_pyr_open_write(&w,file,test_chan,test_levels,rate,start,freqs);
+ for (f=0;ok && f<test_frames;f++)
+ {for (c=0;c<test_chan;c++) x[c]=value(c,f);
+  ok=ani_pyr_write_frame(&w,x);
+ }
+ if (file!=NULL) {ok=ani_pyr_close_write(&w) && ok; fclose(file);}
+ if (!report("pyramid written",ok)) return 0;
+
+ if (!report("pyramid mapped",ani_pyr_map_open(&m,path))) return 0;
+ ok=(m.header.version==ani_pyr_version) && (m.header.nchan==test_chan)
+    && (m.header.nlevels==test_levels) && (m.header.nframes==test_frames)
+    && (m.header.frame_rate==rate) && (m.header.start_time==start);
+ for (c=0;c<test_chan;c++) ok=ok && (m.freqs[c]==freqs[c]);
+ report("pyramid header",ok);
+ for (l=1,span=ani_pyr_factor;ok && l<=test_levels;l++,span*=ani_pyr_factor)
+ {bins=(test_frames+span-1)/span;
+  ok=(m.level[l].span==span) && (m.level[l].mean.nframes==bins)
+     && (m.level[l].mean.frame_rate==rate/span);
+  for (b=0;ok && b<bins;b++)
+     for (c=0;c<test_chan;c++)
+     {first=b*span; last=(first+span<test_frames) ? first+span : test_frames;
+      mn=mx=sum=value(c,first);
+      for (f=first+1;f<last;f++)
+      {y=value(c,f); sum+=y;
+       if (y<mn) mn=y;
+       if (y>mx) mx=y;
+      }
+      ok=ok && (ani_at(m.level[l].min,c,b)==(float)mn)
+            && (ani_at(m.level[l].max,c,b)==(float)mx)
+            && (fabs(ani_at(m.level[l].mean,c,b)-sum/(last-first))<1e-6);
+     }
+ }
+ report("pyramid levels",ok);
+ ok=ok && (ani_pyr_choose(&m,test_frames,100)==1) && (ani_pyr_choose(&m,test_frames,2)==4);
+ report("pyramid choice of level",ok);
+ ani_pyr_map_close(&m);
+ return ok;
+}
+
+int main(int argc,char *argv[])
+{const char *dir=(argc>1) ? argv[1] : ".";
+ char        path[1024];
+ double      freqs[test_chan];
+ long        c;
+ int         ok;
+
+ for (c=0;c<test_chan;c++) freqs[c]=100*pow(2,c);
+ snprintf(path,sizeof(path),"%s/anitest.ani",dir);
+ ok=test_ani(path,freqs);
+ remove(path);
+ snprintf(path,sizeof(path),"%s/anitest.pyr",dir);
+ ok=test_pyramid(path,freqs) && ok;
+ remove(path);
+ return !ok;
+}
@@ -0,0 +1,302 @@
+/* cachetest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE ANI CACHE AND OF RANGES
+
+    Checks the SHA-256 of library/anicache.c against the test vectors
+    of FIPS 180-2, then stores and fetches entries of the cache: a hit
+    gives the stored contents back, a miss leaves the output alone.
+    Then runs the model on a short synthetic signal with a cache: the
+    first analysis misses and stores its ANI, the second is taken from
+    the cache and gives the same file, and a signal that differs in
+    one sample misses again. Finally it analyses a range of the signal
+    and compares it with the frames of the analysis of the whole
+    signal: the start time in the header must point at the frame
+    where the range starts, and the frames must agree once the
+    pre-roll has let the model settle.
+
+    Usage: cachetest [dir]
+    Works in dir (default .), where the model also writes its dump
+    files; removes what it wrote. Prints one line per check and exits
+    with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "IPEMAuditoryModel.h"
+#include "anicache.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          22050.0
+#define  nsignal     26460     /* 1.2 s                                */
+#define  range_at    0.7       /* start of the range (s)               */
+#define  range_len   0.3       /* its duration (s)                     */
+#define  max_frames  nsignal   /* more than the frames of the whole ANI */
+#define  max_chan    40
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* a tone with a vibrato, a second tone and a little noise */
+static void make_signal(double *x)
+{unsigned long r=777;
+ long          i;
+
+ for (i=0;i<nsignal;i++)
+ {r=(r*1103515245+12345)%2147483648UL;
+  x[i]=0.3*sin(2*M_PI*440*i/fs+3*sin(2*M_PI*5*i/fs))
+      +0.1*sin(2*M_PI*1500*i/fs)+0.005*((double)(r>>8)/8388608.0-0.5);
+ }
+}
+
+/* contents of a file (NULL if it cannot be read) */
+static char *read_file(const char *name,long *size)
+{FILE *f=fopen(name,"rb");
+ char *data;
+
+ if (f==NULL) return NULL;
+ fseek(f,0,SEEK_END); *size=ftell(f); rewind(f);
+ data=(char*)malloc(*size+1);
+ if ((data!=NULL) && ((long)fread(data,1,*size,f)!=*size)) {free(data); data=NULL;}
+ fclose(f);
+ return data;
+}
+
+static int exists(const char *name)
+{struct stat st;
+
+ return stat(name,&st)==0;
+}
+
+static int same_file(const char *a,const char *b)
+{char *da,*db;
+ long  na=0,nb=0;
+ int   ok;
+
+ da=read_file(a,&na); db=read_file(b,&nb);
+ ok=(da!=NULL) && (db!=NULL) && (na==nb) && (memcmp(da,db,na)==0);
+ free(da); free(db);
+ return ok;
+}
+
+static void remove_dir(const char *dir)
+{char           path[1024];
+ DIR           *d=opendir(dir);
+ struct dirent *e;
+
+ if (d==NULL) return;
+ while ((e=readdir(d))!=NULL)
+    if (e->d_name[0]!='.')
+    {snprintf(path,sizeof(path),"%s/%s",dir,e->d_name);
+     remove(path);
+    }
+ closedir(d);
+ rmdir(dir);
+}
+
+static int key_of(const char *text,long repeat,anicache_key key)
+{anicache_hash c;
+ long          i;
+
+ anicache_hash_init(&c);
+ for (i=0;i<repeat;i++) anicache_hash_add(&c,text,strlen(text));
+ anicache_hash_final(&c,key);
+ return 1;
+}
+
+static int test_store(void)
+{anicache_key k1,k2;
+ double       level[2]={0.5,0.125},got[2]={0,0};
+ FILE        *f;
+ int          ok;
+
+ key_of("abc",1,k1);
+ ok=(strcmp(k1,"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad")==0);
+ key_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",1,k1);
+ ok=ok && (strcmp(k1,"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1")==0);
+ key_of("a",1000000,k1);
+ ok=ok && (strcmp(k1,"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0")==0);
+ report("key, FIPS 180-2 vectors",ok);
+
+ key_of("entry 1",1,k1); key_of("entry 2",1,k2);
+ mkdir("cachetest.dir",0777);
+ ok=anicache_store_data("cachetest.dir",k1,".lvl",level,sizeof(level))
+    && anicache_fetch_data("cachetest.dir",k1,".lvl",got,sizeof(got))
+    && (got[0]==level[0]) && (got[1]==level[1])
+    && !anicache_fetch_data("cachetest.dir",k2,".lvl",got,sizeof(got));
+ report("data, hit and miss",ok);
+
+ f=fopen("cachetest.in","wb");
+ if (f!=NULL) {fputs("not an ANI, but any file will do\n",f); fclose(f);}
+ remove("cachetest.out");
+ ok=(f!=NULL) && anicache_store("cachetest.dir",k1,"cachetest.in",anicache_def_size)
+    && !anicache_fetch("cachetest.dir",k2,"cachetest.out")
+    && !exists("cachetest.out")
+    && anicache_fetch("cachetest.dir",k1,"cachetest.out")
+    && same_file("cachetest.in","cachetest.out");
+ report("file, hit and miss",ok);
+ remove("cachetest.in"); remove("cachetest.out");
+ remove_dir("cachetest.dir");
+ return ok;
+}
+
+/* counts the analyses and the results taken from the cache */
+typedef struct{
+               int analysed,fetched;
+              } counts;
+
+static void count_message(void *context,int level,const char *text,
+                          const log_field *fields,int nfields)
+{counts *n=(counts*)context;
+
+ (void)level; (void)fields; (void)nfields;
+ if (strcmp(text,"analysed")==0) n->analysed++;
+ else if (strcmp(text,"taken from the cache")==0) n->fetched++;
+}
+
+static int analyse(const double *x,const char *name,const char *cache,counts *n)
+{log_sink sink;
+
+ sink.context=n; sink.message=count_message; sink.level=log_info;
+ n->analysed=n->fetched=0;
+ IPEMAuditoryModel_Setup(-1,-1,-1,NULL,NULL,name,".",fs,-1);
+ IPEMAuditoryModel_SetOutputFormat(aofBinary);
+ IPEMAuditoryModel_SetInputSignal(x,nsignal);
+ IPEMAuditoryModel_SetCache(cache,-1);
+ IPEMAuditoryModel_SetLogSink(&sink);
+ return IPEMAuditoryModel_Process()==0;
+}
+
+static int test_model_cache(double *x)
+{counts n;
+ int    ok;
+
+ mkdir("cachetest.dir",0777);
+ ok=analyse(x,"cachetest1.ani","cachetest.dir",&n) && (n.analysed==1) && (n.fetched==0);
+ report("model, miss",ok);
+ ok=analyse(x,"cachetest2.ani","cachetest.dir",&n) && (n.analysed==0) && (n.fetched==1)
+    && same_file("cachetest1.ani","cachetest2.ani");
+ report("model, hit",ok);
+ x[1000]+=1e-6;
+ ok=analyse(x,"cachetest2.ani","cachetest.dir",&n) && (n.analysed==1) && (n.fetched==0);
+ x[1000]-=1e-6;
+ report("model, other signal",ok);
+ remove("cachetest1.ani"); remove("cachetest2.ani");
+ remove_dir("cachetest.dir");
+ return ok;
+}
+
+/* keeps the frames of an ANI in memory */
+typedef struct{
+               long   nchan,nframes;
+               double frame_rate;
+               float  frames[max_frames*max_chan];
+              } memory_ani;
+
+static int begin_ani(void *context,long nchan,double frame_rate,const double *freqs)
+{memory_ani *a=(memory_ani*)context;
+
+ (void)freqs;
+ a->nchan=nchan; a->frame_rate=frame_rate; a->nframes=0;
+ return nchan<=max_chan;
+}
+
+static int frame_ani(void *context,const double *values)
+{memory_ani *a=(memory_ani*)context;
+ long        c;
+
+ if (a->nframes>=max_frames) return 0;
+ for (c=0;c<a->nchan;c++) a->frames[a->nframes*a->nchan+c]=(float)values[c];
+ a->nframes++;
+ return 1;
+}
+
+static int test_range(const double *x)
+{static memory_ani whole;
+ ani_sink   sink;
+ ani_map    m;
+ long       first,c,f,frames;
+ double     err=0,big=0;
+ int        ok;
+
+ sink.context=&whole; sink.begin=begin_ani; sink.frame=frame_ani;
+ IPEMAuditoryModel_Setup(-1,-1,-1,NULL,NULL,NULL,NULL,fs,-1);
+ IPEMAuditoryModel_SetInputSignal(x,nsignal);
+ IPEMAuditoryModel_SetOutputSink(&sink);
+ ok=(IPEMAuditoryModel_Process()==0);
+
+ IPEMAuditoryModel_Setup(-1,-1,-1,NULL,NULL,"cachetest.ani",".",fs,-1);
+ IPEMAuditoryModel_SetOutputFormat(aofBinary);
+ IPEMAuditoryModel_SetInputSignal(x,nsignal);
+ IPEMAuditoryModel_SetRange(range_at,range_len,-1);
+ ok=ok && (IPEMAuditoryModel_Process()==0);
+ if (!report("range analysed",ok && ani_map_open(&m,"cachetest.ani"))) return 0;
+
+ /* the range starts at the first frame at or after range_at */
+ first=(long)floor(m.header.start_time*whole.frame_rate+0.5);
+ frames=(long)floor(range_len*whole.frame_rate+0.5);
+ ok=(m.header.nchan==whole.nchan) && (m.header.frame_rate==whole.frame_rate)
+    && (fabs(m.header.start_time-first/whole.frame_rate)<1e-9)
+    && (m.header.start_time>=range_at) && (m.header.start_time<range_at+1/whole.frame_rate)
+    && (labs((long)m.header.nframes-frames)<=1) && (first+m.header.nframes<=whole.nframes);
+ report("range, start and length",ok);
+ for (f=0;ok && f<m.header.nframes;f++)
+    for (c=0;c<whole.nchan;c++)
+    {float v=whole.frames[(first+f)*whole.nchan+c];
+
+     if (fabs(v)>big) big=fabs(v);
+     if (fabs(ani_at(m.view,c,f)-v)>err) err=fabs(ani_at(m.view,c,f)-v);
+    }
+ ok=ok && (err<=1e-5*big);
+ report("range, against whole signal",ok);
+ ani_map_close(&m);
+ remove("cachetest.ani");
+ return ok;
+}
+
+int main(int argc,char *argv[])
+{static double x[nsignal];
+ static const char *dumps[]={"outfile.dat","omef.dat","decim.dat","filters.dat",
+                             "eef.dat","lpf.dat","FilterFrequencies.txt"};
+ int    ok,i;
+
+ if ((argc>1) && (chdir(argv[1])!=0)) {printf("cannot work in %s\n",argv[1]); return 1;}
+ make_signal(x);
+ ok=test_store();
+ ok=test_model_cache(x) && ok;
+ ok=test_range(x) && ok;
+ for (i=0;i<(int)(sizeof(dumps)/sizeof(dumps[0]));i++) remove(dumps[i]);
+ return !ok;
+}
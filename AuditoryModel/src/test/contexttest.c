@@ -0,0 +1,161 @@
+/* contexttest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE TONAL CONTEXT
+
+    Computes the contextuality index of analysis/context.c for a short
+    synthetic periodicity pitch image and compares it with a reference
+    that follows the Matlab version of IPEMContextualityIndex: both
+    images from IPEMLeakyIntegration (filter(1,[1 -coef],...) over the
+    image extended with silent columns) and the three curves from
+    corrcoef, which subtracts the means first. The image starts with a
+    silent column, for which corrcoef gives NaN. The snapshot is taken
+    in the middle and at the last column.
+
+    Usage: contexttest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "context.h"
+
+#define  fs          50.0
+#define  nrows       24
+#define  ncols       80
+#define  nextra      30        /* round(fs*enlargement)                */
+#define  ntotal      (ncols+nextra)
+#define  half_chords 0.1
+#define  half_tones  1.5
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* a pitch image whose peak moves every 20 columns, silent in column 0 */
+static void make_image(double *in)
+{long r,j;
+ double m;
+
+ for (j=0;j<ncols;j++)
+ {m=4+(j/20)*5;
+  for (r=0;r<nrows;r++)
+     in[j*nrows+r]=(j==0) ? 0 : exp(-0.3*(r-m)*(r-m))+0.2*exp(-0.3*(r-2*m)*(r-2*m))
+                                 +0.05*sin(0.7*r*j);
+ }
+}
+
+/* corrcoef(x,y)(1,2) */
+static double corrcoef(const double *x,const double *y,long n)
+{double mx=0,my=0,sxx=0,syy=0,sxy=0,zero=0;
+ long   i;
+
+ for (i=0;i<n;i++) {mx+=x[i]; my+=y[i];}
+ mx/=n; my/=n;
+ for (i=0;i<n;i++)
+ {sxx+=(x[i]-mx)*(x[i]-mx); syy+=(y[i]-my)*(y[i]-my);
+  sxy+=(x[i]-mx)*(y[i]-my);
+ }
+ if ((sxx==0) || (syy==0)) return zero/zero;
+ return sxy/sqrt(sxx*syy);
+}
+
+/* IPEMLeakyIntegration of in, extended with nextra silent columns */
+static void leaky(const double *in,double half,double *out)
+{double coef=(half!=0) ? pow(2.0,-1/(fs*half)) : 0;
+ long   r,j;
+
+ for (j=0;j<ntotal;j++)
+    for (r=0;r<nrows;r++)
+       out[j*nrows+r]=((j<ncols) ? in[j*nrows+r] : 0)
+                      +((j>0) ? coef*out[(j-1)*nrows+r] : 0);
+}
+
+/* same values, or both NaN */
+static int agree(const double *a,const double *b,long n,double tol)
+{long i;
+
+ for (i=0;i<n;i++)
+ {if (isnan(a[i]) || isnan(b[i])) {if (!isnan(a[i]) || !isnan(b[i])) return 0;}
+  else if (fabs(a[i]-b[i])>tol) return 0;
+ }
+ return 1;
+}
+
+static int test_snapshot(const double *in,long snapshot,const char *what)
+{static double chords[nrows*ntotal],tones[nrows*ntotal];
+ static double rchords[nrows*ntotal],rtones[nrows*ntotal];
+ double c1[ntotal],c2[ntotal],c3[ntotal],r1[ntotal],r2[ntotal],r3[ntotal];
+ const double *snap=rchords+snapshot*nrows;
+ long   j;
+ int    ok;
+
+ ok=context_index(in,nrows,ncols,nextra,fs,half_chords,half_tones,snapshot,
+                  chords,tones,c1,c2,c3);
+ leaky(in,half_chords,rchords); leaky(in,half_tones,rtones);
+ for (j=0;j<ntotal;j++)
+ {r1[j]=corrcoef(rchords+j*nrows,snap,nrows);
+  r2[j]=corrcoef(rtones+j*nrows,snap,nrows);
+  r3[j]=corrcoef(rtones+j*nrows,rchords+j*nrows,nrows);
+ }
+ ok=ok && agree(chords,rchords,nrows*ntotal,1e-12) && agree(tones,rtones,nrows*ntotal,1e-12)
+       && agree(c1,r1,ntotal,1e-9) && agree(c2,r2,ntotal,1e-9) && agree(c3,r3,ntotal,1e-9)
+       && isnan(c1[0]) && !isnan(c1[1]);
+ return report(what,ok);
+}
+
+/* the streaming engine, a column at a time, against the same images */
+static int test_stream(const double *in)
+{static double rchords[nrows*ntotal],rtones[nrows*ntotal];
+ context_state s;
+ double        chord[nrows],tone[nrows],c3,r3;
+ long          j;
+ int           ok;
+
+ leaky(in,half_chords,rchords); leaky(in,half_tones,rtones);
+ if (!context_open(&s,nrows,fs,half_chords,half_tones))
+    return report("column by column",0);
+ for (ok=1,j=0;ok && j<ntotal;j++)
+ {c3=context_column(&s,(j<ncols) ? in+j*nrows : NULL,chord,tone,NULL);
+  r3=corrcoef(rtones+j*nrows,rchords+j*nrows,nrows);
+  ok=agree(chord,rchords+j*nrows,nrows,1e-12) && agree(tone,rtones+j*nrows,nrows,1e-12)
+     && agree(&c3,&r3,1,1e-9);
+ }
+ context_close(&s);
+ return report("column by column",ok);
+}
+
+int main()
+{static double in[nrows*ncols];
+ int ok;
+
+ make_image(in);
+ ok=test_snapshot(in,ncols/2,"snapshot in the middle");
+ ok=test_snapshot(in,ntotal-1,"snapshot at the end") && ok;
+ ok=test_stream(in) && ok;
+ return !ok;
+}
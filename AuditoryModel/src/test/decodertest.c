@@ -0,0 +1,222 @@
+/* decodertest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE SOUND FILE DECODERS
+
+    Decodes the files in test/data with library/decoder.c and compares
+    the samples with the signal they were written from. The integer
+    samples of channel c at sample i are
+
+      u(i,c) = (i*(37+11*c))%401 + ((i*1103515245+12345+7777*c)
+               mod 2^31 >> 16)%17      (285 for c=1 and i in 1024..2047)
+      s(i,c) = (u(i,c)-208)*2^(bits-9), or u(i,c)/4-52 for 8 bit
+
+    and the float files hold s(i,0) of 16 bit divided by 32768. The
+    mu-law and A-law files hold the 256 codes in order. Every file is
+    read in pieces of 37 samples, then again from a third of its
+    length on (decoder_seek). The damaged FLAC files have a flipped
+    bit in the samples of their third frame and in the header of
+    their fourth: only the frames before it may be delivered, and
+    decoder_read must set failed. A truncated wav file delivers the
+    samples it holds, and a few broken headers must not open at all.
+
+    Usage: decodertest [directory of the files, default test/data]
+    Prints one line per file and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "decoder.h"
+#include "logging.h"
+
+#define  piece   37
+#define  kind_int    0    /* s(i,c) of bits bits                     */
+#define  kind_float  1    /* s(i,0) of 16 bit / 32768                */
+#define  kind_ulaw   2    /* codes 0..255                            */
+#define  kind_alaw   3
+
+typedef struct{
+               const char *name;
+               int         kind;
+               int         bits;      /* of the samples of the formula  */
+               int         channels;
+               double      rate;
+               long        length;    /* samples delivered              */
+               int         failed;    /* damaged data expected          */
+              } fixture;
+
+static const fixture fixtures[]={
+ {"pcm8.wav",       kind_int,   8,1, 8000, 500,0},
+ {"pcm16s.wav",     kind_int,  16,2,22050,1000,0},
+ {"pcm24x.wav",     kind_int,  24,1,48000, 600,0},
+ {"float32.wav",    kind_float,32,1,22050, 400,0},
+ {"ulaw.wav",       kind_ulaw,  8,1, 8000, 256,0},
+ {"alaw.wav",       kind_alaw,  8,1, 8000, 256,0},
+ {"trunc16.wav",    kind_int,  16,1,22050, 700,0},
+ {"pcm16s.aiff",    kind_int,  16,2,44100, 800,0},
+ {"pcm8.aiff",      kind_int,   8,1,11025, 300,0},
+ {"sowt.aifc",      kind_int,  16,1,22050, 500,0},
+ {"fl32.aifc",      kind_float,32,1,22050, 300,0},
+ {"ulaw.aifc",      kind_ulaw, 16,1, 8000, 256,0},
+ {"pcm16s.au",      kind_int,  16,2,22050, 700,0},
+ {"pcm24.au",       kind_int,  24,1,22050, 200,0},
+ {"double.au",      kind_float,64,1,22050, 100,0},
+ {"ulaw.au",        kind_ulaw,  8,1, 8000, 256,0},
+ {"stereo16.flac",  kind_int,  16,2,44100,4396,0},
+ {"mono24.flac",    kind_int,  24,1,22050,1500,0},
+ {"damaged.flac",   kind_int,  16,2,44100,2048,1},
+ {"badheader.flac", kind_int,  16,2,44100,3072,1}
+};
+
+/* headers that must be refused */
+static const char *broken[]={
+ "RIFF\044\0\0\0WAVE",                                   /* no chunks       */
+ "RIFF\044\0\0\0WAVEfmt \020\0\0\0\001\0\0\0\042\126\0\0", /* no channels     */
+ "FORM\0\0\0\044AIFFSSND\0\0\0\010\0\0\0\0\0\0\0\0",      /* no COMM         */
+ ".snd\0\0\0\030\0\0\0\0\0\0\0\011\0\0\126\042\0\0\0\001", /* encoding 9      */
+ "fLaC\001\0\0\004abcd"                                   /* no STREAMINFO   */
+};
+static const int broken_size[]={12,28,28,24,12};
+
+static long long u(long i,int c)
+{
+ if ((i/1024==1) && (c==1)) return 285;
+ return (i*(37+11*c))%401
+        +(((i*1103515245LL+12345+7777*c)&0x7fffffffLL)>>16)%17;
+}
+
+static long long s(long i,int c,int bits)
+{
+ if (bits==8) return (u(i,c)>>2)-52;
+ return (u(i,c)-208)*(1LL<<(bits-9));
+}
+
+/* the mono sample the decoder delivers for integer files */
+static double expected(const fixture *f,long i)
+{double x=0;
+ int    c;
+
+ if (f->kind==kind_float) return s(i,0,16)/32768.0;
+ for (c=0;c<f->channels;c++) x+=s(i,c,f->bits)/ldexp(1.0,f->bits-1);
+ return (f->channels==1) ? x : x/f->channels;
+}
+
+/* mu-law and A-law: the extremes, the smallest steps and the sign */
+static int check_law(const fixture *f,const double *x)
+{int c;
+
+ for (c=0;c<128;c++) if (x[c]!=-x[c+128]) return 0;
+ if (f->kind==kind_ulaw)
+    return (x[0]==-32124/32768.0) && (x[127]==0) && (x[126]==-8/32768.0);
+ return (x[0xd5]==8/32768.0) && (x[0xaa]==32256/32768.0);
+}
+
+/* message sink: only counts the errors */
+static void count_errors(void *context,int level,const char *text,
+                         const log_field *fields,int nfields)
+{
+ (void)text; (void)fields; (void)nfields;
+ if (level==log_error) (*(int*)context)++;
+}
+
+static int test(const char *dir,const fixture *f)
+{char    path[1024];
+ FILE   *file;
+ decoder d;
+ double *x;
+ long    n,k,i,first;
+ int     ok;
+
+ snprintf(path,sizeof(path),"%s/%s",dir,f->name);
+ file=fopen(path,"rb");
+ if (file==NULL) {printf("%-16s cannot open\n",f->name); return 0;}
+ x=(double*)malloc((f->length+piece)*sizeof(double));
+ ok=decoder_open(&d,file);
+ if (!ok) {printf("%-16s not recognized\n",f->name); fclose(file); free(x); return 0;}
+ if ((d.rate!=f->rate) || (f->kind!=kind_float && f->kind!=kind_ulaw
+     && f->kind!=kind_alaw && d.bits!=f->bits))
+ {printf("%-16s header: %g Hz, %d bit\n",f->name,d.rate,d.bits); ok=0;}
+
+ /* all of it, a piece at a time */
+ for (n=0;(k=decoder_read(&d,x+n,piece))>0;n+=k)
+    if (n+k>f->length) {n+=k; break;}
+ if ((n!=f->length) || (d.failed!=f->failed))
+ {printf("%-16s %ld samples, failed %d\n",f->name,n,d.failed); ok=0;}
+ if (f->kind==kind_ulaw || f->kind==kind_alaw)
+ {if (ok && !check_law(f,x)) {printf("%-16s wrong codes\n",f->name); ok=0;}
+ }
+ else
+  for (i=0;ok && i<n;i++)
+     if (x[i]!=expected(f,i))
+     {printf("%-16s sample %ld: %.10g instead of %.10g\n",f->name,i,x[i],expected(f,i));
+      ok=0;
+     }
+ decoder_close(&d);
+
+ /* from a third on */
+ first=f->length/3;
+ if (ok && (f->kind==kind_int || f->kind==kind_float) && !f->failed)
+ {rewind(file);
+  if (!decoder_open(&d,file) || !decoder_seek(&d,first)) ok=0;
+  else
+  {n=decoder_read(&d,x,f->length);
+   if (n!=f->length-first) ok=0;
+   for (i=0;ok && i<n;i++) if (x[i]!=expected(f,first+i)) ok=0;
+   decoder_close(&d);
+  }
+  if (!ok) printf("%-16s wrong after seeking to %ld\n",f->name,first);
+ }
+ fclose(file); free(x);
+ if (ok) printf("%-16s ok\n",f->name);
+ return ok;
+}
+
+static int test_broken(int k)
+{FILE   *file=tmpfile();
+ decoder d;
+ int     ok;
+
+ if (file==NULL) return 0;
+ fwrite(broken[k],1,broken_size[k],file); rewind(file);
+ ok=!decoder_open(&d,file);
+ fclose(file);
+ printf("broken header %d %s\n",k,ok ? "ok" : "accepted");
+ return ok;
+}
+
+int main(int argc,char *argv[])
+{const char *dir=(argc>1) ? argv[1] : "test/data";
+ int         k,failed=0,errors=0;
+ log_sink    sink={&errors,count_errors,log_error};
+
+ log_set_sink(&sink);
+ for (k=0;k<(int)(sizeof(fixtures)/sizeof(fixtures[0]));k++)
+    if (!test(dir,&fixtures[k])) failed++;
+ for (k=0;k<(int)(sizeof(broken)/sizeof(broken[0]));k++)
+    if (!test_broken(k)) failed++;
+ printf("%d failed, %d errors reported\n",failed,errors);
+ return (failed>0);
+}
@@ -0,0 +1,253 @@
+/* descbanktest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE DESCRIPTOR BANK
+
+    Computes the descriptors of analysis/descbank.c for a short
+    synthetic signal and ANI and compares them with a reference that
+    follows the Matlab functions they replace, written out loop by
+    loop: IPEMCalcCentroid, IPEMCalcCentroidWidth, IPEMGetRolloff,
+    IPEMCalcZeroCrossingRate (IPEMCountZeroCrossings),
+    IPEMGetCrestFactor and IPEMCalcFlux. The magnitudes of the signal
+    frames of the reference come from a direct DFT of the frame with
+    Matlab's hanning window, divided by width/2 as
+    IPEMCalcSpectrogram does. Both have silent frames, for which the
+    bank gives a centroid and width of 0 (where Matlab divides by 0)
+    and a crest factor of 1. The bank is run on 1 and on 4 threads,
+    which must give the same values.
+
+    Usage: descbanktest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "descbank.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          8000.0
+#define  nsignal     4000
+#define  silence     2600      /* samples from here on are 0           */
+#define  width       256
+#define  hop         100
+#define  nbins       (width/2+1)
+#define  fraction    0.85      /* of the rolloff                       */
+#define  zcr_tol     0.01      /* of the zero crossings                */
+
+#define  nchan       12
+#define  ncols       300
+#define  ani_width   20
+#define  ani_step    7
+
+#define  max_rows    6
+#define  max_frames  64
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* a tone, a second tone in the middle, a little noise and silence */
+static void make_signal(double *x)
+{unsigned long r=12345;
+ long          i;
+
+ for (i=0;i<nsignal;i++)
+ {r=(r*1103515245+12345)%2147483648UL;
+  x[i]=0.5*sin(2*M_PI*440*i/fs)+0.02*((double)(r>>8)/8388608.0-0.5);
+  if (i>=1000 && i<2000) x[i]+=0.3*sin(2*M_PI*1250*i/fs);
+  if (i>=silence) x[i]=0;
+ }
+}
+
+/* an ANI whose energy moves across the channels, silent in the middle */
+static void make_ani(double *ani,double *freqs)
+{long c,t;
+ double m;
+
+ for (c=0;c<nchan;c++) freqs[c]=100*pow(2,c/3.0);
+ for (t=0;t<ncols;t++)
+ {m=2+8*(double)t/ncols;
+  for (c=0;c<nchan;c++)
+     ani[t*nchan+c]=(t>=120 && t<160) ? 0 : exp(-0.5*(c-m)*(c-m))+0.01*c;
+ }
+}
+
+/* IPEMCalcCentroid, IPEMCalcCentroidWidth, IPEMGetRolloff,
+   IPEMGetCrestFactor and IPEMCalcFlux of the weights w[0..n-1] at
+   distances d (prev: weights of the frame before, NULL for the first);
+   mask as descbank */
+static void reference(int mask,const double *w,const double *prev,
+                      const double *d,long n,const double *samples,
+                      long nsamples,double *out)
+{double total=0,moment=0,c,v,cum,peak,sum;
+ long   i,count;
+ int    last,sign;
+
+ for (i=0;i<n;i++) {total+=w[i]; moment+=d[i]*w[i];}
+ c=(total!=0) ? moment/total : 0;
+ if (mask&descbank_centroid) *out++=c;
+ if (mask&descbank_width)
+ {for (v=0,i=0;i<n;i++) v+=fabs(d[i]-c)*w[i];
+  *out++=(total!=0) ? v/total : 0;
+ }
+ if (mask&descbank_rolloff)
+ {/* find(cumsum(w) >= fraction*sum(w)), first index */
+  for (cum=0,i=0;i<n;i++) {cum+=w[i]; if (cum>=fraction*total) break;}
+  *out++=d[(i<n) ? i : n-1];
+ }
+ if (mask&descbank_zcr)
+ {/* IPEMCountZeroCrossings/(width/fs) */
+  for (count=0,last=0,i=0;i<nsamples;i++)
+  {if (fabs(samples[i])<zcr_tol || samples[i]==0) continue;
+   sign=(samples[i]>0) ? 1 : -1;
+   if (last!=0 && sign!=last) count++;
+   last=sign;
+  }
+  *out++=count/(width/fs);
+ }
+ if (mask&descbank_crest)
+ {const double *x=(samples!=NULL) ? samples : w;
+  long          m=(samples!=NULL) ? nsamples : n;
+
+  for (peak=0,sum=0,i=0;i<m;i++)
+  {if (fabs(x[i])>peak) peak=fabs(x[i]);
+   sum+=x[i]*x[i];
+  }
+  *out++=(sum>0) ? peak/sqrt(sum/m) : 1;
+ }
+ if (mask&descbank_flux)
+ {for (v=0,i=0;(prev!=NULL) && i<n;i++) v+=(w[i]-prev[i])*(w[i]-prev[i]);
+  *out++=sqrt(v);
+ }
+}
+
+/* largest difference relative to the magnitude of the values */
+static double compare(const double *a,const double *b,long n)
+{double err=0,big=1e-12;
+ long   i;
+
+ for (i=0;i<n;i++)
+ {if (fabs(b[i])>big) big=fabs(b[i]);
+  if (fabs(a[i]-b[i])>err) err=fabs(a[i]-b[i]);
+ }
+ return err/big;
+}
+
+static int test_signal(void)
+{static double x[nsignal],out[2][max_rows*max_frames],ref[max_rows*max_frames];
+ double         w[2][nbins],d[nbins],re,im,win;
+ stft_plan      p;
+ descbank_params dp;
+ long           nframes,f,k,i,n;
+ int            rows,ok,t;
+
+ make_signal(x);
+ if (!report("signal plan",stft_plan_open(&p,fs,width,hop,0,stft_hanning,NULL)))
+    return 0;
+ dp.mask=descbank_all; dp.rolloff=fraction; dp.tolerance=zcr_tol;
+ rows=descbank_rows(dp.mask);
+ nframes=stft_frames(&p,nsignal);
+ ok=(rows==max_rows) && (nframes==(nsignal-width)/hop+1) && (nframes<=max_frames);
+ for (t=0;ok && t<2;t++)
+ {dp.nthreads=(t==0) ? 1 : 4;
+  ok=(descbank_signal(&p,x,nsignal,&dp,out[t])==nframes);
+ }
+ stft_plan_close(&p);
+ if (!report("signal descriptors",ok)) return 0;
+ ok=(compare(out[0],out[1],rows*nframes)==0);
+ report("signal, 1 and 4 threads",ok);
+
+ for (k=0;k<nbins;k++) d[k]=k*fs/width;
+ for (f=0;f<nframes;f++)
+ {for (k=0;k<nbins;k++)
+  {for (re=im=0,i=0;i<width;i++)
+   {win=0.5*(1-cos(2*M_PI*(i+1)/(width+1)));
+    re+=x[f*hop+i]*win*cos(2*M_PI*k*i/width);
+    im-=x[f*hop+i]*win*sin(2*M_PI*k*i/width);
+   }
+   w[f%2][k]=sqrt(re*re+im*im)/(width/2.0);
+  }
+  reference(descbank_all,w[f%2],(f>0) ? w[(f+1)%2] : NULL,d,nbins,
+            x+f*hop,width,ref+f*rows);
+ }
+ /* the bank has single precision magnitudes */
+ for (n=0,f=0;f<nframes;f++)
+    if (compare(out[0]+f*rows,ref+f*rows,rows)>1e-5) n++;
+ ok=(n==0) && (out[0][(nframes-1)*rows]==0) && (out[0][(nframes-1)*rows+4]==1);
+ report("signal, against reference",ok);
+ return ok;
+}
+
+static int test_ani(void)
+{static double ani[nchan*ncols],out[2][max_rows*max_frames],ref[max_rows*max_frames];
+ double         freqs[nchan],w[2][nchan];
+ descbank_params dp;
+ long           nframes,f,c,j,n;
+ int            rows,ok,t;
+
+ make_ani(ani,freqs);
+ dp.mask=descbank_all&~descbank_zcr; dp.rolloff=fraction; dp.tolerance=0;
+ rows=descbank_rows(dp.mask);
+ nframes=descbank_ani_frames(ncols,ani_width,ani_step);
+ ok=(nframes==(ncols-ani_width)/ani_step+1) && (nframes<=max_frames);
+ for (t=0;ok && t<2;t++)
+ {dp.nthreads=(t==0) ? 1 : 4;
+  ok=(descbank_ani(ani,nchan,ncols,freqs,ani_width,ani_step,&dp,out[t])==nframes);
+ }
+ dp.mask=descbank_zcr;
+ ok=ok && (descbank_ani(ani,nchan,ncols,freqs,ani_width,ani_step,&dp,out[0])==-1);
+ if (!report("ani descriptors",ok)) return 0;
+ ok=(compare(out[0],out[1],rows*nframes)==0);
+ report("ani, 1 and 4 threads",ok);
+
+ /* the frames of IPEMCalcCentroid: columns t..t+width-1, every step */
+ for (f=0;f<nframes;f++)
+ {for (c=0;c<nchan;c++)
+  {for (w[f%2][c]=0,j=0;j<ani_width;j++) w[f%2][c]+=ani[(f*ani_step+j)*nchan+c];
+   w[f%2][c]/=ani_width;
+  }
+  reference(descbank_all&~descbank_zcr,w[f%2],(f>0) ? w[(f+1)%2] : NULL,
+            freqs,nchan,NULL,0,ref+f*rows);
+ }
+ for (n=0,f=0;f<nframes;f++)
+    if (compare(out[0]+f*rows,ref+f*rows,rows)>1e-12) n++;
+ /* frame 18 (columns 126..145) is silent */
+ ok=(n==0) && (out[0][18*rows]==0) && (out[0][18*rows+3]==1);
+ report("ani, against reference",ok);
+ return ok;
+}
+
+int main()
+{int ok;
+
+ ok=test_signal();
+ ok=test_ani() && ok;
+ return !ok;
+}
@@ -0,0 +1,163 @@
+/* featbanktest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE FEATURE BANK
+
+    Feeds a short synthetic multichannel signal to the feature bank of
+    analysis/featbank.c, in blocks of odd sizes, and compares the
+    running RMS, the flux and the envelopes with references that
+    follow the Matlab versions of IPEMCalcRMS (a window every step
+    frames, i = 1:step:M-width+1), IPEMCalcFlux ([0 sqrt(sum(diff.^2))])
+    and IPEMEnvelopeFollower. The RMS is checked for a width that is a
+    multiple of the step, one that is not, and a step larger than the
+    width; as the running sum of squares has rounding errors of the
+    order of the largest sum, the mean squares are compared. The
+    signal ends in silence, long after the ring of chunks of the
+    running sum has wrapped: the RMS of the last window must be
+    exactly 0.
+
+    Usage: featbanktest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "featbank.h"
+
+#define  fs          200.0
+#define  nchan       5
+#define  ncols       2000
+#define  silence     1400      /* frames from here on are 0            */
+#define  attack      0.01
+#define  release     0.05
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* channels with a different modulation, silent at the end */
+static void make_signal(double *x)
+{long c,j;
+
+ for (j=0;j<ncols;j++)
+    for (c=0;c<nchan;c++)
+       x[j*nchan+c]=(j>=silence) ? 0
+                    : (1+c)*0.1*sin(0.02*j*(c+1))*sin(0.003*j)+0.01*cos(1.7*j*c);
+}
+
+/* largest difference relative to the magnitude of the values */
+static double compare(const double *a,const double *b,long n)
+{double err=0,big=1e-12;
+ long   i;
+
+ for (i=0;i<n;i++)
+ {if (fabs(b[i])>big) big=fabs(b[i]);
+  if (fabs(a[i]-b[i])>err) err=fabs(a[i]-b[i]);
+ }
+ return err/big;
+}
+
+/* the whole signal, in blocks of 1, 13, 101, ... frames */
+static long run_bank(featbank_state *s,const double *x,double *rms,
+                     double *flux,double *env)
+{static const long sizes[]={1,13,101,7,250};
+ long done,n,i,m=0;
+
+ for (done=0,i=0;done<ncols;done+=n,i++)
+ {n=sizes[i%5];
+  if (n>ncols-done) n=ncols-done;
+  m+=featbank_block(s,x+done*nchan,n,(rms!=NULL) ? rms+m*nchan : NULL,
+                    (flux!=NULL) ? flux+done : NULL,(env!=NULL) ? env+done*nchan : NULL);
+ }
+ return m;
+}
+
+static int test_rms(const double *x,long width,long step,const char *what)
+{static double rms[ncols*nchan],ref[ncols*nchan];
+ featbank_state s;
+ long           n,m,k,i,j,c;
+ double         sum;
+ int            ok;
+
+ if (!featbank_open(&s,nchan,featbank_rms,fs,width,step,0,0)) return report(what,0);
+ m=run_bank(&s,x,rms,NULL,NULL);
+ featbank_close(&s);
+ /* IPEMCalcRMS */
+ for (k=0,i=0;i+width<=ncols;i+=step,k++)
+    for (c=0;c<nchan;c++)
+    {for (sum=0,j=i;j<i+width;j++) sum+=x[j*nchan+c]*x[j*nchan+c];
+     ref[k*nchan+c]=sqrt(sum/width);
+    }
+ /* the running sum leaves rounding errors of the order of the largest
+    sum of squares, which are larger relative to a small RMS: compare
+    the mean squares */
+ n=featbank_rms_frames(ncols,width,step);
+ for (i=0;i<n*nchan;i++) {rms[i]*=rms[i]; ref[i]*=ref[i];}
+ ok=(m==n) && (k==n) && (compare(rms,ref,n*nchan)<1e-12);
+ for (c=0;ok && c<nchan;c++) ok=(rms[(n-1)*nchan+c]==0);
+ return report(what,ok);
+}
+
+static int test_flux_envelope(const double *x)
+{static double flux[ncols],env[ncols*nchan],rflux[ncols],renv[ncols*nchan];
+ featbank_state s;
+ double         fa=pow(2.0,-1/(attack*fs)),fr=pow(2.0,-1/(release*fs)),e,a,d;
+ long           j,c;
+ int            ok;
+
+ if (!featbank_open(&s,nchan,featbank_flux|featbank_envelope,fs,0,0,attack,release))
+    return report("flux and envelope",0);
+ run_bank(&s,x,NULL,flux,env);
+ featbank_close(&s);
+ /* IPEMCalcFlux */
+ for (rflux[0]=0,j=1;j<ncols;j++)
+ {for (rflux[j]=0,c=0;c<nchan;c++)
+  {d=x[j*nchan+c]-x[(j-1)*nchan+c]; rflux[j]+=d*d;}
+  rflux[j]=sqrt(rflux[j]);
+ }
+ /* IPEMEnvelopeFollower, per channel */
+ for (c=0;c<nchan;c++)
+    for (e=0,j=0;j<ncols;j++)
+    {a=fabs(x[j*nchan+c]);
+     e=(a>e) ? a+fa*(e-a) : a+fr*(e-a);
+     renv[j*nchan+c]=e;
+    }
+ ok=report("flux",compare(flux,rflux,ncols)<1e-12);
+ return report("envelope",compare(env,renv,ncols*nchan)<1e-12) && ok;
+}
+
+int main()
+{static double x[ncols*nchan];
+ int ok;
+
+ make_signal(x);
+ ok=test_rms(x,40,10,"rms, width 4 steps");
+ ok=test_rms(x,37,10,"rms, width 3.7 steps") && ok;
+ ok=test_rms(x,5,8,"rms, step > width") && ok;
+ ok=test_flux_envelope(x) && ok;
+ return !ok;
+}
@@ -0,0 +1,119 @@
+/* mectest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE MEC ANALYSIS
+
+    Runs the MEC analysis of analysis/mec.c on a short synthetic
+    signal of a few channels and compares it with a reference that
+    follows the Matlab version of IPEMMECAnalysis: the signal preceded
+    by MaxPeriod zeros, the difference values abs(x(i)-x(i-Period))
+    for i every StepSize samples, then IPEMLeakyIntegration of each
+    period at the rate of the values. With and without the
+    integration, on 1 and on 4 threads.
+
+    Usage: mectest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mec.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          2000.0
+#define  nchan       3
+#define  nsignal     700
+#define  min_period  2
+#define  max_period  45
+#define  step        3
+#define  nperiods    (max_period-min_period+1)
+#define  max_frames  ((nsignal-1)/step+1)
+#define  half_decay  0.02
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* pulse trains of a different period in every channel (column major) */
+static void make_signal(double *x)
+{long c,t;
+
+ for (t=0;t<nsignal;t++)
+    for (c=0;c<nchan;c++)
+       x[t*nchan+c]=pow(fabs(sin(M_PI*t/(10+7*c))),8)+0.1*sin(0.05*t*(c+1));
+}
+
+/* IPEMMECAnalysis of channel c */
+static void reference(const double *x,long c,double coef,double *values)
+{double padded[max_period+nsignal];
+ long   i,k,p;
+
+ for (i=0;i<max_period;i++) padded[i]=0;
+ for (i=0;i<nsignal;i++) padded[max_period+i]=x[i*nchan+c];
+ for (k=0,i=max_period;i<max_period+nsignal;i+=step,k++)
+    for (p=min_period;p<=max_period;p++)
+       values[k*nperiods+p-min_period]=fabs(padded[i]-padded[i-p]);
+ /* filter(1,[1 -coef],Values,[],2) */
+ for (k=1;k<max_frames;k++)
+    for (p=0;p<nperiods;p++) values[k*nperiods+p]+=coef*values[(k-1)*nperiods+p];
+}
+
+static int test_case(const double *x,double half,const char *what)
+{static double out[2][nchan][nperiods*max_frames],ref[nperiods*max_frames];
+ double *values[nchan];
+ double  coef=(half!=0) ? pow(2.0,-1/(fs/step*half)) : 0,err=0,big=0;
+ long    c,i;
+ int     ok=(mec_frames(nsignal,step)==max_frames),t;
+
+ for (t=0;ok && t<2;t++)
+ {for (c=0;c<nchan;c++) values[c]=out[t][c];
+  ok=mec_analysis(x,nchan,nsignal,min_period,max_period,step,coef,values,
+                  (t==0) ? 1 : 4);
+ }
+ for (c=0;ok && c<nchan;c++)
+ {reference(x,c,coef,ref);
+  for (i=0;i<nperiods*max_frames;i++)
+  {ok=ok && (out[0][c][i]==out[1][c][i]);
+   if (fabs(ref[i])>big) big=fabs(ref[i]);
+   if (fabs(out[0][c][i]-ref[i])>err) err=fabs(out[0][c][i]-ref[i]);
+  }
+ }
+ return report(what,ok && (err<=1e-12*big));
+}
+
+int main()
+{static double x[nchan*nsignal];
+ int ok;
+
+ make_signal(x);
+ ok=test_case(x,0,"differences");
+ ok=test_case(x,half_decay,"leaky integrated") && ok;
+ return !ok;
+}
@@ -0,0 +1,324 @@
+/* onsettest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE ONSET DETECTION
+
+    Feeds a short synthetic ANI with a few attacks to the streaming
+    onset detection of analysis/onset.c, in blocks of odd sizes and a
+    frame at a time, and
+    compares the onsets it reports with those of a reference that
+    follows the Matlab version of IPEMCalcOnsetsFromANI on the whole
+    ANI at once, step by step: IPEMCalcRMS, butter and filter with the
+    delay of the peak of impz, Peak4 of IPEMOnsetPeakDetection1Channel
+    (IPEMClip, medfilt1, IPEMFindAllPeaks, IPEMFindNearestMinima,
+    IPEMCreateMask), resample(x,16,1), IPEMOnsetPattern and
+    IPEMOnsetPatternFilter. The reference keeps the 1-based indices
+    of the Matlab code. The onsets (sample and strength) and the
+    length of the onset signal must be the same.
+
+    Usage: onsettest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "onset.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          2000.0
+#define  nchan       40
+#define  ncols       6000      /* 3 s                                  */
+#define  max_onsets  100
+#define  up          16        /* resample(x,16,1)                     */
+#define  up_n        10
+#define  up_half     (up_n*up)
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* attacks that decay, each in a band of channels and a few ms later
+   in some of them, over a little noise */
+static void make_ani(double *ani)
+{static const double at[]={0.35,0.9,1.3,1.45,2.1,2.6};
+ static const long   lo[]={0,10,5,20,0,28},hi[]={40,22,30,40,14,40};
+ unsigned long r=99;
+ long          c,j,a;
+ double        t,t0,v;
+
+ for (j=0;j<ncols;j++)
+ {t=j/fs;
+  for (c=0;c<nchan;c++)
+  {r=(r*1103515245+12345)%2147483648UL;
+   v=0.02+0.01*((double)(r>>8)/8388608.0);
+   for (a=0;a<6;a++)
+   {t0=at[a]+0.006*((7*c+a)%4);
+    if ((t>=t0) && (c>=lo[a]) && (c<hi[a]) && ((c+3*a)%5!=0))
+       v+=(0.3+0.2*sin(0.4*c+a))*exp(-(t-t0)/0.12)*(1-exp(-(t-t0)/0.005));
+   }
+   ani[j*nchan+c]=v;
+  }
+ }
+}
+
+/* Reference */
+
+typedef struct{
+               long   n;
+               long   index[max_onsets];
+               double strength[max_onsets];
+               long   length;
+              } onsets;
+
+static double bessel_i0(double x)
+{double sum=1,term=1;
+ int    k;
+
+ for (k=1;k<60;k++) {term*=(x/(2*k))*(x/(2*k)); sum+=term;}
+ return sum;
+}
+
+static int by_value(const void *a,const void *b)
+{double x=*(const double*)a,y=*(const double*)b;
+
+ return (x<y) ? -1 : (x>y) ? 1 : 0;
+}
+
+/* medfilt1(x(1..n),w): zero padded, x(k-w/2..k+w/2-1) for an even w */
+static void medfilt1(const double *x,long n,long w,double *y)
+{double *v=(double*)malloc(w*sizeof(double));
+ long    k,i,lo=(w%2==1) ? (w-1)/2 : w/2;
+
+ for (k=1;k<=n;k++)
+ {for (i=0;i<w;i++) v[i]=((k-lo+i>=1) && (k-lo+i<=n)) ? x[k-lo+i] : 0;
+  qsort(v,w,sizeof(double),by_value);
+  y[k]=(w%2==1) ? v[w/2] : (v[w/2-1]+v[w/2])/2;
+ }
+ free(v);
+}
+
+/* Peak4 of IPEMOnsetPeakDetection1Channel on x(1..n); importances to out(1..n) */
+static void peak4(double *x,long n,double sfs,double *out)
+{long    w1=(long)floor(0.07*sfs+0.5),h1=w1/2,w2=(long)floor(0.5*sfs+0.5);
+ double *med=(double*)calloc(n+1,sizeof(double));
+ double *peaks=(double*)calloc(n+1,sizeof(double));
+ double *mask=(double*)calloc(n+1,sizeof(double));
+ long   *idx=(long*)calloc(n+1,sizeof(long));
+ long    npk=0,i,k,start,left,right;
+ double  prev,m,alpha=-log(0.5);
+
+ for (i=1;i<=n;i++) if (x[i]<0.06) x[i]=0.05;
+ medfilt1(x,n,w2,med);
+ /* IPEMFindAllPeaks, 'center' */
+ for (start=0,i=1;i<n;i++)
+ {if (x[i+1]-x[i]>0) start=i;
+  else if ((x[i+1]-x[i]<0) && (start!=0)) {idx[npk++]=(i+start+1)/2; start=0;}
+ }
+ /* peaks whose nearest minimum to the left is above 90% of them */
+ for (k=0;k<npk;k++)
+ {prev=x[idx[k]]; left=0;
+  for (i=idx[k]-1;i>=1;i--)
+  {if (x[i]>prev) {left=i+1; break;}
+   prev=x[i]; left=i;
+  }
+  if (x[left]>0.9*x[idx[k]]) idx[k]=0;
+ }
+ for (k=0;k<npk;k++) if (idx[k]>0) peaks[idx[k]]=x[idx[k]];
+ /* IPEMCreateMask(theTime,indices/fs,amplitudes,0.2) */
+ for (k=0;k<npk;k++)
+    if (idx[k]>0)
+       for (i=1;i<=n;i++)
+          if ((i-1)/sfs>=idx[k]/sfs)
+          {m=peaks[idx[k]]*exp(-((i-1)/sfs-idx[k]/sfs)/0.2*alpha);
+           if (m>mask[i]) mask[i]=m;
+          }
+ for (i=1;i<=n;i++) if (mask[i]>peaks[i]) peaks[i]=0;
+ for (npk=0,i=1;i<=n;i++) if (peaks[i]>0) idx[npk++]=i;
+ for (k=0;k<npk;k++)
+ {left=(idx[k]-h1>1) ? idx[k]-h1 : 1; right=(idx[k]+h1<n) ? idx[k]+h1 : n;
+  for (m=peaks[left],i=left;i<=right;i++) if (peaks[i]>m) m=peaks[i];
+  if (peaks[idx[k]]<m) peaks[idx[k]]=0;
+  else if (peaks[idx[k]]<1.2*med[idx[k]]) peaks[idx[k]]=0;
+  else peaks[idx[k]]=(x[idx[k]]-med[idx[k]])/med[idx[k]];
+ }
+ for (i=1;i<=n;i++)
+ {out[i]=0;
+  if (peaks[i]>0) out[i]=(2*peaks[i]>1) ? 1 : 2*peaks[i];
+ }
+ free(med); free(peaks); free(mask); free(idx);
+}
+
+static void reference(const double *ani,onsets *result)
+{long    width=(long)floor(0.029*fs+0.5),step=(long)floor(0.0058*fs+0.5);
+ double  sfs=fs/step,ofs=sfs*up;
+ long    nrms=(ncols-width)/step+1,nf,delay,i,j,k,c,n,m,w,d,count;
+ double *rms,*x,*ons,*h,*pattern,*a,*refract,*out,*prev,*sense;
+ double  b0,b1,b2,a1,a2,kk,nn,y,z1,z2,hmax,sum,in;
+
+ /* IPEMCalcRMS(ANI,fs,0.029,0.0058) */
+ rms=(double*)calloc(nrms*nchan,sizeof(double));
+ for (k=0;k<nrms;k++)
+    for (c=0;c<nchan;c++)
+    {for (sum=0,j=k*step;j<k*step+width;j++) sum+=ani[j*nchan+c]*ani[j*nchan+c];
+     rms[k*nchan+c]=sqrt(sum/width);
+    }
+ /* butter(2,15/(RMSFreq/2)), filter, delay of the peak of impz */
+ kk=tan(M_PI*(15/(sfs/2))/2); nn=1/(1+sqrt(2.0)*kk+kk*kk);
+ b0=kk*kk*nn; b1=2*b0; b2=b0; a1=2*(kk*kk-1)*nn; a2=(1-sqrt(2.0)*kk+kk*kk)*nn;
+ for (delay=0,hmax=0,z1=z2=0,i=0;i<4096;i++)
+ {in=(i==0) ? 1 : 0;
+  y=b0*in+z1; z1=b1*in+z2-a1*y; z2=b2*in-a2*y;
+  if (y>hmax) {hmax=y; delay=i;}
+ }
+ for (c=0;c<nchan;c++)
+    for (z1=z2=0,k=0;k<nrms;k++)
+    {in=rms[k*nchan+c];
+     y=b0*in+z1; z1=b1*in+z2-a1*y; z2=b2*in-a2*y;
+     rms[k*nchan+c]=y;
+    }
+ nf=nrms-delay;
+
+ /* IPEMOnsetPeakDetection, channel by channel (1-based) */
+ x=(double*)calloc(nf+1,sizeof(double));
+ ons=(double*)calloc((nf+1)*nchan,sizeof(double));
+ for (c=0;c<nchan;c++)
+ {for (k=1;k<=nf;k++) x[k]=rms[(delay+k-1)*nchan+c];
+  peak4(x,nf,sfs,ons+c*(nf+1));
+ }
+
+ /* resample(Onsets',16,1)': firls of the ideal low-pass (a sinc) with
+    a Kaiser window of beta 5, scaled to a sum of 16, delay 160 */
+ h=(double*)calloc(2*up_half+1,sizeof(double));
+ for (sum=0,i=0;i<=2*up_half;i++)
+ {d=i-up_half;
+  h[i]=(d==0) ? 1.0/up : sin(M_PI*d/up)/(M_PI*d);
+  h[i]*=bessel_i0(5*sqrt(1-((double)d/up_half)*((double)d/up_half)))/bessel_i0(5);
+  sum+=h[i];
+ }
+ for (i=0;i<=2*up_half;i++) h[i]*=up/sum;
+ m=nf*up;
+ pattern=(double*)calloc(m*nchan,sizeof(double));
+ for (c=0;c<nchan;c++)
+    for (n=0;n<m;n++)
+    {for (sum=0,k=0;k<nf;k++)
+     {i=n-up*k+up_half;
+      if ((i>=0) && (i<=2*up_half)) sum+=ons[c*(nf+1)+k+1]*h[i];
+     }
+     pattern[n*nchan+c]=sum;
+    }
+
+ /* IPEMOnsetPattern */
+ a=(double*)calloc(nchan,sizeof(double));
+ refract=(double*)calloc(nchan,sizeof(double));
+ out=(double*)calloc(nchan,sizeof(double));
+ prev=(double*)calloc(nchan,sizeof(double));
+ sense=(double*)calloc(nchan,sizeof(double));
+ for (n=0;n<m;n++)
+ {for (i=0;i<nchan;i++)
+  {sense[i]=1;
+   if (refract[i]>0) {sense[i]=0; refract[i]-=1/ofs;}
+  }
+  for (i=0;i<nchan;i++)
+  {for (in=0,k=0;k<nchan;k++)
+   {if (labs(k-i)<=3) in+=pattern[n*nchan+k]*2;
+    if ((labs(k-i)<=10) && (k!=i)) in+=prev[k]*0.5;
+   }
+   a[i]=(1-0.4)*a[i]+in*sense[i];
+  }
+  for (i=0;i<nchan;i++)
+  {out[i]=0;
+   if (a[i]>7) {out[i]=1; a[i]=0; refract[i]=0.04;}
+  }
+  for (i=0;i<nchan;i++) {pattern[n*nchan+i]=out[i]; prev[i]=out[i];}
+ }
+
+ /* IPEMOnsetPatternFilter (1-based) */
+ w=(long)floor(0.03*ofs+0.5); d=(long)floor(0.04*ofs+0.5);
+ result->n=0; result->length=m;
+ for (i=1;i<m;)
+ {for (count=0,k=i;k<=((i+w-1<m) ? i+w-1 : m);k++)
+     for (c=0;c<nchan;c++) count+=(pattern[(k-1)*nchan+c]!=0);
+  for (sum=0,c=0;c<nchan;c++) sum+=pattern[(i-1)*nchan+c];
+  if ((sum!=0) && ((double)count/nchan>=9.0/40) && (result->n<max_onsets))
+  {result->index[result->n]=i-1; result->strength[result->n]=(double)count/nchan;
+   result->n++; i+=d;
+  }
+  else i++;
+ }
+ free(rms); free(x); free(ons); free(h); free(pattern);
+ free(a); free(refract); free(out); free(prev); free(sense);
+}
+
+/* Streaming detector */
+
+static void add_onset(void *context,long index,double strength)
+{onsets *o=(onsets*)context;
+
+ if (o->n>=max_onsets) return;
+ o->index[o->n]=index; o->strength[o->n]=strength; o->n++;
+}
+
+/* the whole ANI in blocks of the given sizes, in turn */
+static int test_detector(const double *ani,const onsets *ref,const long *sizes,
+                         long nsizes,const char *what)
+{onset_state s;
+ onsets      got;
+ long        done,n,i;
+ int         ok;
+
+ got.n=0;
+ if (!onset_open(&s,nchan,fs,add_onset,&got)) return report(what,0);
+ for (done=0,i=0;done<ncols;done+=n,i++)
+ {n=sizes[i%nsizes];
+  if (n>ncols-done) n=ncols-done;
+  onset_block(&s,ani+done*nchan,n);
+ }
+ got.length=onset_finish(&s);
+ onset_close(&s);
+ ok=(got.length==ref->length) && (got.n==ref->n);
+ for (i=0;ok && i<ref->n;i++)
+    ok=(got.index[i]==ref->index[i]) && (got.strength[i]==ref->strength[i]);
+ return report(what,ok);
+}
+
+int main()
+{static double ani[ncols*nchan];
+ static const long blocks[]={1,17,250,3,1000},frame[]={1};
+ onsets ref;
+ int    ok;
+
+ make_ani(ani);
+ reference(ani,&ref);
+ ok=report("reference has onsets",ref.n>=4);
+ ok=test_detector(ani,&ref,blocks,5,"onsets, in blocks") && ok;
+ ok=test_detector(ani,&ref,frame,1,"onsets, frame by frame") && ok;
+ return !ok;
+}
@@ -0,0 +1,200 @@
+/* roughnesstest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE ROUGHNESS
+
+    Computes the roughness of analysis/roughness.c for a short
+    synthetic ANI of amplitude modulated channels and compares the
+    roughness, the energy per channel and the energy per frequency
+    with a reference that follows the Matlab version of
+    IPEMRoughnessFFT: the frames windowed with hamming, the magnitudes
+    of DC and of the bins Begin:End from a direct DFT of NFFT points,
+    the synchronization filters of FilterWeights and the channel
+    weights of linspace(1,0.45,...). With the 40 channels of the
+    Matlab version, and with an odd number of channels, so that the
+    last one is transformed on its own.
+
+    Usage: roughnesstest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "roughness.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          2000.0
+#define  max_chan    40
+#define  ncols       2000      /* 1 s                                  */
+#define  width       0.2
+#define  step        0.02
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* half wave rectified carriers, modulated at 70 Hz in the lower and
+   at 30 Hz in the upper channels, over a little noise */
+static void make_ani(double *ani,long nchan)
+{unsigned long r=5;
+ long          c,j;
+ double        t,fm;
+
+ for (j=0;j<ncols;j++)
+ {t=j/fs;
+  for (c=0;c<nchan;c++)
+  {r=(r*1103515245+12345)%2147483648UL;
+   fm=(c<nchan/2) ? 70 : 30;
+   ani[j*nchan+c]=0.05+0.01*((double)(r>>8)/8388608.0)
+                  +0.3*(1+sin(2*M_PI*fm*t))*fmax(0,sin(2*M_PI*(300+17*c)*t));
+  }
+ }
+}
+
+/* largest difference relative to the magnitude of the values */
+static double compare(const double *a,const double *b,long n)
+{double err=0,big=1e-12;
+ long   i;
+
+ for (i=0;i<n;i++)
+ {if (fabs(b[i])>big) big=fabs(b[i]);
+  if (fabs(a[i]-b[i])>err) err=fabs(a[i]-b[i]);
+ }
+ return err/big;
+}
+
+static double round_matlab(double x)
+{
+ return (x<0) ? -floor(-x+0.5) : floor(x+0.5);
+}
+
+/* FilterWeights of IPEMRoughnessFFT for channel win, bins Begin:End (1-based) */
+static void filter_weights(long win,long Begin,long End,double *attenuate)
+{double sigmoid,max_hz,bw_hz,filter[1024],roughness[2048],peak=0,lo,hi;
+ long   max_at,bw,k,n,max_filter=1;
+
+ sigmoid=pow(win/40.0,2)/(0.04+pow(win/40.0,2.8))-win*0.007;
+ max_hz=20+52*sigmoid;
+ max_at=(long)round_matlab(End*(max_hz/300));
+ sigmoid=pow(win/40.0,2)/(0.04+pow(win/40.0,2.45))-win*0.007;
+ bw_hz=10+300*sigmoid;
+ bw=(long)round_matlab(End*(bw_hz/310));
+ for (k=1;k<=bw;k++)
+ {filter[k]=exp(-8.0*k/bw)*(1-cos(2*M_PI*k/(10.0*bw)));
+  if (!(filter[k]>0)) filter[k]=0;
+  if (filter[k]>peak) peak=filter[k];
+ }
+ for (k=1;k<=bw;k++) filter[k]/=peak;
+ for (k=bw;k>=1;k--) if (filter[k]==1) max_filter=k;
+ /* [zeros(1,MaximumInSamples-MaxFilterInSamples) FilterInSamples zeros(1,NAddZeros)] */
+ for (n=0,k=1;k<=max_at-max_filter;k++) roughness[++n]=0;
+ for (k=1;k<=bw;k++) roughness[++n]=filter[k];
+ for (k=1;k<=End-(max_at-max_filter+bw);k++) roughness[++n]=0;
+ lo=hi=roughness[Begin];
+ for (k=Begin;k<=End;k++)
+ {if (roughness[k]<lo) lo=roughness[k];
+  if (roughness[k]>hi) hi=roughness[k];
+ }
+ for (k=Begin;k<=End;k++) attenuate[k-Begin]=roughness[k]*1/(hi-lo)-lo;
+}
+
+/* IPEMRoughnessFFT, with a direct DFT of DC and of the band */
+static long reference(const double *ani,long nchan,double *rough,double *bychan,
+                      double *byfreq)
+{long    w=(long)round_matlab(width*fs),s=(long)round_matlab(step*fs);
+ long    nfft,Begin=0,End=0,nb,i,c,k,n,bin,counter=0;
+ double  f,re,im,a,dc,t,sum;
+ double *win=(double*)malloc(w*sizeof(double));
+ double *weights=(double*)malloc(max_chan*256*sizeof(double));
+
+ for (nfft=1;nfft<w;nfft*=2);
+ for (k=1;k<=nfft/2+1;k++)
+ {f=(k-1.0)/nfft*fs;
+  if (f<=roughness_low) Begin=k;
+  if (f<=roughness_high) End=k;
+ }
+ nb=End-Begin+1;
+ for (n=0;n<w;n++) win[n]=0.54-0.46*cos(2*M_PI*n/(w-1));
+ for (c=0;c<nchan;c++)
+ {filter_weights(c+1,Begin,End,weights+c*nb);
+  for (k=0;k<nb;k++) weights[c*nb+k]*=1+c*(0.45-1)/(nchan-1);
+ }
+
+ for (i=1;i<=ncols-w+1;i+=s,counter++)
+ {for (k=0;k<nb;k++) byfreq[counter*nb+k]=0;
+  rough[counter]=0;
+  for (c=0;c<nchan;c++)
+  {for (dc=0,n=0;n<w;n++) dc+=win[n]*ani[(i-1+n)*nchan+c];
+   dc=fabs(dc);
+   for (sum=0,k=0;k<nb;k++)
+   {bin=Begin-1+k;
+    for (re=im=0,n=0;n<w;n++)
+    {t=win[n]*ani[(i-1+n)*nchan+c];
+     re+=t*cos(2*M_PI*((bin*n)%nfft)/nfft); im-=t*sin(2*M_PI*((bin*n)%nfft)/nfft);
+    }
+    a=weights[c*nb+k]/dc*pow(sqrt(re*re+im*im),roughness_alfa);
+    sum+=a; byfreq[counter*nb+k]+=a;
+   }
+   bychan[counter*nchan+c]=sqrt(sum/nfft/w);
+   rough[counter]+=bychan[counter*nchan+c];
+  }
+  rough[counter]/=nchan;
+  for (k=0;k<nb;k++) byfreq[counter*nb+k]=sqrt(byfreq[counter*nb+k]/nfft/w);
+ }
+ free(win); free(weights);
+ return counter;
+}
+
+static int test_case(long nchan,const char *what)
+{static double ani[ncols*max_chan],rough[ncols],bychan[ncols*max_chan],byfreq[ncols*256];
+ static double rrough[ncols],rbychan[ncols*max_chan],rbyfreq[ncols*256];
+ roughness_plan p;
+ long           n,nref;
+ int            ok;
+
+ make_ani(ani,nchan);
+ if (!roughness_plan_open(&p,nchan,fs,width,step)) return report(what,0);
+ n=roughness_frames(&p,ncols);
+ ok=(p.nbins<=256) && roughness_compute(&p,ani,ncols,rough,bychan,byfreq);
+ nref=reference(ani,nchan,rrough,rbychan,rbyfreq);
+ ok=ok && (n==nref) && (n>10) && (roughness_rate(&p)==fs/round_matlab(step*fs))
+       && (compare(rough,rrough,n)<1e-9) && (compare(bychan,rbychan,n*nchan)<1e-9)
+       && (compare(byfreq,rbyfreq,n*p.nbins)<1e-9);
+ roughness_plan_close(&p);
+ return report(what,ok);
+}
+
+int main()
+{int ok;
+
+ ok=test_case(40,"40 channels");
+ ok=test_case(7,"7 channels") && ok;
+ return !ok;
+}
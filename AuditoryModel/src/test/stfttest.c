@@ -0,0 +1,217 @@
+/* stfttest.c */
+
+/*------------------------------------------------------------------------------
+    IPEM Toolbox - Toolbox for perception-based music analysis 
+    Copyright (C) 2005 Ghent University 
+    
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------*/
+
+/*********************************************************************
+
+    TEST OF THE SHORT-TIME FOURIER TRANSFORM
+
+    Compares the real FFT of analysis/stft.c with a direct DFT for
+    sizes with radix 4, 2, 3, 5 and larger prime factors, and checks
+    that the inverse gives the signal back. Then compares the
+    magnitudes of stft_compute, as IPEMCalcSpectrogram computes them
+    (Matlab's specgram: a direct DFT of each windowed, zero padded
+    frame, divided by width/2), for an FFT size of a power of two, one
+    that is not, and a hop larger than the width; and checks the
+    maximum over decimate frames, the dB output, a signal shorter than
+    one frame, a signal given in blocks of odd sizes and the result
+    on 1 and 3 threads.
+
+    Usage: stfttest
+    Prints one line per check and exits with 0 if all of them pass.
+
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "stft.h"
+
+#if !defined(M_PI)
+#define M_PI  3.14159265358979323846
+#endif
+
+#define  fs          8000.0
+#define  nsignal     3000
+#define  max_fft     512
+
+static int report(const char *what,int ok)
+{
+ printf("%-28s %s\n",what,ok ? "ok" : "FAILED");
+ return ok;
+}
+
+/* two tones, a chirp and a little noise */
+static void make_signal(double *x,long n)
+{unsigned long r=4321;
+ long          i;
+
+ for (i=0;i<n;i++)
+ {r=(r*1103515245+12345)%2147483648UL;
+  x[i]=0.4*sin(2*M_PI*300*i/fs)+0.2*cos(2*M_PI*2210*i/fs)
+      +0.1*sin(2*M_PI*(100+0.5*i)*i/fs)+0.01*((double)(r>>8)/8388608.0-0.5);
+ }
+}
+
+/* direct DFT of x[0..n-1], bins 0..n/2 */
+static void dft(const double *x,long n,double *re,double *im)
+{long k,i;
+
+ for (k=0;k<=n/2;k++)
+ {re[k]=im[k]=0;
+  for (i=0;i<n;i++)
+  {re[k]+=x[i]*cos(2*M_PI*((k*i)%n)/n);
+   im[k]-=x[i]*sin(2*M_PI*((k*i)%n)/n);
+  }
+ }
+}
+
+/* largest difference relative to the magnitude of the values */
+static double compare(const double *a,const double *b,long n)
+{double err=0,big=1e-12;
+ long   i;
+
+ for (i=0;i<n;i++)
+ {if (fabs(b[i])>big) big=fabs(b[i]);
+  if (fabs(a[i]-b[i])>err) err=fabs(a[i]-b[i]);
+ }
+ return err/big;
+}
+
+static int test_fft(void)
+{static const long sizes[]={1,2,8,12,15,64,97,100,360,512};
+ double   x[max_fft],y[max_fft],re[max_fft/2+1],im[max_fft/2+1];
+ double   dre[max_fft/2+1],dim[max_fft/2+1],*work;
+ stft_fft f;
+ long     s,n,i;
+ int      ok=1,inv=1;
+
+ for (s=0;s<(long)(sizeof(sizes)/sizeof(sizes[0]));s++)
+ {n=sizes[s];
+  for (i=0;i<n;i++) x[i]=sin(0.3*i*i+1)+0.1*i/n;
+  if (!stft_fft_open(&f,n)) {ok=0; continue;}
+  work=(double*)malloc(stft_fft_work(&f)*sizeof(double));
+  if (work==NULL) {stft_fft_close(&f); ok=0; continue;}
+  stft_fft_real(&f,x,re,im,work);
+  dft(x,n,dre,dim);
+  if (compare(re,dre,n/2+1)>1e-12 || compare(im,dim,n/2+1)>1e-12) ok=0;
+  stft_fft_inverse(&f,re,im,y,work);
+  if (compare(y,x,n)>1e-12) inv=0;
+  free(work);
+  stft_fft_close(&f);
+ }
+ report("fft, against direct DFT",ok);
+ report("fft, inverse",inv);
+ return ok && inv;
+}
+
+/* magnitudes of the frames of x[0..length-1] as specgram, decimate
+   frames per column (the maximum), into ref (nbins per column);
+   returns the number of columns */
+static long reference(const stft_plan *p,const double *x,long length,
+                      long decimate,double *ref)
+{double xw[max_fft],re[max_fft/2+1],im[max_fft/2+1],m;
+ long   nframes,f,i,k,col;
+
+ nframes=(length<p->width) ? 1 : (length-p->width)/p->hop+1;
+ for (f=0;f<nframes;f++)
+ {for (i=0;i<p->nfft;i++)
+     xw[i]=(i<p->width && f*p->hop+i<length) ? x[f*p->hop+i]*p->window[i] : 0;
+  dft(xw,p->nfft,re,im);
+  col=f/decimate;
+  for (k=0;k<p->nbins;k++)
+  {m=sqrt(re[k]*re[k]+im[k]*im[k])/(p->width/2.0);
+   if (f%decimate==0 || m>ref[col*p->nbins+k]) ref[col*p->nbins+k]=m;
+  }
+ }
+ return (nframes+decimate-1)/decimate;
+}
+
+/* one case of stft_compute against the reference; the magnitudes are
+   single precision */
+static int test_case(const char *what,const double *x,long length,long width,
+                     long hop,long nfft,int window,long decimate)
+{static float  out[2][nsignal*(max_fft/2+1)];
+ static double ref[nsignal*(max_fft/2+1)],got[nsignal*(max_fft/2+1)];
+ stft_plan p;
+ long      ncols,n,i;
+ int       ok;
+
+ if (!stft_plan_open(&p,fs,width,hop,nfft,window,NULL)) return report(what,0);
+ ncols=stft_columns(&p,length,decimate);
+ ok=(stft_compute(&p,x,length,stft_magnitude,decimate,1,out[0])==ncols)
+    && (stft_compute(&p,x,length,stft_magnitude,decimate,3,out[1])==ncols);
+ if (ok)
+ {n=ncols*p.nbins;
+  for (i=0;i<n;i++) {got[i]=out[0][i]; ok=ok && (out[0][i]==out[1][i]);}
+  ok=ok && (reference(&p,x,length,decimate,ref)==ncols)
+        && (compare(got,ref,n)<1e-6);
+ }
+ stft_plan_close(&p);
+ return report(what,ok);
+}
+
+/* dB output against the magnitudes, and the signal in blocks of odd
+   sizes against stft_compute */
+static int test_output(const double *x)
+{static float mag[nsignal*129],db[nsignal*129],blk[nsignal*129];
+ stft_plan   p;
+ stft_stream s;
+ long        ncols,nbins,i,done,size,n,m;
+ int         ok,okb;
+
+ if (!stft_plan_open(&p,fs,256,80,0,stft_hamming,NULL)) return report("dB output",0);
+ nbins=p.nbins;
+ ncols=stft_compute(&p,x,nsignal,stft_magnitude,2,1,mag);
+ ok=(ncols==stft_columns(&p,nsignal,2))
+    && (stft_compute(&p,x,nsignal,stft_db,2,1,db)==ncols);
+ for (i=0;ok && i<ncols*nbins;i++)
+    ok=(mag[i]>0) ? fabs(db[i]-20*log10(mag[i]))<1e-3 : db[i]==(float)stft_floor_db;
+ report("dB output",ok);
+
+ okb=stft_stream_open(&s,&p,stft_magnitude,2,2);
+ for (done=0,m=0,i=0;okb && done<nsignal;done+=size,i++)
+ {size=(i%3==0) ? 1 : (i%3==1) ? 77 : 301;
+  if (size>nsignal-done) size=nsignal-done;
+  n=stft_stream_block(&s,x+done,size,blk+m*nbins);
+  okb=(n>=0); m+=n;
+ }
+ if (okb) {n=stft_stream_end(&s,blk+m*nbins); okb=(n>=0); m+=n;}
+ stft_stream_close(&s);
+ for (okb=okb && (m==ncols),i=0;okb && i<ncols*nbins;i++) okb=(blk[i]==mag[i]);
+ stft_plan_close(&p);
+ report("blocks of odd sizes",okb);
+ return ok && okb;
+}
+
+int main()
+{static double x[nsignal];
+ int ok;
+
+ make_signal(x,nsignal);
+ ok=test_fft();
+ ok=test_case("hanning, nfft 256",x,nsignal,256,64,0,stft_hanning,1) && ok;
+ ok=test_case("hanning, nfft 300",x,nsignal,200,64,300,stft_hanning,1) && ok;
+ ok=test_case("boxcar, hop > width",x,nsignal,45,70,45,stft_boxcar,1) && ok;
+ ok=test_case("blackman, decimate 3",x,nsignal,128,50,0,stft_blackman,3) && ok;
+ ok=test_case("shorter than one frame",x,100,256,64,0,stft_hanning,1) && ok;
+ ok=test_output(x) && ok;
+ return !ok;
+}
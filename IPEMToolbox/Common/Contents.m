@@ -9,6 +9,7 @@
 %   IPEMBlockDC                     - Blocks DC (very low frequencies)
 %   IPEMCalcCentroid                - Calculate centroid of multi-channel over signal
 %   IPEMCalcCentroidWidth           - Calculate centroid width over multi-channel signal
+%   IPEMCalcDescriptors             - Calculate spectral descriptors of signal in one pass
 %   IPEMCalcFFT                     - Calculate (and show) FFT of signal
 %   IPEMCalcFlux                    - Calculate flux over multi-channel signal
 %   IPEMCalcMeanAndVariance         - Calculate mean and variance over signal
@@ -67,6 +68,7 @@
 %   IPEMCalcANI                     - Calculate auditory nerve image from signal
 %   IPEMCalcANIFromFile             - Calculate auditory nerve image directly from sound file
 %   IPEMLoadANI                     - Load auditory nerve image from mat file
+%   IPEMLoadANIPyramid              - Load one level of an auditory nerve image pyramid
 %   IPEMSaveANI                     - Save auditory nerve image to mat file
 %
 % + Contextuality
@@ -3,7 +3,8 @@ function [outANI,outANIFreq,outANIFilterFreqs] = IPEMCalcANI (varargin)
 %   [outANI,outANIFreq,outANIFilterFreqs] = ...
 %     IPEMCalcANI (inSignal,inSampleFreq,inAuditoryModelPath,...
 %                  inPlotFlag,inDownsamplingFactor,...
-%                  inNumOfChannels,inFirstCBU,inCBUStep)
+%                  inNumOfChannels,inFirstCBU,inCBUStep,...
+%                  inChannelScale,inChannelPositions)
 %
 % Description:
 %   This function calculates the auditory nerve image for the given signal.
@@ -12,6 +13,8 @@ function [outANI,outANIFreq,outANIFilterFreqs] = IPEMCalcANI (varargin)
 %   inSignal = the sound signal to be processed
 %   inSampleFreq = the sample frequency of the input signal (in Hz)
 %   inAuditoryModelPath = path to the working directory for the auditory model
+%                         (only used if the IPEMCalcANIMex gateway is not
+%                         available, see AuditoryModel/*_UNIX)
 %                         if empty or not specified, IPEMRootDir('code')\Temp
 %                         is used by default
 %   inPlotFlag = if non-zero, plots the ANI
@@ -26,10 +29,19 @@ function [outANI,outANIFreq,outANIFilterFreqs] = IPEMCalcANI (varargin)
 %                if empty or not specified, 2.0 is used by default
 %   inCBUStep = frequency difference between channels (in cbu)
 %               if empty or not specified, 0.5 is used by default
+%   inChannelScale = scale of inFirstCBU, inCBUStep and inChannelPositions:
+%                    'cbu', 'erb' (ERB-rate units), 'bark' or 'hz'
+%                    if empty or not specified, 'cbu' is used by default
+%   inChannelPositions = positions of the channels on inChannelScale, in
+%                        increasing order: only these channels are computed
+%                        (inNumOfChannels, inFirstCBU and inCBUStep are not
+%                        used then)
+%                        if empty or not specified, the channels are equally
+%                        spaced
 %
 % Output:
 %   outANI = a matrix of size [N M] representing the auditory nerve image,
-%            where N is the number of channels (currently 40) and
+%            where N is the number of channels (40 by default) and
 %                  M is the number of samples
 %   outANIFreq = sample freq of ANI (in Hz)
 %   outANIFilterFreqs = center frequencies used by the auditory model (in Hz)
@@ -70,8 +82,11 @@ fprintf(1,'Start of IPEMCalcANI...\n');
 
 % Handle input arguments
 [inSignal,inSampleFreq,inAuditoryModelPath,inPlotFlag,inDownsamplingFactor,...
-    inNumOfChannels,inFirstCBU,inCBUStep] = ...
-    IPEMHandleInputArguments(varargin,3,{[],[],fullfile(IPEMRootDir('code'),'Temp'),0,4,40,2.0,0.5});
+    inNumOfChannels,inFirstCBU,inCBUStep,inChannelScale,inChannelPositions] = ...
+    IPEMHandleInputArguments(varargin,3,{[],[],fullfile(IPEMRootDir('code'),'Temp'),0,4,40,2.0,0.5,'cbu',[]});
+if ~isempty(inChannelPositions)
+   inNumOfChannels = length(inChannelPositions);
+end
 
 % Additional checking
 if or(isempty(inSignal),isempty(inSampleFreq))
@@ -90,26 +105,63 @@ if (size(inSignal,1) ~= 1)
    end;
 end;
 
+% Resample the sound if needed (the auditory model runs at 22050 Hz)
+NewSampleFreq = 22050;
+if (inSampleFreq ~= NewSampleFreq)
+   inSignal = resample(inSignal,NewSampleFreq,inSampleFreq);
+end
+
+% Let the auditory model process the sound: the compiled gateway does this in
+% memory (including the silences and the downsampling), otherwise the model
+% communicates through files in the working directory
+if (exist('IPEMCalcANIMex') == 3)
+   [outANI,outANIFreq,outANIFilterFreqs] = IPEMCalcANIMex(inSignal,NewSampleFreq,...
+       inNumOfChannels,inFirstCBU,inCBUStep,inDownsamplingFactor,...
+       inChannelScale,double(inChannelPositions));
+else
+   [outANI,outANIFreq,outANIFilterFreqs] = CalcANIThroughFiles(inSignal,NewSampleFreq,...
+       inAuditoryModelPath,inDownsamplingFactor,inNumOfChannels,inFirstCBU,inCBUStep,...
+       inChannelScale,inChannelPositions);
+end;
+
+% Plot if needed
+if (inPlotFlag)
+    HFig = figure;
+    IPEMPlotMultiChannel(outANI,outANIFreq,'Auditory Nerve Image (ANI)','Time (in s)',...
+        'Auditory channels (center freqs. in Hz)',14,outANIFilterFreqs,3);
+    IPEMSetFigureLayout(HFig);
+end;
+
+% Elementary feedback
+fprintf(1,'...end of IPEMCalcANI.\n');
+
+% ------------------------------------------------------------------------------
+
+function [outANI,outANIFreq,outANIFilterFreqs] = CalcANIThroughFiles (inSignal,inSampleFreq,...
+    inAuditoryModelPath,inDownsamplingFactor,inNumOfChannels,inFirstCBU,inCBUStep,...
+    inChannelScale,inChannelPositions)
+
 % Store the current directory and change it to the path of the auditory model
 OldPath = cd;
 cd(inAuditoryModelPath);
 
-% Resample the sound if needed, and add silence before and after of 20 ms (for auditory model)
-NewSampleFreq = 22050;
-NZeros = round(0.020/(1/NewSampleFreq));
+% Add silence before and after of 20 ms (for auditory model)
+NZeros = round(0.020/(1/inSampleFreq));
 theZeros = zeros(1,NZeros);
-if (inSampleFreq ~= NewSampleFreq)
-   NewSound = [theZeros resample(inSignal,NewSampleFreq,inSampleFreq) theZeros];
-else
-   NewSound = [theZeros inSignal theZeros];
-end
+NewSound = [theZeros inSignal theZeros];
 
 % Write sound to a temp file
-wavwrite(NewSound,NewSampleFreq,16,'input.wav');
+wavwrite(NewSound,inSampleFreq,16,'input.wav');
 
 % Let the auditory model process the sound
 % (samplefreq. 22050 Hz, input.wav as input file, nerve_image.ani as output file)
-Result = IPEMProcessAuditoryModel('input.wav','','nerve_image.ani','',NewSampleFreq,inNumOfChannels,inFirstCBU,inCBUStep);
+% (the channel scale and positions need the interface in AuditoryModel/*_UNIX)
+if (strcmp(inChannelScale,'cbu') & isempty(inChannelPositions))
+    Result = IPEMProcessAuditoryModel('input.wav','','nerve_image.ani','',inSampleFreq,inNumOfChannels,inFirstCBU,inCBUStep);
+else
+    Result = IPEMProcessAuditoryModel('input.wav','','nerve_image.ani','',inSampleFreq,inNumOfChannels,inFirstCBU,inCBUStep,...
+                                      '',[],'',[],inChannelScale,inChannelPositions);
+end
 if (Result ~= 0)
     cd(OldPath);
     error('Error while processing file with IPEMProcessAuditoryModel...');
@@ -120,7 +172,7 @@ outANI = textread('nerve_image.ani','%f');
 outANI = reshape(outANI,inNumOfChannels,length(outANI)/inNumOfChannels);
 outANIFilterFreqs = dlmread('FilterFrequencies.txt',' ');
 outANIFilterFreqs = 1000*outANIFilterFreqs;
-outANIFreq = NewSampleFreq/2;
+outANIFreq = inSampleFreq/2;
 
 % Remove first and last samples added because of auditory model
 outANI = outANI(:,1+round(NZeros/2):end-round(NZeros/2));
@@ -146,14 +198,3 @@ if (inDownsamplingFactor ~= 1)
    outANI = resample(outANI',1,inDownsamplingFactor)';
    outANIFreq = outANIFreq/inDownsamplingFactor;
 end;
-
-% Plot if needed
-if (inPlotFlag)
-    HFig = figure;
-    IPEMPlotMultiChannel(outANI,outANIFreq,'Auditory Nerve Image (ANI)','Time (in s)',...
-        'Auditory channels (center freqs. in Hz)',14,outANIFilterFreqs,3);
-    IPEMSetFigureLayout(HFig);
-end;
-
-% Elementary feedback
-fprintf(1,'...end of IPEMCalcANI.\n');
@@ -0,0 +1,124 @@
+function [outANIs,outANIFreqs,outANIFilterFreqs] = IPEMCalcANIBatch (varargin)
+% Usage:
+%   [outANIs,outANIFreqs,outANIFilterFreqs] = ...
+%     IPEMCalcANIBatch (inSignals,inSampleFreqs,inDownsamplingFactor,...
+%                       inNumOfChannels,inFirstCBU,inCBUStep,...
+%                       inChannelScale,inChannelPositions,inNumOfThreads)
+%
+% Description:
+%   This function calculates the auditory nerve images of a set of signals,
+%   as IPEMCalcANI does for each of them.
+%
+% Input arguments:
+%   inSignals = the sound signals to be processed (cell array of vectors)
+%   inSampleFreqs = the sample frequency of the input signals (in Hz):
+%                   one for all signals, or one per signal
+%   inDownsamplingFactor = the integer factor by which the outcome of the
+%                          auditory model is downsampled
+%                          (use 1 for no downsampling)
+%                          if empty or not specified, 4 is used by default
+%   inNumOfChannels = number of channels to use
+%                     if empty or not specified, 40 is used by default
+%   inFirstCBU = frequency of first channel (in critical band units)
+%                if empty or not specified, 2.0 is used by default
+%   inCBUStep = frequency difference between channels (in cbu)
+%               if empty or not specified, 0.5 is used by default
+%   inChannelScale = scale of inFirstCBU, inCBUStep and inChannelPositions:
+%                    'cbu', 'erb' (ERB-rate units), 'bark' or 'hz'
+%                    if empty or not specified, 'cbu' is used by default
+%   inChannelPositions = positions of the channels on inChannelScale (see
+%                        IPEMCalcANI)
+%                        if empty or not specified, the channels are equally
+%                        spaced
+%   inNumOfThreads = number of threads used by the native version (see
+%                    remark 1)
+%                    if empty or not specified, one per processor is used
+%
+% Output:
+%   outANIs = cell array (of the size of inSignals) with the auditory nerve
+%             image of every signal
+%   outANIFreqs = sample freqs of the ANIs (in Hz)
+%   outANIFilterFreqs = center frequencies used by the auditory model (in Hz)
+%
+% Remarks:
+%   1. If IPEMCalcANIBatchMex is available, all signals are processed in one
+%      call, concurrently on a pool of native threads; otherwise IPEMCalcANI
+%      is called for one signal after another.
+%   2. As in IPEMCalcANI, the signals are first resampled to 22050 Hz.
+%
+% Example:
+%   [ANIs,ANIFreqs,ANIFilterFreqs] = IPEMCalcANIBatch({Signal1,Signal2},22050);
+%
+% Authors:
+%   IPEM - 20261019
+% ------------------------------------------------------------------------------
+
+% ------------------------------------------------------------------------------
+% IPEM Toolbox - Toolbox for perception-based music analysis 
+% Copyright (C) 2005 Ghent University
+% 
+% This program is free software; you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation; either version 2 of the License, or
+% (at your option) any later version.
+% 
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+% 
+% You should have received a copy of the GNU General Public License
+% along with this program; if not, write to the Free Software
+% Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+% ------------------------------------------------------------------------------
+
+% Handle input arguments
+[inSignals,inSampleFreqs,inDownsamplingFactor,inNumOfChannels,inFirstCBU,inCBUStep,...
+    inChannelScale,inChannelPositions,inNumOfThreads] = ...
+    IPEMHandleInputArguments(varargin,3,{[],[],4,40,2.0,0.5,'cbu',[],[]});
+if ~isempty(inChannelPositions)
+   inNumOfChannels = length(inChannelPositions);
+end
+
+% Additional checking
+if or(isempty(inSignals),isempty(inSampleFreqs))
+   error('ERROR: You must specify the input signals with their sample frequencies !');
+end
+if ~iscell(inSignals)
+   error('ERROR: The input signals must be given as a cell array !');
+end
+N = numel(inSignals);
+if (length(inSampleFreqs) == 1)
+   inSampleFreqs = repmat(inSampleFreqs,size(inSignals));
+elseif (length(inSampleFreqs) ~= N)
+   error('ERROR: Give one sample frequency, or one per signal !');
+end
+
+if (exist('IPEMCalcANIBatchMex') == 3)
+   
+   % The model runs at 22050 Hz (as in IPEMCalcANI)
+   NewSampleFreq = 22050;
+   for i = 1:N
+      if (min(size(inSignals{i})) ~= 1)
+         error('ERROR: Can only process single channel (mono) signals.');
+      end
+      if (inSampleFreqs(i) ~= NewSampleFreq)
+         inSignals{i} = resample(inSignals{i}(:)',NewSampleFreq,inSampleFreqs(i));
+      end
+   end
+   [outANIs,outANIFreqs,outANIFilterFreqs] = IPEMCalcANIBatchMex(inSignals,NewSampleFreq,...
+       inNumOfChannels,inFirstCBU,inCBUStep,inDownsamplingFactor,...
+       inChannelScale,double(inChannelPositions),inNumOfThreads);
+   
+else
+   
+   outANIs = cell(size(inSignals));
+   outANIFreqs = zeros(size(inSignals));
+   outANIFilterFreqs = cell(size(inSignals));
+   for i = 1:N
+      [outANIs{i},outANIFreqs(i),outANIFilterFreqs{i}] = IPEMCalcANI(inSignals{i},inSampleFreqs(i),...
+          [],0,inDownsamplingFactor,inNumOfChannels,inFirstCBU,inCBUStep,...
+          inChannelScale,inChannelPositions);
+   end
+   
+end
@@ -0,0 +1,191 @@
+function [outDescriptors,outDescriptorFreq] = IPEMCalcDescriptors (varargin)
+% Usage:
+%   [outDescriptors,outDescriptorFreq] = ...
+%     IPEMCalcDescriptors (inSignal,inSampleFreq,inFrameWidth,inFrameInterval,...
+%                          inDescriptors,inFreqs,inRolloffFraction,...
+%                          inZeroTolerance,inPlotFlag)
+%
+% Description:
+%   Calculates a set of frame-based descriptors of a signal in one pass: the
+%   centroid (IPEMCalcCentroid), centroid width (IPEMCalcCentroidWidth),
+%   rolloff (IPEMGetRolloff), zero-crossing rate (IPEMCalcZeroCrossingRate),
+%   crest factor (IPEMGetCrestFactor) and flux (IPEMCalcFlux).
+%   For a mono signal, they are calculated from the magnitude spectrum of
+%   every frame (see IPEMCalcSpectrogram) and, for the zero-crossing rate
+%   and crest factor, from its samples. For a multi-channel signal (an
+%   auditory nerve image, for example), they are calculated across the
+%   channels, from the mean of every frame.
+%
+% Input arguments:
+%   inSignal = a mono signal (row or column), or a multi-channel signal with
+%              one channel per row
+%   inSampleFreq = sample frequency of inSignal (in Hz)
+%   inFrameWidth = width of 1 frame (in s)
+%                  if empty or not specified, 0.040 is used by default
+%   inFrameInterval = interval between successive frames (in s)
+%                     if empty or not specified, 0.010 is used by default
+%   inDescriptors = cell array with the names of the descriptors to calculate,
+%                   in the order of the rows of outDescriptors: 'centroid',
+%                   'width', 'rolloff', 'zcr' (mono signal only), 'crest' and
+%                   'flux'
+%                   if empty or not specified, all of them are calculated
+%                   (except 'zcr' for a multi-channel signal)
+%   inFreqs = center frequencies of the channels of a multi-channel signal
+%             (in Hz)
+%             if empty or not specified, 1..number of channels is used
+%   inRolloffFraction = fraction of the total used for the rolloff
+%                       if empty or not specified, 0.85 is used by default
+%   inZeroTolerance = values below this level are not counted as zero
+%                     crossings (see IPEMCalcZeroCrossingRate)
+%                     if empty or not specified, 0 is used by default
+%   inPlotFlag = if non-zero, plots the descriptors
+%                if empty or not specified, 0 is used by default
+%
+% Output:
+%   outDescriptors = matrix with one row per descriptor and one column per
+%                    frame: centroid, width and rolloff are in Hz (or in the
+%                    units of inFreqs), the zero-crossing rate in crossings
+%                    per second
+%   outDescriptorFreq = sample frequency of outDescriptors (in Hz)
+%
+% Remarks:
+%   If IPEMCalcDescriptorsMex is available, every frame is read and
+%   transformed only once, on all processors, whatever the descriptors;
+%   otherwise the spectrogram is calculated once and handed to the
+%   functions above.
+%
+% Example:
+%   [D,DFreq] = IPEMCalcDescriptors(s,fs,0.040,0.010,{'centroid','flux'});
+%   [D,DFreq] = IPEMCalcDescriptors(ANI,ANIFreq,0.05,0.01,[],ANIFilterFreqs);
+%
+% Authors:
+%   IPEM - 20261019
+% ------------------------------------------------------------------------------
+
+% ------------------------------------------------------------------------------
+% IPEM Toolbox - Toolbox for perception-based music analysis 
+% Copyright (C) 2005 Ghent University
+% 
+% This program is free software; you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation; either version 2 of the License, or
+% (at your option) any later version.
+% 
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+% 
+% You should have received a copy of the GNU General Public License
+% along with this program; if not, write to the Free Software
+% Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+% ------------------------------------------------------------------------------
+
+% Handle input arguments
+[inSignal,inSampleFreq,inFrameWidth,inFrameInterval,inDescriptors,inFreqs,...
+    inRolloffFraction,inZeroTolerance,inPlotFlag] = ...
+    IPEMHandleInputArguments(varargin,3,{[],[],0.040,0.010,[],[],0.85,0,0});
+
+% Descriptors asked for (the index of a name is its bit in the mask of the
+% native version)
+Names = {'centroid','width','rolloff','zcr','crest','flux'};
+IsMono = (min(size(inSignal)) == 1);
+if isempty(inDescriptors)
+    if IsMono
+        inDescriptors = Names;
+    else
+        inDescriptors = Names([1 2 3 5 6]);
+    end
+elseif ischar(inDescriptors)
+    inDescriptors = {inDescriptors};
+end
+Index = zeros(1,length(inDescriptors));
+for i = 1:length(inDescriptors)
+    I = find(strcmpi(inDescriptors{i},Names));
+    if isempty(I)
+        error(['ERROR: Unknown descriptor: ' inDescriptors{i}]);
+    end
+    Index(i) = I;
+end
+if ~IsMono & any(Index == 4)
+    error('ERROR: The zero-crossing rate needs a mono signal !');
+end
+
+% Frames (in samples)
+Width = max(1,round(inFrameWidth*inSampleFreq));
+Step = max(1,round(inFrameInterval*inSampleFreq));
+outDescriptorFreq = inSampleFreq/Step;
+
+if (exist('IPEMCalcDescriptorsMex') == 3)
+    
+    % The rows come in the order of the bits of the mask
+    Bits = unique(Index);
+    Rows = IPEMCalcDescriptorsMex(inSignal,inSampleFreq,Width,Step,sum(2.^(Bits-1)),...
+        double(inFreqs(:)),inRolloffFraction,inZeroTolerance);
+    [Dummy,Where] = ismember(Index,Bits);
+    outDescriptors = Rows(Where,:);
+    
+else
+    
+    % Weights of the frames: magnitude spectrum or mean over the frame
+    if IsMono
+        inSignal = inSignal(:)';
+        [Weights,Times,Distances] = IPEMCalcSpectrogram(inSignal,inSampleFreq,...
+            Width/inSampleFreq,Step/inSampleFreq,'hanning',[],0);
+    else
+        if isempty(inFreqs)
+            Distances = (1:size(inSignal,1))';
+        else
+            Distances = inFreqs(:);
+        end
+        NumOfFrames = max(0,floor((size(inSignal,2)-Width)/Step)+1);
+        Weights = zeros(size(inSignal,1),NumOfFrames);
+        for j = 1:NumOfFrames
+            Weights(:,j) = mean(inSignal(:,(j-1)*Step+(1:Width)),2);
+        end
+    end
+    NumOfFrames = size(Weights,2);
+    
+    % Every frame is one column of Weights (sampled at 1 Hz)
+    outDescriptors = zeros(length(Index),NumOfFrames);
+    if any(Index <= 2)
+        Centroid = IPEMCalcCentroid(Weights,1,1,1,Distances,0);
+    end
+    for i = 1:length(Index)
+        switch Index(i)
+            case 1
+                outDescriptors(i,:) = Centroid;
+            case 2
+                outDescriptors(i,:) = IPEMCalcCentroidWidth(Weights,1,1,1,Distances,Centroid,0);
+            case 3
+                outDescriptors(i,:) = Distances(IPEMGetRolloff(Weights',inRolloffFraction))';
+            case 4
+                outDescriptors(i,:) = IPEMCalcZeroCrossingRate(inSignal,inSampleFreq,...
+                    Width/inSampleFreq,Step/inSampleFreq,inZeroTolerance,0);
+            case 5
+                if IsMono
+                    for j = 1:NumOfFrames
+                        outDescriptors(i,j) = IPEMGetCrestFactor(inSignal((j-1)*Step+(1:Width)));
+                    end
+                else
+                    outDescriptors(i,:) = IPEMGetCrestFactor(Weights')';
+                end
+            case 6
+                outDescriptors(i,:) = IPEMCalcFlux(Weights,outDescriptorFreq,0);
+        end
+    end
+    
+end
+
+% Plot if needed
+if (inPlotFlag ~= 0)
+    figure;
+    t = (0:size(outDescriptors,2)-1)/outDescriptorFreq;
+    for i = 1:length(Index)
+        subplot(length(Index),1,i);
+        plot(t,outDescriptors(i,:));
+        axis tight;
+        ylabel(Names{Index(i)});
+    end
+    xlabel('time (s)');
+end
@@ -47,8 +47,12 @@ function outFlux = IPEMCalcFlux (varargin)
 
 % Calculate flux
 [M N] = size(inSignal);
-theDifferences = (inSignal(:,2:N) - inSignal(:,1:N-1));
-outFlux = [0 sqrt(sum(theDifferences.^2,1))];
+if (exist('IPEMFeatureBankMex') == 3) & (N > 0) & isreal(inSignal)
+    [Dummy,outFlux] = IPEMFeatureBankMex(inSignal,inSampleFreq,2);
+else
+    theDifferences = (inSignal(:,2:N) - inSignal(:,1:N-1));
+    outFlux = [0 sqrt(sum(theDifferences.^2,1))];
+end;
 
 % Show plot if needed
 if (inPlotFlag ~= 0)
@@ -47,6 +47,17 @@ function [outOnsetSignal, outOnsetFreq] = IPEMCalcOnsetsFromANI(varargin)
 % Handle input arguments
 [inANI,inANIFreq,inPlotFlag] = IPEMHandleInputArguments(varargin,3,{[],[],1});
 
+% Native detector: the whole chain below, streaming over the frames of the ANI
+if (exist('IPEMCalcOnsetsMex') == 3)
+    fprintf(1,'Calculating onsets...\n');
+    [outOnsetSignal,outOnsetFreq] = IPEMCalcOnsetsMex(inANI,inANIFreq);
+    fprintf(1,'-> Finished calculating onsets\n');
+    if (inPlotFlag ~= 0)
+        PlotOnsets(outOnsetSignal,outOnsetFreq);
+    end
+    return;
+end
+
 
 % Calculate RMS signal
 % --------------------
@@ -118,9 +129,16 @@ outOnsetFreq = FilteredOnsPattFreq;
 
 % Plot if needed
 if (inPlotFlag ~= 0)
-   figure;
-   plot((0:length(outOnsetSignal)-1)/outOnsetFreq,outOnsetSignal);
-   axis([0 (length(outOnsetSignal)-1)/outOnsetFreq 0 1.25]);
-   xlabel('Time (s)');
-   ylabel('Detected onsets');
+   PlotOnsets(outOnsetSignal,outOnsetFreq);
 end
+
+
+% ------------------------------------------------------------------------------
+
+function PlotOnsets(inOnsetSignal,inOnsetFreq)
+
+figure;
+plot((0:length(inOnsetSignal)-1)/inOnsetFreq,inOnsetSignal);
+axis([0 (length(inOnsetSignal)-1)/inOnsetFreq 0 1.25]);
+xlabel('Time (s)');
+ylabel('Detected onsets');
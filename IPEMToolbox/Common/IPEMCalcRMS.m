@@ -58,14 +58,21 @@ function [outRMSSignal,outRMSFreq] = IPEMCalcRMS (varargin)
 theStep = round(inFrameInterval/(1/inSampleFreq));
 theWidth = round(inFrameWidth/(1/inSampleFreq));
 
-% Init the output
-outRMSSignal = zeros(N,round((M-theWidth+1)/theStep));
+if (exist('IPEMFeatureBankMex') == 3) & (theWidth >= 1) & (theStep >= 1) & isreal(inSignal)
 
-% Step through the signal and calculate the RMS value for each frame in each channel
-k = 1;
-for i = 1:theStep:M-theWidth+1,
-    outRMSSignal(:,k) = sqrt(sum(inSignal(:,i:i+theWidth-1).^2,2)/theWidth);
-    k = k + 1;
+    % Native feature bank: all channels in one pass over the signal
+    outRMSSignal = IPEMFeatureBankMex(inSignal,inSampleFreq,1,theWidth,theStep);
+else
+
+    % Init the output
+    outRMSSignal = zeros(N,round((M-theWidth+1)/theStep));
+
+    % Step through the signal and calculate the RMS value for each frame in each channel
+    k = 1;
+    for i = 1:theStep:M-theWidth+1,
+        outRMSSignal(:,k) = sqrt(sum(inSignal(:,i:i+theWidth-1).^2,2)/theWidth);
+        k = k + 1;
+    end;
 end;
 
 % Also return the effective sample frequency of the output signal
@@ -87,24 +87,32 @@ TimeSegments = IPEMGenerateFrameBasedSegments(theLength/fsMixed,fsMixed,...
     theSubPartLength/fsMixed,theSubPartLength/fsMixed,0);
 Segments = IPEMSnipSoundFile(inMixedFileName,inMixedFilePath,TimeSegments);
 
-% Calc roughness for each part
+% Calc the ANIs of all parts at once (in parallel if IPEMCalcANIBatchMex is
+% available)
 N = size(Segments,1);
+Sounds = cell(1,N);
+for i = 1:N
+    Sounds{i} = IPEMAdaptLevel(Segments{i,:},-20);
+end
+[ANIs,ANIFreqs,ANIFilterFreqs] = IPEMCalcANIBatch(Sounds,fsMixed);
+
+% Calc roughness for each part
 outRoughness = zeros(1,N);
 for i = 1:N
     
-    % Calc ANI
-    Sound = IPEMAdaptLevel(Segments{i,:},-20);
-    [ANI,ANIFreq,ANIFilterFreqs] = IPEMCalcANI(Sound,fsMixed,[],0);
+    Sound = Sounds{i};
+    ANI = ANIs{i};
+    ANIFreq = ANIFreqs(i);
     
     % Calc roughness and store the result
     if 0
         % analyze sound segment in frames
-        [Roughness,RoughnessFreq] = IPEMRoughnessFFT(ANI,ANIFreq,ANIFilterFreqs,[],[],0);
+        [Roughness,RoughnessFreq] = IPEMRoughnessFFT(ANI,ANIFreq,ANIFilterFreqs{i},[],[],0);
         outRoughness(1,i) = mean(Roughness);
     else 
         % analyze sound segment as a whole
         Duration = length(Sound)/fsMixed;
-        [Roughness,RoughnessFreq] = IPEMRoughnessFFT(ANI,ANIFreq,ANIFilterFreqs,Duration,Duration,0);
+        [Roughness,RoughnessFreq] = IPEMRoughnessFFT(ANI,ANIFreq,ANIFilterFreqs{i},Duration,Duration,0);
         outRoughness(1,i) = Roughness;
 %        outRoughness(1,i) = rand(1)*100;
     end
@@ -2,10 +2,14 @@ function [outSpectrogram,outTimes,outFrequencies] = IPEMCalcSpectrogram (varargi
 % Usage:
 %   [outSpectrogram,outTimes,outFrequencies] = ...
 %     IPEMCalcSpectrogram(inSignal,inSampleFreq,inFrameSize,inFrameInterval,
-%                         inWindowType,inFFTSize,inPlotFlag,inPlotTreshold)
+%                         inWindowType,inFFTSize,inPlotFlag,inPlotTreshold,
+%                         inOutputType,inOverviewFactor)
 %
 % Description:
 %   Utility function for calculating/plotting the spectrogram of a signal.
+%   When IPEMCalcSpectrogramMex is available, the spectrogram is computed
+%   natively (on all processors), without holding the complex spectrogram
+%   in memory.
 %
 % Input arguments:
 %   inSignal = signal to analyze
@@ -28,9 +32,17 @@ function [outSpectrogram,outTimes,outFrequencies] = IPEMCalcSpectrogram (varargi
 %                if empty or not specified, 1 is used by default
 %   inPlotTreshold = values below this level are ignored in the plot (in dB)
 %                    if empty or not specified, -Inf is used by default
+%   inOutputType = 'magnitude' for amplitude values, 'db' for their level in dB
+%                  if empty or not specified, 'magnitude' is used by default
+%   inOverviewFactor = number of frames combined in one output column (their
+%                      maximum is taken in every bin), for an overview of a
+%                      long signal
+%                      if empty or not specified, 1 is used by default
 %
 % Output:
-%   outSpectrogram = spectrogram data (amplitude values, so not in dB)
+%   outSpectrogram = spectrogram data (magnitudes, so not in dB, unless
+%                    inOutputType is 'db'), in double precision with or
+%                    without IPEMCalcSpectrogramMex
 %   outTimes = instants at which an analysis was calculated (in s)
 %   outFrequencies = frequencies used in decomposition (in Hz)
 %
@@ -61,8 +73,8 @@ function [outSpectrogram,outTimes,outFrequencies] = IPEMCalcSpectrogram (varargi
 % ------------------------------------------------------------------------------
 
 % Handle input arguments
-[inSignal,inSampleFreq,inFrameSize,inFrameInterval,inWindowType,inFFTSize,inPlotFlag,inPlotTreshold] = ...
-    IPEMHandleInputArguments(varargin,3,{[],[],0.040,0.010,'hanning',[],1,-Inf});
+[inSignal,inSampleFreq,inFrameSize,inFrameInterval,inWindowType,inFFTSize,inPlotFlag,inPlotTreshold,inOutputType,inOverviewFactor] = ...
+    IPEMHandleInputArguments(varargin,3,{[],[],0.040,0.010,'hanning',[],1,-Inf,'magnitude',1});
 
 % Additional input handling/parameter setup
 WindowSize = round(inFrameSize*inSampleFreq);
@@ -76,18 +88,51 @@ if isempty(inFFTSize)
 elseif (inFFTSize == -1)
     inFFTSize = WindowSize;
 end
-NumOverlap = WindowSize-round(inFrameInterval*inSampleFreq);
+FrameInterval = round(inFrameInterval*inSampleFreq);
+NumOverlap = WindowSize-FrameInterval;
+DBOutput = strcmpi(inOutputType,'db');
 
-% Calculate spectrogram
-[outSpectrogram,outFrequencies,outTimes] = specgram(inSignal,inFFTSize,inSampleFreq,Window,NumOverlap);
+if (exist('IPEMCalcSpectrogramMex') == 3)
+    % Native STFT: magnitudes (or dB levels) straight from the frames
+    if ~ischar(inWindowType)
+        inWindowType = Window;
+    end
+    [outSpectrogram,outTimes,outFrequencies] = ...
+        IPEMCalcSpectrogramMex(inSignal,inSampleFreq,WindowSize,FrameInterval,inFFTSize,inWindowType,inOutputType,inOverviewFactor);
+    outSpectrogram = double(outSpectrogram);
+    outTimes = outTimes';
+else
+    % Calculate spectrogram
+    [outSpectrogram,outFrequencies,outTimes] = specgram(inSignal,inFFTSize,inSampleFreq,Window,NumOverlap);
 
-% Normalize (no correction for window type though...)
-outSpectrogram = outSpectrogram/(WindowSize/2);
+    % Normalize (no correction for window type though...)
+    outSpectrogram = abs(outSpectrogram)/(WindowSize/2);
+
+    % Overview: maximum magnitude over every inOverviewFactor frames
+    if (inOverviewFactor > 1)
+        NumOfColumns = ceil(size(outSpectrogram,2)/inOverviewFactor);
+        Overview = zeros(size(outSpectrogram,1),NumOfColumns);
+        for i = 1:NumOfColumns
+            Columns = (i-1)*inOverviewFactor+1:min(i*inOverviewFactor,size(outSpectrogram,2));
+            Overview(:,i) = max(outSpectrogram(:,Columns),[],2);
+        end
+        outSpectrogram = Overview;
+        outTimes = outTimes(1:inOverviewFactor:end);
+    end
+    if DBOutput
+        outSpectrogram = 20*log10(outSpectrogram);
+    end
+end
 
 % Plot if needed
 if (inPlotFlag)
     figure;
-    imagesc(outTimes,outFrequencies,IPEMClip(20*log10(abs(outSpectrogram)),inPlotTreshold,[],inPlotTreshold));
+    if DBOutput
+        Levels = outSpectrogram;
+    else
+        Levels = 20*log10(outSpectrogram);
+    end
+    imagesc(outTimes,outFrequencies,IPEMClip(Levels,inPlotTreshold,[],inPlotTreshold));
     set(gca,'TickDir','out');
     colormap(1-gray);
     axis xy;
@@ -92,24 +92,35 @@ else
 end
 [Rows,Columns] = size(inPeriodicityPitch);
 
-% Perform leaky integration
-outChords = IPEMLeakyIntegration(inPeriodicityPitch,inSampleFreq,inHalfDecayChords,inEnlargement,0);
-outToneCenters = IPEMLeakyIntegration(inPeriodicityPitch,inSampleFreq,inHalfDecayToneCenters,inEnlargement,0);
+if (exist('IPEMContextualityIndexMex') == 3)
 
-% Calculate contextualities
-outContextuality1 = [];
-outContextuality2 = [];
-outContextuality3 = [];
-[ws,wf] = warning; warning('off'); % TBC - I hate this, and it should be avoided, but it's the only way to turn off the corrcoef warnings generated by this function...
-for i = 1:size(outToneCenters,2)
-    value1 = corrcoef(outChords(:,i),outChords(:,inSnapShotSamples));
-    value2 = corrcoef(outToneCenters(:,i),outChords(:,inSnapShotSamples));
-    value3 = corrcoef(outToneCenters(:,i),outChords(:,i));
-    outContextuality1 = [outContextuality1 value1(1,2)];
-    outContextuality2 = [outContextuality2 value2(1,2)];
-    outContextuality3 = [outContextuality3 value3(1,2)];
-end 
-warning(ws); warning(wf); % Restore previous warning state and frequency
+    % Native engine: both leaky integrations and all correlations in one pass
+    [outChords,outToneCenters,outContextuality1,outContextuality2,outContextuality3] = ...
+        IPEMContextualityIndexMex(inPeriodicityPitch,inSampleFreq,inSnapShotSamples,...
+                                  inHalfDecayChords,inHalfDecayToneCenters,...
+                                  round(inSampleFreq*inEnlargement));
+else
+
+    % Perform leaky integration
+    outChords = IPEMLeakyIntegration(inPeriodicityPitch,inSampleFreq,inHalfDecayChords,inEnlargement,0);
+    outToneCenters = IPEMLeakyIntegration(inPeriodicityPitch,inSampleFreq,inHalfDecayToneCenters,inEnlargement,0);
+
+    % Calculate contextualities
+    N = size(outToneCenters,2);
+    outContextuality1 = zeros(1,N);
+    outContextuality2 = zeros(1,N);
+    outContextuality3 = zeros(1,N);
+    [ws,wf] = warning; warning('off'); % TBC - I hate this, and it should be avoided, but it's the only way to turn off the corrcoef warnings generated by this function...
+    for i = 1:N
+        value1 = corrcoef(outChords(:,i),outChords(:,inSnapShotSamples));
+        value2 = corrcoef(outToneCenters(:,i),outChords(:,inSnapShotSamples));
+        value3 = corrcoef(outToneCenters(:,i),outChords(:,i));
+        outContextuality1(i) = value1(1,2);
+        outContextuality2(i) = value2(1,2);
+        outContextuality3(i) = value3(1,2);
+    end 
+    warning(ws); warning(wf); % Restore previous warning state and frequency
+end
 
 % Generate figures if needed
 if (inPlotFlag)
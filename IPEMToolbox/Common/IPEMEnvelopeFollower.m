@@ -74,17 +74,22 @@ end
 
 % Perform envelope extraction
 N = length(inSignal);
-outEnvelope = zeros(1,N);
 outEnvelopeFreq = inSignalFreq;
-e = 0;
-for i = 1:N
-    a = abs(inSignal(i));
-    if (a > e)
-        e = a + fAttack*(e - a);
-    else
-        e = a + fRelease*(e - a);
+if (exist('IPEMFeatureBankMex') == 3) & isreal(inSignal)
+    [Dummy,Dummy,outEnvelope] = IPEMFeatureBankMex(reshape(inSignal,1,N),inSignalFreq,4,[],[],...
+                                                   inAttackTime,inReleaseTime);
+else
+    outEnvelope = zeros(1,N);
+    e = 0;
+    for i = 1:N
+        a = abs(inSignal(i));
+        if (a > e)
+            e = a + fAttack*(e - a);
+        else
+            e = a + fRelease*(e - a);
+        end
+        outEnvelope(i) = e;
     end
-    outEnvelope(i) = e;
 end
 
 % Plot results if requested
@@ -78,15 +78,12 @@ else
     integrator = 0;
 end
 
-% Initialize (enlarged) matrices
+% Initialize (enlarged) matrix
 Matrix = [inSignal zeros(size(inSignal,1),round(inSampleFreq*inEnlargement))];
-outLeakyIntegration = [zeros(size(Matrix))];
 
-% Perform leaky integration
-outLeakyIntegration(:,1) = Matrix(:,1);
-for j = 2:size(Matrix,2)
-    outLeakyIntegration(:,j) = (outLeakyIntegration(:,j-1)*integrator) + Matrix(:,j);
-end;
+% Perform leaky integration: out(:,j) = out(:,j-1)*integrator + Matrix(:,j)
+% (a first order recursive filter along the rows, starting from zero state)
+outLeakyIntegration = filter(1,[1 -integrator],Matrix,[],2);
 
 % Plot if needed
 if (inPlotFlag)
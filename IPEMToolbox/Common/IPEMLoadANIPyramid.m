@@ -0,0 +1,135 @@
+function [outMin,outMax,outMean,outFreq,outFilterFreqs,outTimeOffset,outLevel] = IPEMLoadANIPyramid(varargin)
+% Usage:
+%   [outMin,outMax,outMean,outFreq,outFilterFreqs,outTimeOffset,outLevel] = ...
+%     IPEMLoadANIPyramid(inFileName,inStartTime,inDuration,inNumOfBins,inLevel)
+%
+% Description:
+%   Loads part of one level of an auditory nerve image pyramid, as written by
+%   IPEMProcessAuditoryModel (inPyramidFile) or the -zf option of the console
+%   application. Level l holds the nerve image at 1/4^l of its sample
+%   frequency, with the minimum, maximum and mean of each channel over every
+%   4^l samples. Only the requested part of the chosen level is read, so an
+%   overview of a long nerve image loads as fast as one of a short image.
+%
+% Input arguments:
+%   inFileName = name of the pyramid file (including its path)
+%   inStartTime = start of the part to load (in s, in the time of the signal:
+%                 a pyramid of a part of a signal starts at the start of
+%                 that part)
+%                 if empty or not specified, 0 is used by default
+%   inDuration = duration of the part to load (in s)
+%                if empty or not specified, Inf (up to the end) is used by default
+%   inNumOfBins = number of values per channel needed for the display (e.g.
+%                 the width of the plot in pixels): the coarsest level that
+%                 still has at least this many values in the part is used
+%                 if empty or not specified, 1000 is used by default
+%   inLevel = level to load (1 is the finest), overrides inNumOfBins
+%             if empty or not specified, 0 (choose using inNumOfBins) is used
+%             by default
+%
+% Output:
+%   outMin = minimum of each channel per bin (each row represents a channel)
+%   outMax = maximum of each channel per bin
+%   outMean = mean of each channel per bin
+%   outFreq = sample frequency of the loaded level (in Hz)
+%   outFilterFreqs = center frequencies of the channels (in Hz)
+%   outTimeOffset = time of the first bin in the signal (in s)
+%   outLevel = the level that was loaded
+%
+% Example:
+%   [Min,Max,Mean,Freq,FilterFreqs,Offset] = IPEMLoadANIPyramid('song.pyr',0,Inf,800);
+%   IPEMPlotMultiChannel(Mean,Freq,'Auditory nerve image','Time (in s)',...
+%        'Auditory channels (center freqs. in Hz)',14,FilterFreqs,3,[],[],1,Offset);
+%
+% Authors:
+%   IPEM - 20261019
+% ------------------------------------------------------------------------------
+
+% ------------------------------------------------------------------------------
+% IPEM Toolbox - Toolbox for perception-based music analysis 
+% Copyright (C) 2005 Ghent University
+% 
+% This program is free software; you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation; either version 2 of the License, or
+% (at your option) any later version.
+% 
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+% 
+% You should have received a copy of the GNU General Public License
+% along with this program; if not, write to the Free Software
+% Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+% ------------------------------------------------------------------------------
+
+% Handle input arguments
+[inFileName,inStartTime,inDuration,inNumOfBins,inLevel] = ...
+    IPEMHandleInputArguments(varargin,2,{'',0,Inf,1000,0});
+
+% Open the file in the byte order it was written in
+theFile = fopen(inFileName,'r','l');
+if (theFile == -1)
+    error(['ERROR: Could not open pyramid file ' inFileName]);
+end
+theMagic = fread(theFile,8,'uchar')';
+if (fread(theFile,1,'uint32') ~= hex2dec('01020304'))
+    fclose(theFile);
+    theFile = fopen(inFileName,'r','b');
+    fseek(theFile,8,'bof');
+    if (fread(theFile,1,'uint32') ~= hex2dec('01020304'))
+        theMagic = [];
+    end
+end
+if (length(theMagic) < 7) || ~strcmp(char(theMagic(1:7)),'IPEMPYR')
+    fclose(theFile);
+    error(['ERROR: ' inFileName ' is not a pyramid file...']);
+end
+
+% Header (see library/aniio.h of the auditory model)
+theHeader = fread(theFile,5,'uint32');  % version, header size, channels, levels, factor
+theNumOfChannels = theHeader(3);
+theNumOfLevels = theHeader(4);
+theNumOfFrames = fread(theFile,1,'int64');
+theFrameRate = fread(theFile,1,'double');
+theStartTime = fread(theFile,1,'double');   % 0 in version 1 files
+fseek(theFile,64,'bof');
+outFilterFreqs = fread(theFile,theNumOfChannels,'double');
+theIndex = zeros(theNumOfLevels,4); % offset, bins, frames per bin, bin rate
+for i = 1:theNumOfLevels
+    theIndex(i,1:3) = fread(theFile,3,'int64')';
+    theIndex(i,4) = fread(theFile,1,'double');
+end
+
+% Frames of the nerve image in the requested part
+theFirst = min(max(0,floor((inStartTime-theStartTime)*theFrameRate)),theNumOfFrames);
+theCount = theNumOfFrames - theFirst;
+if ~isinf(inDuration)
+    theCount = min(theCount,max(0,round(inDuration*theFrameRate)));
+end
+
+% Choose the level
+if (inLevel >= 1) & (inLevel <= theNumOfLevels)
+    outLevel = inLevel;
+else
+    outLevel = 1;
+    for i = 2:theNumOfLevels
+        if (floor(theCount/theIndex(i,3)) >= inNumOfBins)
+            outLevel = i;
+        end
+    end
+end
+
+% Read the bins covering the part: nchan minima, maxima and means per bin
+theSpan = theIndex(outLevel,3);
+theFirstBin = floor(theFirst/theSpan);
+theNumOfBins = max(0,min(theIndex(outLevel,2),ceil((theFirst+theCount)/theSpan)) - theFirstBin);
+fseek(theFile,theIndex(outLevel,1) + theFirstBin*3*theNumOfChannels*4,'bof');
+theData = fread(theFile,[theNumOfChannels 3*theNumOfBins],'float32');
+fclose(theFile);
+outMin = theData(:,1:3:end);
+outMax = theData(:,2:3:end);
+outMean = theData(:,3:3:end);
+outFreq = theIndex(outLevel,4);
+outTimeOffset = theStartTime + theFirstBin*theSpan/theFrameRate;
@@ -85,6 +85,20 @@ NumOfChannels = size(inSignal,1);
 outValues = cell(NumOfChannels,1);
 outValuesFreq = inSampleFreq/StepSize;
 outPeriods = (MinPeriod:MaxPeriod)'/inSampleFreq;
+
+% Native kernel: all channels in parallel, leaky integration included
+if (exist('IPEMMECAnalysisMex') == 3)
+    outValues = IPEMMECAnalysisMex(inSignal,MinPeriod,MaxPeriod,StepSize,outValuesFreq,inHalfDecayTime);
+    if (inPlotFlag)
+        for Channel = 1:NumOfChannels
+            PlotValues(outValues{Channel},outValuesFreq,outPeriods,Channel,NumOfChannels);
+        end
+    end
+    fprintf(1,'Done.\n');
+    return;
+end
+
+% Prepend zeros for the longest period
 NPrefixZeros = MaxPeriod;
 Signal = [zeros(NumOfChannels,NPrefixZeros) inSignal];
 NNew = N + NPrefixZeros;
@@ -127,23 +141,29 @@ for Channel = 1:NumOfChannels
     
     % Plot if needed
     if (inPlotFlag)
-        Time = (0:size(Values,2)-1)/outValuesFreq;
-        figure;
-        imagesc(Time,outPeriods,Values);
-        axis xy;
-        colormap(1-gray);
-        colorbar;
-        axis([Time(1) Time(end) 0 outPeriods(end)]);
-        if (NumOfChannels == 1)
-            title('Differences values over time');
-        else
-            title(sprintf('Differences values over time for channel %d',Channel));
-        end
-        xlabel('Time (s)');
-        ylabel('Difference values');
+        PlotValues(Values,outValuesFreq,outPeriods,Channel,NumOfChannels);
     end
     
 end
 
 % Feedback
 fprintf(1,'Done.\n');
+
+% ------------------------------------------------------------------------------
+
+function PlotValues(inValues,inValuesFreq,inPeriods,inChannel,inNumOfChannels)
+
+Time = (0:size(inValues,2)-1)/inValuesFreq;
+figure;
+imagesc(Time,inPeriods,inValues);
+axis xy;
+colormap(1-gray);
+colorbar;
+axis([Time(1) Time(end) 0 inPeriods(end)]);
+if (inNumOfChannels == 1)
+    title('Differences values over time');
+else
+    title(sprintf('Differences values over time for channel %d',inChannel));
+end
+xlabel('Time (s)');
+ylabel('Difference values');
@@ -3,7 +3,7 @@ function [outPatterns,outPatternLengths,outPatternFreq] = IPEMMECExtractPatterns
 %   [outPatterns,outPatternLenghts,outPatternFreq] = ...
 %     IPEMMECExtractPatterns(inAnalyzedSignal,inSampleFreq,inPeriods,...
 %                            inBestPeriodIndices,inAnalysisFreq,...
-%                            inRescalePatterns,inPlotFlag);
+%                            inRescalePatterns,inPlotFlag,inTimeIndices);
 %
 % Description:
 %   Extracts the best pattern from the original signal using the results
@@ -23,12 +23,16 @@ function [outPatterns,outPatternLengths,outPatternFreq] = IPEMMECExtractPatterns
 %                       if empty or not specified, 0 is used by default
 %   inPlotFlag = if non-zero, plots are generated
 %                if empty or not specified, 0 is used by default
+%   inTimeIndices = indices of the moments in time (columns of
+%                   inBestPeriodIndices) for which patterns are extracted
+%                   if empty or not specified, all moments are used by default
 %
 % Output:
 %   outPatterns = cell array containing the extracted patterns for each channel
 %                 at each moment in time
 %                 (outPatterns{i}(j,k) represents the j-th sample of the pattern
-%                 extracted at the time corresponding with index k for channel i)
+%                 extracted at the time corresponding with index k (or
+%                 inTimeIndices(k)) for channel i)
 %   outPatternLengths = 2D array containing the length of the patterns in
 %                       outPatterns (in samples) (each row represents a channel)
 %   outPatternFreq = sample frequency of outPatterns (same as inAnalysisFreq)
@@ -37,6 +41,10 @@ function [outPatterns,outPatternLengths,outPatternFreq] = IPEMMECExtractPatterns
 % Remarks:
 %   The input arguments inPeriods, inBestPeriodIndices and inAnalysisFreq are
 %   direct results of IPEMMECAnalysis and IPEMMECFindBestPeriods.
+%   When IPEMMECExtractPatternsMex is available (see the AuditoryModel
+%   bindings), the patterns are extracted by native code; with inTimeIndices,
+%   only the patterns of those moments are extracted, e.g. for interactive
+%   resynthesis of a single moment.
 %
 % Example:
 %   [P,PLengths,PFreq] = ...
@@ -70,8 +78,8 @@ function [outPatterns,outPatternLengths,outPatternFreq] = IPEMMECExtractPatterns
 fprintf(1,'Start of MEC pattern extraction... ');
 
 % Handle input arguments
-[inAnalyzedSignal,inSampleFreq,inPeriods,inBestPeriodIndices,inAnalysisFreq,inRescalePatterns,inPlotFlag] = ...
-    IPEMHandleInputArguments(varargin,5,{[],[],[],[],[],0,0});
+[inAnalyzedSignal,inSampleFreq,inPeriods,inBestPeriodIndices,inAnalysisFreq,inRescalePatterns,inPlotFlag,inTimeIndices] = ...
+    IPEMHandleInputArguments(varargin,5,{[],[],[],[],[],0,0,[]});
 
 % Get periods in samples
 MinPeriod = round(inSampleFreq*inPeriods(1));
@@ -85,42 +93,56 @@ MaxNumSamples = MaxPeriod;
 if ((NumOfChannels ~= 1)&(M == 1))
     inBestPeriodIndices = repmat(inBestPeriodIndices,NumOfChannels,1);
 end
+if isempty(inTimeIndices)
+    inTimeIndices = 1:N;
+end
+NumOfMoments = length(inTimeIndices);
 outPatterns = cell(NumOfChannels,1);
 outPatternLengths = round(inPeriods(inBestPeriodIndices)*inSampleFreq); % (rounding for perfect conversion from float to integer)
 outPatternLengths = reshape(outPatternLengths,NumOfChannels,N);
+outPatternLengths = outPatternLengths(:,inTimeIndices);
 outPatternFreq = inAnalysisFreq;
 NPrefixZeros = MaxPeriod;
-Signal = [zeros(NumOfChannels,NPrefixZeros) inAnalyzedSignal];
-NNew = N + NPrefixZeros;
+
+% Use the native extraction if available
+UseMex = (exist('IPEMMECExtractPatternsMex') == 3);
+if UseMex
+    outPatterns = IPEMMECExtractPatternsMex(inAnalyzedSignal,StepSize,outPatternLengths,...
+                                            inTimeIndices,MaxNumSamples,inRescalePatterns);
+else
+    Signal = [zeros(NumOfChannels,NPrefixZeros) inAnalyzedSignal];
+end
 
 % Extract the patterns from all channels
 for Channel = 1:NumOfChannels
     
-    Pattern = zeros(MaxNumSamples,N);
-    for i = 1:N
-        % Extract pattern
-        End = NPrefixZeros + (i-1)*StepSize;
-        CurrentPattern = Signal(Channel,End-outPatternLengths(Channel,i)+1:End);
-        
-        % Rescale if needed
-        if (inRescalePatterns) CurrentPattern = IPEMRescale(CurrentPattern,0,1); end
-        
-        % Rotate to account for phase
-        Pattern(1:length(CurrentPattern),i) = IPEMRotateMatrix(CurrentPattern',End-NPrefixZeros,0);
+    if ~UseMex
+        Pattern = zeros(MaxNumSamples,NumOfMoments);
+        for k = 1:NumOfMoments
+            % Extract pattern
+            End = NPrefixZeros + (inTimeIndices(k)-1)*StepSize;
+            CurrentPattern = Signal(Channel,End-outPatternLengths(Channel,k)+1:End);
+            
+            % Rescale if needed
+            if (inRescalePatterns) CurrentPattern = IPEMRescale(CurrentPattern,0,1); end
+            
+            % Rotate to account for phase
+            Pattern(1:length(CurrentPattern),k) = IPEMRotateMatrix(CurrentPattern',End-NPrefixZeros,0);
+        end
+        outPatterns{Channel,1} = Pattern;
     end
-    outPatterns{Channel,1} = Pattern;
     
     % Plot if needed
     if (inPlotFlag)
         figure;
-        Time = (0:N-1)./outPatternFreq;
+        Time = (inTimeIndices-1)./outPatternFreq;
         Periods = (inPeriods(end)-inPeriods(end-1))*(1:MaxNumSamples);
         imagesc(Time,Periods,outPatterns{Channel,1});
         axis xy;
         colormap(1-gray);
         colorbar;
         hold on;
-        plot(Time,inPeriods(inBestPeriodIndices(Channel,:)),'red');
+        plot(Time,inPeriods(inBestPeriodIndices(Channel,inTimeIndices)),'red');
         hold off;
         if (NumOfChannels == 1)
             title('Extracted patterns');
@@ -16,10 +16,16 @@ function IPEMMECReSynthUI(varargin)
 %              Periods = periods that were analyzed
 %              BestPeriodIndices = indices for detected best periods
 %              AnalysisFreq = sample frequency of BestPeriodIndices
-%              P = extracted patterns (see remark below)
-%              PLengths = lenghts of the patterns in P
-%              PFreq = sample frequency of P (same as AnalysisFreq)
-%              OriginalFreq = sample frequency of contents of P
+%              P = extracted patterns (see remarks below)
+%              PLengths = lenghts of the patterns in P
+%              PFreq = sample frequency of P (same as AnalysisFreq)
+%              OriginalFreq = sample frequency of contents of P
+%              AnalyzedSignal = signal that was used for IPEMMECAnalysis,
+%                               sampled at OriginalFreq (only needed
+%                               without P, see remark 3)
+%              RescalePatterns = if non-zero, the patterns extracted from
+%                                AnalyzedSignal are rescaled between 0 and 1
+%                                (optional, 0 by default)
 %              NoiseBands = noise bands to use for resynthesis
 %              ANIFilterFreqs = filter frequencies
 %                               (empty in case of non-ANI data)
@@ -30,14 +36,17 @@ function IPEMMECReSynthUI(varargin)
 %      IPEMMECSynthesis.
 %   2. For the 'P' field, you have to specify P between curly braces:
 %      DataStruct = struct('Sound',s,'SampleFreq',fs,....,'P',{P},...);
-%      This is because of Matlab's way of handling cell arrays in struct
-%      definitions.
+%      This is because of Matlab's way of handling cell arrays in struct
+%      definitions.
+%   3. P, PLengths and PFreq may be left out (or empty): the pattern of the
+%      selected moment is then extracted from AnalyzedSignal each time a
+%      resynthesis is asked for, instead of all patterns up front.
 %
 % Example:
 %   UIData = struct('Sound',s,'SampleFreq',fs,'Periods',Periods,...
 %                   'BestPeriodIndices',BestPeriodIndices,'AnalysisFreq',Freq,...
-%                   'P',{P},'PLengths',PLengths,'PFreq',PFreq,'OriginalFreq',...
-%                   RMSFreq,'NoiseBands',NoiseBands,'ANIFilterFreqs',[]);
+%                   'OriginalFreq',RMSFreq,'AnalyzedSignal',RMS,...
+%                   'NoiseBands',NoiseBands,'ANIFilterFreqs',[]);
 %   IPEMMECReSynthUI('Start',UIData);
 %
 % Authors:
@@ -89,8 +98,13 @@ case 'Start'
     set(HFig,'Tag','IPEMECReSynthUIData');
     IPEMSetFigureLayout(HFig);
     
-    % Variables
-    LastTime = -1;
+    % Variables
+    if isfield(D,'P') & ~isempty(D.P)
+        NumOfChannels = length(D.P);
+    else
+        NumOfChannels = size(D.AnalyzedSignal,1);
+    end
+    LastTime = -1;
     SelectedChannel = 1;
     SelectedTime = 0;
     ReSynthSound = [];
@@ -101,7 +115,7 @@ case 'Start'
     HUIFig = findobj(0,'Tag','IPEMMECReSynthUI');
     ud = D;
     LocalData = struct(...
-        'LastTime',LastTime,'SelectedTime',SelectedTime,'SelectedChannel',SelectedChannel,...
+        'NumOfChannels',NumOfChannels,'LastTime',LastTime,'SelectedTime',SelectedTime,'SelectedChannel',SelectedChannel,...
         'ReSynthSound',ReSynthSound,'IndividualReSynthSounds',IndividualReSynthSounds);
     fn = fieldnames(LocalData);
     values = struct2cell(LocalData);
@@ -134,8 +148,8 @@ case 'Start'
                 set(HUIFig,'UserData',ud);
                 DataChanged = 1;
             end;
-            if (length(ud.P) ~= 1)
-                if (y >= 1) & (y < (length(ud.P)+1))
+            if (ud.NumOfChannels ~= 1)
+                if (y >= 1) & (y < (ud.NumOfChannels+1))
                     SelectedChannel = floor(y);
                     ud = get(HUIFig,'UserData');
                     ud.SelectedChannel = SelectedChannel;
@@ -155,9 +169,22 @@ case 'Start'
     
 case 'ReSynth'
     HUIFig = findobj(0,'Tag','IPEMMECReSynthUI');
-    ud = get(HUIFig,'UserData');
-    [ud.ReSynthSound,UsedPeriods,ud.IndividualReSynthSounds] = IPEMMECSynthesis(...
-        ud.P,ud.PLengths,ud.PFreq,ud.OriginalFreq,ud.SelectedTime,...
+    ud = get(HUIFig,'UserData');
+    if isfield(ud,'P') & ~isempty(ud.P)
+        P = ud.P; PLengths = ud.PLengths; PFreq = ud.PFreq;
+        SelectionTime = ud.SelectedTime;
+    else
+        % Extract the pattern of the selected moment only
+        TimeIndex = round(ud.SelectedTime*ud.AnalysisFreq)+1;
+        TimeIndex = max(1,min(TimeIndex,size(ud.BestPeriodIndices,2)));
+        RescalePatterns = 0;
+        if isfield(ud,'RescalePatterns') RescalePatterns = ud.RescalePatterns; end
+        [P,PLengths,PFreq] = IPEMMECExtractPatterns(ud.AnalyzedSignal,ud.OriginalFreq,ud.Periods,...
+            ud.BestPeriodIndices,ud.AnalysisFreq,RescalePatterns,0,TimeIndex);
+        SelectionTime = 0;
+    end
+    [ud.ReSynthSound,UsedPeriods,ud.IndividualReSynthSounds] = IPEMMECSynthesis(...
+        P,PLengths,PFreq,ud.OriginalFreq,SelectionTime,...
         length(ud.Sound)/ud.SampleFreq,ud.SampleFreq,ud.NoiseBands,-20,1,4096,0);
     ud.LastTime = ud.SelectedTime;
     set(HUIFig,'UserData',ud);
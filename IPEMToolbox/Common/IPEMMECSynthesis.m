@@ -45,6 +45,14 @@ function [outResynthesizedSound,outDetectedPeriods,outIndividualSounds] = IPEMME
 %                        each channel (in s)
 %   outIndividualSounds = resynthesized sounds per channel
 %
+% Remarks:
+%   When IPEMMECSynthesisMex is available (see the AuditoryModel bindings),
+%   the sound is computed by native code: the noise piece of each channel is
+%   computed once and modulated block-wise, and the individual sounds are
+%   only computed when asked for. The repeated pattern then wraps around
+%   seamlessly at the end of the sound, and the noise comes from a random
+%   generator of its own instead of Matlab's rand (which only gives its seed).
+%
 % Example:
 %   [ss,periods,sschan] = IPEMMECSynthesis(P,PL,PFreq,RMSFreq,3,10,22050);
 %
@@ -92,44 +100,78 @@ if isempty(inNoiseBands)
 end
 
 % Handle all channels
-for Channel = 1:NumOfChannels
+if (exist('IPEMMECSynthesisMex') == 3)
     
-    % Feedback
-    fprintf(1,'Channel %d... ',Channel);
+    % Get the selected patterns
+    Patterns = cell(NumOfChannels,1);
+    for Channel = 1:NumOfChannels
+        Patterns{Channel} = inPatterns{Channel}(1:inPatternLengths(Channel,TimeIndex),TimeIndex);
+        outDetectedPeriods(Channel) = length(Patterns{Channel})/inOriginalSignalFreq;
+    end
     
-    % Get the selected pattern
-    Pattern = inPatterns{Channel}(1:inPatternLengths(Channel,TimeIndex),TimeIndex)';
-    PatternDuration = length(Pattern)/inOriginalSignalFreq;
-    outDetectedPeriods(Channel) = PatternDuration;
+    % Width of one piece of noise (as in IPEMGenerateBandPassedNoise)
+    NumOfSamples = round(inDuration*inOutputFreq);
+    if isempty(inReSynthWidth)
+        NoiseWidth = NumOfSamples;
+    elseif (inReSynthWidth == -1)
+        NoiseWidth = 2^nextpow2(NumOfSamples);
+    else
+        NoiseWidth = inReSynthWidth;
+    end
     
-    % Repeat pattern and interpolate to obtain modulation signal
-    RepPattern = repmat(Pattern,1,ceil(inDuration/PatternDuration));
-    RPL = length(RepPattern);
-    ML = round(RPL*inOutputFreq/inOriginalSignalFreq);
-    Modulation = interp1((0:RPL-1)/inOriginalSignalFreq,RepPattern,(0:ML-1)/inOutputFreq);
-    Modulation = Modulation(1:round(inDuration*inOutputFreq));
+    % Modulate the noise bands with the repeated patterns
+    Seed = floor(rand*2^31);
+    if ((nargout > 2) | (inPlotFlag & (NumOfChannels ~= 1)))
+        [Sound,outIndividualSounds] = IPEMMECSynthesisMex(Patterns,inOriginalSignalFreq,inOutputFreq,NumOfSamples,...
+                                                          inNoiseBands,NoiseWidth,-20,inEnhanceContrast,Seed);
+    else
+        Sound = IPEMMECSynthesisMex(Patterns,inOriginalSignalFreq,inOutputFreq,NumOfSamples,...
+                                    inNoiseBands,NoiseWidth,-20,inEnhanceContrast,Seed);
+    end
+    outResynthesizedSound = IPEMAdaptLevel(Sound,indBLevel);
     
-    % Generate noise signal
-    theNoise = IPEMGenerateBandPassedNoise(inNoiseBands(Channel,:),inDuration,inOutputFreq,-20,inReSynthWidth);
+else
     
-    % Enhance contrast if requested
-    if (inEnhanceContrast)
-        theNorm = max(abs(Modulation));
-        if (theNorm)
-            Modulation = ((Modulation/theNorm).^3)*theNorm;
+    for Channel = 1:NumOfChannels
+        
+        % Feedback
+        fprintf(1,'Channel %d... ',Channel);
+        
+        % Get the selected pattern
+        Pattern = inPatterns{Channel}(1:inPatternLengths(Channel,TimeIndex),TimeIndex)';
+        PatternDuration = length(Pattern)/inOriginalSignalFreq;
+        outDetectedPeriods(Channel) = PatternDuration;
+        
+        % Repeat pattern and interpolate to obtain modulation signal
+        RepPattern = repmat(Pattern,1,ceil(inDuration/PatternDuration));
+        RPL = length(RepPattern);
+        ML = round(RPL*inOutputFreq/inOriginalSignalFreq);
+        Modulation = interp1((0:RPL-1)/inOriginalSignalFreq,RepPattern,(0:ML-1)/inOutputFreq);
+        Modulation = Modulation(1:round(inDuration*inOutputFreq));
+        
+        % Generate noise signal
+        theNoise = IPEMGenerateBandPassedNoise(inNoiseBands(Channel,:),inDuration,inOutputFreq,-20,inReSynthWidth);
+        
+        % Enhance contrast if requested
+        if (inEnhanceContrast)
+            theNorm = max(abs(Modulation));
+            if (theNorm)
+                Modulation = ((Modulation/theNorm).^3)*theNorm;
+            end
         end
+        
+        % Modulate noise with repeated pattern
+        outIndividualSounds(Channel,:) = Modulation.*theNoise;
+        
+        % Feedback
+        fprintf(1,'Done.\n');
     end
     
-    % Modulate noise with repeated pattern
-    outIndividualSounds(Channel,:) = Modulation.*theNoise;
+    % Mix all sounds together and adapt level
+    outResynthesizedSound = IPEMAdaptLevel(sum(outIndividualSounds,1),indBLevel);
     
-    % Feedback
-    fprintf(1,'Done.\n');
 end
 
-% Mix all sounds together and adapt level
-outResynthesizedSound = IPEMAdaptLevel(sum(outIndividualSounds,1),indBLevel);
-
 % Plot if needed
 if (inPlotFlag)
     if (NumOfChannels ~= 1)
@@ -13,7 +13,9 @@ function outResult = IPEMProcessAuditoryModel (varargin)
 %   nerve image corresponding to this sound file.
 %
 % Input arguments:
-%   inInputFileName = name of the file to process (only .wav files)
+%   inInputFileName = name of the file to process (.wav, .aiff/.aifc, .au/.snd
+%                     or .flac; the format is recognized from the file itself,
+%                     and files with several channels are mixed down to mono)
 %   inInputFilePath = directory path to the input file
 %                     if empty or not specified, '' is used by default
 %   inOutputFileName = name for the output file
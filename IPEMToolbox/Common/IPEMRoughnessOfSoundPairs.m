@@ -5,7 +5,7 @@ function [outMeanRoughness,outSortedList,outRoughness,outRoughnessFreq,outUsedSe
 %    outUsedSection] = ...
 %      IPEMRoughnessOfSoundPairs(inFiles,inPaths,inSection,...
 %                                inSaveSoundCombinations,inOutputPath,...
-%                                inUseReference,inPlotFlag)
+%                                inUseReference,inPlotFlag,inCheckpointFile)
 %
 % Description:
 %   Calculates roughness of 2-by-2 combinations of sounds.
@@ -34,6 +34,11 @@ function [outMeanRoughness,outSortedList,outRoughness,outRoughnessFreq,outUsedSe
 %                    if empty or not specified, 0 is used by default 
 %   inPlotFlag = if non-zero, plots outRoughness as a 2D map
 %                if empty or not specified, 1 is used by default
+%   inCheckpointFile = file in which the roughness of every finished pair is
+%                      kept (only used by the native version, see remark 3):
+%                      calling this function again with the same file after
+%                      an interruption continues where it stopped
+%                      if empty or not specified, no checkpoint file is used
 %
 % Output:
 %   outMeanRoughness = mean of outRoughness over the complete section
@@ -53,6 +58,14 @@ function [outMeanRoughness,outSortedList,outRoughness,outRoughnessFreq,outUsedSe
 %        s1 = IPEMAdaptLevel(s1,-20); s2 = IPEMAdaptLevel(s2,-20);
 %        s = IPEMAdaptLevel(s1+s2,-20);
 %   2. All sound files should be of the same sample frequency...
+%   3. If IPEMRoughnessOfSoundPairsMex is available, every sound is read only
+%      once and the pairs are mixed and analyzed in memory, in parallel.
+%      The levels are then adapted (and clipping is checked) after the
+%      resampling to 22050 Hz done by IPEMCalcANI, and the reference value
+%      (inUseReference) is the one for -20 dB, the level of every mix.
+%      Otherwise the mixes are made a few per processor at a time, and the
+%      ANIs of each such chunk are computed in one call of IPEMCalcANIBatch
+%      (in parallel if IPEMCalcANIBatchMex is available).
 %
 % Example:
 %   theFiles = {'sound1.wav','sound2.wav','sound3.wav'};
@@ -84,8 +97,8 @@ function [outMeanRoughness,outSortedList,outRoughness,outRoughnessFreq,outUsedSe
 % ------------------------------------------------------------------------------
 
 % Handle input arguments
-[inFiles,inPaths,inSection,inSaveSoundCombinations,inOutputPath,inUseReference,inPlotFlag] = ...
-    IPEMHandleInputArguments(varargin,1,{[],fullfile(IPEMRootDir('input'),'Sounds'),[],1,IPEMRootDir('output'),0,1});
+[inFiles,inPaths,inSection,inSaveSoundCombinations,inOutputPath,inUseReference,inPlotFlag,inCheckpointFile] = ...
+    IPEMHandleInputArguments(varargin,1,{[],fullfile(IPEMRootDir('input'),'Sounds'),[],1,IPEMRootDir('output'),0,1,''});
 
 % Additional checking
 if isempty(inFiles)
@@ -138,53 +151,99 @@ end
 
 % Start calculations for all combinations
 SectionStr = sprintf('[%5.3f-%5.3f]',inSection(1),inSection(2));
-for i = 1:NSounds
+if (exist('IPEMRoughnessOfSoundPairsMex') == 3)
     
-    for j = i:NSounds
-        
-        % Read the sounds
-        if (NPaths == 1)
-            Path1 = inPaths;
-            Path2 = inPaths;
-        else
-            Path1 = inPaths{i};
-            Path2 = inPaths{j};
+    % Native batch: the model runs in memory on all pairs at once
+    [outRoughness,outRoughnessFreq,Clipping,Duration] = ...
+        RoughnessThroughMex(inFiles,inPaths,inSection,Names,SectionStr,...
+                            inSaveSoundCombinations,inOutputPath,inCheckpointFile);
+    if (inUseReference)
+        outRoughness = outRoughness/IPEMGetRoughnessFFTReference(-20,Duration);
+    end
+    
+else
+    
+    % All combinations, in the order in which they are computed
+    NPairs = NSounds*(NSounds+1)/2;
+    Pairs = zeros(NPairs,2);
+    Count = 1;
+    for i = 1:NSounds
+        for j = i:NSounds
+            Pairs(Count,:) = [i j];
+            Count = Count + 1;
         end
-        [s1,fs] = IPEMReadSoundFile(inFiles{i},Path1,inSection);
-        [s2,fs] = IPEMReadSoundFile(inFiles{j},Path2,inSection);
+    end
+    
+    % The combinations are mixed and analyzed a chunk at a time (a few per
+    % thread of IPEMCalcANIBatchMex), so that the mixes and their ANIs are
+    % not all kept in memory at once
+    if (exist('nproc') == 2) | (exist('nproc') == 5)
+        NThreads = nproc;
+    elseif (exist('maxNumCompThreads') == 2) | (exist('maxNumCompThreads') == 5)
+        NThreads = maxNumCompThreads;
+    else
+        NThreads = 1;
+    end
+    ChunkSize = 4*NThreads;
+    for First = 1:ChunkSize:NPairs
+        Last = min(First+ChunkSize-1,NPairs);
+        Sounds = cell(1,Last-First+1);
+        RoughnessRefs = ones(1,Last-First+1);
+        for k = First:Last
         
-        % Adapt the levels and setup the combination
-        s1 = IPEMAdaptLevel(s1,-20);
-        s2 = IPEMAdaptLevel(s2,-20);
-        s = IPEMAdaptLevel(s1+s2,-20);
+            % Read the sounds
+            i = Pairs(k,1);
+            j = Pairs(k,2);
+            if (NPaths == 1)
+                Path1 = inPaths;
+                Path2 = inPaths;
+            else
+                Path1 = inPaths{i};
+                Path2 = inPaths{j};
+            end
+            [s1,fs] = IPEMReadSoundFile(inFiles{i},Path1,inSection);
+            [s2,fs] = IPEMReadSoundFile(inFiles{j},Path2,inSection);
         
-        % For keeping track whether clipping occured or not...
-        if ((max(s) > 1) | (min(s) < -1)) Clipping(i,j) = 1; else Clipping(i,j) = 0; end;
+            % Adapt the levels and setup the combination
+            s1 = IPEMAdaptLevel(s1,-20);
+            s2 = IPEMAdaptLevel(s2,-20);
+            s = IPEMAdaptLevel(s1+s2,-20);
         
-        % Get the level and the reference value for this level if needed
-        if  (inUseReference)
-            L = IPEMGetLevel(s);
-            RoughnessRef = IPEMGetRoughnessFFTReference(L,length(s)/fs);
-        else
-            RoughnessRef = 1;
-        end
+            % For keeping track whether clipping occured or not...
+            if ((max(s) > 1) | (min(s) < -1)) Clipping(i,j) = 1; else Clipping(i,j) = 0; end;
         
-        % Write combinations to a wav file if needed
-        if (inSaveSoundCombinations)
-            OutputFileName = sprintf('Roughness_%s_%s_%s.wav',Names{i},Names{j},SectionStr);
-            OutputFile = fullfile(inOutputPath,OutputFileName);
-            wavwrite(s,fs,OutputFile);
-        end
+            % Get the level and the reference value for this level if needed
+            if  (inUseReference)
+                L = IPEMGetLevel(s);
+                RoughnessRefs(k-First+1) = IPEMGetRoughnessFFTReference(L,length(s)/fs);
+            end
         
-        % Calc ANI and from there roughness
-        [ANI,ANIFreq,ANIFilterFreqs] = IPEMCalcANI(s,fs,[],0);
-        [Roughness,outRoughnessFreq] = IPEMRoughnessFFT(ANI,ANIFreq,ANIFilterFreqs,[],[],0);
-        Roughness = Roughness/RoughnessRef;
+            % Write combinations to a wav file if needed
+            if (inSaveSoundCombinations)
+                OutputFileName = sprintf('Roughness_%s_%s_%s.wav',Names{i},Names{j},SectionStr);
+                OutputFile = fullfile(inOutputPath,OutputFileName);
+                wavwrite(s,fs,OutputFile);
+            end
+        
+            Sounds{k-First+1} = s;
         
-        % Store Roughness values over combination and also the mean
-        outRoughness(i,j,:) = Roughness;
-        outRoughness(j,i,:) = Roughness;
+        end
         
+        % Calc the ANIs of the chunk at once (in parallel if
+        % IPEMCalcANIBatchMex is available) and from there roughness
+        [ANIs,ANIFreqs,ANIFilterFreqs] = IPEMCalcANIBatch(Sounds,fs,[],[],[],[],[],[],NThreads);
+        clear Sounds;
+        for k = First:Last
+            [Roughness,outRoughnessFreq] = IPEMRoughnessFFT(ANIs{k-First+1},ANIFreqs(k-First+1),ANIFilterFreqs{k-First+1},[],[],0);
+            Roughness = Roughness/RoughnessRefs(k-First+1);
+            
+            % Store Roughness values over combination and also the mean
+            i = Pairs(k,1);
+            j = Pairs(k,2);
+            outRoughness(i,j,:) = Roughness;
+            outRoughness(j,i,:) = Roughness;
+        end
+        clear ANIs;
     end
     
 end
@@ -241,3 +300,46 @@ if (inPlotFlag)
     set(haxis,'YTick',1:NSounds);
     
 end
+
+
+% ------------------------------------------------------------------------------
+
+function [outRoughness,outRoughnessFreq,outClipping,outDuration] = ...
+    RoughnessThroughMex(inFiles,inPaths,inSection,inNames,inSectionStr,...
+                        inSaveSoundCombinations,inOutputPath,inCheckpointFile)
+
+% Read every sound once
+NSounds = length(inFiles);
+for i = 1:NSounds
+    if iscell(inPaths)
+        Path = inPaths{i};
+    else
+        Path = inPaths;
+    end
+    [s,fs] = IPEMReadSoundFile(inFiles{i},Path,inSection);
+    if (i == 1)
+        Sounds = zeros(NSounds,length(s));
+    end
+    Sounds(i,:) = s;
+end
+outDuration = size(Sounds,2)/fs;
+
+% Write combinations to wav files if needed (mixed as by the Matlab version)
+if (inSaveSoundCombinations)
+    for i = 1:NSounds
+        for j = i:NSounds
+            s = IPEMAdaptLevel(IPEMAdaptLevel(Sounds(i,:),-20) + IPEMAdaptLevel(Sounds(j,:),-20),-20);
+            OutputFileName = sprintf('Roughness_%s_%s_%s.wav',inNames{i},inNames{j},inSectionStr);
+            wavwrite(s,fs,fullfile(inOutputPath,OutputFileName));
+        end
+    end
+end
+
+% The model runs at 22050 Hz (as in IPEMCalcANI)
+NewSampleFreq = 22050;
+if (fs ~= NewSampleFreq)
+    Sounds = resample(Sounds',NewSampleFreq,fs)';
+end
+fprintf(1,'Calculating roughness of %d pairs of sounds...\n',NSounds*(NSounds+1)/2);
+[outRoughness,outRoughnessFreq,outClipping] = ...
+    IPEMRoughnessOfSoundPairsMex(Sounds,NewSampleFreq,inCheckpointFile);
@@ -306,10 +306,14 @@ if 0
         P,PLengths,PFreq,RMSFreq,NoiseBands,ANIFilterFreqs);
 end
 
-% Start ReSynthUI
-UIData = struct(...
-    'Sound',s,'SampleFreq',fs,'Periods',Periods,'BestPeriodIndices',BestPeriodIndices,'AnalysisFreq',AnalysisFreq,...
-    'P',{P},'PLengths',PLengths,'PFreq',PFreq,'OriginalFreq',RMSFreq,'NoiseBands',NoiseBands);
+% Start ReSynthUI (which extracts the pattern of the selected moment itself,
+% unless the patterns were integrated)
+if (~PatternIntegration)
+    P = {}; PLengths = []; PFreq = [];
+end
+UIData = struct(...
+    'Sound',s,'SampleFreq',fs,'Periods',Periods,'BestPeriodIndices',BestPeriodIndices,'AnalysisFreq',AnalysisFreq,...
+    'P',{P},'PLengths',PLengths,'PFreq',PFreq,'OriginalFreq',RMSFreq,'AnalyzedSignal',RMS,'NoiseBands',NoiseBands);
 switch (UseMode)
 case 1,
     UIData = setfield(UIData,'ANIFilterFreqs',[]);
@@ -137,15 +137,31 @@ case 3
     IPEMPlotMultiChannel(Periods(BestPeriodIndices),AnalysisFreq,'Best period over time for each channel','Time (in s)','Auditory channels (center freqs. in Hz)',14,ANIFilterFreqs,1);
 end
 
-% Extract patterns for all channels and integrate if needed
-if (inPatternIntegrationTime == 0)
-    [P,PLengths,PFreq] = IPEMMECExtractPatterns(RMS,RMSFreq,Periods,BestPeriodIndices,AnalysisFreq,inRescalePatterns,1);
-else
-    [P,PLengths,PFreq] = IPEMMECExtractPatterns(RMS,RMSFreq,Periods,BestPeriodIndices,AnalysisFreq,inRescalePatterns,0);
-    fprintf(1,'Integrating patterns... ');
-    P = IntegratePatterns(P,PFreq,inPatternIntegrationTime,Periods,BestPeriodIndices,RMSFreq);
-    fprintf(1,'Done.\n');
-end
+% Extract the patterns for all channels: only the one of the selected moment
+% (or those up to it when they are integrated), unless all of them are saved
+SelectionIndex = round(inSelectionTime*AnalysisFreq)+1;
+SelectionIndex = max(1,min(SelectionIndex,size(BestPeriodIndices,2)));
+if (inSaveMECResults)
+    TimeIndices = [];
+elseif (inPatternIntegrationTime == 0)
+    TimeIndices = SelectionIndex;
+else
+    TimeIndices = 1:SelectionIndex;
+end
+if (inPatternIntegrationTime == 0)
+    [P,PLengths,PFreq] = IPEMMECExtractPatterns(RMS,RMSFreq,Periods,BestPeriodIndices,AnalysisFreq,inRescalePatterns,...
+                                                length(TimeIndices) ~= 1,TimeIndices);
+else
+    [P,PLengths,PFreq] = IPEMMECExtractPatterns(RMS,RMSFreq,Periods,BestPeriodIndices,AnalysisFreq,inRescalePatterns,0,TimeIndices);
+    fprintf(1,'Integrating patterns... ');
+    P = IntegratePatterns(P,PFreq,inPatternIntegrationTime,Periods,BestPeriodIndices,RMSFreq);
+    fprintf(1,'Done.\n');
+end
+if isempty(TimeIndices)
+    SynthesisTime = inSelectionTime;
+else
+    SynthesisTime = (length(TimeIndices)-1)/PFreq;
+end
 
 % Set layout
 IPEMSetFigureLayout('all');
@@ -159,7 +175,7 @@ end
 
 % Resynthesize sound
 [outResynthesizedSound,outDetectedPeriods,outIndividualSounds] = ...
-    IPEMMECSynthesis(P,PLengths,PFreq,RMSFreq,inSelectionTime,inResynthDuration,fs,NoiseBands,-20,1,[],1);
+    IPEMMECSynthesis(P,PLengths,PFreq,RMSFreq,SynthesisTime,inResynthDuration,fs,NoiseBands,-20,1,[],1);
 
 % Play the resynthesized sound
 wavplay(outResynthesizedSound,fs,'async');